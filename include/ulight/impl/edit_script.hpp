@@ -0,0 +1,607 @@
+#ifndef ULIGHT_EDIT_SCRIPT_HPP
+#define ULIGHT_EDIT_SCRIPT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ulight/impl/assert.hpp"
+
+namespace ulight {
+
+enum struct Edit_Type : signed char {
+    /// @brief Delete an element in the source sequence.
+    /// Advance by one element in the source sequence.
+    del = -1,
+    /// @brief Keep the element in the source sequence.
+    /// Advance by one element in both sequences.
+    common = 0,
+    /// @brief Insert the element from the target sequence into the source sequence.
+    /// Advance by one element in the target sequence.
+    ins = 1,
+};
+
+namespace detail {
+
+/// @brief The state of `myers_edit_script`.
+/// See also:
+/// Eugene W. Myers, "An O(ND) Difference Algorithm and Its Variations", 1986.
+/// The implementation closely follows `diffseq.h` in GNU diffutils,
+/// including its heuristic for giving up on finding a minimal script.
+template <typename T, typename Equal>
+struct Myers_Context {
+    using Diagonal = std::ptrdiff_t;
+
+    std::span<const T> from;
+    std::span<const T> to;
+    Equal& equal;
+    std::size_t max_cost;
+
+    /// @brief For each diagonal `k`, the furthest-reaching `x` of the forward search.
+    Diagonal* forward;
+    /// @brief For each diagonal `k`, the furthest-reaching `x` of the backward search.
+    Diagonal* backward;
+
+    struct Split {
+        Diagonal x;
+        Diagonal y;
+    };
+
+    [[nodiscard]]
+    bool equal_at(Diagonal x, Diagonal y)
+    {
+        return equal(from[std::size_t(x)], to[std::size_t(y)]);
+    }
+
+    /// @brief Finds the midpoint of the shortest edit script within the given sub-sequences,
+    /// i.e. the point at which a forward and a backward search overlap.
+    /// If the cost of the search exceeds `max_cost`,
+    /// returns the point that has been reached furthest instead.
+    /// The sub-sequences shall not have a common prefix or suffix,
+    /// and neither shall be empty.
+    [[nodiscard]]
+    Split find_split(Diagonal x_begin, Diagonal x_end, Diagonal y_begin, Diagonal y_end)
+    {
+        const Diagonal d_min = x_begin - y_end;
+        const Diagonal d_max = x_end - y_begin;
+        const Diagonal f_mid = x_begin - y_begin;
+        const Diagonal b_mid = x_end - y_end;
+        Diagonal f_min = f_mid;
+        Diagonal f_max = f_mid;
+        Diagonal b_min = b_mid;
+        Diagonal b_max = b_mid;
+        const bool odd = ((f_mid - b_mid) & 1) != 0;
+
+        forward[f_mid] = x_begin;
+        backward[b_mid] = x_end;
+
+        for (std::size_t cost = 1;; ++cost) {
+            // Extend the forward search by one edit.
+            if (f_min > d_min) {
+                forward[--f_min - 1] = -1;
+            }
+            else {
+                ++f_min;
+            }
+            if (f_max < d_max) {
+                forward[++f_max + 1] = -1;
+            }
+            else {
+                --f_max;
+            }
+            for (Diagonal d = f_max; d >= f_min; d -= 2) {
+                const Diagonal lo = forward[d - 1];
+                const Diagonal hi = forward[d + 1];
+                Diagonal x = lo >= hi ? lo + 1 : hi;
+                Diagonal y = x - d;
+                while (x < x_end && y < y_end && equal_at(x, y)) {
+                    ++x;
+                    ++y;
+                }
+                forward[d] = x;
+                if (odd && b_min <= d && d <= b_max && backward[d] <= x) {
+                    return { x, y };
+                }
+            }
+
+            // Extend the backward search by one edit.
+            if (b_min > d_min) {
+                backward[--b_min - 1] = std::numeric_limits<Diagonal>::max();
+            }
+            else {
+                ++b_min;
+            }
+            if (b_max < d_max) {
+                backward[++b_max + 1] = std::numeric_limits<Diagonal>::max();
+            }
+            else {
+                --b_max;
+            }
+            for (Diagonal d = b_max; d >= b_min; d -= 2) {
+                const Diagonal lo = backward[d - 1];
+                const Diagonal hi = backward[d + 1];
+                Diagonal x = lo < hi ? lo : hi - 1;
+                Diagonal y = x - d;
+                while (x_begin < x && y_begin < y && equal_at(x - 1, y - 1)) {
+                    --x;
+                    --y;
+                }
+                backward[d] = x;
+                if (!odd && f_min <= d && d <= f_max && x <= forward[d]) {
+                    return { x, y };
+                }
+            }
+
+            if (cost >= max_cost) {
+                return find_heuristic_split(
+                    x_begin, x_end, y_begin, y_end, f_min, f_max, b_min, b_max
+                );
+            }
+        }
+    }
+
+    /// @brief Returns the furthest-reaching point of either search,
+    /// measured by the progress along both sequences.
+    [[nodiscard]]
+    Split find_heuristic_split(
+        Diagonal x_begin,
+        Diagonal x_end,
+        Diagonal y_begin,
+        Diagonal y_end,
+        Diagonal f_min,
+        Diagonal f_max,
+        Diagonal b_min,
+        Diagonal b_max
+    ) const
+    {
+        Diagonal f_best_xy = -1;
+        Diagonal f_best_x = x_begin;
+        for (Diagonal d = f_max; d >= f_min; d -= 2) {
+            Diagonal x = std::min(forward[d], x_end);
+            Diagonal y = x - d;
+            if (y_end < y) {
+                x = y_end + d;
+                y = y_end;
+            }
+            if (f_best_xy < x + y) {
+                f_best_xy = x + y;
+                f_best_x = x;
+            }
+        }
+
+        Diagonal b_best_xy = std::numeric_limits<Diagonal>::max();
+        Diagonal b_best_x = x_end;
+        for (Diagonal d = b_max; d >= b_min; d -= 2) {
+            Diagonal x = std::max(x_begin, backward[d]);
+            Diagonal y = x - d;
+            if (y < y_begin) {
+                x = y_begin + d;
+                y = y_begin;
+            }
+            if (x + y < b_best_xy) {
+                b_best_xy = x + y;
+                b_best_x = x;
+            }
+        }
+
+        if ((x_end + y_end) - b_best_xy < f_best_xy - (x_begin + y_begin)) {
+            return { f_best_x, f_best_xy - f_best_x };
+        }
+        return { b_best_x, b_best_xy - b_best_x };
+    }
+};
+
+} // namespace detail
+
+/// @brief Computes a short edit script which converts the sequence `from` into `to`,
+/// and appends it to `out`.
+///
+/// This uses the linear-space variant of Myers' O(ND) algorithm,
+/// so the memory required is O(N + M) regardless of how different the sequences are.
+/// If the sequences are so different that the minimal script costs more than `max_cost`
+/// edits for some part of the sequences,
+/// the search for that part gives up and settles for a script that is not minimal.
+/// This bounds the time to roughly O((N + M) * max_cost).
+/// @param max_cost The cost after which the heuristic kicks in.
+/// A value of `std::size_t(-1)` always finds a minimal script.
+/// @param equal The predicate which determines whether two elements are equal.
+template <typename T, typename Equal = std::ranges::equal_to>
+void myers_edit_script(
+    std::pmr::vector<Edit_Type>& out,
+    std::span<const T> from,
+    std::span<const T> to,
+    std::pmr::memory_resource* memory,
+    std::size_t max_cost = std::size_t(-1),
+    Equal equal = {}
+)
+{
+    using Context = detail::Myers_Context<T, Equal>;
+    using Diagonal = Context::Diagonal;
+
+    // Diagonals range from -to.size() - 1 to from.size() + 1.
+    const std::size_t diagonals = from.size() + to.size() + 3;
+    std::pmr::vector<Diagonal> diagonal_data(2 * diagonals, memory);
+    const auto offset = Diagonal(to.size() + 1);
+    Context context { .from = from,
+                      .to = to,
+                      .equal = equal,
+                      .max_cost = std::max(max_cost, std::size_t(1)),
+                      .forward = diagonal_data.data() + offset,
+                      .backward = diagonal_data.data() + diagonals + offset };
+
+    // To keep the stack bounded, even if the heuristic splits the sequences unevenly,
+    // we use an explicit stack of sub-problems instead of recursion.
+    // A task with empty sub-sequences stands for the common suffix of a sub-problem,
+    // which has to be emitted after the rest of that sub-problem.
+    struct Task {
+        Diagonal x_begin;
+        Diagonal x_end;
+        Diagonal y_begin;
+        Diagonal y_end;
+        std::size_t common_suffix;
+    };
+    std::pmr::vector<Task> stack(memory);
+    stack.push_back({ 0, Diagonal(from.size()), 0, Diagonal(to.size()), 0 });
+
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+        if (task.common_suffix != 0) {
+            out.insert(out.end(), task.common_suffix, Edit_Type::common);
+            continue;
+        }
+
+        while (task.x_begin < task.x_end && task.y_begin < task.y_end
+               && context.equal_at(task.x_begin, task.y_begin)) {
+            out.push_back(Edit_Type::common);
+            ++task.x_begin;
+            ++task.y_begin;
+        }
+        std::size_t common_suffix = 0;
+        while (task.x_begin < task.x_end && task.y_begin < task.y_end
+               && context.equal_at(task.x_end - 1, task.y_end - 1)) {
+            ++common_suffix;
+            --task.x_end;
+            --task.y_end;
+        }
+
+        const auto emit_trivial = [&] {
+            out.insert(out.end(), std::size_t(task.x_end - task.x_begin), Edit_Type::del);
+            out.insert(out.end(), std::size_t(task.y_end - task.y_begin), Edit_Type::ins);
+            out.insert(out.end(), common_suffix, Edit_Type::common);
+        };
+        if (task.x_begin == task.x_end || task.y_begin == task.y_end) {
+            emit_trivial();
+            continue;
+        }
+
+        const auto [x, y] = context.find_split(task.x_begin, task.x_end, task.y_begin, task.y_end);
+        const bool splits = (x != task.x_begin || y != task.y_begin)
+            && (x != task.x_end || y != task.y_end);
+        if (!splits) {
+            // This should not happen, but if it did,
+            // we would be stuck with the same sub-problem forever.
+            emit_trivial();
+            continue;
+        }
+        if (common_suffix != 0) {
+            stack.push_back({ 0, 0, 0, 0, common_suffix });
+        }
+        stack.push_back({ x, task.x_end, y, task.y_end, 0 });
+        stack.push_back({ task.x_begin, x, task.y_begin, y, 0 });
+    }
+}
+
+/// @brief Computes an edit script which converts the sequence `from` into `to` using the
+/// histogram diff algorithm (as used by Git and JGit), and appends it to `out`.
+///
+/// The sequences are recursively split at the longest common region which contains the
+/// least frequent element of `from`.
+/// This prefers anchoring on rare elements, such as unique lines in source code,
+/// over frequent ones, such as blank lines or closing braces,
+/// which tends to produce more readable hunks than a minimal edit script,
+/// and is fast on typical input.
+/// If no element within a region of `from` occurs at most `max_occurrences` times and
+/// also occurs in `to`, that region is diffed using `myers_edit_script` with `max_cost`.
+///
+/// The memory required is O(N + M).
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::ranges::equal_to>
+void histogram_edit_script(
+    std::pmr::vector<Edit_Type>& out,
+    std::span<const T> from,
+    std::span<const T> to,
+    std::pmr::memory_resource* memory,
+    std::size_t max_cost = std::size_t(-1),
+    Hash hash = {},
+    Equal equal = {}
+)
+{
+    constexpr std::size_t max_occurrences = 64;
+    constexpr auto npos = std::size_t(-1);
+
+    struct Task {
+        std::size_t x_begin;
+        std::size_t x_end;
+        std::size_t y_begin;
+        std::size_t y_end;
+        std::size_t common_suffix;
+    };
+    std::pmr::vector<Task> stack(memory);
+    stack.push_back({ 0, from.size(), 0, to.size(), 0 });
+
+    /// For each element of `from` within the current region,
+    /// the first index of its occurrences, and how often it occurs.
+    struct Occurrences {
+        std::size_t first;
+        std::size_t count;
+    };
+    std::pmr::unordered_map<T, Occurrences, Hash, Equal> occurrences(0, hash, equal, memory);
+    /// For each index in `from`, the index of the next occurrence of the same element,
+    /// or `npos`.
+    std::pmr::vector<std::size_t> next_occurrence(from.size(), npos, memory);
+    std::pmr::vector<Edit_Type> region_edits(memory);
+
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+        if (task.common_suffix != 0) {
+            out.insert(out.end(), task.common_suffix, Edit_Type::common);
+            continue;
+        }
+
+        while (task.x_begin < task.x_end && task.y_begin < task.y_end
+               && equal(from[task.x_begin], to[task.y_begin])) {
+            out.push_back(Edit_Type::common);
+            ++task.x_begin;
+            ++task.y_begin;
+        }
+        std::size_t common_suffix = 0;
+        while (task.x_begin < task.x_end && task.y_begin < task.y_end
+               && equal(from[task.x_end - 1], to[task.y_end - 1])) {
+            ++common_suffix;
+            --task.x_end;
+            --task.y_end;
+        }
+        if (task.x_begin == task.x_end || task.y_begin == task.y_end) {
+            out.insert(out.end(), task.x_end - task.x_begin, Edit_Type::del);
+            out.insert(out.end(), task.y_end - task.y_begin, Edit_Type::ins);
+            out.insert(out.end(), common_suffix, Edit_Type::common);
+            continue;
+        }
+
+        // Iterating backwards makes the chains of occurrences ascending.
+        occurrences.clear();
+        for (std::size_t x = task.x_end; x-- > task.x_begin;) {
+            const auto [it, inserted] = occurrences.try_emplace(from[x], Occurrences { x, 0 });
+            next_occurrence[x] = inserted ? npos : it->second.first;
+            it->second.first = x;
+            ++it->second.count;
+        }
+
+        std::size_t best_count = max_occurrences + 1;
+        std::size_t best_length = 0;
+        std::size_t best_x = 0;
+        std::size_t best_y = 0;
+        for (std::size_t y = task.y_begin; y < task.y_end;) {
+            const auto it = occurrences.find(to[y]);
+            if (it == occurrences.end()
+                || it->second.count > std::min(best_count, max_occurrences)) {
+                ++y;
+                continue;
+            }
+            std::size_t next_y = y + 1;
+            for (std::size_t x = it->second.first; x != npos; x = next_occurrence[x]) {
+                std::size_t x_start = x;
+                std::size_t y_start = y;
+                while (x_start > task.x_begin && y_start > task.y_begin
+                       && equal(from[x_start - 1], to[y_start - 1])) {
+                    --x_start;
+                    --y_start;
+                }
+                std::size_t x_stop = x + 1;
+                std::size_t y_stop = y + 1;
+                while (x_stop < task.x_end && y_stop < task.y_end
+                       && equal(from[x_stop], to[y_stop])) {
+                    ++x_stop;
+                    ++y_stop;
+                }
+                const std::size_t length = x_stop - x_start;
+                if (it->second.count < best_count || length > best_length) {
+                    best_count = it->second.count;
+                    best_length = length;
+                    best_x = x_start;
+                    best_y = y_start;
+                }
+                // Elements within the common region have been considered as part of it,
+                // so they need not be looked at individually.
+                next_y = std::max(next_y, y_stop);
+            }
+            y = next_y;
+        }
+
+        if (best_length == 0) {
+            region_edits.clear();
+            myers_edit_script<T, Equal>(
+                region_edits, from.subspan(task.x_begin, task.x_end - task.x_begin),
+                to.subspan(task.y_begin, task.y_end - task.y_begin), memory, max_cost, equal
+            );
+            out.insert(out.end(), region_edits.begin(), region_edits.end());
+            out.insert(out.end(), common_suffix, Edit_Type::common);
+            continue;
+        }
+
+        if (common_suffix != 0) {
+            stack.push_back({ 0, 0, 0, 0, common_suffix });
+        }
+        stack.push_back({ best_x + best_length, task.x_end, best_y + best_length, task.y_end, 0 });
+        stack.push_back({ 0, 0, 0, 0, best_length });
+        stack.push_back({ task.x_begin, best_x, task.y_begin, best_y, 0 });
+    }
+}
+
+/// @brief Reorders each contiguous block of insertions and deletions within `edits`
+/// so that all deletions precede all insertions.
+/// This does not change the meaning of the edit script,
+/// but makes it more readable.
+inline void group_edits(std::span<Edit_Type> edits)
+{
+    auto it = edits.begin();
+    while (it != edits.end()) {
+        // Find the next block of insertions/deletions.
+        const auto next_mod_begin = std::ranges::find_if(it, edits.end(), [](Edit_Type t) {
+            return t != Edit_Type::common;
+        });
+        const auto next_mod_end = std::ranges::find(next_mod_begin, edits.end(), Edit_Type::common);
+        // Partition the block so that deletions all precede insertions.
+        std::ranges::partition(next_mod_begin, next_mod_end, [](Edit_Type t) {
+            return t == Edit_Type::del;
+        });
+        it = next_mod_end;
+    }
+}
+
+/// @brief A hunk of a unified diff, i.e. a block of changes with surrounding context.
+struct Diff_Hunk {
+    /// @brief The index of the first line of the hunk in the source sequence.
+    std::size_t from_begin;
+    /// @brief The amount of lines of the hunk in the source sequence.
+    std::size_t from_length;
+    /// @brief The index of the first line of the hunk in the target sequence.
+    std::size_t to_begin;
+    /// @brief The amount of lines of the hunk in the target sequence.
+    std::size_t to_length;
+    /// @brief The range of edits within the edit script that make up the hunk.
+    std::size_t edits_begin;
+    std::size_t edits_end;
+};
+
+/// @brief Splits the edit script `edits` into hunks, which consist of changes,
+/// surrounded by up to `context` common elements.
+/// Changes which are separated by no more than `2 * context` common elements
+/// are placed in the same hunk.
+inline void find_hunks(
+    std::pmr::vector<Diff_Hunk>& out,
+    std::span<const Edit_Type> edits,
+    std::size_t context = 3
+)
+{
+    std::size_t from_index = 0;
+    std::size_t to_index = 0;
+    // The amount of common elements since the last change,
+    // and the positions after that change.
+    std::size_t commons = 0;
+    std::size_t after_change = 0;
+    std::size_t from_after_change = 0;
+    std::size_t to_after_change = 0;
+    bool in_hunk = false;
+
+    const auto close_hunk = [&] {
+        Diff_Hunk& hunk = out.back();
+        const std::size_t trailing = std::min(commons, context);
+        hunk.edits_end = after_change + trailing;
+        hunk.from_length = from_after_change + trailing - hunk.from_begin;
+        hunk.to_length = to_after_change + trailing - hunk.to_begin;
+    };
+
+    for (std::size_t i = 0; i < edits.size(); ++i) {
+        if (edits[i] == Edit_Type::common) {
+            ++commons;
+            ++from_index;
+            ++to_index;
+            continue;
+        }
+        if (in_hunk && commons > 2 * context) {
+            close_hunk();
+            in_hunk = false;
+        }
+        if (!in_hunk) {
+            const std::size_t leading = std::min(commons, context);
+            out.push_back({ .from_begin = from_index - leading,
+                            .from_length = 0,
+                            .to_begin = to_index - leading,
+                            .to_length = 0,
+                            .edits_begin = i - leading,
+                            .edits_end = 0 });
+            in_hunk = true;
+        }
+        from_index += edits[i] == Edit_Type::del;
+        to_index += edits[i] == Edit_Type::ins;
+        commons = 0;
+        after_change = i + 1;
+        from_after_change = from_index;
+        to_after_change = to_index;
+    }
+    if (in_hunk) {
+        close_hunk();
+    }
+}
+
+/// @brief Appends the unified diff of `from_lines` and `to_lines` to `out`,
+/// where `edits` is an edit script that converts the former into the latter.
+/// Only the hunks are rendered (i.e. no `---` and `+++` headings),
+/// and every line is terminated by `'\n'`.
+/// The output can be highlighted using `ULIGHT_LANG_DIFF`.
+inline void append_unified_diff(
+    std::pmr::u8string& out,
+    std::span<const std::u8string_view> from_lines,
+    std::span<const std::u8string_view> to_lines,
+    std::span<const Edit_Type> edits,
+    std::size_t context = 3
+)
+{
+    std::pmr::vector<Diff_Hunk> hunks(out.get_allocator());
+    find_hunks(hunks, edits, context);
+
+    // In unified format, the start of an empty range is the line preceding it.
+    const auto append_range = [&](std::size_t begin, std::size_t length) {
+        const std::size_t start = length == 0 ? begin : begin + 1;
+        out += reinterpret_cast<const char8_t*>(std::to_string(start).c_str());
+        if (length != 1) {
+            out += u8',';
+            out += reinterpret_cast<const char8_t*>(std::to_string(length).c_str());
+        }
+    };
+
+    for (const Diff_Hunk& hunk : hunks) {
+        out += u8"@@ -";
+        append_range(hunk.from_begin, hunk.from_length);
+        out += u8" +";
+        append_range(hunk.to_begin, hunk.to_length);
+        out += u8" @@\n";
+
+        std::size_t from_index = hunk.from_begin;
+        std::size_t to_index = hunk.to_begin;
+        for (std::size_t i = hunk.edits_begin; i < hunk.edits_end; ++i) {
+            switch (edits[i]) {
+            case Edit_Type::common: {
+                out += u8' ';
+                out += from_lines[from_index++];
+                ++to_index;
+                break;
+            }
+            case Edit_Type::del: {
+                out += u8'-';
+                out += from_lines[from_index++];
+                break;
+            }
+            case Edit_Type::ins: {
+                out += u8'+';
+                out += to_lines[to_index++];
+                break;
+            }
+            }
+            out += u8'\n';
+        }
+    }
+}
+
+} // namespace ulight
+
+#endif
@@ -20,6 +20,15 @@ struct Highlight_Options {
     ///
     /// For example, if `false`, C++ highlighting also includes all C keywords.
     bool strict = false;
+    /// @brief The maximum amount of threads used for highlighting, including the calling thread,
+    /// where zero means one thread per hardware thread.
+    /// Only languages which consist of independent records (i.e. JSON Lines)
+    /// are highlighted on multiple threads.
+    /// In that case, the memory resource has to be thread-safe.
+    std::size_t threads = 1;
+    /// @brief If `true`, the files within diffs are highlighted
+    /// in the language that is determined from their paths.
+    bool diff_langs = false;
 };
 
 bool highlight_cowel(
@@ -94,6 +103,12 @@ bool highlight_jsonc(
     std::pmr::memory_resource* memory,
     const Highlight_Options& options = {}
 );
+bool highlight_jsonl(
+    Non_Owning_Buffer<Token>& out,
+    std::u8string_view source,
+    std::pmr::memory_resource* memory,
+    const Highlight_Options& options = {}
+);
 inline bool highlight_txt(
     Non_Owning_Buffer<Token>&,
     std::u8string_view,
@@ -165,6 +180,8 @@ inline Status highlight(
         return to_result(highlight_json(out, source, memory, options));
     case Lang::jsonc: //
         return to_result(highlight_jsonc(out, source, memory, options));
+    case Lang::jsonl: //
+        return to_result(highlight_jsonl(out, source, memory, options));
     case Lang::txt: //
         return to_result(highlight_txt(out, source, memory, options));
     case Lang::tex: //
@@ -0,0 +1,43 @@
+#ifndef ULIGHT_HTML_OUTPUT_HPP
+#define ULIGHT_HTML_OUTPUT_HPP
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+#include "ulight/ulight.hpp"
+
+#include "ulight/impl/buffer.hpp"
+
+namespace ulight {
+
+/// @brief Appends `text` to `out`,
+/// with every `<`, `>`, and `&` replaced by the corresponding HTML entity.
+void append_html_escaped(Non_Owning_Buffer<char>& out, std::string_view text);
+
+/// @brief Converts highlight tokens into HTML, chunk by chunk.
+/// This is the second stage of the pipeline in `ulight_source_to_html`,
+/// and is exposed so that it can be driven (and measured) separately from the first.
+struct [[nodiscard]] Html_Token_Writer {
+    Non_Owning_Buffer<char>& out;
+    /// @brief The source code that the tokens refer to.
+    std::string_view source;
+    std::string_view tag_name;
+    std::string_view attr_name;
+    /// @brief The index in `source` up to which HTML has been generated.
+    std::size_t previous_end = 0;
+
+    /// @brief Appends the HTML for `tokens` to `out`,
+    /// including any unhighlighted source code between `previous_end` and the first token.
+    /// The tokens have to be ordered and non-overlapping,
+    /// and must not start before `previous_end`.
+    void write(std::span<const Token> tokens);
+
+    /// @brief Appends the remaining source code following the last written token.
+    /// This does not flush `out`.
+    void finish();
+};
+
+} // namespace ulight
+
+#endif
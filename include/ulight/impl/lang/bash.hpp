@@ -2,7 +2,9 @@
 #define ULIGHT_BASH_HPP
 
 #include <algorithm>
+#include <cstddef>
 #include <optional>
+#include <string>
 #include <string_view>
 
 #include "ulight/ulight.hpp"
@@ -111,6 +113,59 @@ bool starts_with_substitution(std::u8string_view str);
 [[nodiscard]]
 std::size_t match_identifier(std::u8string_view str);
 
+struct Heredoc_Delimiter_Result {
+    /// @brief The length of the delimiter word, including any quotes and backslashes.
+    std::size_t length;
+    /// @brief If `true`, some part of the delimiter word is quoted,
+    /// which means that no expansions take place within the lines of the here-document.
+    bool quoted;
+
+    [[nodiscard]]
+    constexpr explicit operator bool() const
+    {
+        return length != 0;
+    }
+
+    [[nodiscard]]
+    friend constexpr bool operator==(Heredoc_Delimiter_Result, Heredoc_Delimiter_Result)
+        = default;
+};
+
+/// @brief Matches the delimiter word which follows a `<<` or `<<-` redirection operator,
+/// like `EOF`, `'EOF'`, or `"E"OF`.
+/// https://www.gnu.org/software/bash/manual/bash.html#Here-Documents
+[[nodiscard]]
+Heredoc_Delimiter_Result match_heredoc_delimiter(std::u8string_view str);
+
+/// @brief Appends the result of quote removal on `word` to `out`.
+/// For example, the delimiter word `"E"O\F` is turned into the delimiter line `EOF`.
+void append_unquoted(std::pmr::u8string& out, std::u8string_view word);
+
+struct Heredoc_Body_Result {
+    /// @brief The length of the lines of the here-document,
+    /// including the line terminator of the last line, if any.
+    std::size_t content_length;
+    /// @brief The length of the delimiter line, including any leading tabs,
+    /// but not including the line terminator.
+    std::size_t delimiter_length;
+    /// @brief If `true`, the here-document is terminated by a delimiter line.
+    /// Otherwise, the here-document extends to the end of the input.
+    bool terminated;
+
+    [[nodiscard]]
+    friend constexpr bool operator==(Heredoc_Body_Result, Heredoc_Body_Result)
+        = default;
+};
+
+/// @brief Matches the lines of a here-document up to and including the delimiter line,
+/// i.e. the first line which consists of `delimiter` exactly.
+/// `str` shall start at the beginning of a line.
+/// @param strip_tabs If `true`, leading tabs are ignored on the delimiter line,
+/// as is the case for here-documents introduced with `<<-`.
+[[nodiscard]]
+Heredoc_Body_Result
+match_heredoc_body(std::u8string_view str, std::u8string_view delimiter, bool strip_tabs);
+
 } // namespace ulight::bash
 
 #endif
@@ -77,6 +77,25 @@ constexpr bool is_bash_escapable_in_double_quotes(char32_t c) noexcept
     return is_ascii(c) && is_bash_escapable_in_double_quotes(char8_t(c));
 }
 
+inline constexpr Charset256 is_bash_escapable_in_heredoc_set = detail::to_charset256(u8"$`\\\n");
+
+/// @brief Returns `true` iff `c` is a character
+/// for which a preceding backslash within the lines of a here-document retains its special
+/// meaning, assuming that the delimiter of the here-document is not quoted.
+[[nodiscard]]
+constexpr bool is_bash_escapable_in_heredoc(char8_t c) noexcept
+{
+    // https://www.gnu.org/software/bash/manual/bash.html#Here-Documents
+    return is_bash_escapable_in_heredoc_set.contains(c);
+}
+
+[[nodiscard]]
+constexpr bool is_bash_escapable_in_heredoc(char32_t c) noexcept
+{
+    // https://www.gnu.org/software/bash/manual/bash.html#Here-Documents
+    return is_ascii(c) && is_bash_escapable_in_heredoc(char8_t(c));
+}
+
 inline constexpr Charset256 is_bash_special_parameter_set = detail::to_charset256(u8"*@#?-$!0");
 
 /// @brief Returns `true` iff `c` forms a parameter substitution
@@ -1,6 +1,8 @@
 #ifndef ULIGHT_DIFF_HPP
 #define ULIGHT_DIFF_HPP
 
+#include <cstddef>
+#include <optional>
 #include <string_view>
 
 #include "ulight/ulight.hpp"
@@ -10,6 +12,31 @@ namespace ulight::diff {
 [[nodiscard]]
 Highlight_Type choose_line_highlight(std::u8string_view line);
 
-}
+/// @brief The amounts of lines in a hunk of a unified diff.
+struct Hunk_Header {
+    /// @brief The amount of lines from the old file (context and deletions).
+    std::size_t old_lines;
+    /// @brief The amount of lines from the new file (context and insertions).
+    std::size_t new_lines;
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const Hunk_Header&, const Hunk_Header&)
+        = default;
+};
+
+/// @brief Matches a unified hunk heading like `@@ -1,7 +1,6 @@`,
+/// where the amounts of lines default to `1` if omitted.
+/// @returns The amounts of lines, or `std::nullopt` if `line` is not a hunk heading.
+[[nodiscard]]
+std::optional<Hunk_Header> match_hunk_header(std::u8string_view line);
+
+/// @brief Returns the path within a file heading like `+++ b/main.cpp\t2002-02-21`,
+/// i.e. the text following the three-character marker and a space,
+/// up to the first tab (which separates the path from a timestamp).
+/// `line` shall start with `"--- "` or `"+++ "`.
+[[nodiscard]]
+std::u8string_view file_heading_path(std::u8string_view line);
+
+} // namespace ulight::diff
 
 #endif
@@ -2,8 +2,14 @@
 #define ULIGHT_HTML_HPP
 
 #include <cstddef>
+#include <memory_resource>
 #include <string_view>
 
+#include "ulight/ulight.hpp"
+
+#include "ulight/impl/buffer.hpp"
+#include "ulight/impl/highlight.hpp"
+
 namespace ulight::html {
 
 struct Match_Result {
@@ -114,6 +120,84 @@ struct End_Tag_Result {
 [[nodiscard]]
 End_Tag_Result match_end_tag_permissive(std::u8string_view str);
 
+/// @brief The construct which is open at the boundary between two windows
+/// of a streamed HTML or XML document.
+enum struct Stream_Context : Underlying {
+    /// @brief Text between tags, comments, etc.
+    text,
+    /// @brief A start tag, after its name.
+    tag,
+    /// @brief A quoted attribute value, after its opening quote.
+    attribute_value,
+    /// @brief The contents of a raw text element like `<script>` or `<title>`.
+    raw_text,
+    /// @brief The contents of a comment.
+    comment,
+    /// @brief The contents of a CDATA section.
+    cdata,
+};
+
+/// @brief The HTML elements whose contents are raw text rather than markup.
+enum struct Raw_Text_Element : Underlying {
+    none,
+    script,
+    style,
+    textarea,
+    title,
+};
+
+/// @brief The state which a streaming highlighter carries from one window into the next.
+struct Stream_State {
+    Stream_Context context = Stream_Context::text;
+    /// @brief In the `tag` and `raw_text` context,
+    /// the raw text element whose start tag or contents we are in.
+    Raw_Text_Element element = Raw_Text_Element::none;
+    /// @brief In the `attribute_value` context, the quote which closes the value.
+    char8_t quote = 0;
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const Stream_State&, const Stream_State&)
+        = default;
+};
+
+/// @brief The amount of code units at the end of a window which streaming highlighters
+/// leave unconsumed when splitting text, comments, etc.,
+/// so that short constructs like character references are never split.
+inline constexpr std::size_t stream_lookahead = 64;
+
+/// @brief Returns the position at which a construct that extends to the end of a window
+/// is split, leaving at least `stream_lookahead` code units (or all of `str`) for the next
+/// window.
+/// The position is never within a UTF-8 sequence.
+[[nodiscard]]
+std::size_t window_split_position(std::u8string_view str);
+
+/// @brief Highlights a window of an HTML document which is too large to be held in memory,
+/// resuming in `state` and updating `state` to the context in which the window is left.
+/// Long text, comments, attribute values, and raw text are split at the end of the window,
+/// whereas tag names, end tags, and other short constructs are left for the next window.
+/// The next window shall start with the unconsumed part of this window.
+///
+/// The tokens equal those of highlighting the document as a whole,
+/// except that tokens can be split at window boundaries,
+/// and that `<script>` and `<style>` contents are highlighted in pieces of whole lines.
+/// @param offset The position of `window` within the document,
+/// which is added to the positions of the tokens.
+/// @param final `true` iff `window` extends to the end of the document.
+/// @returns The amount of code units consumed from `window`.
+/// If `final` is `true`, this is the length of `window`.
+/// If this is zero and the window cannot be made larger,
+/// the window has to be highlighted as if it was `final`.
+std::size_t highlight_window(
+    Non_Owning_Buffer<Token>& out,
+    std::u8string_view window,
+    std::size_t offset,
+    Stream_State& state,
+    bool final,
+    std::pmr::memory_resource* memory,
+    const Highlight_Options& options
+);
+
 } // namespace ulight::html
 
 #endif
@@ -63,6 +63,14 @@ constexpr bool is_js_identifier_start(char32_t c) noexcept
     // clang-format on
 }
 
+/// @brief The ASCII subset of `is_js_identifier_start`, i.e. `[A-Za-z$_]`.
+inline constexpr Charset256 is_js_ascii_identifier_start_set
+    = is_ascii_alpha_set | detail::to_charset256(u8"$_");
+
+/// @brief The ASCII subset of `is_js_identifier_part`, i.e. `[A-Za-z0-9$_]`.
+inline constexpr Charset256 is_js_ascii_identifier_part_set
+    = is_js_ascii_identifier_start_set | is_ascii_digit_set;
+
 [[nodiscard]]
 constexpr bool is_js_identifier_part(char8_t c)
     = delete;
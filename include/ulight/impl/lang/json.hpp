@@ -1,9 +1,14 @@
 #ifndef ULIGHT_JSON_HPP
 #define ULIGHT_JSON_HPP
 
+#include <optional>
 #include <string_view>
 
+#include "ulight/json.hpp"
+
 #include "ulight/impl/platform.h"
+#include "ulight/impl/unicode.hpp"
+#include "ulight/impl/unicode_chars.hpp"
 
 #include "ulight/impl/lang/js.hpp"
 
@@ -69,12 +74,83 @@ enum struct Escape_Policy : bool {
 [[nodiscard]]
 Escape_Result match_escape_sequence(std::u8string_view str, Escape_Policy policy);
 
+/// @brief Encodes the code points of consecutive escape sequences as UTF-8.
+/// JSON represents code points outside the Basic Multilingual Plane as surrogate pairs,
+/// like `"\ud83d\ude00"` for U+1F600,
+/// so a leading surrogate is held back until the following escape sequence is known.
+/// Lone surrogates are replaced with U+FFFD REPLACEMENT CHARACTER,
+/// so the output is always valid UTF-8.
+struct Escape_Decoder {
+private:
+    char32_t m_leading_surrogate = 0;
+
+public:
+    [[nodiscard]]
+    constexpr Escape_Decoder() noexcept
+        = default;
+
+    /// @brief Resumes decoding with the state returned by `leading_surrogate()`.
+    [[nodiscard]]
+    constexpr explicit Escape_Decoder(char32_t leading_surrogate) noexcept
+        : m_leading_surrogate { leading_surrogate }
+    {
+    }
+
+    /// @brief Returns the leading surrogate which is held back, or zero if there is none.
+    [[nodiscard]]
+    constexpr char32_t leading_surrogate() const noexcept
+    {
+        return m_leading_surrogate;
+    }
+
+    /// @brief Decodes the `code_point` of an escape sequence,
+    /// and invokes `out` with the resulting code units, if any.
+    template <typename Out>
+    void push(char32_t code_point, Out&& out)
+    {
+        if (m_leading_surrogate != 0) {
+            if (is_trailing_surrogate(code_point)) {
+                const char32_t combined = 0x10000 + ((m_leading_surrogate - 0xD800) << 10)
+                    + (code_point - 0xDC00);
+                m_leading_surrogate = 0;
+                out(utf8::encode8_unchecked(combined).as_string());
+                return;
+            }
+            flush(out);
+        }
+        if (is_leading_surrogate(code_point)) {
+            m_leading_surrogate = code_point;
+            return;
+        }
+        const char32_t scalar
+            = is_surrogate(code_point) ? U'\N{REPLACEMENT CHARACTER}' : code_point;
+        out(utf8::encode8_unchecked(scalar).as_string());
+    }
+
+    /// @brief Invokes `out` with U+FFFD if a leading surrogate is held back.
+    /// This has to be called before anything other than an escape sequence,
+    /// and at the end of each string.
+    template <typename Out>
+    void flush(Out&& out)
+    {
+        if (m_leading_surrogate != 0) {
+            m_leading_surrogate = 0;
+            out(utf8::encode8_unchecked(U'\N{REPLACEMENT CHARACTER}').as_string());
+        }
+    }
+};
+
 [[nodiscard]]
 std::size_t match_digits(std::u8string_view str);
 
 [[nodiscard]]
 std::size_t match_whitespace(std::u8string_view str);
 
+enum struct String_Type : bool {
+    value,
+    property,
+};
+
 using js::Comment_Result;
 using js::match_block_comment;
 using js::match_line_comment;
@@ -111,6 +187,17 @@ struct Number_Result {
 [[nodiscard]]
 Number_Result match_number(std::u8string_view str);
 
+/// @brief Converts a number that was matched by `match_number` to `double`.
+/// @returns The value, or `std::nullopt` if the number could not be converted.
+[[nodiscard]]
+std::optional<double> parse_number_value(std::u8string_view number);
+
+/// @brief Converts a number that was matched by `match_number` to an integer.
+/// @returns The value, or `std::nullopt` if the number has a fractional part or exponent,
+/// is `-0`, or doesn't fit into `std::int64_t` or `std::uint64_t`.
+[[nodiscard]]
+std::optional<JSON_Integer> parse_integer_value(std::u8string_view number);
+
 } // namespace ulight::json
 
 #endif
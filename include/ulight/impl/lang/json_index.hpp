@@ -0,0 +1,140 @@
+#ifndef ULIGHT_JSON_INDEX_HPP
+#define ULIGHT_JSON_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ulight/json.hpp"
+
+namespace ulight::json {
+
+/// @brief The amount of code units covered by one `Block_Masks`.
+inline constexpr std::size_t index_block_size = 64;
+
+/// @brief Bitmasks which classify the code units in a block of up to 64 code units.
+/// Bit `i` of each mask corresponds to the code unit at offset `i` within the block.
+/// Bits past the end of a partial block are always zero.
+struct Block_Masks {
+    /// @brief `"`, `\`, and control characters (U+0000 to U+001F),
+    /// i.e. the code units which end a run of literal characters within a string.
+    std::uint64_t string_special;
+    /// @brief Whitespace, i.e. space, tab, form feed, line feed, and carriage return.
+    std::uint64_t whitespace;
+    /// @brief Line feeds.
+    std::uint64_t newline;
+    /// @brief `{`, `}`, `[`, `]`, and `/`,
+    /// i.e. the code units outside of strings which change the nesting depth or start comments.
+    std::uint64_t nesting;
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const Block_Masks&, const Block_Masks&)
+        = default;
+};
+
+/// @brief Classifies the code units in `block`.
+/// This uses SIMD instructions where available.
+/// @param block A block of at most `index_block_size` code units.
+[[nodiscard]]
+Block_Masks classify_block(std::u8string_view block);
+
+/// @brief A bitmask index over the entire source,
+/// computed in a single pass over blocks of 64 code units.
+/// This allows skipping whitespace and literal characters in strings,
+/// as well as computing line numbers, without inspecting every code unit again.
+struct Source_Index {
+private:
+    std::u8string_view m_source;
+    std::pmr::vector<Block_Masks> m_blocks;
+
+public:
+    [[nodiscard]]
+    Source_Index(std::u8string_view source, std::pmr::memory_resource* memory);
+
+    [[nodiscard]]
+    std::u8string_view source() const
+    {
+        return m_source;
+    }
+
+    [[nodiscard]]
+    std::span<const Block_Masks> blocks() const
+    {
+        return m_blocks;
+    }
+
+    /// @brief Returns the position of the first `"`, `\`, or control character
+    /// at or after `pos`, or `source().length()` if there is none.
+    [[nodiscard]]
+    std::size_t find_string_special(std::size_t pos) const;
+
+    /// @brief Returns the position of the first non-whitespace code unit
+    /// at or after `pos`, or `source().length()` if there is none.
+    [[nodiscard]]
+    std::size_t skip_whitespace(std::size_t pos) const;
+
+    /// @brief Returns the position of the first line feed
+    /// at or after `pos`, or `source().length()` if there is none.
+    [[nodiscard]]
+    std::size_t find_newline(std::size_t pos) const;
+};
+
+/// @brief Computes `Source_Position`s on demand from the newline masks in a `Source_Index`.
+/// Looking up positions in ascending order takes amortized constant time,
+/// because only the line feeds since the previous lookup need to be counted,
+/// and positions on the same line as the previous lookup need no counting at all.
+struct Line_Tracker {
+private:
+    const Source_Index& m_index;
+    /// @brief The code unit of the previous lookup.
+    std::size_t m_code_unit = 0;
+    /// @brief The position of the first line feed at or after `m_code_unit`,
+    /// or a lower bound thereof.
+    std::size_t m_next_newline = 0;
+    /// @brief The amount of line feeds prior to `m_code_unit`.
+    std::size_t m_line = 0;
+    /// @brief The position after the last line feed prior to `m_code_unit`.
+    std::size_t m_line_start = 0;
+
+public:
+    [[nodiscard]]
+    explicit Line_Tracker(const Source_Index& index)
+        : m_index { index }
+    {
+    }
+
+    /// @brief Returns the position of the code unit at `code_unit`.
+    /// @param code_unit The offset from the start of the source, at most `source().length()`.
+    [[nodiscard]]
+    Source_Position position(std::size_t code_unit)
+    {
+        if (code_unit >= m_code_unit && code_unit <= m_next_newline) {
+            return { .code_unit = code_unit,
+                     .line = m_line,
+                     .line_code_unit = code_unit - m_line_start };
+        }
+        return position_after_line_break(code_unit);
+    }
+
+private:
+    [[nodiscard]]
+    Source_Position position_after_line_break(std::size_t code_unit);
+};
+
+/// @brief Parses the single value which starts at `begin` within the source of `index`.
+/// Unlike `parse_json`, no whitespace is permitted before the value,
+/// and whatever follows the value is not inspected.
+/// The positions passed to `visitor` are relative to the start of the source.
+bool parse_json_value(
+    JSON_Visitor& visitor,
+    const Source_Index& index,
+    std::size_t begin,
+    JSON_Options options
+);
+
+} // namespace ulight::json
+
+#endif
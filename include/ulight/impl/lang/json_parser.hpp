@@ -0,0 +1,570 @@
+#ifndef ULIGHT_JSON_PARSER_IMPL_HPP
+#define ULIGHT_JSON_PARSER_IMPL_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "ulight/json.hpp"
+
+#include "ulight/impl/assert.hpp"
+#include "ulight/impl/unicode.hpp"
+
+#include "ulight/impl/lang/json.hpp"
+#include "ulight/impl/lang/json_chars.hpp"
+#include "ulight/impl/lang/json_index.hpp"
+
+namespace ulight::json {
+
+/// @brief A recursive descent JSON parser which invokes the member functions of `Visitor`.
+/// `Visitor` is typically `JSON_Visitor`, a type derived from it, or `JSON_Static_Visitor`.
+/// Since the member functions are called statically,
+/// they can be inlined unless `Visitor` is a polymorphic base class.
+template <typename Visitor>
+struct Parser {
+private:
+    Visitor& out;
+    const std::size_t source_length;
+    const JSON_Options options;
+    const Source_Index& source_index;
+    Line_Tracker lines { source_index };
+
+    std::u8string_view remainder;
+
+    /// @brief `true` iff any error occurred, including ones that were recovered from.
+    bool failed = false;
+    /// @brief The reaction of the visitor to the most recent error.
+    Error_Reaction reaction = Error_Reaction::abort;
+
+public:
+    /// @brief Constructs a parser which starts parsing at `begin` within the indexed source.
+    [[nodiscard]]
+    Parser(
+        Visitor& out,
+        const Source_Index& source_index,
+        std::size_t begin,
+        JSON_Options options
+    )
+        : out { out }
+        , source_length { source_index.source().length() }
+        , options { options }
+        , source_index { source_index }
+        , remainder { source_index.source().substr(begin) }
+    {
+    }
+
+    /// @brief Parses a whole JSON file, which is a single value surrounded by whitespace.
+    [[nodiscard]]
+    bool operator()()
+    {
+        if (!consume_whitespace_comments() || !consume_value() || !consume_whitespace_comments()) {
+            return false;
+        }
+        if (!remainder.empty()) {
+            error(JSON_Error::illegal_character);
+            return false;
+        }
+        return !failed;
+    }
+
+    /// @brief Parses a single value, which starts at the current position.
+    [[nodiscard]]
+    bool parse_value()
+    {
+        return consume_value() && !failed;
+    }
+
+private:
+    /// @brief The offset of `remainder` from the start of the source.
+    [[nodiscard]]
+    std::size_t index() const
+    {
+        return source_length - remainder.length();
+    }
+
+    /// @brief Returns the current position.
+    /// Line numbers are only computed when a visitor needs them, not during advancing.
+    [[nodiscard]]
+    Source_Position pos()
+    {
+        return lines.position(index());
+    }
+
+    void error(JSON_Error error)
+    {
+        failed = true;
+        reaction = out.error(pos(), error);
+    }
+
+    /// @brief To be called when parsing an element or member has failed.
+    /// If the visitor chose to recover from the error,
+    /// skips to the next `,`, `]`, or `}` which belongs to the enclosing array or object,
+    /// or to the end of the source.
+    /// @returns `true` if parsing can continue.
+    [[nodiscard]]
+    bool recover()
+    {
+        ULIGHT_DEBUG_ASSERT(failed);
+        if (reaction != Error_Reaction::recover) {
+            return false;
+        }
+        std::size_t depth = 0;
+        while (!remainder.empty()) {
+            switch (remainder[0]) {
+            case u8',': {
+                if (depth == 0) {
+                    return true;
+                }
+                break;
+            }
+            case u8'[':
+            case u8'{': {
+                ++depth;
+                break;
+            }
+            case u8']':
+            case u8'}': {
+                if (depth == 0) {
+                    return true;
+                }
+                --depth;
+                break;
+            }
+            case u8'"': {
+                skip_string();
+                continue;
+            }
+            case u8'/': {
+                if (options.allow_comments) {
+                    if (const std::size_t length = match_line_comment(remainder)) {
+                        advance(length);
+                        continue;
+                    }
+                    if (const Comment_Result block_comment = match_block_comment(remainder)) {
+                        advance(block_comment.length);
+                        continue;
+                    }
+                }
+                break;
+            }
+            default: break;
+            }
+            advance(1);
+        }
+        return true;
+    }
+
+    /// @brief Skips a possibly malformed string without invoking the visitor.
+    /// Besides a closing `"`, the string is also terminated by any control character,
+    /// since line breaks within strings are almost certainly a missing `"`.
+    void skip_string()
+    {
+        ULIGHT_DEBUG_ASSERT(remainder.starts_with(u8'"'));
+        advance(1);
+        while (true) {
+            advance(source_index.find_string_special(index()) - index());
+            if (remainder.empty()) {
+                return;
+            }
+            if (remainder[0] == u8'\\') {
+                advance(std::min(std::size_t(2), remainder.length()));
+                continue;
+            }
+            if (remainder[0] == u8'"') {
+                advance(1);
+            }
+            return;
+        }
+    }
+
+    void advance(std::size_t amount)
+    {
+        ULIGHT_DEBUG_ASSERT(amount <= remainder.length());
+        remainder.remove_prefix(amount);
+    }
+
+    void skip_whitespace()
+    {
+        // Most tokens are not preceded by whitespace, especially in minified JSON.
+        if (!remainder.empty() && is_json_whitespace(remainder[0])) {
+            advance(source_index.skip_whitespace(index()) - index());
+        }
+    }
+
+    [[nodiscard]]
+    bool consume_whitespace_comments()
+    {
+        if (!options.allow_comments) {
+            skip_whitespace();
+            return true;
+        }
+        while (true) {
+            skip_whitespace();
+            if (remainder.starts_with(u8"//")) {
+                if (!consume_line_comment()) {
+                    return false;
+                }
+                continue;
+            }
+            if (remainder.starts_with(u8"/*")) {
+                if (!consume_block_comment()) {
+                    return false;
+                }
+                continue;
+            }
+            break;
+        }
+        return true;
+    }
+
+    [[nodiscard]]
+    bool consume_line_comment()
+    {
+        if (const std::size_t length = match_line_comment(remainder)) {
+            out.line_comment(pos(), remainder.substr(0, length));
+            advance(length);
+            return true;
+        }
+        ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"// should have been tested.");
+        error(JSON_Error::error);
+        return false;
+    }
+
+    [[nodiscard]]
+    bool consume_block_comment()
+    {
+        if (const js::Comment_Result block_comment = match_block_comment(remainder)) {
+            if (!block_comment.is_terminated) {
+                error(JSON_Error::comment);
+                return false;
+            }
+            out.block_comment(pos(), remainder.substr(0, block_comment.length));
+            advance(block_comment.length);
+            return true;
+        }
+        ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"/* should have been tested.");
+        error(JSON_Error::error);
+        return false;
+    }
+
+    [[nodiscard]]
+    bool consume_value()
+    {
+        if (remainder.empty()) {
+            error(JSON_Error::error);
+            return false;
+        }
+        switch (remainder[0]) {
+        case u8'"': {
+            return consume_string(String_Type::value);
+        }
+        case u8'[': {
+            return consume_array();
+        }
+        case u8'{': {
+            return consume_object();
+        }
+        case u8'-':
+        case u8'0':
+        case u8'1':
+        case u8'2':
+        case u8'3':
+        case u8'4':
+        case u8'5':
+        case u8'6':
+        case u8'7':
+        case u8'8':
+        case u8'9': {
+            return consume_number();
+        }
+        case u8't': {
+            if (remainder.starts_with(u8"true")) {
+                out.boolean(pos(), true);
+                advance(4);
+                return true;
+            }
+            break;
+        }
+        case u8'f': {
+            if (remainder.starts_with(u8"false")) {
+                out.boolean(pos(), false);
+                advance(5);
+                return true;
+            }
+            break;
+        }
+        case u8'n': {
+            if (remainder.starts_with(u8"null")) {
+                out.null(pos());
+                advance(4);
+                return true;
+            }
+            break;
+        }
+        default: break;
+        }
+        error(JSON_Error::illegal_character);
+        return false;
+    }
+
+    [[nodiscard]]
+    bool consume_string(String_Type type)
+    {
+        if (!remainder.starts_with(u8'"')) {
+            ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"Should have checked for quotes already.");
+            return false;
+        }
+        if (type == String_Type::property) {
+            out.push_property(pos());
+        }
+        else {
+            out.push_string(pos());
+        }
+        std::size_t length = 0;
+        advance(1);
+
+        const auto flush = [&] {
+            if (length != 0) {
+                out.literal(pos(), remainder.substr(0, length));
+                advance(length);
+                length = 0;
+            }
+        };
+
+        while (true) {
+            // Literal characters are skipped in bulk using the index.
+            length = source_index.find_string_special(index()) - index();
+            if (length == remainder.length()) {
+                break;
+            }
+            switch (const char8_t c = remainder[length]) {
+            case u8'"': {
+                flush();
+                if (type == String_Type::property) {
+                    out.pop_property(pos());
+                }
+                else {
+                    out.pop_string(pos());
+                }
+                advance(1);
+                return true;
+            }
+            case u8'\\': {
+                flush();
+                if (!consume_escape()) {
+                    return false;
+                }
+                continue;
+            }
+            default: {
+                ULIGHT_DEBUG_ASSERT(c < 0x20);
+                flush();
+                error(JSON_Error::illegal_character);
+                return false;
+            }
+            }
+        }
+
+        error(JSON_Error::unterminated_string);
+        return false;
+    }
+
+    [[nodiscard]]
+    bool consume_escape()
+    {
+        const auto policy = options.escapes == Escape_Parsing::none ? Escape_Policy::match_only
+                                                                    : Escape_Policy::parse;
+        const Escape_Result escape = match_escape_sequence(remainder, policy);
+        if (!escape || escape.value == Escape_Result::no_value) {
+            error(JSON_Error::illegal_escape);
+            return false;
+        }
+
+        switch (options.escapes) {
+        case Escape_Parsing::none: //
+            out.escape(pos(), remainder.substr(0, escape.length));
+            break;
+        case Escape_Parsing::parse: //
+            out.escape(pos(), remainder.substr(0, escape.length), escape.value);
+            break;
+        case Escape_Parsing::parse_encode: {
+            const auto [code_units, length] = utf8::encode8_unchecked(escape.value);
+            const std::u8string_view encoded { code_units.data(), std::size_t(length) };
+            out.escape(pos(), remainder.substr(0, escape.length), escape.value, encoded);
+            break;
+        }
+        }
+
+        advance(escape.length);
+        return true;
+    }
+
+    [[nodiscard]]
+    bool consume_number()
+    {
+        const Number_Result number = match_number(remainder);
+        if (!number || number.erroneous) {
+            error(JSON_Error::illegal_number);
+            return false;
+        }
+
+        const std::u8string_view number_string = remainder.substr(0, number.length);
+        if (options.parse_integers && number.fraction == 0 && number.exponent == 0) {
+            if (const std::optional<JSON_Integer> value = parse_integer_value(number_string)) {
+                out.integer(pos(), number_string, *value);
+                advance(number.length);
+                return true;
+            }
+        }
+        if (options.parse_numbers) {
+            const std::optional<double> value = parse_number_value(number_string);
+            if (!value) {
+                error(JSON_Error::illegal_number);
+                return false;
+            }
+            out.number(pos(), number_string, *value);
+        }
+        else {
+            out.number(pos(), number_string);
+        }
+        advance(number.length);
+        return true;
+    }
+
+    [[nodiscard]]
+    bool consume_object()
+    {
+        if (!remainder.starts_with(u8'{')) {
+            ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"This should have been tested outside.");
+            error(JSON_Error::error);
+            return false;
+        }
+        out.push_object(pos());
+        advance(1);
+        return consume_elements(
+            u8'}', JSON_Error::unterminated_object, //
+            [&] { return consume_member(); }, //
+            [&] { out.pop_object(pos()); }
+        );
+    }
+
+    [[nodiscard]]
+    bool consume_member()
+    {
+        if (!remainder.starts_with(u8'"')) {
+            error(JSON_Error::illegal_character);
+            return false;
+        }
+        if (!consume_string(String_Type::property)) {
+            return false;
+        }
+
+        const auto at_end = [&] {
+            return remainder.empty() || remainder.starts_with(u8'}')
+                || remainder.starts_with(u8',');
+        };
+        if (!consume_whitespace_comments()) {
+            return false;
+        }
+        if (!remainder.starts_with(u8':')) {
+            error(JSON_Error::valueless_member);
+            return false;
+        }
+        advance(1);
+
+        if (!consume_whitespace_comments()) {
+            return false;
+        }
+        if (at_end()) {
+            error(JSON_Error::valueless_member);
+            return false;
+        }
+        return consume_value();
+    }
+
+    [[nodiscard]]
+    bool consume_array()
+    {
+        if (!remainder.starts_with(u8'[')) {
+            ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"This should have been tested outside.");
+            error(JSON_Error::error);
+            return false;
+        }
+        out.push_array(pos());
+        advance(1);
+        return consume_elements(
+            u8']', JSON_Error::unterminated_array, //
+            [&] { return consume_value(); }, //
+            [&] { out.pop_array(pos()); }
+        );
+    }
+
+    /// @brief Consumes the comma-separated elements of an array or members of an object,
+    /// followed by the closing bracket.
+    /// @param closing The closing bracket.
+    /// @param unterminated The error to report if the closing bracket is missing.
+    /// @param consume_element Consumes a single element or member,
+    /// and returns `true` on success.
+    /// @param pop Invokes the visitor for the closing bracket.
+    template <typename Consume, typename Pop>
+    [[nodiscard]]
+    bool consume_elements(
+        char8_t closing,
+        JSON_Error unterminated,
+        Consume consume_element,
+        Pop pop
+    )
+    {
+        bool first_element = true;
+        while (true) {
+            if (!consume_whitespace_comments() && !recover()) {
+                return false;
+            }
+            if (remainder.empty()) {
+                break;
+            }
+            if (remainder[0] == closing) {
+                pop();
+                advance(1);
+                return true;
+            }
+            if (remainder[0] == u8']' || remainder[0] == u8'}') {
+                // When recovering, we assume that a mismatched bracket was meant to close
+                // the current array or object, rather than some enclosing one.
+                error(JSON_Error::illegal_character);
+                if (reaction != Error_Reaction::recover) {
+                    return false;
+                }
+                pop();
+                advance(1);
+                return true;
+            }
+            if (first_element) {
+                first_element = false;
+            }
+            else if (remainder[0] == u8',') {
+                advance(1);
+                if (!consume_whitespace_comments() && !recover()) {
+                    return false;
+                }
+            }
+            else {
+                error(JSON_Error::illegal_character);
+                if (!recover()) {
+                    return false;
+                }
+                continue;
+            }
+            if (!consume_element() && !recover()) {
+                return false;
+            }
+        }
+
+        error(unterminated);
+        return false;
+    }
+};
+
+} // namespace ulight::json
+
+#endif
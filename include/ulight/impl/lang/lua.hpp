@@ -103,6 +103,22 @@ std::size_t match_whitespace(std::u8string_view str);
 [[nodiscard]]
 std::size_t match_non_whitespace(std::u8string_view str);
 
+/// @brief Returns the length of an opening long bracket like `[[` or `[==[`
+/// at the start of `str`, or zero if there is none.
+/// The level of the bracket (i.e. the amount of `=`) is the length minus two.
+[[nodiscard]]
+std::size_t match_opening_long_bracket(std::u8string_view str) noexcept;
+
+/// @brief Returns the position of the first closing long bracket of the given `level`
+/// (like `]]` for level zero or `]==]` for level two) in `str` at or after `start`,
+/// or `std::u8string_view::npos` if there is none.
+[[nodiscard]]
+std::size_t find_closing_long_bracket(
+    std::u8string_view str,
+    std::size_t level,
+    std::size_t start = 0
+) noexcept;
+
 struct Comment_Result {
     std::size_t length;
     bool is_terminated;
@@ -4,9 +4,31 @@
 #include <string_view>
 
 #include "ulight/impl/escapes.hpp"
+#include "ulight/impl/platform.h"
 
 namespace ulight::nasm {
 
+/// @brief The kind of keyword that an identifier is, if any.
+enum struct Keyword_Type : Underlying {
+    /// @brief The identifier is not a keyword.
+    none,
+    /// @brief A pseudo-instruction like `db` or `times`.
+    pseudo_instruction,
+    /// @brief A type (or size specifier) like `dword` or `ptr`.
+    type,
+    /// @brief An operator keyword like `seg` or `wrt`.
+    operator_keyword,
+    /// @brief A register like `eax` or `xmm0`.
+    register_,
+    /// @brief An instruction whose operand is a label, like `jmp` or `call`.
+    label_instruction,
+};
+
+/// @brief Classifies `name` as one of the keywords, ignoring ASCII case.
+/// This is a single probe into a perfect hash table.
+[[nodiscard]]
+Keyword_Type classify_keyword(std::u8string_view name) noexcept;
+
 [[nodiscard]]
 bool is_pseudo_instruction(std::u8string_view name) noexcept;
 
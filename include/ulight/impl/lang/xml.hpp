@@ -22,6 +22,37 @@ std::size_t match_whitespace(std::u8string_view str);
 [[nodiscard]]
 html::Match_Result match_comment(std::u8string_view str);
 
+/// @brief Matches a sequence of name characters (a `Nmtoken`) at the start of `str`
+/// and returns its length.
+[[nodiscard]]
+std::size_t match_nmtoken(std::u8string_view str);
+
+/// @brief Matches a name at the start of `str` and returns its length,
+/// or zero if `str` does not start with a name start character.
+[[nodiscard]]
+std::size_t match_name(std::u8string_view str);
+
+struct Qualified_Name {
+    /// @brief The namespace prefix, or an empty string if the name has no prefix.
+    std::u8string_view prefix;
+    std::u8string_view local_name;
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const Qualified_Name&, const Qualified_Name&)
+        = default;
+};
+
+/// @brief Splits a name like `xlink:href` into its namespace prefix and local name.
+/// Names without a colon, or where either part would be empty, have no prefix.
+[[nodiscard]]
+Qualified_Name split_qualified_name(std::u8string_view name);
+
+/// @brief Matches a DOCTYPE at the start of `str`, including its internal subset (if any).
+/// The DOCTYPE is terminated by the first `>` that is not within the internal subset,
+/// a literal, a comment, or a processing instruction.
+[[nodiscard]]
+html::Match_Result match_doctype(std::u8string_view str);
+
 /// @brief matches character data at the beginning of str.
 /// The character data that is being matched needs to be character
 /// data according to the XML standard i.e must not contain
@@ -29,5 +60,18 @@ html::Match_Result match_comment(std::u8string_view str);
 [[nodiscard]]
 std::size_t match_text(std::u8string_view str);
 
+/// @brief Highlights a window of an XML document which is too large to be held in memory.
+/// This works like `html::highlight_window`,
+/// except that XML has no raw text elements.
+std::size_t highlight_window(
+    Non_Owning_Buffer<Token>& out,
+    std::u8string_view window,
+    std::size_t offset,
+    html::Stream_State& state,
+    bool final,
+    std::pmr::memory_resource* memory,
+    const Highlight_Options& options
+);
+
 } // namespace ulight::xml
 #endif
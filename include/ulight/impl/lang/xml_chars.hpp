@@ -22,6 +22,28 @@ constexpr bool is_xml_whitespace(char32_t c) noexcept
     return is_ascii(c) && is_xml_whitespace(char8_t(c));
 }
 
+inline constexpr Charset256 is_xml_ascii_name_start_set
+    = is_ascii_alpha_set | detail::to_charset256(u8":_");
+
+/// @brief Returns true iff `c` is an ASCII name start character
+/// according to the XML standard.
+[[nodiscard]]
+constexpr bool is_xml_ascii_name_start(char8_t c) noexcept
+{
+    return is_xml_ascii_name_start_set.contains(c);
+}
+
+inline constexpr Charset256 is_xml_ascii_name_set
+    = is_xml_ascii_name_start_set | is_ascii_digit_set | detail::to_charset256(u8"-.");
+
+/// @brief Returns true iff `c` is an ASCII name character
+/// according to the XML standard.
+[[nodiscard]]
+constexpr bool is_xml_ascii_name(char8_t c) noexcept
+{
+    return is_xml_ascii_name_set.contains(c);
+}
+
 constexpr bool is_xml_name_start(char8_t c) = delete;
 
 /// @brief Returns true iff `c` is a name start character
@@ -56,7 +78,7 @@ constexpr bool is_xml_name(char32_t c) noexcept
     // https://www.w3.org/TR/REC-xml/#sec-common-syn
     return is_ascii_digit(c) //
         || is_xml_name_start(c) //
-        || c == U':' //
+        || c == U'-' //
         || c == U'.' //
         || c == U'\u00b7' //
         || (c >= U'\u0300' && c <= U'\u036f') //
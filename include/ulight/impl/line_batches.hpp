@@ -0,0 +1,185 @@
+#ifndef ULIGHT_LINE_BATCHES_HPP
+#define ULIGHT_LINE_BATCHES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "ulight/impl/platform.h"
+
+#ifndef ULIGHT_EMSCRIPTEN
+#include <barrier>
+#include <exception>
+#include <thread>
+#endif
+
+namespace ulight {
+
+/// @brief The default minimum amount of code units in a `Line_Batch`.
+/// Batches have to be large enough for the synchronization between threads to be negligible,
+/// but small enough for the results of a batch to be cheap to hold in memory.
+inline constexpr std::size_t default_line_batch_size = 256 * 1024;
+
+/// @brief Returns the amount of threads to use when `requested` threads are requested,
+/// where zero requests one thread per hardware thread.
+/// Without thread support (i.e. in WASM), the result is always one.
+[[nodiscard]]
+inline std::size_t resolve_thread_count(std::size_t requested)
+{
+#ifdef ULIGHT_EMSCRIPTEN
+    return 1;
+#else
+    if (requested == 0) {
+        return std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(1));
+    }
+    return requested;
+#endif
+}
+
+/// @brief A sequence of whole lines within a source.
+struct Line_Batch {
+    /// @brief The offset of the first code unit of the batch within the source.
+    std::size_t begin;
+    /// @brief The lines, including the line feed that terminates each line.
+    /// Only the last line of the source may be unterminated.
+    std::u8string_view lines;
+};
+
+/// @brief Returns the batch of lines which starts at `begin` within `source`.
+/// The batch consists of at least `batch_size` code units
+/// (unless the end of the source is reached first),
+/// and extends to the end of the line in which the minimum size is reached.
+/// `batch_size` shall be nonzero.
+[[nodiscard]]
+inline Line_Batch
+next_line_batch(std::u8string_view source, std::size_t begin, std::size_t batch_size)
+{
+    std::size_t end = source.length();
+    if (source.length() - begin > batch_size) {
+        const std::size_t newline = source.find(u8'\n', begin + batch_size - 1);
+        if (newline != std::u8string_view::npos) {
+            end = newline + 1;
+        }
+    }
+    return { .begin = begin, .lines = source.substr(begin, end - begin) };
+}
+
+/// @brief Splits `source` into batches of whole lines and processes them on up to `threads`
+/// threads, including the calling thread.
+/// `process(const Line_Batch&, Result&)` is invoked for each batch, possibly concurrently,
+/// and `deliver(const Line_Batch&, Result&)` is then invoked for each batch on the calling
+/// thread, in the order in which the batches appear in the source.
+/// Each thread reuses one `Result` object for all the batches it processes,
+/// so `process` is responsible for clearing it.
+///
+/// Batches are processed in rounds of `threads` batches,
+/// and the results of a round are delivered before the next round starts.
+/// This bounds the memory held by results regardless of the size of the source.
+/// If `process` throws, the exception is rethrown on the calling thread
+/// in place of delivering the batch.
+template <typename Result, typename Process, typename Deliver>
+void process_line_batches(
+    std::u8string_view source,
+    std::size_t threads,
+    Process process,
+    Deliver deliver,
+    std::size_t batch_size = default_line_batch_size
+)
+{
+    threads = resolve_thread_count(threads);
+    if (threads == 1) {
+        Result result {};
+        for (std::size_t begin = 0; begin < source.length();) {
+            const Line_Batch batch = next_line_batch(source, begin, batch_size);
+            process(batch, result);
+            deliver(batch, result);
+            begin += batch.lines.length();
+        }
+        return;
+    }
+
+#ifndef ULIGHT_EMSCRIPTEN
+    struct Slot {
+        Line_Batch batch;
+        Result result;
+        std::exception_ptr exception;
+    };
+    std::vector<Slot> slots(threads);
+    std::size_t active = 0;
+    bool done = false;
+
+    const auto process_slot = [&](Slot& slot) {
+#ifdef ULIGHT_EXCEPTIONS
+        try {
+            process(slot.batch, slot.result);
+        } catch (...) {
+            slot.exception = std::current_exception();
+        }
+#else
+        process(slot.batch, slot.result);
+#endif
+    };
+
+    // Every round is delimited by two phases of the barrier:
+    // in the first one, the calling thread has assigned batches to the slots,
+    // and in the second one, all threads have processed their slots.
+    std::barrier sync { std::ptrdiff_t(threads) };
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([&, i] {
+            while (true) {
+                sync.arrive_and_wait();
+                if (done) {
+                    return;
+                }
+                if (i < active) {
+                    process_slot(slots[i]);
+                }
+                sync.arrive_and_wait();
+            }
+        });
+    }
+
+    const auto run_rounds = [&] {
+        for (std::size_t begin = 0; begin < source.length();) {
+            for (active = 0; active < threads && begin < source.length(); ++active) {
+                slots[active].batch = next_line_batch(source, begin, batch_size);
+                begin += slots[active].batch.lines.length();
+            }
+            sync.arrive_and_wait();
+            process_slot(slots[0]);
+            sync.arrive_and_wait();
+            for (std::size_t i = 0; i < active; ++i) {
+                if (slots[i].exception) {
+                    std::rethrow_exception(slots[i].exception);
+                }
+                deliver(slots[i].batch, slots[i].result);
+            }
+        }
+    };
+    // At this point, and whenever run_rounds exits, all workers wait for the next round,
+    // so they can be stopped by letting them pass the barrier once more.
+    const auto stop_workers = [&] {
+        done = true;
+        sync.arrive_and_wait();
+    };
+
+#ifdef ULIGHT_EXCEPTIONS
+    try {
+        run_rounds();
+    } catch (...) {
+        stop_workers();
+        throw;
+    }
+#else
+    run_rounds();
+#endif
+    stop_workers();
+#endif
+}
+
+} // namespace ulight
+
+#endif
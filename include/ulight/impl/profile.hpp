@@ -0,0 +1,124 @@
+#ifndef ULIGHT_PROFILE_HPP
+#define ULIGHT_PROFILE_HPP
+
+#include "ulight/ulight.hpp"
+
+#include "ulight/impl/platform.h"
+
+#ifdef ULIGHT_PROFILE
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#if defined(ULIGHT_MSVC)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+// Wraps an expression which tries to match a highlighter rule, such as `expect_whitespace()`.
+// If ulight is built with `ULIGHT_PROFILE`, the amount of attempts, hits, and cycles spent
+// is recorded for every language `lang` and every call site,
+// and can be obtained with `ulight_profile_entries`.
+// Otherwise, this is simply equivalent to the given expression.
+//
+// The result of the expression is contextually converted to `bool` to decide whether the rule
+// has matched, if possible.
+// Rules returning `void` are considered to always match.
+#ifdef ULIGHT_PROFILE
+#define ULIGHT_PROFILE_RULE(lang, ...)                                                             \
+    (::ulight::profile_call(                                                                       \
+        []() -> ::ulight::Profile_Rule& {                                                          \
+            static ::ulight::Profile_Rule rule { #__VA_ARGS__ };                                   \
+            return rule;                                                                           \
+        }(),                                                                                       \
+        (lang), [&]() -> decltype(auto) { return __VA_ARGS__; }                                    \
+    ))
+#else
+#define ULIGHT_PROFILE_RULE(lang, ...) (__VA_ARGS__)
+#endif
+
+#ifdef ULIGHT_PROFILE
+namespace ulight {
+
+struct Profile_Counters {
+    std::atomic<std::size_t> attempts;
+    std::atomic<std::size_t> hits;
+    std::atomic<std::size_t> cycles;
+};
+
+/// @brief A single call site of `ULIGHT_PROFILE_RULE`,
+/// with counters for each language.
+/// All rules are registered in a global, intrusive, singly linked list upon construction,
+/// so they should only be created as static objects.
+struct Profile_Rule {
+    std::string_view name;
+    Profile_Counters counters[ULIGHT_LANG_COUNT] {};
+    Profile_Rule* next = nullptr;
+
+    explicit Profile_Rule(std::string_view name) noexcept;
+
+    Profile_Rule(const Profile_Rule&) = delete;
+    Profile_Rule& operator=(const Profile_Rule&) = delete;
+};
+
+/// @brief Returns the first element in the list of all `Profile_Rule`s,
+/// or `nullptr` if no rule has been registered yet.
+[[nodiscard]]
+Profile_Rule* profile_rules_head() noexcept;
+
+/// @brief Returns the current value of the CPU cycle counter,
+/// or the current time in nanoseconds if no cycle counter is available.
+[[nodiscard]]
+inline std::uint64_t profile_ticks() noexcept
+{
+#if defined(ULIGHT_MSVC) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__has_builtin) && __has_builtin(__builtin_readcyclecounter)
+    return __builtin_readcyclecounter();
+#else
+    return std::uint64_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+#endif
+}
+
+template <typename F>
+decltype(auto) profile_call(Profile_Rule& rule, Lang lang, F&& f)
+{
+    constexpr auto relaxed = std::memory_order::relaxed;
+    Profile_Counters& counters = rule.counters[std::size_t(lang)];
+
+    counters.attempts.fetch_add(1, relaxed);
+    const std::uint64_t start = profile_ticks();
+    if constexpr (std::is_void_v<std::invoke_result_t<F>>) {
+        f();
+        counters.cycles.fetch_add(std::size_t(profile_ticks() - start), relaxed);
+        counters.hits.fetch_add(1, relaxed);
+    }
+    else {
+        auto result = f();
+        counters.cycles.fetch_add(std::size_t(profile_ticks() - start), relaxed);
+        if constexpr (std::is_constructible_v<bool, const decltype(result)&>) {
+            if (result) {
+                counters.hits.fetch_add(1, relaxed);
+            }
+        }
+        else {
+            counters.hits.fetch_add(1, relaxed);
+        }
+        return result;
+    }
+}
+
+} // namespace ulight
+#endif
+
+#endif
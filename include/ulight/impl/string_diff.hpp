@@ -1,5 +1,5 @@
-#ifndef ULIGHT_DIFF_HPP
-#define ULIGHT_DIFF_HPP
+#ifndef ULIGHT_STRING_DIFF_HPP
+#define ULIGHT_STRING_DIFF_HPP
 
 #include "ulight/impl/platform.h"
 #if ULIGHT_CPP // suppress unused include warning
@@ -8,103 +8,54 @@
 #error This header should not be included in Emscripten builds.
 #endif
 
-#include <algorithm>
 #include <cstddef>
+#include <memory_resource>
 #include <ostream>
 #include <span>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "ulight/impl/ansi.hpp"
 #include "ulight/impl/assert.hpp"
+#include "ulight/impl/edit_script.hpp"
 #include "ulight/impl/strings.hpp"
 
 namespace ulight {
 
-enum struct Edit_Type : signed char {
-    /// @brief Delete an element in the source sequence.
-    /// Advance by one element in the source sequence.
-    del = -1,
-    /// @brief Keep the element in the source sequence.
-    /// Advance by one element in both sequences.
-    common = 0,
-    /// @brief Insert the element from the target sequence into the source sequence.
-    /// Advance by one element in the target sequence.
-    ins = 1,
-};
-
-/// @brief Uses the
-/// [Needleman-Wunsch algorithm](https://en.wikipedia.org/wiki/Needleman%E2%80%93Wunsch_algorithm)
-/// to compute the Shortest Edit Script to convert sequence `from` into sequence `to`.
-inline std::vector<Edit_Type> shortest_edit_script(
+/// @brief Computes the Shortest Edit Script to convert sequence `from` into sequence `to`,
+/// using `myers_edit_script`.
+/// Within each block of changes, deletions precede insertions.
+inline std::pmr::vector<Edit_Type> shortest_edit_script(
     std::span<const std::u8string_view> from,
-    std::span<const std::u8string_view> to
+    std::span<const std::u8string_view> to,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()
 )
 {
-    const std::size_t f_data_size = (from.size() + 1) * (to.size() + 1);
-    std::pmr::vector<std::size_t> f_data(f_data_size);
-    const auto F = [&](std::size_t i, std::size_t j) -> std::size_t& {
-        const std::size_t index = (i * (to.size() + 1)) + j;
-        ULIGHT_DEBUG_ASSERT(index < f_data.size());
-        return f_data[index];
-    };
-
-    for (std::size_t i = 0; i <= from.size(); ++i) {
-        F(i, 0) = i;
-    }
-    for (std::size_t j = 0; j <= to.size(); ++j) {
-        F(0, j) = j;
-    }
-    for (std::size_t i = 1; i <= from.size(); ++i) {
-        for (std::size_t j = 1; j <= to.size(); ++j) {
-            // The costs here are essentially the same as for Levenshtein distance computation,
-            // except that if the two strings mismatch at a given index,
-            // we consider the cost to be infinite.
-            // This way, the output is made of pure insertions and deletions;
-            // substitutions don't exist.
-            F(i, j) = std::min({
-                from[i - 1] == to[j - 1] ? F(i - 1, j - 1) : std::size_t(-1), // common
-                F(i - 1, j) + 1, // deletion
-                F(i, j - 1) + 1, // insertion
-            });
-        }
-    }
-
-    std::size_t i = from.size();
-    std::size_t j = to.size();
-
-    std::vector<Edit_Type> out;
-    while (i != 0 || j != 0) {
-        if (i != 0 && j != 0 && from[i - 1] == to[j - 1]) {
-            out.push_back(Edit_Type::common);
-            --i;
-            --j;
-        }
-        else if (i != 0 && F(i, j) == F(i - 1, j) + 1) {
-            out.push_back(Edit_Type::del);
-            --i;
-        }
-        else {
-            out.push_back(Edit_Type::ins);
-            --j;
-        }
-    }
+    std::pmr::vector<Edit_Type> out(memory);
+    myers_edit_script(out, from, to, memory);
+    group_edits(out);
+    return out;
+}
 
-    std::ranges::reverse(out);
-    auto it = out.begin();
-    while (it != out.end()) {
-        // Find the next block of insertions/deletions.
-        const auto next_mod_begin = std::ranges::find_if(it, out.end(), [](Edit_Type t) {
-            return t != Edit_Type::common;
-        });
-        const auto next_mod_end = std::ranges::find(next_mod_begin, out.end(), Edit_Type::common);
-        // Partition the block so that deletions all precede insertions.
-        std::ranges::partition(next_mod_begin, next_mod_end, [](Edit_Type t) {
-            return t == Edit_Type::del;
-        });
-        it = next_mod_end;
-    }
+/// @brief Computes an edit script to convert sequence `from` into sequence `to`,
+/// using `histogram_edit_script`.
+/// The result is not necessarily minimal,
+/// but typically more readable, and much cheaper to compute for large, different inputs.
+/// Within each block of changes, deletions precede insertions.
+inline std::pmr::vector<Edit_Type> readable_edit_script(
+    std::span<const std::u8string_view> from,
+    std::span<const std::u8string_view> to,
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()
+)
+{
+    // The cost limit only matters for regions without rare lines to anchor on,
+    // and keeps pathological inputs from taking quadratic time.
+    constexpr std::size_t max_cost = 1024;
 
+    std::pmr::vector<Edit_Type> out(memory);
+    histogram_edit_script(out, from, to, memory, max_cost);
+    group_edits(out);
     return out;
 }
 
@@ -148,40 +99,42 @@ print_diff_line(std::ostream& out, std::u8string_view line, std::string_view def
     }
 }
 
+/// @brief Prints the hunks of the diff between `from_lines` and `to_lines` in unified format,
+/// colored with ANSI escape sequences.
+/// @param context The amount of unchanged lines to print around each change.
 inline void print_diff(
     std::ostream& out,
     std::span<const std::u8string_view> from_lines,
-    std::span<const std::u8string_view> to_lines
+    std::span<const std::u8string_view> to_lines,
+    std::size_t context = 3
 )
 {
-    const std::vector<Edit_Type> edits = shortest_edit_script(from_lines, to_lines);
-    std::size_t from_index = 0;
-    std::size_t to_index = 0;
-    for (const auto e : edits) {
-        switch (e) {
-        case Edit_Type::common: {
-            out << ansi::h_black << ' ';
-            print_diff_line(out, from_lines[from_index], ansi::h_black);
-            out << '\n';
-            ++from_index;
-            ++to_index;
-            break;
-        }
-        case Edit_Type::del: {
-            out << ansi::h_red << '-';
-            print_diff_line(out, from_lines[from_index], ansi::h_red);
-            out << '\n';
-            ++from_index;
-            break;
-        }
-        case Edit_Type::ins: {
-            out << ansi::h_green << '+';
-            print_diff_line(out, to_lines[to_index], ansi::h_green);
-            out << '\n';
-            ++to_index;
-            break;
-        }
+    const std::pmr::vector<Edit_Type> edits = readable_edit_script(from_lines, to_lines);
+    std::pmr::u8string unified;
+    append_unified_diff(unified, from_lines, to_lines, edits, context);
+
+    // Every line of the unified diff is terminated by '\n',
+    // and its first code unit tells hunk headings, context, deletions, and insertions apart.
+    const auto formatting_of = [](std::u8string_view line) -> std::string_view {
+        switch (line.empty() ? u8' ' : line[0]) {
+        case u8'@': return ansi::h_cyan;
+        case u8'-': return ansi::h_red;
+        case u8'+': return ansi::h_green;
+        default: return ansi::h_black;
         }
+    };
+
+    std::u8string_view remainder = unified;
+    while (!remainder.empty()) {
+        const std::size_t line_length = remainder.find(u8'\n');
+        ULIGHT_ASSERT(line_length != std::u8string_view::npos);
+        const std::u8string_view line = remainder.substr(0, line_length);
+        remainder.remove_prefix(line_length + 1);
+
+        const std::string_view formatting = formatting_of(line);
+        out << formatting;
+        print_diff_line(out, line, formatting);
+        out << '\n';
     }
 }
 
@@ -0,0 +1,67 @@
+#ifndef ULIGHT_STRING_SEARCH_HPP
+#define ULIGHT_STRING_SEARCH_HPP
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace ulight {
+
+/// @brief Returns the position of the first code unit in `str` at or after `start`
+/// which is equal to `a` or `b`,
+/// or `std::u8string_view::npos` if there is none.
+///
+/// This is equivalent to `str.find_first_of`, but vectorized,
+/// which makes it suitable for skipping large amounts of text,
+/// like comments or raw text up to a terminator.
+[[nodiscard]]
+std::size_t
+find_either(std::u8string_view str, char8_t a, char8_t b, std::size_t start = 0) noexcept;
+
+/// @brief An inclusive range of code units.
+struct Code_Unit_Range {
+    char8_t min;
+    char8_t max;
+};
+
+/// @brief Returns the position of the first code unit in `str` at or after `start`
+/// which lies in none of the given `ranges`,
+/// or `std::u8string_view::npos` if there is none.
+///
+/// This is vectorized like `find_either`,
+/// which makes it suitable for skipping long runs of one class of code units,
+/// like identifiers or digits in minified code.
+[[nodiscard]]
+std::size_t find_first_not_in_ranges(
+    std::u8string_view str,
+    std::span<const Code_Unit_Range> ranges,
+    std::size_t start = 0
+) noexcept;
+
+/// @brief Returns the position of the first occurrence of `needle` in `haystack`
+/// at or after `start`,
+/// or `std::u8string_view::npos` if there is none.
+///
+/// This is equivalent to `haystack.find(needle, start)`, but vectorized by first filtering
+/// candidate positions by the first and last code unit of `needle`,
+/// which makes searching for terminators like `"-->"` or `"]]>"` run at memory bandwidth.
+[[nodiscard]]
+std::size_t find_substring(
+    std::u8string_view haystack,
+    std::u8string_view needle,
+    std::size_t start = 0
+) noexcept;
+
+/// @brief Like `find_substring`,
+/// but ignores any case differences between ASCII alphabetic characters.
+/// For example, this can find `"</script"` in `"</SCRIPT>"`.
+[[nodiscard]]
+std::size_t find_substring_ascii_ignore_case(
+    std::u8string_view haystack,
+    std::u8string_view needle,
+    std::size_t start = 0
+) noexcept;
+
+} // namespace ulight
+
+#endif
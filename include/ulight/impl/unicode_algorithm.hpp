@@ -5,6 +5,8 @@
 #include <string_view>
 #include <type_traits>
 
+#include "ulight/impl/ascii_chars.hpp"
+#include "ulight/impl/charset.hpp"
 #include "ulight/impl/unicode.hpp"
 
 namespace ulight::utf8 {
@@ -78,6 +80,41 @@ length_if_not(std::u8string_view str, F predicate) noexcept(noexcept(predicate(c
     return detail::find_if(str, predicate, true, str.length());
 }
 
+/// @brief Like `length_if`, but with a fast path for ASCII text.
+/// ASCII code units are classified using `ascii_set` without any decoding,
+/// and only non-ASCII code points are passed to `predicate`.
+/// For consistency with `length_if`, `ascii_set` has to contain exactly those
+/// ASCII characters for which `predicate` returns `true`.
+/// @param start The position in `str` at which matching starts, in code units.
+template <typename F>
+    requires std::is_invocable_r_v<bool, F, char32_t>
+[[nodiscard]]
+constexpr std::size_t length_if_likely_ascii(
+    std::u8string_view str,
+    const Charset256& ascii_set,
+    F predicate,
+    std::size_t start = 0
+) noexcept(noexcept(predicate(char32_t {})))
+{
+    std::size_t length = start;
+    while (length < str.length()) {
+        const char8_t c = str[length];
+        if (is_ascii(c)) [[likely]] {
+            if (!ascii_set.contains(c)) {
+                return length;
+            }
+            ++length;
+            continue;
+        }
+        const auto [code_point, units] = decode_and_length_or_replacement(str.substr(length));
+        if (!predicate(code_point)) {
+            return length;
+        }
+        length += std::size_t(units);
+    }
+    return length;
+}
+
 } // namespace ulight::utf8
 
 #endif
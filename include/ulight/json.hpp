@@ -2,6 +2,7 @@
 #define ULIGHT_JSON_PARSER_HPP
 
 #include "ulight/impl/platform.h"
+#include <cstdint>
 #include <string_view>
 
 namespace ulight {
@@ -40,11 +41,79 @@ enum struct JSON_Error : Underlying {
     valueless_member,
 };
 
+/// @brief The type of a JSON value.
+enum struct JSON_Type : Underlying {
+    null,
+    boolean,
+    number,
+    string,
+    array,
+    object,
+};
+
+/// @brief An integer which is exactly representable as `std::int64_t` or `std::uint64_t`.
+struct JSON_Integer {
+    /// @brief The absolute value.
+    std::uint64_t magnitude;
+    /// @brief If `true`, the integer is negative.
+    /// Negative integers are never zero, and their magnitude is at most `2^63`.
+    bool negative;
+
+    /// @brief Returns `true` iff the integer is representable as `std::int64_t`.
+    [[nodiscard]]
+    constexpr bool is_int64() const noexcept
+    {
+        return negative || magnitude <= std::uint64_t(INT64_MAX);
+    }
+
+    /// @brief Returns the integer as `std::int64_t`.
+    /// `is_int64()` shall be `true`.
+    [[nodiscard]]
+    constexpr std::int64_t as_int64() const noexcept
+    {
+        // Negating in unsigned arithmetic is well-defined, even for a magnitude of 2^63.
+        return negative ? std::int64_t(-magnitude) : std::int64_t(magnitude);
+    }
+
+    /// @brief Returns `true` iff the integer is representable as `std::uint64_t`.
+    [[nodiscard]]
+    constexpr bool is_uint64() const noexcept
+    {
+        return !negative;
+    }
+
+    /// @brief Returns the integer as `std::uint64_t`.
+    /// `is_uint64()` shall be `true`.
+    [[nodiscard]]
+    constexpr std::uint64_t as_uint64() const noexcept
+    {
+        return magnitude;
+    }
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const JSON_Integer&, const JSON_Integer&)
+        = default;
+};
+
+/// @brief The position and kind of an error which occurred during parsing.
+struct JSON_Error_Info {
+    Source_Position pos;
+    JSON_Error error;
+};
+
 enum struct Error_Reaction : Underlying {
     /// @brief On error, quit parsing.
     abort,
-    // There may be more values in the future here,
-    // like the option to attempt error recovery.
+    /// @brief On error, skip to the next `,`, `]`, or `}` which belongs to the enclosing
+    /// array or object, and continue parsing from there.
+    /// A mismatched closing bracket is treated as closing the enclosing array or object.
+    /// This allows reporting multiple errors in a single pass,
+    /// but parsing still fails in the end.
+    ///
+    /// The visitor has to tolerate incomplete values when recovering:
+    /// for example, `push_string` may not be followed by `pop_string`,
+    /// and `pop_property` may not be followed by a value.
+    recover,
 };
 
 ULIGHT_DIAGNOSTIC_PUSH()
@@ -114,6 +183,16 @@ struct JSON_Visitor {
     /// @param number The contents of the number.
     /// @param value The parsed value of the number.
     virtual void number(const Source_Position& pos, std::u8string_view number, double value) { }
+    /// @brief Invoked instead of `number` when an integer is matched
+    /// and the `parse_integers` option is `true`,
+    /// if the integer is exactly representable as `std::int64_t` or `std::uint64_t`.
+    /// The integer is converted directly, without going through `double`.
+    /// @param pos The position of the first character of the number.
+    /// @param number The contents of the number.
+    /// @param value The value of the number.
+    virtual void integer(const Source_Position& pos, std::u8string_view number, JSON_Integer value)
+    {
+    }
 
     /// @brief Invoked when `null` is matched.
     /// @param pos The position of the leading `n` character.
@@ -150,8 +229,19 @@ struct JSON_Visitor {
     /// @param pos The position of the closing `]` character.
     virtual void pop_array(const Source_Position& pos) { }
 
+    /// @brief Invoked by `parse_json_lines` when a record is entered.
+    /// @param pos The position of the first character of the line containing the record.
+    virtual void push_record(const Source_Position& pos) { }
+    /// @brief Invoked by `parse_json_lines` when a record is exited,
+    /// even if parsing the record failed.
+    /// @param pos The position of the line feed that terminates the record,
+    /// or the end of the source.
+    virtual void pop_record(const Source_Position& pos) { }
+
     /// @brief Invoked when a parse error occurs.
     /// @param pos The position of the character responsible for the error.
+    /// @returns Whether to abort parsing or to recover from the error.
+    /// `parse_json_lines` always aborts the record in which the error occurred.
     virtual Error_Reaction error([[maybe_unused]] const Source_Position& pos, JSON_Error error)
     {
         return Error_Reaction::abort;
@@ -176,7 +266,13 @@ struct JSON_Options {
     /// Otherwise, comments result in `JSON_Error::comment`.
     bool allow_comments : 1 = false;
     /// @brief If `true`, converts numbers to `double` within the parser.
+    /// Numbers without fraction and exponent which are too large for `std::int64_t`
+    /// are correctly rounded as well.
     bool parse_numbers : 1 = false;
+    /// @brief If `true`, integers (i.e. numbers without fraction and exponent)
+    /// which fit into `std::int64_t` or `std::uint64_t` are passed to `JSON_Visitor::integer`.
+    /// Other numbers are handled according to `parse_numbers`.
+    bool parse_integers : 1 = false;
     /// @brief How to handle escape sequences.
     Escape_Parsing escapes = Escape_Parsing::none;
 };
@@ -194,6 +290,37 @@ bool parse_json(JSON_Visitor& visitor, std::u8string_view source, JSON_Options o
 /// but taking `std::string_view` for compatibility.
 bool parse_json(JSON_Visitor& visitor, std::string_view source, JSON_Options options = {});
 
+/// @brief Options for parsing JSON Lines.
+struct JSON_Lines_Options {
+    /// @brief The options for parsing each record.
+    JSON_Options json;
+    /// @brief The maximum amount of threads on which records are parsed,
+    /// including the calling thread.
+    /// If zero, one thread per hardware thread is used.
+    std::size_t threads = 1;
+};
+
+/// @brief Parses JSON Lines (also known as NDJSON) found in `source`,
+/// i.e. a sequence of JSON values which are separated by line feeds.
+/// Lines that consist only of whitespace are skipped.
+///
+/// The source is split into batches of lines, which are parsed on up to `options.threads` threads.
+/// Regardless of the amount of threads,
+/// `visitor` is only invoked on the calling thread, and in the order of the source,
+/// with each record surrounded by `push_record` and `pop_record`.
+/// Errors are isolated to the record in which they occur:
+/// `JSON_Visitor::error` is invoked, parsing of that record is aborted,
+/// and parsing continues with the next record.
+/// @param visitor The visitor.
+/// @param source The contents of the source file.
+/// @param options Additional options.
+/// @returns `true` if every record was parsed successfully, else `false`.
+bool parse_json_lines(
+    JSON_Visitor& visitor,
+    std::u8string_view source,
+    const JSON_Lines_Options& options = {}
+);
+
 } // namespace ulight
 
 #endif
@@ -0,0 +1,301 @@
+#ifndef ULIGHT_JSON_CURSOR_HPP
+#define ULIGHT_JSON_CURSOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "ulight/json.hpp"
+
+namespace ulight {
+
+namespace json {
+struct Source_Index;
+} // namespace json
+
+struct JSON_On_Demand;
+struct JSON_Element_Iterator;
+struct JSON_Member_Iterator;
+struct JSON_Element_Range;
+struct JSON_Member_Range;
+
+/// @brief A lightweight handle to a value within a `JSON_On_Demand` document.
+/// Creating a cursor parses nothing;
+/// the value is only inspected once a member function such as `find` or `get_number` is called.
+/// Values which are not of interest are skipped by bracket matching over the bitmask index
+/// of the document, without tokenizing them.
+/// Skipped values are not validated; use `parse` to validate a value.
+///
+/// A default-constructed cursor refers to no value, and all lookups on it fail.
+/// Lookups which fail due to mismatched types, missing keys, or malformed JSON
+/// also return such a cursor.
+struct JSON_Cursor {
+private:
+    const JSON_On_Demand* m_document = nullptr;
+    std::size_t m_offset = 0;
+
+    friend JSON_Element_Iterator;
+    friend JSON_Member_Iterator;
+
+public:
+    [[nodiscard]]
+    constexpr JSON_Cursor() noexcept
+        = default;
+
+    [[nodiscard]]
+    constexpr JSON_Cursor(const JSON_On_Demand& document, std::size_t offset) noexcept
+        : m_document { &document }
+        , m_offset { offset }
+    {
+    }
+
+    [[nodiscard]]
+    constexpr explicit operator bool() const noexcept
+    {
+        return m_document != nullptr;
+    }
+
+    /// @brief Returns the offset of the first code unit of the value within the source.
+    [[nodiscard]]
+    constexpr std::size_t offset() const noexcept
+    {
+        return m_offset;
+    }
+
+    /// @brief Returns the type of the value, determined from its first code unit,
+    /// or `std::nullopt` if this cursor refers to no value or the value is malformed.
+    [[nodiscard]]
+    std::optional<JSON_Type> type() const;
+
+    /// @brief Returns the source code of the value, including quotes and brackets.
+    [[nodiscard]]
+    std::u8string_view raw() const;
+
+    /// @brief Returns the value of the first member of this object whose key equals `key`.
+    /// Keys are compared after decoding escape sequences,
+    /// and the values of preceding members are skipped.
+    [[nodiscard]]
+    JSON_Cursor find(std::u8string_view key) const;
+
+    /// @brief Returns the element at `index` in this array.
+    /// All preceding elements are skipped.
+    [[nodiscard]]
+    JSON_Cursor find(std::size_t index) const;
+
+    /// @brief Returns a range over the elements of this array.
+    [[nodiscard]]
+    JSON_Element_Range elements() const;
+
+    /// @brief Returns a range over the members of this object.
+    [[nodiscard]]
+    JSON_Member_Range members() const;
+
+    /// @brief Returns `true` iff this value is `null`.
+    [[nodiscard]]
+    bool is_null() const;
+
+    /// @brief Returns the value of this `true` or `false` literal, or `std::nullopt`.
+    [[nodiscard]]
+    std::optional<bool> get_boolean() const;
+
+    /// @brief Returns this number converted to `double`, or `std::nullopt`.
+    /// This conversion takes place regardless of `JSON_Options::parse_numbers`.
+    [[nodiscard]]
+    std::optional<double> get_number() const;
+
+    /// @brief Returns this number as an exact integer, or `std::nullopt`
+    /// if it is not a number, has a fraction or exponent,
+    /// or doesn't fit into `std::int64_t` or `std::uint64_t`.
+    [[nodiscard]]
+    std::optional<JSON_Integer> get_integer() const;
+
+    /// @brief Returns the contents of this string between the quotes,
+    /// with escape sequences left as is, or `std::nullopt`.
+    [[nodiscard]]
+    std::optional<std::u8string_view> get_raw_string() const;
+
+    /// @brief Appends the contents of this string to `out`.
+    /// Escape sequences are decoded unless `JSON_Options::escapes` is `Escape_Parsing::none`.
+    /// @returns `true` on success, or `false` if this is not a valid string.
+    bool get_string(std::u8string& out) const;
+
+    /// @brief Parses this value completely, invoking `visitor` like `parse_json` would.
+    /// The document options are used, and positions are relative to the start of the source.
+    /// @returns `true` if the value was parsed successfully, else `false`.
+    bool parse(JSON_Visitor& visitor) const;
+};
+
+/// @brief A key-value pair within an object.
+struct JSON_Member_Cursor {
+    /// @brief The key, which refers to a string.
+    JSON_Cursor key;
+    JSON_Cursor value;
+};
+
+/// @brief An iterator over the elements of an array.
+/// Advancing the iterator skips over the current element.
+struct JSON_Element_Iterator {
+    using value_type = JSON_Cursor;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    JSON_Cursor m_current;
+
+public:
+    [[nodiscard]]
+    constexpr JSON_Element_Iterator() noexcept
+        = default;
+
+    [[nodiscard]]
+    constexpr explicit JSON_Element_Iterator(JSON_Cursor current) noexcept
+        : m_current { current }
+    {
+    }
+
+    [[nodiscard]]
+    constexpr JSON_Cursor operator*() const noexcept
+    {
+        return m_current;
+    }
+
+    JSON_Element_Iterator& operator++();
+
+    JSON_Element_Iterator operator++(int)
+    {
+        JSON_Element_Iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const JSON_Element_Iterator& i, std::default_sentinel_t)
+    {
+        return !i.m_current;
+    }
+};
+
+/// @brief An iterator over the members of an object.
+/// Advancing the iterator skips over the value of the current member.
+struct JSON_Member_Iterator {
+    using value_type = JSON_Member_Cursor;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    JSON_Member_Cursor m_current;
+
+public:
+    [[nodiscard]]
+    constexpr JSON_Member_Iterator() noexcept
+        = default;
+
+    [[nodiscard]]
+    constexpr explicit JSON_Member_Iterator(JSON_Member_Cursor current) noexcept
+        : m_current { current }
+    {
+    }
+
+    [[nodiscard]]
+    constexpr JSON_Member_Cursor operator*() const noexcept
+    {
+        return m_current;
+    }
+
+    JSON_Member_Iterator& operator++();
+
+    JSON_Member_Iterator operator++(int)
+    {
+        JSON_Member_Iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const JSON_Member_Iterator& i, std::default_sentinel_t)
+    {
+        return !i.m_current.key;
+    }
+};
+
+struct JSON_Element_Range {
+    JSON_Element_Iterator first;
+
+    [[nodiscard]]
+    constexpr JSON_Element_Iterator begin() const noexcept
+    {
+        return first;
+    }
+
+    [[nodiscard]]
+    constexpr std::default_sentinel_t end() const noexcept
+    {
+        return {};
+    }
+};
+
+struct JSON_Member_Range {
+    JSON_Member_Iterator first;
+
+    [[nodiscard]]
+    constexpr JSON_Member_Iterator begin() const noexcept
+    {
+        return first;
+    }
+
+    [[nodiscard]]
+    constexpr std::default_sentinel_t end() const noexcept
+    {
+        return {};
+    }
+};
+
+/// @brief A JSON document which is parsed on demand through `JSON_Cursor`s.
+/// Upon construction, only a bitmask index over the source is computed,
+/// which allows skipping whitespace, strings, and whole subtrees quickly.
+/// This is useful when only a few values out of a large document are needed.
+///
+/// The source has to outlive the document, and the document has to outlive its cursors.
+struct JSON_On_Demand {
+private:
+    std::pmr::memory_resource* m_memory;
+    json::Source_Index* m_index = nullptr;
+    JSON_Options m_options;
+
+public:
+    [[nodiscard]]
+    explicit JSON_On_Demand(
+        std::u8string_view source,
+        JSON_Options options = {},
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource()
+    );
+
+    ~JSON_On_Demand();
+
+    JSON_On_Demand(const JSON_On_Demand&) = delete;
+    JSON_On_Demand& operator=(const JSON_On_Demand&) = delete;
+
+    [[nodiscard]]
+    std::u8string_view source() const noexcept;
+
+    [[nodiscard]]
+    const json::Source_Index& index() const noexcept
+    {
+        return *m_index;
+    }
+
+    [[nodiscard]]
+    JSON_Options options() const noexcept
+    {
+        return m_options;
+    }
+
+    /// @brief Returns a cursor to the root value, after any leading whitespace and comments.
+    [[nodiscard]]
+    JSON_Cursor root() const;
+};
+
+} // namespace ulight
+
+#endif
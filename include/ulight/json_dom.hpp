@@ -0,0 +1,252 @@
+#ifndef ULIGHT_JSON_DOM_HPP
+#define ULIGHT_JSON_DOM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+
+#include "ulight/json.hpp"
+
+#include "ulight/impl/assert.hpp"
+#include "ulight/impl/platform.h"
+
+namespace ulight {
+
+struct JSON_Member;
+
+/// @brief A node in a JSON document object model (DOM).
+/// Values are 16 bytes large and trivially copyable.
+/// Strings, array elements, and object members are not owned by the value;
+/// they are stored contiguously in the memory resource that the DOM was parsed into,
+/// or, for strings without escape sequences, they point into the source itself.
+struct JSON_Value {
+private:
+    JSON_Type m_type = JSON_Type::null;
+    bool m_boolean = false;
+    /// @brief The length of a string, or the amount of array elements or object members.
+    std::uint32_t m_size = 0;
+    union {
+        double m_number;
+        const char8_t* m_string;
+        const JSON_Value* m_elements;
+        const JSON_Member* m_members = nullptr;
+    };
+
+public:
+    /// @brief Constructs a `null` value.
+    [[nodiscard]]
+    constexpr JSON_Value() noexcept
+        = default;
+
+    [[nodiscard]]
+    static constexpr JSON_Value make_boolean(bool value) noexcept
+    {
+        JSON_Value result;
+        result.m_type = JSON_Type::boolean;
+        result.m_boolean = value;
+        return result;
+    }
+
+    [[nodiscard]]
+    static constexpr JSON_Value make_number(double value) noexcept
+    {
+        JSON_Value result;
+        result.m_type = JSON_Type::number;
+        result.m_number = value;
+        return result;
+    }
+
+    /// @brief Creates a string value which refers to `value`.
+    /// The length of `value` shall not exceed `max_size`.
+    [[nodiscard]]
+    static constexpr JSON_Value make_string(std::u8string_view value) noexcept
+    {
+        ULIGHT_DEBUG_ASSERT(value.length() <= max_size);
+        JSON_Value result;
+        result.m_type = JSON_Type::string;
+        result.m_size = std::uint32_t(value.length());
+        result.m_string = value.data();
+        return result;
+    }
+
+    /// @brief Creates an array value which refers to `elements`.
+    /// The size of `elements` shall not exceed `max_size`.
+    [[nodiscard]]
+    static constexpr JSON_Value make_array(std::span<const JSON_Value> elements) noexcept
+    {
+        ULIGHT_DEBUG_ASSERT(elements.size() <= max_size);
+        JSON_Value result;
+        result.m_type = JSON_Type::array;
+        result.m_size = std::uint32_t(elements.size());
+        result.m_elements = elements.data();
+        return result;
+    }
+
+    /// @brief Creates an object value which refers to `members`.
+    /// The size of `members` shall not exceed `max_size`.
+    [[nodiscard]]
+    static constexpr JSON_Value make_object(std::span<const JSON_Member> members) noexcept
+    {
+        ULIGHT_DEBUG_ASSERT(members.size() <= max_size);
+        JSON_Value result;
+        result.m_type = JSON_Type::object;
+        result.m_size = std::uint32_t(members.size());
+        result.m_members = members.data();
+        return result;
+    }
+
+    /// @brief The maximum length of strings, and the maximum amount of elements or members.
+    static constexpr std::size_t max_size = std::uint32_t(-1);
+
+    [[nodiscard]]
+    constexpr JSON_Type type() const noexcept
+    {
+        return m_type;
+    }
+
+    [[nodiscard]]
+    constexpr bool is_null() const noexcept
+    {
+        return m_type == JSON_Type::null;
+    }
+
+    [[nodiscard]]
+    constexpr bool as_boolean() const
+    {
+        ULIGHT_DEBUG_ASSERT(m_type == JSON_Type::boolean);
+        return m_boolean;
+    }
+
+    [[nodiscard]]
+    constexpr double as_number() const
+    {
+        ULIGHT_DEBUG_ASSERT(m_type == JSON_Type::number);
+        return m_number;
+    }
+
+    [[nodiscard]]
+    constexpr std::u8string_view as_string() const
+    {
+        ULIGHT_DEBUG_ASSERT(m_type == JSON_Type::string);
+        return { m_string, m_size };
+    }
+
+    [[nodiscard]]
+    constexpr std::span<const JSON_Value> as_array() const
+    {
+        ULIGHT_DEBUG_ASSERT(m_type == JSON_Type::array);
+        return { m_elements, m_size };
+    }
+
+    [[nodiscard]]
+    constexpr std::span<const JSON_Member> as_object() const;
+
+    /// @brief Returns the first member of this object whose key equals `key`,
+    /// or `nullptr` if there is no such member or if this value is not an object.
+    /// This is a linear search.
+    [[nodiscard]]
+    const JSON_Value* find(std::u8string_view key) const;
+
+    /// @brief Returns the element at `index`,
+    /// or `nullptr` if `index` is out of bounds or if this value is not an array.
+    [[nodiscard]]
+    const JSON_Value* find(std::size_t index) const;
+
+    /// @brief Resolves a JSON Pointer (RFC 6901) such as `/foo/0/bar~1baz`
+    /// relative to this value.
+    /// The empty pointer refers to this value itself.
+    /// @returns The referenced value,
+    /// or `nullptr` if the pointer is malformed or refers to no value.
+    [[nodiscard]]
+    const JSON_Value* find_pointer(std::u8string_view pointer) const;
+};
+
+static_assert(sizeof(JSON_Value) == 16);
+
+struct JSON_Member {
+    /// @brief The key, which is always a string.
+    JSON_Value key;
+    JSON_Value value;
+};
+
+// Defined out of line because `JSON_Member` needs to be complete.
+constexpr std::span<const JSON_Member> JSON_Value::as_object() const
+{
+    ULIGHT_DEBUG_ASSERT(m_type == JSON_Type::object);
+    return { m_members, m_size };
+}
+
+/// @brief Parses a JSON string found in `source` into a DOM.
+/// All arrays, objects, and strings containing escape sequences are allocated from `memory`,
+/// which is typically a `std::pmr::monotonic_buffer_resource`.
+/// The nodes are never deallocated individually,
+/// so the DOM lives as long as `memory` and `source` do.
+/// Numbers are always parsed as `double`, and escape sequences are always decoded,
+/// regardless of the `parse_numbers` and `escapes` options.
+/// @param out Receives the root value on success.
+/// @param source The contents of the source file.
+/// Strings without escape sequences refer directly to this source.
+/// @param memory The memory resource from which nodes are allocated.
+/// @param options Additional options.
+/// @param error If not null and parsing fails, receives the position and kind of the error.
+/// @returns `true` if the file was parsed successfully, else `false`.
+bool parse_json_dom(
+    JSON_Value& out,
+    std::u8string_view source,
+    std::pmr::memory_resource* memory,
+    JSON_Options options = {},
+    JSON_Error_Info* error = nullptr
+);
+
+/// @brief Like the overload taking `std::u8string_view`,
+/// but taking `std::string_view` for compatibility.
+bool parse_json_dom(
+    JSON_Value& out,
+    std::string_view source,
+    std::pmr::memory_resource* memory,
+    JSON_Options options = {},
+    JSON_Error_Info* error = nullptr
+);
+
+/// @brief A JSON DOM together with the monotonic arena that all its nodes are allocated in.
+/// Loading a document performs no per-node heap allocations;
+/// the arena requests memory from its upstream resource in geometrically growing chunks.
+struct JSON_Document {
+private:
+    std::pmr::monotonic_buffer_resource m_arena;
+    JSON_Value m_root;
+
+public:
+    [[nodiscard]]
+    explicit JSON_Document(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_arena { upstream }
+    {
+    }
+
+    /// @brief Parses `source` into this document,
+    /// releasing all memory held by a previously parsed document.
+    /// `source` has to outlive this document because strings may refer to it.
+    /// @returns `true` if the file was parsed successfully, else `false`.
+    bool parse(
+        std::u8string_view source,
+        JSON_Options options = {},
+        JSON_Error_Info* error = nullptr
+    )
+    {
+        m_root = {};
+        m_arena.release();
+        return parse_json_dom(m_root, source, &m_arena, options, error);
+    }
+
+    [[nodiscard]]
+    const JSON_Value& root() const noexcept
+    {
+        return m_root;
+    }
+};
+
+} // namespace ulight
+
+#endif
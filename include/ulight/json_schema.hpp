@@ -0,0 +1,259 @@
+#ifndef ULIGHT_JSON_SCHEMA_HPP
+#define ULIGHT_JSON_SCHEMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ulight/function_ref.hpp"
+#include "ulight/json.hpp"
+#include "ulight/json_dom.hpp"
+
+namespace ulight {
+
+struct JSON_Schema_Property;
+
+/// @brief A compiled subschema, which constrains a single value.
+/// All constraints are optional, and a default-constructed node accepts any value.
+struct JSON_Schema_Node {
+    /// @brief A bitmask of the permitted types, where bit `i` corresponds to `JSON_Type(i)`.
+    std::uint8_t types = all_types;
+    /// @brief If `true`, numbers are only permitted if they have no fractional part,
+    /// i.e. the type is `"integer"` rather than `"number"`.
+    bool integer = false;
+    /// @brief If `false`, object members whose key is not in `properties` are violations.
+    bool additional_properties = true;
+
+    /// @brief The inclusive range of permitted numbers.
+    double minimum = -std::numeric_limits<double>::infinity();
+    double maximum = std::numeric_limits<double>::infinity();
+    bool exclusive_minimum = false;
+    bool exclusive_maximum = false;
+
+    /// @brief The inclusive range of permitted amounts of array elements.
+    std::size_t min_items = 0;
+    std::size_t max_items = std::size_t(-1);
+    /// @brief The schema of all array elements, or null if unconstrained.
+    const JSON_Schema_Node* items = nullptr;
+
+    /// @brief The known object members, sorted by key.
+    std::span<const JSON_Schema_Property> properties;
+
+    /// @brief If not empty, values have to be equal to one of these.
+    /// Only `null`, booleans, numbers, and strings are supported.
+    std::span<const JSON_Value> enumeration;
+
+    static constexpr std::uint8_t all_types = (1 << 6) - 1;
+
+    [[nodiscard]]
+    static constexpr std::uint8_t type_bit(JSON_Type type) noexcept
+    {
+        return std::uint8_t(1 << int(type));
+    }
+
+    [[nodiscard]]
+    constexpr bool permits(JSON_Type type) const noexcept
+    {
+        return (types & type_bit(type)) != 0;
+    }
+};
+
+/// @brief A member of an object which has a schema or which is required.
+struct JSON_Schema_Property {
+    std::u8string_view key;
+    /// @brief The schema of the value, or null if unconstrained.
+    const JSON_Schema_Node* schema;
+    bool required;
+};
+
+/// @brief A compiled "JSON Schema lite", consisting of `JSON_Schema_Node`s.
+/// Schemas are compiled from JSON Schema documents,
+/// of which the following keywords are supported:
+/// `type`, `enum`, `const`, `minimum`, `maximum`, `exclusiveMinimum`, `exclusiveMaximum`,
+/// `items`, `minItems`, `maxItems`, `properties`, `required`,
+/// and `additionalProperties` (only `true` or `false`).
+/// Other keywords, such as `title` or `$schema`, are ignored.
+///
+/// All nodes and strings are allocated in an arena owned by the schema,
+/// so the schema does not refer to the document it was compiled from.
+struct JSON_Schema {
+private:
+    std::pmr::monotonic_buffer_resource m_arena;
+    JSON_Schema_Node m_root;
+
+public:
+    [[nodiscard]]
+    explicit JSON_Schema(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_arena { upstream }
+    {
+    }
+
+    JSON_Schema(const JSON_Schema&) = delete;
+    JSON_Schema& operator=(const JSON_Schema&) = delete;
+
+    /// @brief Compiles `schema` into this schema,
+    /// releasing all memory held by a previously compiled schema.
+    /// @returns `true` on success, or `false` if `schema` is malformed or uses
+    /// keywords in an unsupported way (e.g. `additionalProperties` with a subschema).
+    /// On failure, the schema accepts any value.
+    bool compile(const JSON_Value& schema);
+
+    [[nodiscard]]
+    const JSON_Schema_Node& root() const noexcept
+    {
+        return m_root;
+    }
+};
+
+enum struct JSON_Schema_Error : Underlying {
+    /// @brief The value is not of any permitted type.
+    type,
+    /// @brief The value is not one of the `enum` values.
+    enumeration,
+    /// @brief The number is below `minimum` or `exclusiveMinimum`.
+    minimum,
+    /// @brief The number is above `maximum` or `exclusiveMaximum`.
+    maximum,
+    /// @brief The array has fewer than `minItems` elements.
+    min_items,
+    /// @brief The array has more than `maxItems` elements.
+    max_items,
+    /// @brief A `required` member is missing from the object.
+    missing_property,
+    /// @brief A member is not in `properties`, and `additionalProperties` is `false`.
+    additional_property,
+};
+
+/// @brief A violation of a schema by a value.
+struct JSON_Schema_Violation {
+    /// @brief The position of the first character of the value,
+    /// or of the key for `additional_property`.
+    Source_Position pos;
+    JSON_Schema_Error error;
+    /// @brief For `missing_property` and `additional_property`, the key of the member.
+    /// This is only valid for the duration of the callback.
+    std::u8string_view property;
+};
+
+/// @brief A visitor which validates a JSON document against a schema while it is being parsed,
+/// without materializing the document.
+/// Violations are reported to a callback.
+///
+/// The validator can be fused with another pass over the document:
+/// if `next` is not null, all events are forwarded to it after validation,
+/// and the reaction to parse errors is determined by `next`.
+/// When used with `parse_json_lines`, every record is validated against the root schema.
+struct JSON_Schema_Validator final : JSON_Visitor {
+private:
+    struct Frame {
+        /// @brief The schema of the array or object, or null if unconstrained.
+        const JSON_Schema_Node* node;
+        Source_Position pos;
+        JSON_Type type;
+        /// @brief The amount of array elements so far.
+        std::size_t items = 0;
+        /// @brief The offset of the flags of this object in `m_seen_properties`.
+        std::size_t seen_begin = 0;
+        /// @brief The schema of the value of the current member, or null if unconstrained.
+        const JSON_Schema_Node* member_schema = nullptr;
+    };
+
+    const JSON_Schema_Node& m_root;
+    Function_Ref<void(const JSON_Schema_Violation&)> m_on_violation;
+    JSON_Visitor* m_next;
+
+    std::pmr::vector<Frame> m_frames;
+    /// @brief For every object in `m_frames`, one flag per property of its schema,
+    /// indicating whether the property has been encountered.
+    std::pmr::vector<bool> m_seen_properties;
+
+    /// @brief The contents of the current key or string, if they are needed.
+    std::pmr::u8string m_string;
+    bool m_collecting_string = false;
+    /// @brief The leading surrogate of an escaped surrogate pair within `m_string`,
+    /// which is held back until the next escape sequence, or zero.
+    char32_t m_leading_surrogate = 0;
+    /// @brief The schema of the current string value.
+    const JSON_Schema_Node* m_string_node = nullptr;
+    Source_Position m_string_pos {};
+
+    bool m_valid = true;
+
+public:
+    [[nodiscard]]
+    JSON_Schema_Validator(
+        const JSON_Schema& schema,
+        Function_Ref<void(const JSON_Schema_Violation&)> on_violation,
+        JSON_Visitor* next = nullptr,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource()
+    );
+
+    /// @brief Returns `true` iff no violations have been reported so far.
+    [[nodiscard]]
+    bool valid() const noexcept
+    {
+        return m_valid;
+    }
+
+    using JSON_Visitor::escape;
+    using JSON_Visitor::number;
+
+    void line_comment(const Source_Position& pos, std::u8string_view comment) final;
+    void block_comment(const Source_Position& pos, std::u8string_view comment) final;
+    void literal(const Source_Position& pos, std::u8string_view chars) final;
+    void escape(const Source_Position& pos, std::u8string_view escape) final;
+    void escape(const Source_Position& pos, std::u8string_view escape, char32_t code_point) final;
+    void escape(
+        const Source_Position& pos,
+        std::u8string_view escape,
+        char32_t code_point,
+        std::u8string_view code_units
+    ) final;
+    void number(const Source_Position& pos, std::u8string_view number) final;
+    void number(const Source_Position& pos, std::u8string_view number, double value) final;
+    void integer(const Source_Position& pos, std::u8string_view number, JSON_Integer value) final;
+    void null(const Source_Position& pos) final;
+    void boolean(const Source_Position& pos, bool value) final;
+    void push_string(const Source_Position& pos) final;
+    void pop_string(const Source_Position& pos) final;
+    void push_property(const Source_Position& pos) final;
+    void pop_property(const Source_Position& pos) final;
+    void push_object(const Source_Position& pos) final;
+    void pop_object(const Source_Position& pos) final;
+    void push_array(const Source_Position& pos) final;
+    void pop_array(const Source_Position& pos) final;
+    void push_record(const Source_Position& pos) final;
+    void pop_record(const Source_Position& pos) final;
+    Error_Reaction error(const Source_Position& pos, JSON_Error error) final;
+
+private:
+    [[nodiscard]]
+    const JSON_Schema_Node* begin_value(const Source_Position& pos, JSON_Type type);
+    void check_number(const JSON_Schema_Node* node, const Source_Position& pos, double value);
+    void append_code_point(char32_t code_point);
+    void flush_code_points();
+    void violation(
+        const Source_Position& pos,
+        JSON_Schema_Error error,
+        std::u8string_view property = {}
+    );
+};
+
+/// @brief Parses `source` and validates it against `schema` in a single pass.
+/// @param on_violation Invoked for every violation of the schema.
+/// @returns `true` iff `source` is well-formed and satisfies `schema`.
+bool validate_json(
+    std::u8string_view source,
+    const JSON_Schema& schema,
+    Function_Ref<void(const JSON_Schema_Violation&)> on_violation,
+    JSON_Options options = {}
+);
+
+} // namespace ulight
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef ULIGHT_JSON_STATIC_HPP
+#define ULIGHT_JSON_STATIC_HPP
+
+#include <memory_resource>
+#include <string_view>
+
+#include "ulight/json.hpp"
+
+#include "ulight/impl/platform.h"
+
+#include "ulight/impl/lang/json_index.hpp"
+#include "ulight/impl/lang/json_parser.hpp"
+
+namespace ulight {
+
+ULIGHT_DIAGNOSTIC_PUSH()
+ULIGHT_DIAGNOSTIC_IGNORED("-Wunused-parameter")
+// NOLINTBEGIN(misc-unused-parameters)
+
+/// @brief A base class for visitors which are passed to the `parse_json` template.
+/// It has the same member functions as `JSON_Visitor`, except that they are not virtual.
+/// Derived classes hide the member functions they are interested in,
+/// and the empty member functions of this class are inlined away for the rest.
+/// When hiding only some overloads of `escape` or `number`,
+/// the others need to be brought into scope with a using-declaration.
+/// See `JSON_Visitor` for the meaning of each member function.
+struct JSON_Static_Visitor {
+    void line_comment(const Source_Position& pos, std::u8string_view comment) { }
+    void block_comment(const Source_Position& pos, std::u8string_view comment) { }
+
+    void literal(const Source_Position& pos, std::u8string_view chars) { }
+    void escape(const Source_Position& pos, std::u8string_view escape) { }
+    void escape(const Source_Position& pos, std::u8string_view escape, char32_t code_point) { }
+    void escape(
+        const Source_Position& pos,
+        std::u8string_view escape,
+        char32_t code_point,
+        std::u8string_view code_units
+    )
+    {
+    }
+
+    void number(const Source_Position& pos, std::u8string_view number) { }
+    void number(const Source_Position& pos, std::u8string_view number, double value) { }
+    void integer(const Source_Position& pos, std::u8string_view number, JSON_Integer value) { }
+    void null(const Source_Position& pos) { }
+    void boolean(const Source_Position& pos, bool value) { }
+
+    void push_string(const Source_Position& pos) { }
+    void pop_string(const Source_Position& pos) { }
+    void push_property(const Source_Position& pos) { }
+    void pop_property(const Source_Position& pos) { }
+    void push_object(const Source_Position& pos) { }
+    void pop_object(const Source_Position& pos) { }
+    void push_array(const Source_Position& pos) { }
+    void pop_array(const Source_Position& pos) { }
+
+    Error_Reaction error(const Source_Position& pos, JSON_Error error)
+    {
+        return Error_Reaction::abort;
+    }
+};
+
+// NOLINTEND(misc-unused-parameters)
+ULIGHT_DIAGNOSTIC_POP()
+
+/// @brief Like the overload taking `JSON_Visitor&`,
+/// but calls the member functions of `visitor` statically rather than through virtual calls.
+/// This lets the compiler inline callbacks, and eliminate the ones that do nothing.
+/// `Visitor` is typically derived from `JSON_Static_Visitor`,
+/// but it may also be a `final` class derived from `JSON_Visitor`.
+/// @param visitor The visitor.
+/// @param source The contents of the source file.
+/// @param options Additional options.
+/// @param memory The memory resource from which the index over `source` is allocated.
+/// @returns `true` if the file was parsed successfully, else `false`.
+template <typename Visitor>
+bool parse_json(
+    Visitor& visitor,
+    std::u8string_view source,
+    JSON_Options options = {},
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource()
+)
+{
+    const json::Source_Index index { source, memory };
+    return json::Parser<Visitor> { visitor, index, 0, options }();
+}
+
+} // namespace ulight
+
+#endif
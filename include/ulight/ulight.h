@@ -54,7 +54,7 @@ typedef struct ulight_u8string_view {
 enum {
     /// @brief The amount of unique languages supported,
     /// including `ULIGHT_LANG_NONE`.
-    ULIGHT_LANG_COUNT = 17
+    ULIGHT_LANG_COUNT = 18
 };
 
 /// @brief A language supported by ulight for syntax highlighting.
@@ -79,6 +79,8 @@ typedef enum ulight_lang {
     ULIGHT_LANG_JSON = 10,
     /// @brief JSON with comments.
     ULIGHT_LANG_JSONC = 11,
+    /// @brief JSON Lines, also known as NDJSON (newline-delimited JSON).
+    ULIGHT_LANG_JSONL = 17,
     /// @brief LaTeX.
     ULIGHT_LANG_LATEX = 15,
     /// @brief Lua.
@@ -202,6 +204,19 @@ typedef enum ulight_flag {
     /// By default, ulight "over-extends" its highlighting a bit to provide better UX,
     /// rather than maximizing conformance.
     ULIGHT_STRICT = 2,
+    /// @brief Permit highlighting on multiple threads,
+    /// one per hardware thread.
+    /// This only affects languages which consist of independent records,
+    /// currently only JSON Lines.
+    /// Tokens are still flushed in order and only on the calling thread.
+    ULIGHT_PARALLEL = 4,
+    /// @brief In diffs, highlight the contents of each file with the language that is
+    /// determined from its path (see `ulight_lang_from_path`) in the `---` and `+++` headings.
+    /// Each line still begins with a token for its `+`, `-`, or space marker
+    /// that has the highlighting of the whole line (e.g. `ULIGHT_HL_DIFF_INSERTION`),
+    /// and that highlighting also applies to all code in the line
+    /// which is not covered by a token of the nested language.
+    ULIGHT_DIFF_LANGS = 8,
 } ulight_flag;
 
 // TOKENS
@@ -338,7 +353,9 @@ typedef enum ulight_highlight_type {
     /// such as a line preceded with `+`.
     ULIGHT_HL_DIFF_INSERTION = 0x84,
     /// @brief In diff, a modified line,
-    /// such as a line preceded with `!` in Context Format.
+    /// such as a line preceded with `!` in Context Format,
+    /// or the changed words within a paired deletion or insertion line
+    /// in Unified Format.
     ULIGHT_HL_DIFF_MODIFICATION = 0x85,
 
     // 0x88..0x8a Unused
@@ -596,6 +613,81 @@ ulight_status ulight_source_to_tokens(ulight_state* state) ULIGHT_NOEXCEPT;
 /// `state->flush_tokens` is automatically set.
 ulight_status ulight_source_to_html(ulight_state* state) ULIGHT_NOEXCEPT;
 
+/// @brief The state which `ulight_window_to_tokens` carries from one window of a document
+/// into the next.
+/// Before the first window, all members have to be zero.
+typedef struct ulight_window_state {
+    /// @brief The position of the current window within the document, in code units.
+    /// This is advanced by `ulight_window_to_tokens`.
+    size_t offset;
+    /// @brief The amount of code units of the last window
+    /// which were consumed by `ulight_window_to_tokens`.
+    size_t consumed;
+    /// @brief Provided by the caller.
+    /// Nonzero iff the current window extends to the end of the document.
+    unsigned char last;
+    /// @brief The construct which is open at the end of the last window.
+    /// This should not be modified by the caller.
+    unsigned char internal[3];
+} ulight_window_state;
+
+/// @brief Like `ulight_source_to_tokens`,
+/// but highlights `[state->source, state->source + state->source_length)`
+/// as one window of a document that is too large to be held in memory at once.
+/// Only `ULIGHT_LANG_HTML` and `ULIGHT_LANG_XML` are supported;
+/// for other languages, `ULIGHT_STATUS_BAD_LANG` is returned.
+///
+/// The positions of the tokens are relative to the start of the document.
+/// As much of the window is consumed as can be highlighted without seeing what follows,
+/// and `window->consumed` is set to that amount.
+/// The next window has to start with the unconsumed part of this window.
+/// If nothing was consumed, the next window has to be larger,
+/// or it has to be highlighted as the last window if that is not possible.
+///
+/// The tokens are the same as for `ulight_source_to_tokens` on the whole document,
+/// except that tokens can be split at window boundaries,
+/// and that `<script>` and `<style>` contents are highlighted in pieces of whole lines.
+ulight_status
+ulight_window_to_tokens(ulight_state* state, ulight_window_state* window) ULIGHT_NOEXCEPT;
+
+// PROFILING
+// =================================================================================================
+
+/// @brief Counters for a single rule (such as matching whitespace or a string literal)
+/// in the highlighter of some language.
+typedef struct ulight_profile_entry {
+    /// @brief The language for which the rule was used.
+    ulight_lang lang;
+    /// @brief The name of the rule, which is the source code of the instrumented expression.
+    /// The name is null-terminated.
+    const char* rule;
+    /// @brief The length of `rule`, in bytes.
+    size_t rule_length;
+    /// @brief The amount of times that the rule was tried.
+    size_t attempts;
+    /// @brief The amount of times that the rule has matched.
+    /// For rules that always match, this is equal to `attempts`.
+    size_t hits;
+    /// @brief The total amount of CPU cycles spent in the rule,
+    /// including the cycles of any nested rules.
+    /// On platforms without a cycle counter, this is measured in nanoseconds instead.
+    /// This value may wrap around on platforms where `size_t` is 32 bits.
+    size_t cycles;
+} ulight_profile_entry;
+
+/// @brief Writes up to `capacity` profile entries to `out`,
+/// and returns the total amount of entries that are available,
+/// which may be greater than `capacity`.
+/// Only rules that have been attempted at least once are reported.
+///
+/// Profiling data is only collected if ulight was built with `ULIGHT_PROFILE`.
+/// Otherwise, this function always returns zero.
+size_t ulight_profile_entries(ulight_profile_entry* out, size_t capacity) ULIGHT_NOEXCEPT;
+
+/// @brief Sets all profile counters to zero.
+/// If ulight was built without `ULIGHT_PROFILE`, this function does nothing.
+void ulight_profile_reset(void) ULIGHT_NOEXCEPT;
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,7 @@ enum struct Lang : Underlying {
     javascript = ULIGHT_LANG_JS,
     json = ULIGHT_LANG_JSON,
     jsonc = ULIGHT_LANG_JSONC,
+    jsonl = ULIGHT_LANG_JSONL,
     latex = ULIGHT_LANG_LATEX,
     lua = ULIGHT_LANG_LUA,
     nasm = ULIGHT_LANG_NASM,
@@ -97,6 +98,8 @@ enum struct Flag : Underlying {
     no_flags = ULIGHT_NO_FLAGS,
     coalesce = ULIGHT_COALESCE,
     strict = ULIGHT_STRICT,
+    parallel = ULIGHT_PARALLEL,
+    diff_langs = ULIGHT_DIFF_LANGS,
 };
 
 [[nodiscard]]
@@ -265,6 +268,7 @@ inline std::string_view highlight_type_id(Highlight_Type type) noexcept
 
 /// See `ulight_token`.
 using Token = ulight_token;
+using Window_State = ulight_window_state;
 
 /// See `ulight_alloc`.
 [[nodiscard]]
@@ -439,6 +443,13 @@ struct [[nodiscard]] State {
         return Status(ulight_source_to_html(&impl));
     }
 
+    /// See `ulight_window_to_tokens`.
+    [[nodiscard]]
+    Status window_to_tokens(Window_State& window) noexcept
+    {
+        return Status(ulight_window_to_tokens(&impl, &window));
+    }
+
     [[nodiscard]]
     std::string_view get_error_string() const noexcept
     {
@@ -454,6 +465,21 @@ struct [[nodiscard]] State {
 
 static_assert(std::is_trivially_copyable_v<State>);
 
+using Profile_Entry = ulight_profile_entry;
+
+/// See `ulight_profile_entries`.
+[[nodiscard]]
+inline std::size_t profile_entries(std::span<Profile_Entry> out) noexcept
+{
+    return ulight_profile_entries(out.data(), out.size());
+}
+
+/// See `ulight_profile_reset`.
+inline void profile_reset() noexcept
+{
+    ulight_profile_reset();
+}
+
 } // namespace ulight
 
 #endif
@@ -0,0 +1,158 @@
+#!/usr/bin/node
+"use strict";
+
+// Generates include/ulight/impl/unicode_xid_tables.hpp
+// from the ranges in include/ulight/impl/unicode_xid_ranges.hpp.
+//
+// The code point space is split into blocks of 256 code points.
+// The first stage maps each block to the index of a unique bitmap,
+// and the second stage contains the XID_Start and XID_Continue bitmaps of each unique block.
+// Classification is then O(1): one byte load, one word load, and a bit test.
+//
+// Usage: scripts/generate-xid-tables.js (from the repository root)
+
+const fs = require("fs");
+const path = require("path");
+
+const root = path.join(__dirname, "..");
+const rangesPath = path.join(root, "include/ulight/impl/unicode_xid_ranges.hpp");
+const outputPath = path.join(root, "include/ulight/impl/unicode_xid_tables.hpp");
+
+const blockShift = 8;
+const blockSize = 1 << blockShift;
+const wordsPerBlock = blockSize / 64;
+
+function parseRanges(source, name) {
+    const begin = source.indexOf(`${name}[] {`);
+    if (begin === -1) {
+        throw new Error(`Could not find ${name} in ${rangesPath}`);
+    }
+    const end = source.indexOf("};", begin);
+    const body = source.substring(begin, end);
+    return [...body.matchAll(/\{\s*(0x[0-9A-Fa-f]+)\s*,\s*(0x[0-9A-Fa-f]+)\s*\}/g)]
+        .map(([, min, max]) => [Number(min), Number(max)]);
+}
+
+function toBitmap(ranges, limit) {
+    const result = new Uint8Array(limit);
+    for (const [min, max] of ranges) {
+        result.fill(1, min, max + 1);
+    }
+    return result;
+}
+
+function blockWords(bitmap, block) {
+    const words = [];
+    for (let w = 0; w < wordsPerBlock; ++w) {
+        let word = 0n;
+        for (let bit = 63; bit >= 0; --bit) {
+            word = (word << 1n) | BigInt(bitmap[block * blockSize + w * 64 + bit]);
+        }
+        words.push(word);
+    }
+    return words;
+}
+
+function hex64(word) {
+    return "0x" + word.toString(16).padStart(16, "0");
+}
+
+function wrap(items, indent, width = 100) {
+    const lines = [];
+    let line = indent;
+    for (const item of items) {
+        const piece = item + ",";
+        if (line.length + piece.length + 1 > width && line !== indent) {
+            lines.push(line.trimEnd());
+            line = indent;
+        }
+        line += piece + " ";
+    }
+    if (line !== indent) {
+        lines.push(line.trimEnd());
+    }
+    return lines.join("\n");
+}
+
+const source = fs.readFileSync(rangesPath, "utf8");
+const startRanges = parseRanges(source, "XID_Start_Ranges");
+const continueRanges = parseRanges(source, "XID_Continue_Minus_XID_Start");
+
+const maxCodePoint = Math.max(...startRanges.concat(continueRanges).map(([, max]) => max));
+const blockCount = (maxCodePoint >> blockShift) + 1;
+const limit = blockCount * blockSize;
+
+const start = toBitmap(startRanges, limit);
+const cont = toBitmap(continueRanges, limit);
+for (let c = 0; c < limit; ++c) {
+    cont[c] |= start[c];
+}
+
+const uniqueBlocks = new Map();
+const startBlocks = [];
+const continueBlocks = [];
+const blockIndices = [];
+for (let block = 0; block < blockCount; ++block) {
+    const startWords = blockWords(start, block);
+    const continueWords = blockWords(cont, block);
+    const key = startWords.concat(continueWords).join(",");
+    if (!uniqueBlocks.has(key)) {
+        uniqueBlocks.set(key, uniqueBlocks.size);
+        startBlocks.push(startWords);
+        continueBlocks.push(continueWords);
+    }
+    blockIndices.push(uniqueBlocks.get(key));
+}
+if (uniqueBlocks.size > 256) {
+    throw new Error("Too many unique blocks for 8-bit indices.");
+}
+
+const formatBlocks = blocks =>
+    blocks.map(words => `    { ${words.map(hex64).join(", ")} },`).join("\n");
+
+const output = `// This file was generated by scripts/generate-xid-tables.js. Do not edit it manually.
+#ifndef ULIGHT_UNICODE_XID_TABLES_HPP
+#define ULIGHT_UNICODE_XID_TABLES_HPP
+
+#include <cstdint>
+
+namespace ulight::detail {
+
+// clang-format off
+
+/// @brief All code points at or above this limit have neither XID_Start nor XID_Continue.
+inline constexpr char32_t xid_limit = 0x${limit.toString(16).toUpperCase()};
+
+/// @brief The amount of bits that a code point is shifted by to obtain its block.
+inline constexpr int xid_block_shift = ${blockShift};
+
+/// @brief For each block of ${blockSize} code points,
+/// the index into \`xid_start_blocks\` and \`xid_continue_blocks\`.
+inline constexpr std::uint8_t xid_block_indices[${blockCount}] {
+${wrap(blockIndices.map(String), "    ")}
+};
+
+/// @brief For each unique block, a bitmap where bit \`i\` is set
+/// iff the \`i\`-th code point in the block has the XID_Start property.
+inline constexpr std::uint64_t xid_start_blocks[${startBlocks.length}][${wordsPerBlock}] {
+${formatBlocks(startBlocks)}
+};
+
+/// @brief For each unique block, a bitmap where bit \`i\` is set
+/// iff the \`i\`-th code point in the block has the XID_Continue property.
+inline constexpr std::uint64_t xid_continue_blocks[${continueBlocks.length}][${wordsPerBlock}] {
+${formatBlocks(continueBlocks)}
+};
+
+// clang-format on
+
+} // namespace ulight::detail
+
+#endif
+`;
+
+fs.writeFileSync(outputPath, output);
+console.log(
+    `Wrote ${outputPath}: ${blockCount} blocks, ${uniqueBlocks.size} unique, `
+        + `${blockCount + uniqueBlocks.size * wordsPerBlock * 8 * 2} bytes`
+);
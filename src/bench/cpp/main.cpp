@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "ulight/ulight.hpp"
+
+namespace ulight {
+namespace {
+
+[[nodiscard]]
+std::u8string repeat(std::u8string_view str, std::size_t n)
+{
+    std::u8string result;
+    result.reserve(str.length() * n);
+    for (std::size_t i = 0; i < n; ++i) {
+        result += str;
+    }
+    return result;
+}
+
+/// @brief Returns the fastest time out of several runs to highlight `source` in `lang`.
+[[nodiscard]]
+std::chrono::steady_clock::duration time_highlighting(std::u8string_view source, Lang lang)
+{
+    Token token_buffer[1024];
+    State state;
+    state.set_source(source);
+    state.set_lang(lang);
+    state.set_token_buffer(token_buffer);
+    const auto flush = [](Token*, std::size_t) { };
+    state.on_flush_tokens(flush);
+
+    auto best = std::chrono::steady_clock::duration::max();
+    for (int i = 0; i < 3; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (state.source_to_tokens() != Status::ok) {
+            std::fputs("Highlighting failed.\n", stderr);
+        }
+        best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+    return best;
+}
+
+struct Nesting_Case {
+    const char* name;
+    std::u8string (*generate)(std::size_t depth);
+};
+
+/// @brief Each of these nests braces within templates or JSX to the given depth.
+/// Rescanning nested code would make the time grow faster than the depth.
+constexpr Nesting_Case js_nesting_cases[] {
+    { "template substitutions",
+      [](std::size_t depth) {
+          return repeat(u8"`${", depth) + u8"x" + repeat(u8"}`", depth);
+      } },
+    { "JSX attributes",
+      [](std::size_t depth) {
+          return u8"x = " + repeat(u8"<a b={", depth) + u8"0" + repeat(u8"} />", depth);
+      } },
+    { "JSX children",
+      [](std::size_t depth) {
+          return u8"x = " + repeat(u8"<a>{", depth) + u8"0" + repeat(u8"}</a>", depth);
+      } },
+    { "unterminated JSX attributes",
+      [](std::size_t depth) { return u8"x" + repeat(u8"<y z={", depth); } },
+};
+
+void bench_js_nesting()
+{
+    constexpr std::size_t small_depth = 2000;
+    constexpr std::size_t large_depth = small_depth * 16;
+    std::printf(
+        "JS nesting, depth %zu vs. %zu (linear: 16x, quadratic: 256x)\n", small_depth,
+        large_depth
+    );
+    for (const Nesting_Case& c : js_nesting_cases) {
+        const auto small_time = time_highlighting(c.generate(small_depth), Lang::javascript);
+        const auto large_time = time_highlighting(c.generate(large_depth), Lang::javascript);
+        const double factor = double(large_time.count()) / double(small_time.count() + 1);
+        std::printf("  %-28s %8.1fx\n", c.name, factor);
+    }
+}
+
+/// @brief A generated document whose highlighting throughput is measured.
+struct Throughput_Case {
+    const char* name;
+    Lang lang;
+    /// @brief Returns a document of roughly `size` code units.
+    std::u8string (*generate)(std::size_t size);
+};
+
+void bench_throughput(const char* title, std::span<const Throughput_Case> cases, std::size_t size)
+{
+    std::printf("%s, %zu MB each\n", title, size / 1'000'000);
+    for (const Throughput_Case& c : cases) {
+        const std::u8string source = c.generate(size);
+        const auto time = time_highlighting(source, c.lang);
+        const double seconds = std::chrono::duration<double>(time).count();
+        std::printf("  %-28s %8.0f MB/s\n", c.name, double(source.length()) / seconds / 1e6);
+    }
+}
+
+/// @brief Asset-style Lua files, which mostly consist of long brackets.
+constexpr Throughput_Case lua_asset_cases[] {
+    { "base64 in [==[...]==]", Lang::lua,
+      [](std::size_t size) {
+          constexpr std::u8string_view alphabet
+              = u8"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+          constexpr std::size_t sprites = 8;
+          std::u8string result = u8"return {\n";
+          std::uint32_t seed = 1;
+          for (std::size_t s = 0; s < sprites; ++s) {
+              result += u8"  sprite_";
+              result += char8_t(u8'a' + s);
+              result += u8" = [==[\n";
+              for (std::size_t i = 0; i < size / sprites; ++i) {
+                  seed = (seed * 1103515245) + 12345;
+                  result += alphabet[(seed >> 16) & 63];
+                  if (i % 76 == 75) {
+                      result += u8'\n';
+                  }
+              }
+              result += u8"]==],\n";
+          }
+          result += u8"}\n";
+          return result;
+      } },
+    { "]-heavy long comment", Lang::lua,
+      [](std::size_t size) {
+          std::u8string result = u8"--[=[\n";
+          while (result.length() < size) {
+              result += u8"tiles[1][2] = map[x][y]; -- ]] inside a level-1 comment\n";
+          }
+          result += u8"]=]\n";
+          return result;
+      } },
+};
+
+/// @brief Large XML documents with namespace prefixes, hyphenated names, and a DTD.
+constexpr Throughput_Case xml_cases[] {
+    { "SVG", Lang::xml,
+      [](std::size_t size) {
+          std::u8string result = u8R"(<?xml version="1.0"?>
+<svg xmlns="http://www.w3.org/2000/svg" xmlns:xlink="http://www.w3.org/1999/xlink")"
+              u8R"( xmlns:inkscape="http://www.inkscape.org/namespaces/inkscape">
+)";
+          while (result.length() < size) {
+              result += u8R"(  <path inkscape:label="layer" stroke-width="1.5" fill-opacity="0.8")"
+                  u8R"( d="M 10 20 L 30 40 C 50 60 70 80 90 100 Z" xlink:href="#grad"/>
+  <svg:text font-family="sans-serif" x="10" y="20">Label &amp; text</svg:text>
+)";
+          }
+          result += u8"</svg>\n";
+          return result;
+      } },
+    { "XSD", Lang::xml,
+      [](std::size_t size) {
+          std::u8string result = u8R"(<?xml version="1.0"?>
+<!DOCTYPE xs:schema [
+<!ENTITY foo "bar">
+]>
+<xs:schema xmlns:xs="http://www.w3.org/2001/XMLSchema">
+)";
+          while (result.length() < size) {
+              result += u8R"(  <xs:element name="item" type="xs:string")"
+                  u8R"( minOccurs="0" maxOccurs="unbounded">
+    <xs:annotation><xs:documentation>Some documentation text for the item.)"
+                  u8R"(</xs:documentation></xs:annotation>
+  </xs:element>
+)";
+          }
+          result += u8"</xs:schema>\n";
+          return result;
+      } },
+};
+
+} // namespace
+} // namespace ulight
+
+int main()
+{
+    ulight::bench_js_nesting();
+    ulight::bench_throughput("Lua assets", ulight::lua_asset_cases, 8'000'000);
+    ulight::bench_throughput("XML", ulight::xml_cases, 20'000'000);
+}
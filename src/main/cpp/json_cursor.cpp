@@ -0,0 +1,492 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "ulight/json.hpp"
+#include "ulight/json_cursor.hpp"
+
+#include "ulight/impl/assert.hpp"
+
+#include "ulight/impl/lang/json.hpp"
+#include "ulight/impl/lang/json_index.hpp"
+
+namespace ulight {
+namespace {
+
+/// @brief Scans over the source of a `JSON_On_Demand` document without tokenizing it.
+/// All functions take and return offsets within the source,
+/// where `source.length()` indicates that the end was reached.
+struct Scanner {
+    const json::Source_Index& index;
+    const std::u8string_view source;
+    const bool allow_comments;
+
+    [[nodiscard]]
+    explicit Scanner(const JSON_On_Demand& document)
+        : index { document.index() }
+        , source { document.source() }
+        , allow_comments { document.options().allow_comments }
+    {
+    }
+
+    [[nodiscard]]
+    bool at(std::size_t pos, char8_t c) const
+    {
+        return pos < source.length() && source[pos] == c;
+    }
+
+    /// @brief Skips a comment starting at `pos`, or returns `pos` if there is none.
+    /// Comments are matched exactly like the parser matches them,
+    /// so line comments also end at other line terminators than line feeds.
+    [[nodiscard]]
+    std::size_t skip_comment(std::size_t pos) const
+    {
+        const std::u8string_view remainder = source.substr(pos);
+        if (const std::size_t length = json::match_line_comment(remainder)) {
+            return pos + length;
+        }
+        return pos + json::match_block_comment(remainder).length;
+    }
+
+    [[nodiscard]]
+    std::size_t skip_whitespace_comments(std::size_t pos) const
+    {
+        while (true) {
+            pos = index.skip_whitespace(pos);
+            if (!allow_comments) {
+                return pos;
+            }
+            const std::size_t comment_end = skip_comment(pos);
+            if (comment_end == pos) {
+                return pos;
+            }
+            pos = comment_end;
+        }
+    }
+
+    /// @brief Skips the rest of a string, where `pos` is just past the opening `"`.
+    /// @returns The position just past the closing `"`.
+    [[nodiscard]]
+    std::size_t skip_string(std::size_t pos) const
+    {
+        while (true) {
+            pos = index.find_string_special(pos);
+            if (pos == source.length()) {
+                return pos;
+            }
+            switch (source[pos]) {
+            case u8'"': return pos + 1;
+            case u8'\\': pos = std::min(pos + 2, source.length()); break;
+            default: ++pos; break;
+            }
+        }
+    }
+
+    /// @brief Skips an array or object by bracket matching, where `pos` is just past the opening
+    /// bracket.
+    /// The masks of the index are scanned block by block,
+    /// and only the code units in the `nesting` and `string_special` masks are visited.
+    /// Within strings, only the `string_special` mask is relevant.
+    /// @returns The position just past the closing bracket.
+    [[nodiscard]]
+    std::size_t skip_container(std::size_t pos) const
+    {
+        const std::span<const json::Block_Masks> blocks = index.blocks();
+        std::size_t depth = 1;
+        bool in_string = false;
+        while (true) {
+            const std::size_t block = pos / json::index_block_size;
+            if (block >= blocks.size()) {
+                return source.length();
+            }
+            const std::uint64_t interesting = in_string
+                ? blocks[block].string_special
+                : blocks[block].string_special | blocks[block].nesting;
+            const std::uint64_t mask
+                = interesting & (~std::uint64_t(0) << (pos % json::index_block_size));
+            if (mask == 0) {
+                pos = (block + 1) * json::index_block_size;
+                continue;
+            }
+            // Bits past the end of the source are never set, so this is always in bounds.
+            pos = (block * json::index_block_size) + std::size_t(std::countr_zero(mask));
+            switch (source[pos]) {
+            case u8'"': {
+                in_string = !in_string;
+                ++pos;
+                break;
+            }
+            case u8'\\': {
+                // Only string_special is considered within strings, so this is an escape.
+                pos += 2;
+                break;
+            }
+            case u8'{':
+            case u8'[': {
+                ++depth;
+                ++pos;
+                break;
+            }
+            case u8'}':
+            case u8']': {
+                ++pos;
+                if (--depth == 0) {
+                    return pos;
+                }
+                break;
+            }
+            case u8'/': {
+                const std::size_t comment_end = allow_comments ? skip_comment(pos) : pos;
+                pos = comment_end == pos ? pos + 1 : comment_end;
+                break;
+            }
+            default: ++pos; break;
+            }
+        }
+    }
+
+    /// @brief Skips the value starting at `pos`.
+    /// @returns The position just past the value.
+    [[nodiscard]]
+    std::size_t skip_value(std::size_t pos) const
+    {
+        if (pos >= source.length()) {
+            return source.length();
+        }
+        switch (source[pos]) {
+        case u8'"': return skip_string(pos + 1);
+        case u8'{':
+        case u8'[': return skip_container(pos + 1);
+        default: break;
+        }
+        // Numbers and literals are short, so there is no point in using the index.
+        while (pos < source.length()) {
+            switch (source[pos]) {
+            case u8',':
+            case u8'}':
+            case u8']':
+            case u8'/':
+            case u8' ':
+            case u8'\t':
+            case u8'\f':
+            case u8'\n':
+            case u8'\r': return pos;
+            default: ++pos; break;
+            }
+        }
+        return pos;
+    }
+
+    /// @brief Returns the position of the next element or member in a container,
+    /// where `pos` is just past the previous element or member,
+    /// or `source.length()` if the container ends.
+    [[nodiscard]]
+    std::size_t next_in_container(std::size_t pos) const
+    {
+        pos = skip_whitespace_comments(pos);
+        if (!at(pos, u8',')) {
+            return source.length();
+        }
+        return skip_whitespace_comments(pos + 1);
+    }
+
+    /// @brief Returns the position of the first element or member in the container
+    /// that starts at `pos`, or `source.length()` if there is none.
+    [[nodiscard]]
+    std::size_t first_in_container(std::size_t pos, char8_t closing) const
+    {
+        pos = skip_whitespace_comments(pos + 1);
+        return at(pos, closing) ? source.length() : pos;
+    }
+};
+
+[[nodiscard]]
+JSON_Cursor make_cursor(const JSON_On_Demand& document, std::size_t pos)
+{
+    if (pos >= document.source().length()) {
+        return {};
+    }
+    return { document, pos };
+}
+
+/// @brief Returns the member whose key starts at `key_pos`,
+/// or a member with no key if there is no valid member at `key_pos`.
+[[nodiscard]]
+JSON_Member_Cursor member_at(const JSON_On_Demand& document, std::size_t key_pos)
+{
+    const Scanner scanner { document };
+    if (!scanner.at(key_pos, u8'"')) {
+        return {};
+    }
+    const std::size_t colon_pos
+        = scanner.skip_whitespace_comments(scanner.skip_string(key_pos + 1));
+    if (!scanner.at(colon_pos, u8':')) {
+        return {};
+    }
+    const std::size_t value_pos = scanner.skip_whitespace_comments(colon_pos + 1);
+    const JSON_Cursor value = make_cursor(document, value_pos);
+    if (!value) {
+        return {};
+    }
+    return { .key = { document, key_pos }, .value = value };
+}
+
+/// @brief Decodes the raw string contents `raw`,
+/// and invokes `out` with each piece of the result, in order.
+/// @returns `false` if `raw` contains an invalid escape sequence, else `true`.
+template <typename Out>
+[[nodiscard]]
+bool decode_raw_string(std::u8string_view raw, Out out)
+{
+    json::Escape_Decoder decoder;
+    while (!raw.empty()) {
+        const std::size_t literal_length = std::min(raw.find(u8'\\'), raw.length());
+        if (literal_length != 0) {
+            decoder.flush(out);
+            out(raw.substr(0, literal_length));
+            raw.remove_prefix(literal_length);
+            continue;
+        }
+        const json::Escape_Result escape
+            = json::match_escape_sequence(raw, json::Escape_Policy::parse);
+        if (!escape || escape.value == json::Escape_Result::no_value) {
+            return false;
+        }
+        decoder.push(escape.value, out);
+        raw.remove_prefix(escape.length);
+    }
+    decoder.flush(out);
+    return true;
+}
+
+/// @brief Returns `true` iff the raw string contents `raw`, once decoded, are equal to `str`.
+[[nodiscard]]
+bool raw_string_equals(std::u8string_view raw, std::u8string_view str)
+{
+    if (raw.find(u8'\\') == std::u8string_view::npos) {
+        return raw == str;
+    }
+    bool equal = true;
+    const bool valid = decode_raw_string(raw, [&](std::u8string_view piece) {
+        equal = equal && str.starts_with(piece);
+        if (equal) {
+            str.remove_prefix(piece.length());
+        }
+    });
+    return valid && equal && str.empty();
+}
+
+} // namespace
+
+std::optional<JSON_Type> JSON_Cursor::type() const
+{
+    if (!m_document) {
+        return {};
+    }
+    switch (m_document->source()[m_offset]) {
+    case u8'"': return JSON_Type::string;
+    case u8'[': return JSON_Type::array;
+    case u8'{': return JSON_Type::object;
+    case u8't':
+    case u8'f': return JSON_Type::boolean;
+    case u8'n': return JSON_Type::null;
+    case u8'-':
+    case u8'0':
+    case u8'1':
+    case u8'2':
+    case u8'3':
+    case u8'4':
+    case u8'5':
+    case u8'6':
+    case u8'7':
+    case u8'8':
+    case u8'9': return JSON_Type::number;
+    default: return {};
+    }
+}
+
+std::u8string_view JSON_Cursor::raw() const
+{
+    if (!m_document) {
+        return {};
+    }
+    const std::size_t end = Scanner { *m_document }.skip_value(m_offset);
+    return m_document->source().substr(m_offset, end - m_offset);
+}
+
+JSON_Cursor JSON_Cursor::find(std::u8string_view key) const
+{
+    for (const JSON_Member_Cursor member : members()) {
+        if (raw_string_equals(*member.key.get_raw_string(), key)) {
+            return member.value;
+        }
+    }
+    return {};
+}
+
+JSON_Cursor JSON_Cursor::find(std::size_t index) const
+{
+    for (const JSON_Cursor element : elements()) {
+        if (index-- == 0) {
+            return element;
+        }
+    }
+    return {};
+}
+
+JSON_Element_Range JSON_Cursor::elements() const
+{
+    if (type() != JSON_Type::array) {
+        return {};
+    }
+    const std::size_t first = Scanner { *m_document }.first_in_container(m_offset, u8']');
+    return { JSON_Element_Iterator { make_cursor(*m_document, first) } };
+}
+
+JSON_Member_Range JSON_Cursor::members() const
+{
+    if (type() != JSON_Type::object) {
+        return {};
+    }
+    const std::size_t first = Scanner { *m_document }.first_in_container(m_offset, u8'}');
+    return { JSON_Member_Iterator { member_at(*m_document, first) } };
+}
+
+JSON_Element_Iterator& JSON_Element_Iterator::operator++()
+{
+    ULIGHT_ASSERT(m_current);
+    const JSON_On_Demand& document = *m_current.m_document;
+    const Scanner scanner { document };
+    const std::size_t next
+        = scanner.next_in_container(scanner.skip_value(m_current.offset()));
+    // A trailing comma is tolerated, just like a missing closing bracket.
+    m_current = scanner.at(next, u8']') ? JSON_Cursor {} : make_cursor(document, next);
+    return *this;
+}
+
+JSON_Member_Iterator& JSON_Member_Iterator::operator++()
+{
+    ULIGHT_ASSERT(m_current.key);
+    const JSON_On_Demand& document = *m_current.value.m_document;
+    const Scanner scanner { document };
+    const std::size_t next
+        = scanner.next_in_container(scanner.skip_value(m_current.value.offset()));
+    m_current = member_at(document, next);
+    return *this;
+}
+
+bool JSON_Cursor::is_null() const
+{
+    return m_document && m_document->source().substr(m_offset).starts_with(u8"null");
+}
+
+std::optional<bool> JSON_Cursor::get_boolean() const
+{
+    if (!m_document) {
+        return {};
+    }
+    const std::u8string_view remainder = m_document->source().substr(m_offset);
+    if (remainder.starts_with(u8"true")) {
+        return true;
+    }
+    if (remainder.starts_with(u8"false")) {
+        return false;
+    }
+    return {};
+}
+
+std::optional<double> JSON_Cursor::get_number() const
+{
+    if (!m_document) {
+        return {};
+    }
+    const std::u8string_view remainder = m_document->source().substr(m_offset);
+    const json::Number_Result number = json::match_number(remainder);
+    if (!number || number.erroneous) {
+        return {};
+    }
+    return json::parse_number_value(remainder.substr(0, number.length));
+}
+
+std::optional<JSON_Integer> JSON_Cursor::get_integer() const
+{
+    if (!m_document) {
+        return {};
+    }
+    const std::u8string_view remainder = m_document->source().substr(m_offset);
+    const json::Number_Result number = json::match_number(remainder);
+    if (!number || number.erroneous || number.fraction != 0 || number.exponent != 0) {
+        return {};
+    }
+    return json::parse_integer_value(remainder.substr(0, number.length));
+}
+
+std::optional<std::u8string_view> JSON_Cursor::get_raw_string() const
+{
+    if (type() != JSON_Type::string) {
+        return {};
+    }
+    const std::size_t end = Scanner { *m_document }.skip_string(m_offset + 1);
+    if (m_document->source()[end - 1] != u8'"' || end - m_offset < 2) {
+        return {};
+    }
+    return m_document->source().substr(m_offset + 1, end - m_offset - 2);
+}
+
+bool JSON_Cursor::get_string(std::u8string& out) const
+{
+    const std::optional<std::u8string_view> raw = get_raw_string();
+    if (!raw) {
+        return false;
+    }
+    if (m_document->options().escapes == Escape_Parsing::none) {
+        out.append(*raw);
+        return true;
+    }
+    return decode_raw_string(*raw, [&](std::u8string_view piece) { out.append(piece); });
+}
+
+bool JSON_Cursor::parse(JSON_Visitor& visitor) const
+{
+    if (!m_document) {
+        return false;
+    }
+    return json::parse_json_value(visitor, m_document->index(), m_offset, m_document->options());
+}
+
+JSON_On_Demand::JSON_On_Demand(
+    std::u8string_view source,
+    JSON_Options options,
+    std::pmr::memory_resource* memory
+)
+    : m_memory { memory }
+    , m_options { options }
+{
+    // The index is only forward-declared in the public header, so it lives behind a pointer.
+    m_index = std::pmr::polymorphic_allocator<>(memory).new_object<json::Source_Index>(
+        source, memory
+    );
+}
+
+JSON_On_Demand::~JSON_On_Demand()
+{
+    std::pmr::polymorphic_allocator<>(m_memory).delete_object(m_index);
+}
+
+std::u8string_view JSON_On_Demand::source() const noexcept
+{
+    return m_index->source();
+}
+
+JSON_Cursor JSON_On_Demand::root() const
+{
+    return make_cursor(*this, Scanner { *this }.skip_whitespace_comments(0));
+}
+
+} // namespace ulight
@@ -0,0 +1,379 @@
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ulight/json.hpp"
+#include "ulight/json_dom.hpp"
+#include "ulight/json_static.hpp"
+
+#include "ulight/impl/assert.hpp"
+
+#include "ulight/impl/lang/json.hpp"
+
+namespace ulight {
+namespace {
+
+/// @brief A visitor which builds a DOM.
+/// Finished values (and object keys) are collected on a stack of scratch memory.
+/// When an array or object is popped,
+/// its elements are moved into one contiguous allocation from the arena.
+struct DOM_Builder final : JSON_Visitor {
+private:
+    std::pmr::memory_resource* const m_memory;
+    JSON_Error_Info* const m_error;
+
+    std::pmr::vector<JSON_Value> m_values;
+    std::pmr::vector<std::size_t> m_container_starts;
+
+    /// @brief The first literal piece of the current string.
+    /// As long as the string consists of no other pieces,
+    /// it can refer to the source instead of being copied.
+    std::u8string_view m_string_view;
+    /// @brief The contents of the current string,
+    /// if it is made of multiple pieces or escape sequences.
+    std::pmr::u8string m_string_buffer;
+    bool m_string_buffered = false;
+    json::Escape_Decoder m_escape_decoder;
+
+public:
+    // Brings the overloads which are never invoked with our options into scope,
+    // since parse_json calls the member functions of this class statically.
+    using JSON_Visitor::escape;
+    using JSON_Visitor::number;
+
+    [[nodiscard]]
+    DOM_Builder(std::pmr::memory_resource* memory, JSON_Error_Info* error)
+        : m_memory { memory }
+        , m_error { error }
+    {
+    }
+
+    [[nodiscard]]
+    JSON_Value result() const
+    {
+        ULIGHT_ASSERT(m_values.size() == 1);
+        ULIGHT_ASSERT(m_container_starts.empty());
+        return m_values.back();
+    }
+
+    void literal(const Source_Position&, std::u8string_view chars) final
+    {
+        ULIGHT_DEBUG_ASSERT(!chars.empty());
+        flush_escapes();
+        if (!m_string_buffered && m_string_view.empty()) {
+            m_string_view = chars;
+            return;
+        }
+        append_to_buffer(chars);
+    }
+
+    void escape(const Source_Position&, std::u8string_view, char32_t code_point, std::u8string_view)
+        final
+    {
+        // The code units of each escape are encoded separately by the parser,
+        // which would turn surrogate pairs into invalid UTF-8,
+        // so the code points are decoded again.
+        m_escape_decoder.push(code_point, [&](std::u8string_view code_units) {
+            append_to_buffer(code_units);
+        });
+    }
+
+    void number(const Source_Position&, std::u8string_view, double value) final
+    {
+        m_values.push_back(JSON_Value::make_number(value));
+    }
+
+    void null(const Source_Position&) final
+    {
+        m_values.push_back(JSON_Value {});
+    }
+
+    void boolean(const Source_Position&, bool value) final
+    {
+        m_values.push_back(JSON_Value::make_boolean(value));
+    }
+
+    void push_string(const Source_Position&) final
+    {
+        start_string();
+    }
+    void pop_string(const Source_Position&) final
+    {
+        finish_string();
+    }
+
+    void push_property(const Source_Position&) final
+    {
+        start_string();
+    }
+    void pop_property(const Source_Position&) final
+    {
+        finish_string();
+    }
+
+    void push_object(const Source_Position&) final
+    {
+        m_container_starts.push_back(m_values.size());
+    }
+    void pop_object(const Source_Position&) final
+    {
+        const std::size_t start = pop_container_start();
+        const std::span<const JSON_Value> pairs = std::span { m_values }.subspan(start);
+        ULIGHT_ASSERT(pairs.size() % 2 == 0);
+
+        const std::size_t size = pairs.size() / 2;
+        JSON_Member* members = nullptr;
+        if (size != 0) {
+            members = allocate<JSON_Member>(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                std::construct_at(members + i, pairs[i * 2], pairs[(i * 2) + 1]);
+            }
+        }
+        replace_container(start, JSON_Value::make_object({ members, size }));
+    }
+
+    void push_array(const Source_Position&) final
+    {
+        m_container_starts.push_back(m_values.size());
+    }
+    void pop_array(const Source_Position&) final
+    {
+        const std::size_t start = pop_container_start();
+        const std::span<const JSON_Value> elements = std::span { m_values }.subspan(start);
+        JSON_Value* copy = nullptr;
+        if (!elements.empty()) {
+            copy = allocate<JSON_Value>(elements.size());
+            std::uninitialized_copy(elements.begin(), elements.end(), copy);
+        }
+        replace_container(start, JSON_Value::make_array({ copy, elements.size() }));
+    }
+
+    Error_Reaction error(const Source_Position& pos, JSON_Error error) final
+    {
+        if (m_error) {
+            *m_error = { .pos = pos, .error = error };
+        }
+        return Error_Reaction::abort;
+    }
+
+private:
+    template <typename T>
+    [[nodiscard]]
+    T* allocate(std::size_t size)
+    {
+        return static_cast<T*>(m_memory->allocate(size * sizeof(T), alignof(T)));
+    }
+
+    void start_string()
+    {
+        m_string_view = {};
+        m_string_buffer.clear();
+        m_string_buffered = false;
+    }
+
+    void append_to_buffer(std::u8string_view chars)
+    {
+        if (!m_string_buffered) {
+            m_string_buffer.assign(m_string_view);
+            m_string_buffered = true;
+        }
+        m_string_buffer.append(chars);
+    }
+
+    void flush_escapes()
+    {
+        m_escape_decoder.flush([&](std::u8string_view code_units) {
+            append_to_buffer(code_units);
+        });
+    }
+
+    void finish_string()
+    {
+        flush_escapes();
+        if (!m_string_buffered) {
+            m_values.push_back(JSON_Value::make_string(m_string_view));
+            return;
+        }
+        auto* const copy = allocate<char8_t>(m_string_buffer.length());
+        std::memcpy(copy, m_string_buffer.data(), m_string_buffer.length());
+        m_values.push_back(JSON_Value::make_string({ copy, m_string_buffer.length() }));
+    }
+
+    /// @brief Returns the index within `m_values` of the first value
+    /// that belongs to the innermost container.
+    [[nodiscard]]
+    std::size_t pop_container_start()
+    {
+        ULIGHT_ASSERT(!m_container_starts.empty());
+        const std::size_t start = m_container_starts.back();
+        m_container_starts.pop_back();
+        return start;
+    }
+
+    /// @brief Replaces the values of a container, starting at `start`, with the container itself.
+    void replace_container(std::size_t start, JSON_Value container)
+    {
+        m_values.resize(start);
+        m_values.push_back(container);
+    }
+};
+
+/// @brief Returns `true` iff `token` contains only valid `~0` and `~1` escapes.
+[[nodiscard]]
+bool is_valid_reference_token(std::u8string_view token)
+{
+    for (std::size_t i = token.find(u8'~'); i != std::u8string_view::npos;
+         i = token.find(u8'~', i + 2)) {
+        if (i + 1 >= token.length() || (token[i + 1] != u8'0' && token[i + 1] != u8'1')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Returns `true` iff `key` equals the unescaped reference `token`.
+[[nodiscard]]
+bool key_equals_reference_token(std::u8string_view key, std::u8string_view token)
+{
+    std::size_t k = 0;
+    for (std::size_t t = 0; t < token.length(); ++t, ++k) {
+        char8_t c = token[t];
+        if (c == u8'~') {
+            c = token[++t] == u8'0' ? u8'~' : u8'/';
+        }
+        if (k >= key.length() || key[k] != c) {
+            return false;
+        }
+    }
+    return k == key.length();
+}
+
+[[nodiscard]]
+const JSON_Value* find_reference_token(const JSON_Value& value, std::u8string_view token)
+{
+    switch (value.type()) {
+    case JSON_Type::array: {
+        // RFC 6901 only permits decimal indices without leading zeroes.
+        // The special token "-" refers to the nonexistent element past the end.
+        if (token.empty() || (token.length() > 1 && token[0] == u8'0')) {
+            return nullptr;
+        }
+        std::size_t index = 0;
+        const auto* const begin = reinterpret_cast<const char*>(token.data());
+        const auto* const end = begin + token.length();
+        const auto [p, ec] = std::from_chars(begin, end, index);
+        if (ec != std::errc {} || p != end) {
+            return nullptr;
+        }
+        return value.find(index);
+    }
+    case JSON_Type::object: {
+        if (token.find(u8'~') == std::u8string_view::npos) {
+            return value.find(token);
+        }
+        if (!is_valid_reference_token(token)) {
+            return nullptr;
+        }
+        for (const JSON_Member& member : value.as_object()) {
+            if (key_equals_reference_token(member.key.as_string(), token)) {
+                return &member.value;
+            }
+        }
+        return nullptr;
+    }
+    default: return nullptr;
+    }
+}
+
+} // namespace
+
+const JSON_Value* JSON_Value::find(std::u8string_view key) const
+{
+    if (m_type != JSON_Type::object) {
+        return nullptr;
+    }
+    for (const JSON_Member& member : as_object()) {
+        if (member.key.as_string() == key) {
+            return &member.value;
+        }
+    }
+    return nullptr;
+}
+
+const JSON_Value* JSON_Value::find(std::size_t index) const
+{
+    if (m_type != JSON_Type::array || index >= m_size) {
+        return nullptr;
+    }
+    return m_elements + index;
+}
+
+const JSON_Value* JSON_Value::find_pointer(std::u8string_view pointer) const
+{
+    const JSON_Value* current = this;
+    while (!pointer.empty()) {
+        if (pointer[0] != u8'/') {
+            return nullptr;
+        }
+        pointer.remove_prefix(1);
+        const std::size_t token_length = std::min(pointer.find(u8'/'), pointer.length());
+        current = find_reference_token(*current, pointer.substr(0, token_length));
+        if (!current) {
+            return nullptr;
+        }
+        pointer.remove_prefix(token_length);
+    }
+    return current;
+}
+
+bool parse_json_dom(
+    JSON_Value& out,
+    std::u8string_view source,
+    std::pmr::memory_resource* memory,
+    JSON_Options options,
+    JSON_Error_Info* error
+)
+{
+    ULIGHT_ASSERT(memory);
+    // Strings and containers cannot be larger than the source,
+    // so this guarantees that their sizes fit into a JSON_Value.
+    if (source.length() > JSON_Value::max_size) {
+        if (error) {
+            *error = { .pos = {}, .error = JSON_Error::error };
+        }
+        return false;
+    }
+
+    // The DOM only stores numbers as doubles, so integers must not be reported separately.
+    options.parse_numbers = true;
+    options.parse_integers = false;
+    options.escapes = Escape_Parsing::parse_encode;
+
+    DOM_Builder builder { memory, error };
+    // DOM_Builder is final, so its member functions are called without virtual dispatch.
+    if (!parse_json<DOM_Builder>(builder, source, options)) {
+        return false;
+    }
+    out = builder.result();
+    return true;
+}
+
+bool parse_json_dom(
+    JSON_Value& out,
+    std::string_view source,
+    std::pmr::memory_resource* memory,
+    JSON_Options options,
+    JSON_Error_Info* error
+)
+{
+    const std::u8string_view u8source { reinterpret_cast<const char8_t*>(source.data()),
+                                        source.length() };
+    return parse_json_dom(out, u8source, memory, options, error);
+}
+
+} // namespace ulight
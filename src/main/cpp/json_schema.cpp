@@ -0,0 +1,746 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ulight/function_ref.hpp"
+#include "ulight/json.hpp"
+#include "ulight/json_dom.hpp"
+#include "ulight/json_schema.hpp"
+#include "ulight/json_static.hpp"
+
+#include "ulight/impl/assert.hpp"
+
+#include "ulight/impl/lang/json.hpp"
+
+namespace ulight {
+namespace {
+
+[[nodiscard]]
+std::optional<JSON_Type> type_by_name(std::u8string_view name)
+{
+    static constexpr std::u8string_view names[] {
+        u8"null", u8"boolean", u8"number", u8"string", u8"array", u8"object",
+    };
+    for (std::size_t i = 0; i < std::size(names); ++i) {
+        if (names[i] == name) {
+            return JSON_Type(i);
+        }
+    }
+    return {};
+}
+
+/// @brief Compiles a JSON Schema document into nodes which are allocated from an arena.
+struct Schema_Compiler {
+private:
+    std::pmr::memory_resource* const m_memory;
+
+public:
+    [[nodiscard]]
+    explicit Schema_Compiler(std::pmr::memory_resource* memory)
+        : m_memory { memory }
+    {
+    }
+
+    [[nodiscard]]
+    bool compile(const JSON_Value& schema, JSON_Schema_Node& out)
+    {
+        out = {};
+        if (schema.type() == JSON_Type::boolean) {
+            if (!schema.as_boolean()) {
+                out.types = 0;
+            }
+            return true;
+        }
+        if (schema.type() != JSON_Type::object) {
+            return false;
+        }
+
+        const JSON_Value* exclusive_minimum = nullptr;
+        const JSON_Value* exclusive_maximum = nullptr;
+        const JSON_Value* properties = nullptr;
+        const JSON_Value* required = nullptr;
+        const JSON_Value* enumeration = nullptr;
+        const JSON_Value* constant = nullptr;
+
+        for (const JSON_Member& member : schema.as_object()) {
+            const std::u8string_view key = member.key.as_string();
+            const JSON_Value& value = member.value;
+            bool success = true;
+            if (key == u8"type") {
+                success = compile_type(value, out);
+            }
+            else if (key == u8"minimum") {
+                success = value.type() == JSON_Type::number;
+                out.minimum = success ? value.as_number() : out.minimum;
+            }
+            else if (key == u8"maximum") {
+                success = value.type() == JSON_Type::number;
+                out.maximum = success ? value.as_number() : out.maximum;
+            }
+            else if (key == u8"exclusiveMinimum") {
+                exclusive_minimum = &value;
+            }
+            else if (key == u8"exclusiveMaximum") {
+                exclusive_maximum = &value;
+            }
+            else if (key == u8"minItems") {
+                success = compile_count(value, out.min_items);
+            }
+            else if (key == u8"maxItems") {
+                success = compile_count(value, out.max_items);
+            }
+            else if (key == u8"items") {
+                JSON_Schema_Node* const items = make_node();
+                success = compile(value, *items);
+                out.items = items;
+            }
+            else if (key == u8"properties") {
+                properties = &value;
+            }
+            else if (key == u8"required") {
+                required = &value;
+            }
+            else if (key == u8"additionalProperties") {
+                success = value.type() == JSON_Type::boolean;
+                out.additional_properties = !success || value.as_boolean();
+            }
+            else if (key == u8"enum") {
+                enumeration = &value;
+            }
+            else if (key == u8"const") {
+                constant = &value;
+            }
+            if (!success) {
+                return false;
+            }
+        }
+
+        return compile_exclusive_bound(exclusive_minimum, out.minimum, out.exclusive_minimum, 1)
+            && compile_exclusive_bound(exclusive_maximum, out.maximum, out.exclusive_maximum, -1)
+            && compile_properties(properties, required, out)
+            && compile_enumeration(enumeration, constant, out);
+    }
+
+private:
+    [[nodiscard]]
+    static bool compile_type(const JSON_Value& type, JSON_Schema_Node& out)
+    {
+        const std::span<const JSON_Value> names
+            = type.type() == JSON_Type::array ? type.as_array() : std::span { &type, 1 };
+        bool number = false;
+        bool integer = false;
+        out.types = 0;
+        for (const JSON_Value& name : names) {
+            if (name.type() != JSON_Type::string) {
+                return false;
+            }
+            if (name.as_string() == u8"integer") {
+                integer = true;
+                continue;
+            }
+            const std::optional<JSON_Type> t = type_by_name(name.as_string());
+            if (!t) {
+                return false;
+            }
+            number |= *t == JSON_Type::number;
+            out.types |= JSON_Schema_Node::type_bit(*t);
+        }
+        if (integer && !number) {
+            out.types |= JSON_Schema_Node::type_bit(JSON_Type::number);
+            out.integer = true;
+        }
+        return true;
+    }
+
+    [[nodiscard]]
+    static bool compile_count(const JSON_Value& count, std::size_t& out)
+    {
+        if (count.type() != JSON_Type::number) {
+            return false;
+        }
+        const double value = count.as_number();
+        if (!(value >= 0) || value != std::trunc(value)) {
+            return false;
+        }
+        out = value >= 0x1p64 ? std::size_t(-1) : std::size_t(value);
+        return true;
+    }
+
+    /// @brief Applies `exclusiveMinimum` or `exclusiveMaximum`,
+    /// which is a bound in its own right since draft 6,
+    /// but only a flag that modifies `minimum` or `maximum` in draft 4.
+    /// @param direction `1` for a minimum, or `-1` for a maximum.
+    [[nodiscard]]
+    static bool
+    compile_exclusive_bound(const JSON_Value* value, double& bound, bool& exclusive, int direction)
+    {
+        if (!value) {
+            return true;
+        }
+        if (value->type() == JSON_Type::boolean) {
+            exclusive = value->as_boolean();
+            return true;
+        }
+        if (value->type() != JSON_Type::number) {
+            return false;
+        }
+        // If both an inclusive and an exclusive bound are given, the tighter one applies.
+        const double exclusive_bound = value->as_number();
+        if (exclusive_bound * direction >= bound * direction) {
+            bound = exclusive_bound;
+            exclusive = true;
+        }
+        return true;
+    }
+
+    [[nodiscard]]
+    bool compile_properties(
+        const JSON_Value* properties,
+        const JSON_Value* required,
+        JSON_Schema_Node& out
+    )
+    {
+        if ((properties && properties->type() != JSON_Type::object)
+            || (required && required->type() != JSON_Type::array)) {
+            return false;
+        }
+        std::vector<JSON_Schema_Property> result;
+        if (properties) {
+            for (const JSON_Member& member : properties->as_object()) {
+                JSON_Schema_Node* const node = make_node();
+                if (!compile(member.value, *node)) {
+                    return false;
+                }
+                result.push_back(
+                    { .key = member.key.as_string(), .schema = node, .required = false }
+                );
+            }
+        }
+        const auto by_key = [](const JSON_Schema_Property& x, const JSON_Schema_Property& y) {
+            return x.key < y.key;
+        };
+        std::ranges::sort(result, by_key);
+        if (std::ranges::adjacent_find(result, {}, &JSON_Schema_Property::key) != result.end()) {
+            return false;
+        }
+
+        if (required) {
+            const std::size_t known = result.size();
+            for (const JSON_Value& key : required->as_array()) {
+                if (key.type() != JSON_Type::string) {
+                    return false;
+                }
+                const auto known_end = result.begin() + std::ptrdiff_t(known);
+                const auto it = std::ranges::lower_bound(
+                    result.begin(), known_end, key.as_string(), {}, &JSON_Schema_Property::key
+                );
+                if (it != known_end && it->key == key.as_string()) {
+                    it->required = true;
+                }
+                else {
+                    result.push_back(
+                        { .key = key.as_string(), .schema = nullptr, .required = true }
+                    );
+                }
+            }
+            std::ranges::sort(result, by_key);
+            // Keys which are only in "required" may be repeated, which is harmless.
+            const auto duplicates = std::ranges::unique(result, {}, &JSON_Schema_Property::key);
+            result.erase(duplicates.begin(), duplicates.end());
+        }
+
+        if (result.empty()) {
+            return true;
+        }
+        auto* const copy = allocate<JSON_Schema_Property>(result.size());
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            result[i].key = copy_string(result[i].key);
+            std::construct_at(copy + i, result[i]);
+        }
+        out.properties = { copy, result.size() };
+        return true;
+    }
+
+    [[nodiscard]]
+    bool compile_enumeration(
+        const JSON_Value* enumeration,
+        const JSON_Value* constant,
+        JSON_Schema_Node& out
+    )
+    {
+        if (!enumeration && !constant) {
+            return true;
+        }
+        if ((enumeration && constant)
+            || (enumeration && enumeration->type() != JSON_Type::array)) {
+            return false;
+        }
+
+        const std::span<const JSON_Value> values
+            = constant ? std::span { constant, 1 } : enumeration->as_array();
+        auto* const copy = allocate<JSON_Value>(std::max(values.size(), std::size_t(1)));
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            JSON_Value value = values[i];
+            switch (value.type()) {
+            case JSON_Type::array:
+            case JSON_Type::object: return false;
+            case JSON_Type::string: {
+                value = JSON_Value::make_string(copy_string(value.as_string()));
+                break;
+            }
+            default: break;
+            }
+            std::construct_at(copy + i, value);
+        }
+        // An empty "enum" permits no value, which is equivalent to permitting no type.
+        if (values.empty()) {
+            out.types = 0;
+            return true;
+        }
+        out.enumeration = { copy, values.size() };
+        return true;
+    }
+
+    [[nodiscard]]
+    JSON_Schema_Node* make_node()
+    {
+        return std::construct_at(allocate<JSON_Schema_Node>(1));
+    }
+
+    [[nodiscard]]
+    std::u8string_view copy_string(std::u8string_view str)
+    {
+        if (str.empty()) {
+            return {};
+        }
+        auto* const copy = allocate<char8_t>(str.length());
+        std::memcpy(copy, str.data(), str.length());
+        return { copy, str.length() };
+    }
+
+    template <typename T>
+    [[nodiscard]]
+    T* allocate(std::size_t size)
+    {
+        return static_cast<T*>(m_memory->allocate(size * sizeof(T), alignof(T)));
+    }
+};
+
+[[nodiscard]]
+bool is_integer(double value)
+{
+    return std::isfinite(value) && value == std::trunc(value);
+}
+
+[[nodiscard]]
+double to_double(JSON_Integer value)
+{
+    const auto magnitude = double(value.magnitude);
+    return value.negative ? -magnitude : magnitude;
+}
+
+} // namespace
+
+bool JSON_Schema::compile(const JSON_Value& schema)
+{
+    m_root = {};
+    m_arena.release();
+    if (!Schema_Compiler { &m_arena }.compile(schema, m_root)) {
+        m_root = {};
+        m_arena.release();
+        return false;
+    }
+    return true;
+}
+
+JSON_Schema_Validator::JSON_Schema_Validator(
+    const JSON_Schema& schema,
+    Function_Ref<void(const JSON_Schema_Violation&)> on_violation,
+    JSON_Visitor* next,
+    std::pmr::memory_resource* memory
+)
+    : m_root { schema.root() }
+    , m_on_violation { on_violation }
+    , m_next { next }
+    , m_frames { memory }
+    , m_seen_properties(memory)
+    , m_string { memory }
+{
+}
+
+void JSON_Schema_Validator::line_comment(const Source_Position& pos, std::u8string_view comment)
+{
+    if (m_next) {
+        m_next->line_comment(pos, comment);
+    }
+}
+
+void JSON_Schema_Validator::block_comment(const Source_Position& pos, std::u8string_view comment)
+{
+    if (m_next) {
+        m_next->block_comment(pos, comment);
+    }
+}
+
+void JSON_Schema_Validator::literal(const Source_Position& pos, std::u8string_view chars)
+{
+    if (m_collecting_string) {
+        flush_code_points();
+        m_string.append(chars);
+    }
+    if (m_next) {
+        m_next->literal(pos, chars);
+    }
+}
+
+void JSON_Schema_Validator::escape(const Source_Position& pos, std::u8string_view escape)
+{
+    if (m_collecting_string) {
+        const json::Escape_Result result
+            = json::match_escape_sequence(escape, json::Escape_Policy::parse);
+        ULIGHT_DEBUG_ASSERT(result.value != json::Escape_Result::no_value);
+        append_code_point(result.value);
+    }
+    if (m_next) {
+        m_next->escape(pos, escape);
+    }
+}
+
+void JSON_Schema_Validator::escape(
+    const Source_Position& pos,
+    std::u8string_view escape,
+    char32_t code_point
+)
+{
+    if (m_collecting_string) {
+        append_code_point(code_point);
+    }
+    if (m_next) {
+        m_next->escape(pos, escape, code_point);
+    }
+}
+
+void JSON_Schema_Validator::escape(
+    const Source_Position& pos,
+    std::u8string_view escape,
+    char32_t code_point,
+    std::u8string_view code_units
+)
+{
+    if (m_collecting_string) {
+        append_code_point(code_point);
+    }
+    if (m_next) {
+        m_next->escape(pos, escape, code_point, code_units);
+    }
+}
+
+void JSON_Schema_Validator::number(const Source_Position& pos, std::u8string_view number)
+{
+    const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::number);
+    // Without the parse_numbers option, the number only has to be converted if it is constrained.
+    if (node
+        && (node->integer || !node->enumeration.empty() || std::isfinite(node->minimum)
+            || std::isfinite(node->maximum))) {
+        if (const std::optional<double> value = json::parse_number_value(number)) {
+            check_number(node, pos, *value);
+        }
+    }
+    if (m_next) {
+        m_next->number(pos, number);
+    }
+}
+
+void JSON_Schema_Validator::number(
+    const Source_Position& pos,
+    std::u8string_view number,
+    double value
+)
+{
+    if (const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::number)) {
+        check_number(node, pos, value);
+    }
+    if (m_next) {
+        m_next->number(pos, number, value);
+    }
+}
+
+void JSON_Schema_Validator::integer(
+    const Source_Position& pos,
+    std::u8string_view number,
+    JSON_Integer value
+)
+{
+    if (const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::number)) {
+        check_number(node, pos, to_double(value));
+    }
+    if (m_next) {
+        m_next->integer(pos, number, value);
+    }
+}
+
+void JSON_Schema_Validator::null(const Source_Position& pos)
+{
+    const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::null);
+    if (node && !node->enumeration.empty()
+        && std::ranges::none_of(node->enumeration, &JSON_Value::is_null)) {
+        violation(pos, JSON_Schema_Error::enumeration);
+    }
+    if (m_next) {
+        m_next->null(pos);
+    }
+}
+
+void JSON_Schema_Validator::boolean(const Source_Position& pos, bool value)
+{
+    const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::boolean);
+    if (node && !node->enumeration.empty()
+        && std::ranges::none_of(node->enumeration, [&](const JSON_Value& e) {
+               return e.type() == JSON_Type::boolean && e.as_boolean() == value;
+           })) {
+        violation(pos, JSON_Schema_Error::enumeration);
+    }
+    if (m_next) {
+        m_next->boolean(pos, value);
+    }
+}
+
+void JSON_Schema_Validator::push_string(const Source_Position& pos)
+{
+    m_string_node = begin_value(pos, JSON_Type::string);
+    m_string_pos = pos;
+    m_string.clear();
+    m_collecting_string = m_string_node && !m_string_node->enumeration.empty();
+    if (m_next) {
+        m_next->push_string(pos);
+    }
+}
+
+void JSON_Schema_Validator::pop_string(const Source_Position& pos)
+{
+    flush_code_points();
+    if (m_collecting_string
+        && std::ranges::none_of(m_string_node->enumeration, [&](const JSON_Value& e) {
+               return e.type() == JSON_Type::string && e.as_string() == m_string;
+           })) {
+        violation(m_string_pos, JSON_Schema_Error::enumeration);
+    }
+    m_collecting_string = false;
+    if (m_next) {
+        m_next->pop_string(pos);
+    }
+}
+
+void JSON_Schema_Validator::push_property(const Source_Position& pos)
+{
+    ULIGHT_DEBUG_ASSERT(!m_frames.empty() && m_frames.back().type == JSON_Type::object);
+    const JSON_Schema_Node* const node = m_frames.back().node;
+    m_string_pos = pos;
+    m_string.clear();
+    m_collecting_string = node && (!node->properties.empty() || !node->additional_properties);
+    m_frames.back().member_schema = nullptr;
+    if (m_next) {
+        m_next->push_property(pos);
+    }
+}
+
+void JSON_Schema_Validator::pop_property(const Source_Position& pos)
+{
+    flush_code_points();
+    if (m_collecting_string) {
+        Frame& frame = m_frames.back();
+        const std::span<const JSON_Schema_Property> properties = frame.node->properties;
+        const auto it = std::ranges::lower_bound(
+            properties, std::u8string_view { m_string }, {}, &JSON_Schema_Property::key
+        );
+        if (it != properties.end() && it->key == m_string) {
+            m_seen_properties[frame.seen_begin + std::size_t(it - properties.begin())] = true;
+            frame.member_schema = it->schema;
+        }
+        else if (!frame.node->additional_properties) {
+            violation(m_string_pos, JSON_Schema_Error::additional_property, m_string);
+        }
+        m_collecting_string = false;
+    }
+    if (m_next) {
+        m_next->pop_property(pos);
+    }
+}
+
+void JSON_Schema_Validator::push_object(const Source_Position& pos)
+{
+    const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::object);
+    const std::size_t seen_begin = m_seen_properties.size();
+    if (node) {
+        m_seen_properties.resize(seen_begin + node->properties.size());
+    }
+    m_frames.push_back(
+        { .node = node, .pos = pos, .type = JSON_Type::object, .seen_begin = seen_begin }
+    );
+    if (m_next) {
+        m_next->push_object(pos);
+    }
+}
+
+void JSON_Schema_Validator::pop_object(const Source_Position& pos)
+{
+    ULIGHT_DEBUG_ASSERT(!m_frames.empty() && m_frames.back().type == JSON_Type::object);
+    const Frame& frame = m_frames.back();
+    if (frame.node) {
+        const std::span<const JSON_Schema_Property> properties = frame.node->properties;
+        for (std::size_t i = 0; i < properties.size(); ++i) {
+            if (properties[i].required && !m_seen_properties[frame.seen_begin + i]) {
+                violation(frame.pos, JSON_Schema_Error::missing_property, properties[i].key);
+            }
+        }
+    }
+    m_seen_properties.resize(frame.seen_begin);
+    m_frames.pop_back();
+    if (m_next) {
+        m_next->pop_object(pos);
+    }
+}
+
+void JSON_Schema_Validator::push_array(const Source_Position& pos)
+{
+    const JSON_Schema_Node* const node = begin_value(pos, JSON_Type::array);
+    m_frames.push_back({ .node = node, .pos = pos, .type = JSON_Type::array });
+    if (m_next) {
+        m_next->push_array(pos);
+    }
+}
+
+void JSON_Schema_Validator::pop_array(const Source_Position& pos)
+{
+    ULIGHT_DEBUG_ASSERT(!m_frames.empty() && m_frames.back().type == JSON_Type::array);
+    const Frame& frame = m_frames.back();
+    if (frame.node) {
+        if (frame.items < frame.node->min_items) {
+            violation(frame.pos, JSON_Schema_Error::min_items);
+        }
+        if (frame.items > frame.node->max_items) {
+            violation(frame.pos, JSON_Schema_Error::max_items);
+        }
+    }
+    m_frames.pop_back();
+    if (m_next) {
+        m_next->pop_array(pos);
+    }
+}
+
+void JSON_Schema_Validator::push_record(const Source_Position& pos)
+{
+    // Containers which were left open by a failed record must not leak into the next one.
+    m_frames.clear();
+    m_seen_properties.clear();
+    m_collecting_string = false;
+    if (m_next) {
+        m_next->push_record(pos);
+    }
+}
+
+void JSON_Schema_Validator::pop_record(const Source_Position& pos)
+{
+    if (m_next) {
+        m_next->pop_record(pos);
+    }
+}
+
+Error_Reaction JSON_Schema_Validator::error(const Source_Position& pos, JSON_Error error)
+{
+    return m_next ? m_next->error(pos, error) : Error_Reaction::abort;
+}
+
+const JSON_Schema_Node*
+JSON_Schema_Validator::begin_value(const Source_Position& pos, JSON_Type type)
+{
+    const JSON_Schema_Node* node = &m_root;
+    if (!m_frames.empty()) {
+        Frame& parent = m_frames.back();
+        if (parent.type == JSON_Type::array) {
+            ++parent.items;
+            node = parent.node ? parent.node->items : nullptr;
+        }
+        else {
+            node = parent.member_schema;
+        }
+    }
+    if (node && !node->permits(type)) {
+        violation(pos, JSON_Schema_Error::type);
+    }
+    return node;
+}
+
+void JSON_Schema_Validator::check_number(
+    const JSON_Schema_Node* node,
+    const Source_Position& pos,
+    double value
+)
+{
+    // A fractional number which is not permitted at all has already been reported as a type error.
+    if (node->integer && !is_integer(value) && node->permits(JSON_Type::number)) {
+        violation(pos, JSON_Schema_Error::type);
+    }
+    if (node->exclusive_minimum ? value <= node->minimum : value < node->minimum) {
+        violation(pos, JSON_Schema_Error::minimum);
+    }
+    if (node->exclusive_maximum ? value >= node->maximum : value > node->maximum) {
+        violation(pos, JSON_Schema_Error::maximum);
+    }
+    if (!node->enumeration.empty()
+        && std::ranges::none_of(node->enumeration, [&](const JSON_Value& e) {
+               return e.type() == JSON_Type::number && e.as_number() == value;
+           })) {
+        violation(pos, JSON_Schema_Error::enumeration);
+    }
+}
+
+void JSON_Schema_Validator::append_code_point(char32_t code_point)
+{
+    // Escape sequences are decoded one by one, and surrogate pairs have to be combined,
+    // so the state of the decoder is kept between calls.
+    json::Escape_Decoder decoder { m_leading_surrogate };
+    decoder.push(code_point, [&](std::u8string_view code_units) { m_string.append(code_units); });
+    m_leading_surrogate = decoder.leading_surrogate();
+}
+
+void JSON_Schema_Validator::flush_code_points()
+{
+    json::Escape_Decoder decoder { m_leading_surrogate };
+    decoder.flush([&](std::u8string_view code_units) { m_string.append(code_units); });
+    m_leading_surrogate = 0;
+}
+
+void JSON_Schema_Validator::violation(
+    const Source_Position& pos,
+    JSON_Schema_Error error,
+    std::u8string_view property
+)
+{
+    m_valid = false;
+    m_on_violation(JSON_Schema_Violation { .pos = pos, .error = error, .property = property });
+}
+
+bool validate_json(
+    std::u8string_view source,
+    const JSON_Schema& schema,
+    Function_Ref<void(const JSON_Schema_Violation&)> on_violation,
+    JSON_Options options
+)
+{
+    // Numbers are only converted by the validator if the schema constrains them.
+    options.parse_numbers = false;
+    options.parse_integers = false;
+    options.escapes = Escape_Parsing::parse_encode;
+    JSON_Schema_Validator validator { schema, on_violation };
+    const bool parsed = parse_json<JSON_Schema_Validator>(validator, source, options);
+    return parsed && validator.valid();
+}
+
+} // namespace ulight
@@ -1,11 +1,17 @@
 #include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "ulight/impl/ascii_algorithm.hpp"
 #include "ulight/ulight.hpp"
 
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/string_search.hpp"
 
 #include "ulight/impl/lang/bash.hpp"
 #include "ulight/impl/lang/bash_chars.hpp"
@@ -93,6 +99,96 @@ std::size_t match_identifier(std::u8string_view str)
     return ascii::length_if_head_tail(str, head, tail);
 }
 
+Heredoc_Delimiter_Result match_heredoc_delimiter(std::u8string_view str)
+{
+    // https://www.gnu.org/software/bash/manual/bash.html#Here-Documents
+    std::size_t length = 0;
+    bool quoted = false;
+    while (length < str.length()) {
+        const char8_t c = str[length];
+        if (c == u8'\\') {
+            quoted = true;
+            length = std::min(length + 2, str.length());
+        }
+        else if (c == u8'\'' || c == u8'"') {
+            quoted = true;
+            const std::size_t closing_index = str.find(c, length + 1);
+            if (closing_index == std::u8string_view::npos) {
+                return { .length = str.length(), .quoted = true };
+            }
+            length = closing_index + 1;
+        }
+        else if (is_bash_unquoted_terminator(c)) {
+            break;
+        }
+        else {
+            ++length;
+        }
+    }
+    return { .length = length, .quoted = quoted };
+}
+
+void append_unquoted(std::pmr::u8string& out, std::u8string_view word)
+{
+    // https://www.gnu.org/software/bash/manual/bash.html#Quote-Removal
+    char8_t quote = 0;
+    for (std::size_t i = 0; i < word.length(); ++i) {
+        const char8_t c = word[i];
+        if (quote != 0) {
+            if (c == quote) {
+                quote = 0;
+            }
+            else {
+                out.push_back(c);
+            }
+        }
+        else if (c == u8'\'' || c == u8'"') {
+            quote = c;
+        }
+        else if (c == u8'\\') {
+            if (i + 1 < word.length()) {
+                out.push_back(word[++i]);
+            }
+        }
+        else {
+            out.push_back(c);
+        }
+    }
+}
+
+Heredoc_Body_Result
+match_heredoc_body(std::u8string_view str, std::u8string_view delimiter, bool strip_tabs)
+{
+    // https://www.gnu.org/software/bash/manual/bash.html#Here-Documents
+    // Rather than comparing every line to the delimiter,
+    // we search for occurrences of the delimiter anywhere,
+    // and only check whether such an occurrence makes up a whole line.
+    // That way, long here-documents are skipped by a vectorized substring search.
+    std::size_t pos = 0;
+    while (true) {
+        pos = delimiter.empty() ? str.find(u8'\n', pos) : find_substring(str, delimiter, pos);
+        if (pos == std::u8string_view::npos) {
+            break;
+        }
+        const std::size_t end = pos + delimiter.length();
+        if (end == str.length() || str[end] == u8'\n') {
+            std::size_t begin = pos;
+            while (strip_tabs && begin != 0 && str[begin - 1] == u8'\t') {
+                --begin;
+            }
+            if (begin == 0 || str[begin - 1] == u8'\n') {
+                return {
+                    .content_length = begin,
+                    .delimiter_length = end - begin,
+                    .terminated = true,
+                };
+            }
+        }
+        ++pos;
+    }
+    return { .content_length = str.length(), .delimiter_length = 0, .terminated = false };
+}
+
 std::optional<Token_Type> match_operator(std::u8string_view str)
 {
     using enum Token_Type;
@@ -154,15 +250,49 @@ private:
         parameter_sub,
     };
 
+    /// @brief A here-document whose redirection has been highlighted,
+    /// but whose lines only begin after the end of the current line.
+    struct Pending_Heredoc {
+        /// @brief The delimiter line, after quote removal.
+        std::pmr::u8string delimiter;
+        /// @brief The language that the lines are written in, guessed from the delimiter.
+        Lang lang;
+        /// @brief `true` if the redirection was `<<-`,
+        /// in which case leading tabs are stripped from the lines.
+        bool strip_tabs;
+        /// @brief `true` if the delimiter is unquoted,
+        /// in which case substitutions take place within the lines.
+        bool expand;
+        /// @brief The index at which the lines were matched in advance.
+        std::size_t lines_begin;
+        /// @brief The lines, as matched at `lines_begin`.
+        Heredoc_Body_Result lines;
+    };
+
+    struct Missing_Delimiter {
+        std::pmr::u8string delimiter;
+        /// @brief `true` if leading tabs were ignored in the search,
+        /// which means that the search also failed without ignoring them.
+        bool strip_tabs;
+    };
+
     State state = State::before_command;
+    std::pmr::vector<Pending_Heredoc> pending_heredocs;
+    /// @brief Delimiters for which no delimiter line was found after some redirection.
+    /// Since there is no such line after any later redirection either,
+    /// we don't search again, which keeps repeated shifts like "$((x << 2))" linear.
+    std::pmr::vector<Missing_Delimiter> missing_delimiters;
 
 public:
     Highlighter(
         Non_Owning_Buffer<Token>& out,
         std::u8string_view source,
+        std::pmr::memory_resource* memory,
         const Highlight_Options& options
     )
-        : Highlighter_Base { out, source, options }
+        : Highlighter_Base { out, source, memory, options }
+        , pending_heredocs { memory }
+        , missing_delimiters { memory }
     {
     }
 
@@ -188,7 +318,7 @@ private:
             }
             case u8'"': {
                 emit_and_advance(1, Highlight_Type::string_delim);
-                consume_double_quoted_string();
+                consume_expandable_text(true);
                 continue;
             }
             case u8'#': {
@@ -209,10 +339,17 @@ private:
                 continue;
             }
             case u8'\v':
-            case u8'\r':
+            case u8'\r': {
+                advance(1);
+                state = State::before_command;
+                continue;
+            }
             case u8'\n': {
                 advance(1);
                 state = State::before_command;
+                if (!pending_heredocs.empty()) {
+                    consume_heredocs();
+                }
                 continue;
             }
             case u8'$': {
@@ -233,6 +370,9 @@ private:
                 const std::optional<Token_Type> op = match_operator(remainder);
                 ULIGHT_ASSERT(op);
                 emit_and_advance(token_type_length(*op), Highlight_Type::sym_op);
+                if (op == Token_Type::less_less) {
+                    consume_heredoc_redirection();
+                }
                 continue;
             }
             case u8')': {
@@ -259,6 +399,127 @@ private:
         }
     }
 
+    /// @brief Consumes the remainder of a `<<` or `<<-` redirection,
+    /// i.e. the optional `-` and the delimiter word.
+    /// The lines of the here-document are only consumed once the current line ends.
+    void consume_heredoc_redirection()
+    {
+        // https://www.gnu.org/software/bash/manual/bash.html#Here-Documents
+        const bool strip_tabs = remainder.starts_with(u8'-');
+        if (strip_tabs) {
+            emit_and_advance(1, Highlight_Type::sym_op);
+        }
+        advance(match_blank(remainder));
+        const Heredoc_Delimiter_Result delimiter = match_heredoc_delimiter(remainder);
+        if (!delimiter) {
+            return;
+        }
+        std::pmr::u8string delimiter_line { memory };
+        append_unquoted(delimiter_line, remainder.substr(0, delimiter.length));
+
+        // Bash would read an unterminated here-document up to the end of the input.
+        // However, "<<" is also a shift in arithmetic like "$((x << 2))",
+        // so we only treat this as a here-document if there is a delimiter line.
+        const std::size_t line_end = remainder.find(u8'\n', delimiter.length);
+        if (line_end == std::u8string_view::npos) {
+            return;
+        }
+        const auto is_known_missing = [&](const Missing_Delimiter& missing) {
+            return missing.delimiter == delimiter_line && (missing.strip_tabs || !strip_tabs);
+        };
+        if (std::ranges::any_of(missing_delimiters, is_known_missing)) {
+            return;
+        }
+        const Heredoc_Body_Result lines
+            = match_heredoc_body(remainder.substr(line_end + 1), delimiter_line, strip_tabs);
+        if (!lines.terminated) {
+            missing_delimiters.push_back({ std::move(delimiter_line), strip_tabs });
+            return;
+        }
+        const Lang lang = guess_heredoc_lang(delimiter_line);
+        pending_heredocs.push_back({
+            .delimiter = std::move(delimiter_line),
+            .lang = lang,
+            .strip_tabs = strip_tabs,
+            .expand = !delimiter.quoted,
+            .lines_begin = index + line_end + 1,
+            .lines = lines,
+        });
+        emit_and_advance(delimiter.length, Highlight_Type::string_delim);
+    }
+
+    /// @brief Guesses the language of a here-document from its delimiter,
+    /// following the common convention of naming the delimiter after the language,
+    /// like `<<'JSON'` or `<<HTML`.
+    [[nodiscard]]
+    static Lang guess_heredoc_lang(std::u8string_view delimiter)
+    {
+        // Single letters like "C" are too commonly used as arbitrary delimiters.
+        constexpr std::size_t max_length = 16;
+        if (delimiter.length() < 2 || delimiter.length() > max_length) {
+            return Lang::none;
+        }
+        char8_t lower[max_length];
+        std::ranges::transform(delimiter, lower, [](char8_t c) { return to_ascii_lower(c); });
+        const Lang result = get_lang(std::u8string_view { lower, delimiter.length() });
+        return result == Lang::txt ? Lang::none : result;
+    }
+
+    /// @brief Consumes the lines of all pending here-documents,
+    /// which follow one another, starting at the current position.
+    void consume_heredocs()
+    {
+        for (const Pending_Heredoc& heredoc : pending_heredocs) {
+            // Usually, the lines of the first here-document have already been matched
+            // when its redirection was highlighted.
+            const Heredoc_Body_Result body = heredoc.lines_begin == index
+                ? heredoc.lines
+                : match_heredoc_body(remainder, heredoc.delimiter, heredoc.strip_tabs);
+            if (!body.terminated) {
+                break;
+            }
+            consume_heredoc_content(heredoc, body.content_length);
+            const std::size_t tabs_length = body.delimiter_length - heredoc.delimiter.length();
+            advance(tabs_length);
+            if (!heredoc.delimiter.empty()) {
+                emit_and_advance(heredoc.delimiter.length(), Highlight_Type::string_delim);
+            }
+            if (remainder.starts_with(u8'\n')) {
+                advance(1);
+            }
+        }
+        pending_heredocs.clear();
+    }
+
+    void consume_heredoc_content(const Pending_Heredoc& heredoc, std::size_t length)
+    {
+        if (length == 0) {
+            return;
+        }
+        const std::u8string_view content = remainder.substr(0, length);
+        // Substitutions within the lines would be misinterpreted by the nested language,
+        // so if there are any, we highlight the lines like a double-quoted string instead.
+        const bool has_substitutions = heredoc.expand
+            && content.find_first_of(u8"$`\\") != std::u8string_view::npos;
+        if (heredoc.lang != Lang::none && !has_substitutions) {
+            Token nested_tokens[1024];
+            const Status status = consume_nested_language(heredoc.lang, length, nested_tokens);
+            ULIGHT_ASSERT(status == Status::ok);
+            return;
+        }
+        if (!heredoc.expand) {
+            emit_and_advance(length, Highlight_Type::string);
+            return;
+        }
+        // The lines are highlighted by a separate highlighter which only sees these lines,
+        // so that unterminated substitutions within cannot extend past the delimiter line.
+        Token nested_tokens[256];
+        Non_Owning_Buffer<Token> sub = sub_buffer(nested_tokens);
+        Highlighter { sub, content, memory, options }.consume_expandable_text(false);
+        sub.flush();
+        advance(length);
+    }
+
     void consume_word(Context context)
     {
         std::size_t length = 0;
@@ -319,7 +580,11 @@ private:
         }
     }
 
-    void consume_double_quoted_string()
+    /// @brief Consumes text in which substitutions take place, but which is otherwise literal.
+    /// @param quoted If `true`, the text is the content of a double-quoted string,
+    /// and is terminated by `"`.
+    /// Otherwise, the text is made up of the lines of a here-document.
+    void consume_expandable_text(bool quoted)
     {
         std::size_t chars = 0;
         const auto flush_chars = [&] {
@@ -330,14 +595,15 @@ private:
         };
 
         for (; chars < remainder.length();) {
-            if (remainder[chars] == u8'\"') {
+            if (quoted && remainder[chars] == u8'\"') {
                 flush_chars();
                 emit_and_advance(1, Highlight_Type::string_delim);
                 return;
             }
             if (remainder[chars] == u8'\\' //
                 && chars + 1 < remainder.length() //
-                && is_bash_escapable_in_double_quotes(remainder[chars + 1])) {
+                && (quoted ? is_bash_escapable_in_double_quotes(remainder[chars + 1])
+                           : is_bash_escapable_in_heredoc(remainder[chars + 1]))) {
                 flush_chars();
                 emit_and_advance(2, Highlight_Type::escape);
                 continue;
@@ -398,11 +664,11 @@ private:
 bool highlight_bash(
     Non_Owning_Buffer<Token>& out,
     std::u8string_view source,
-    std::pmr::memory_resource*,
+    std::pmr::memory_resource* memory,
     const Highlight_Options& options
 )
 {
-    return bash::Highlighter { out, source, options }();
+    return bash::Highlighter { out, source, memory, options }();
 }
 
 } // namespace ulight
@@ -10,6 +10,7 @@
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/string_search.hpp"
 #include "ulight/impl/unicode_algorithm.hpp"
 
 #include "ulight/impl/lang/cowel.hpp"
@@ -55,8 +56,8 @@ std::size_t match_line_comment(std::u8string_view str)
         return 0;
     }
 
-    constexpr auto is_terminator = [](char8_t c) { return c == u8'\r' || c == u8'\n'; };
-    return ascii::length_if_not(str, is_terminator, 2);
+    const std::size_t result = find_either(str, u8'\r', u8'\n', 2);
+    return result == std::u8string_view::npos ? str.length() : result;
 }
 
 bool starts_with_escape_comment_directive(std::u8string_view str)
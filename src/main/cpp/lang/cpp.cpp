@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <memory_resource>
@@ -14,7 +15,9 @@
 #include "ulight/impl/escapes.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/numbers.hpp"
+#include "ulight/impl/profile.hpp"
 #include "ulight/impl/unicode.hpp"
+#include "ulight/impl/unicode_algorithm.hpp"
 
 #include "ulight/impl/lang/cpp.hpp"
 #include "ulight/impl/lang/cpp_chars.hpp"
@@ -235,15 +238,6 @@ Literal_Match_Result match_integer_literal(std::u8string_view s)
 
 namespace {
 
-[[nodiscard]]
-bool is_identifier_start_likely_ascii(char32_t c)
-{
-    if (is_ascii(c)) [[likely]] {
-        return is_cpp_ascii_identifier_start(c);
-    }
-    return is_cpp_identifier_start(c);
-}
-
 [[nodiscard]]
 bool is_identifier_continue_likely_ascii(char32_t c)
 {
@@ -321,27 +315,28 @@ std::size_t match_pp_number(const std::u8string_view str)
 
 std::size_t match_identifier(std::u8string_view str)
 {
-    std::size_t length = 0;
+    if (str.empty()) {
+        return 0;
+    }
 
-    if (!str.empty()) {
-        const auto [code_point, units] = utf8::decode_and_length_or_replacement(str);
-        if (!is_identifier_start_likely_ascii(code_point)) {
-            return length;
+    std::size_t length = 1;
+    if (is_ascii(str[0])) [[likely]] {
+        if (!is_cpp_ascii_identifier_start(str[0])) {
+            return 0;
         }
-        str.remove_prefix(std::size_t(units));
-        length += std::size_t(units);
     }
-
-    while (!str.empty()) {
+    else {
         const auto [code_point, units] = utf8::decode_and_length_or_replacement(str);
-        if (!is_identifier_continue_likely_ascii(code_point)) {
-            return length;
+        if (!is_cpp_identifier_start(code_point)) {
+            return 0;
         }
-        str.remove_prefix(std::size_t(units));
-        length += std::size_t(units);
+        length = std::size_t(units);
     }
 
-    return length;
+    constexpr auto is_continue = [](char32_t c) { return is_cpp_identifier_continue(c); };
+    return utf8::length_if_likely_ascii(
+        str, is_cpp_ascii_identifier_continue_set, is_continue, length
+    );
 }
 
 Escape_Result match_escape_sequence(std::u8string_view str)
@@ -444,7 +439,10 @@ Escape_Result match_escape_sequence(std::u8string_view str)
     }
 
     default: {
-        return { .length = 2,
+        // The escaped character may be a multi-byte code point,
+        // and we must not split it, or the caller would be left in the middle of a sequence.
+        const auto units = std::size_t(utf8::sequence_length(str[1], 1));
+        return { .length = std::min(1 + std::max(units, std::size_t(1)), str.length()),
                  .type = Escape_Type::conditional,
                  .erroneous = !is_cpp_basic(str[1]) };
     }
@@ -579,6 +577,50 @@ Highlight_Type usual_fallback_highlight(std::u8string_view id)
     return id.ends_with(u8"_t") ? Highlight_Type::id_type : Highlight_Type::id;
 }
 
+/// @brief Classifies the first code unit of a token,
+/// which determines the rules in `Highlighter` that can possibly match.
+enum struct Leading_Byte : Underlying {
+    /// @brief Anything not covered by the other classes.
+    /// This can only begin an operator or punctuator, or stray non-whitespace like `\`.
+    other,
+    /// @brief See `is_cpp_whitespace`.
+    whitespace,
+    /// @brief `/`, which begins a comment or an operator.
+    slash,
+    /// @brief `.`, which begins a pp-number like `.5`, or an operator.
+    dot,
+    /// @brief `[0-9]`, which begins a pp-number.
+    digit,
+    /// @brief `"`, which begins a string literal without prefix.
+    double_quote,
+    /// @brief `'`, which begins a character literal without prefix.
+    single_quote,
+    /// @brief `[A-Za-z_]` or any non-ASCII code unit,
+    /// which may begin an identifier, or the prefix of a string or character literal.
+    identifier,
+};
+
+constexpr auto leading_byte_table = [] {
+    std::array<Leading_Byte, 256> result {};
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        const auto c = char8_t(i);
+        if (is_cpp_whitespace(c)) {
+            result[i] = Leading_Byte::whitespace;
+        }
+        else if (is_ascii_digit(c)) {
+            result[i] = Leading_Byte::digit;
+        }
+        else if (!is_ascii(c) || is_cpp_ascii_identifier_start(c)) {
+            result[i] = Leading_Byte::identifier;
+        }
+    }
+    result[u8'/'] = Leading_Byte::slash;
+    result[u8'.'] = Leading_Byte::dot;
+    result[u8'"'] = Leading_Byte::double_quote;
+    result[u8'\''] = Leading_Byte::single_quote;
+    return result;
+}();
+
 // Approximately implements highlighting based on C++ tokenization,
 // as described in:
 // https://eel.is/c++draft/lex.phases
@@ -653,20 +695,68 @@ public:
     bool operator()()
     {
         while (index < source.size()) {
-            const bool any_matched = expect_whitespace() //
-                || expect_line_comment() //
-                || expect_block_comment() //
-                || expect_string_literal() //
-                || expect_character_literal() //
-                || expect_pp_number() //
-                || expect_identifier_or_keyword(usual_fallback_highlight) //
-                || expect_preprocessing_op_or_punc() //
-                || expect_non_whitespace();
+            const bool any_matched = expect_token();
             ULIGHT_ASSERT(any_matched);
         }
         return true;
     }
 
+    /// @brief Matches a single token.
+    /// Rather than trying every rule in sequence,
+    /// the first code unit is used to select the only rule that can match,
+    /// or a short sequence of rules in the few ambiguous cases.
+    bool expect_token()
+    {
+        switch (leading_byte_table[source[index]]) {
+        case Leading_Byte::whitespace: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_whitespace());
+        }
+        case Leading_Byte::slash: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_line_comment()) //
+                || ULIGHT_PROFILE_RULE(c_or_cpp, expect_block_comment()) //
+                || ULIGHT_PROFILE_RULE(c_or_cpp, expect_preprocessing_op_or_punc());
+        }
+        case Leading_Byte::dot: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_pp_number()) //
+                || ULIGHT_PROFILE_RULE(c_or_cpp, expect_preprocessing_op_or_punc());
+        }
+        case Leading_Byte::digit: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_pp_number());
+        }
+        case Leading_Byte::double_quote: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_string_literal(0));
+        }
+        case Leading_Byte::single_quote: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_character_literal(0));
+        }
+        case Leading_Byte::identifier: {
+            const std::size_t id_length = match_identifier(remainder());
+            if (id_length == 0) {
+                // Non-ASCII characters that cannot begin an identifier
+                // also cannot begin any operator or punctuator.
+                return ULIGHT_PROFILE_RULE(c_or_cpp, expect_non_whitespace());
+            }
+            // Identifiers directly followed by quotes are encoding prefixes, like in u8"...".
+            const std::size_t end = index + id_length;
+            const char8_t next = end < source.length() ? source[end] : u8'\0';
+            if (next == u8'"') {
+                return ULIGHT_PROFILE_RULE(c_or_cpp, expect_string_literal(id_length));
+            }
+            if (next == u8'\'') {
+                return ULIGHT_PROFILE_RULE(c_or_cpp, expect_character_literal(id_length));
+            }
+            return ULIGHT_PROFILE_RULE(
+                c_or_cpp, expect_identifier_or_keyword(id_length, usual_fallback_highlight)
+            );
+        }
+        case Leading_Byte::other: {
+            return ULIGHT_PROFILE_RULE(c_or_cpp, expect_preprocessing_op_or_punc()) //
+                || ULIGHT_PROFILE_RULE(c_or_cpp, expect_non_whitespace());
+        }
+        }
+        ULIGHT_ASSERT_UNREACHABLE(u8"Invalid leading byte class.");
+    }
+
     bool expect_whitespace()
     {
         if (const std::size_t white_length = match_whitespace(remainder())) {
@@ -708,12 +798,13 @@ public:
         return false;
     }
 
-    bool expect_character_literal()
+    /// @brief Matches a character literal, if `prefix_length` code units of the identifier
+    /// at the current position are followed by `'`.
+    bool expect_character_literal(std::size_t prefix_length)
     {
         // https://eel.is/c++draft/lex#nt:character-literal
         constexpr char8_t quote_char = u8'\'';
 
-        const std::size_t prefix_length = match_identifier(remainder());
         if (index + prefix_length >= source.length()
             || source[index + prefix_length] != quote_char) {
             return false;
@@ -734,12 +825,13 @@ public:
         return true;
     }
 
-    bool expect_string_literal()
+    /// @brief Matches a string literal, if `prefix_length` code units of the identifier
+    /// at the current position are followed by `"`.
+    bool expect_string_literal(std::size_t prefix_length)
     {
         // https://eel.is/c++draft/lex.string#:string-literal
         constexpr char8_t quote_char = u8'"';
 
-        const std::size_t prefix_length = match_identifier(remainder());
         if (index + prefix_length >= source.length()
             || source[index + prefix_length] != quote_char) {
             return false;
@@ -991,9 +1083,17 @@ public:
     bool expect_identifier_or_keyword(Highlight_Type fallback_highlight(std::u8string_view))
     {
         const std::size_t id_length = match_identifier(remainder());
-        if (id_length == 0) {
-            return false;
-        }
+        return id_length != 0 && expect_identifier_or_keyword(id_length, fallback_highlight);
+    }
+
+    /// @brief Like `expect_identifier_or_keyword(fallback_highlight)`,
+    /// but for an already matched identifier of length `id_length`.
+    bool expect_identifier_or_keyword(
+        std::size_t id_length,
+        Highlight_Type fallback_highlight(std::u8string_view)
+    )
+    {
+        ULIGHT_DEBUG_ASSERT(id_length != 0);
         const std::u8string_view id = remainder().substr(0, id_length);
         const std::optional<Token_Type> keyword = cpp_token_type_by_code(id);
         const auto highlight = keyword && feature_in_mask(*keyword, feature_source_mask)
@@ -1,13 +1,17 @@
+#include <algorithm>
 #include <cstddef>
 #include <memory_resource>
 #include <string_view>
+#include <vector>
 
 #include "ulight/ulight.hpp"
 
+#include "ulight/impl/ascii_algorithm.hpp"
 #include "ulight/impl/assert.hpp"
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/string_search.hpp"
 #include "ulight/impl/strings.hpp"
 #include "ulight/impl/unicode.hpp"
 
@@ -19,6 +23,31 @@
 namespace ulight {
 namespace css {
 
+namespace {
+
+constexpr Code_Unit_Range identifier_ranges[] {
+    { u8'a', u8'z' }, { u8'A', u8'Z' }, { u8'0', u8'9' },
+    { u8'_', u8'_' }, { u8'-', u8'-' }, { 0x80, 0xff },
+};
+
+constexpr Code_Unit_Range digit_ranges[] { { u8'0', u8'9' } };
+
+/// @brief Returns the position of the first code unit at or after `start`
+/// which is not `is_css_identifier`, or `str.length()` if there is none.
+[[nodiscard]]
+std::size_t skip_identifier(std::u8string_view str, std::size_t start)
+{
+    return std::min(find_first_not_in_ranges(str, identifier_ranges, start), str.length());
+}
+
+[[nodiscard]]
+std::size_t skip_digits(std::u8string_view str, std::size_t start)
+{
+    return std::min(find_first_not_in_ranges(str, digit_ranges, start), str.length());
+}
+
+} // namespace
+
 bool starts_with_number(std::u8string_view str)
 {
     // https://www.w3.org/TR/css-syntax-3/#check-if-three-code-points-would-start-a-number
@@ -52,11 +81,7 @@ std::size_t match_number(std::u8string_view str)
 {
     // https://www.w3.org/TR/css-syntax-3/#consume-number
     std::size_t length = 0;
-    const auto consume_digits = [&] {
-        while (length < str.length() && is_ascii_digit(str[length])) {
-            ++length;
-        }
-    };
+    const auto consume_digits = [&] { length = skip_digits(str, length); };
 
     if (str.starts_with(u8'+') || str.starts_with(u8'-')) {
         ++length;
@@ -107,16 +132,15 @@ std::size_t match_ident_sequence(std::u8string_view str)
     // https://www.w3.org/TR/css-syntax-3/#consume-name
     std::size_t length = 0;
     while (length < str.length()) {
-        if (starts_with_valid_escape(str.substr(length))) {
-            ++length;
-            length += match_escaped_code_point(str.substr(length));
-        }
-        else if (is_css_identifier(str[length])) {
-            ++length;
-        }
-        else {
+        // Since backslashes are not identifier characters,
+        // we can skip over whole runs of identifier characters
+        // and only need to look for escapes where such a run ends.
+        length = skip_identifier(str, length);
+        if (!starts_with_valid_escape(str.substr(length))) {
             break;
         }
+        ++length;
+        length += match_escaped_code_point(str.substr(length));
     }
     return length;
 }
@@ -153,7 +177,8 @@ namespace {
 /// The `Context` is the best guess we have regarding the content that we're
 /// currently highlighting.
 enum struct Context : Underlying {
-    /// @brief Highlighting top-level content, such as stylesheets.
+    /// @brief Highlighting top-level content, such as stylesheets,
+    /// or the selector of a style rule, which may be nested in another style rule.
     top_level,
     /// @brief The prelude of an at rule, such as "@layer something".
     at_prelude,
@@ -163,20 +188,112 @@ enum struct Context : Underlying {
     value
 };
 
+/// @brief The kind of at-rule whose prelude is being highlighted,
+/// which determines what the block of that at-rule contains.
+enum struct At_Rule_Kind : Underlying {
+    /// @brief An at-rule whose block contains declarations, like `@font-face` or `@page`.
+    /// Unknown at-rules are also treated this way.
+    declarations,
+    /// @brief A grouping rule like `@media` or `@layer`,
+    /// whose block contains the same kind of items as the block that the rule appears in.
+    group,
+    /// @brief `@keyframes`, whose block contains rules with selectors like `from` or `50%`.
+    keyframes,
+};
+
+[[nodiscard]]
+At_Rule_Kind classify_at_rule(std::u8string_view name)
+{
+    // Vendor-prefixed rules like "@-webkit-keyframes" behave like their unprefixed forms.
+    if (name.starts_with(u8'-')) {
+        if (const std::size_t prefix_end = name.find(u8'-', 1);
+            prefix_end != std::u8string_view::npos) {
+            name.remove_prefix(prefix_end + 1);
+        }
+    }
+    static constexpr std::u8string_view group_rules[] {
+        u8"container", u8"document", u8"layer", u8"media", u8"scope", u8"starting-style",
+        u8"supports",
+    };
+    for (const std::u8string_view rule : group_rules) {
+        if (equals_ascii_ignore_case(name, rule)) {
+            return At_Rule_Kind::group;
+        }
+    }
+    return equals_ascii_ignore_case(name, u8"keyframes") ? At_Rule_Kind::keyframes
+                                                          : At_Rule_Kind::declarations;
+}
+
+/// @brief Returns `true` if the item at the start of `str` within a block of declarations
+/// is a nested style rule like `& .child { ... }` rather than a declaration like `color: red`.
+/// https://www.w3.org/TR/css-nesting-1/#syntax
+///
+/// Like the CSS parser, which only falls back to parsing a rule once parsing a declaration
+/// has failed, this looks ahead to the end of the item:
+/// the item is a rule if a `{` comes before any `;` or `}`.
+/// However, custom properties like `--x: { ... }` are always declarations.
+[[nodiscard]]
+bool starts_with_nested_rule(std::u8string_view str)
+{
+    static constexpr Charset256 is_item_special_set = detail::to_charset256(u8"{};\"'/");
+
+    std::size_t i = html::match_whitespace(str);
+    if (str.substr(i).starts_with(u8"--")) {
+        return false;
+    }
+    while (true) {
+        i = ascii::find_if(str, [](char8_t c) { return is_item_special_set.contains(c); }, i);
+        if (i == std::u8string_view::npos) {
+            return false;
+        }
+        switch (str[i]) {
+        case u8'{': return true;
+        case u8'}':
+        case u8';': return false;
+        case u8'"':
+        case u8'\'': {
+            // Quotes within the string are escaped, and newlines terminate the string.
+            const char8_t quote = str[i];
+            for (++i; i < str.length() && str[i] != quote && !is_css_newline(str[i]); ++i) {
+                i += std::size_t(str[i] == u8'\\');
+            }
+            ++i;
+            break;
+        }
+        default: {
+            const cpp::Comment_Result comment = cpp::match_block_comment(str.substr(i));
+            i += comment ? comment.length : 1;
+            break;
+        }
+        }
+        if (i >= str.length()) {
+            return false;
+        }
+    }
+}
+
 constexpr Highlight_Type selector_highlight_type = Highlight_Type::markup_tag;
 
 struct Highlighter : Highlighter_Base {
 private:
-    std::size_t brace_level = 0;
+    /// @brief For each enclosing block,
+    /// the context in which items within that block begin:
+    /// `Context::top_level` for blocks which contain rules (such as the block of `@media`),
+    /// and `Context::block` for blocks which contain declarations and nested rules
+    /// (such as the block of a style rule).
+    std::pmr::vector<Context> block_contexts;
     Context context = Context::top_level;
+    At_Rule_Kind at_rule = At_Rule_Kind::declarations;
 
 public:
     Highlighter(
         Non_Owning_Buffer<Token>& out,
         std::u8string_view source,
+        std::pmr::memory_resource* memory,
         const Highlight_Options& options
     )
-        : Highlighter_Base { out, source, options }
+        : Highlighter_Base { out, source, memory, options }
+        , block_contexts { memory }
     {
     }
 
@@ -260,6 +377,16 @@ public:
                 emit_and_advance(1, Highlight_Type::error);
                 break;
             }
+            case u8'&': {
+                // Example: "&:hover", which refers to the parent rule's selector.
+                if (context == Context::top_level) {
+                    emit_and_advance(1, selector_highlight_type, Coalescing::forced);
+                }
+                else {
+                    emit_and_advance(1, Highlight_Type::sym_op);
+                }
+                break;
+            }
             case u8',': {
                 emit_and_advance(1, Highlight_Type::sym_punc);
                 break;
@@ -286,13 +413,8 @@ public:
                 break;
             }
             case u8';': {
-                if (context == Context::value) {
-                    context = Context::block;
-                }
-                else if (context == Context::at_prelude) {
-                    context = Context::top_level;
-                }
                 emit_and_advance(1, Highlight_Type::sym_punc);
+                begin_item();
                 break;
             }
             case u8'<': {
@@ -321,6 +443,8 @@ public:
                 context = Context::at_prelude;
                 if (starts_with_ident_sequence(remainder.substr(1))) {
                     emit_and_advance(1, Highlight_Type::macro);
+                    const std::size_t name_length = match_ident_sequence(remainder);
+                    at_rule = classify_at_rule(remainder.substr(0, name_length));
                     consume_ident_like_token(Highlight_Type::macro);
                 }
                 else {
@@ -361,19 +485,17 @@ public:
                 break;
             }
             case u8'{': {
-                ++brace_level;
-                context = Context::block;
+                block_contexts.push_back(block_context());
                 emit_and_advance(1, Highlight_Type::sym_brace);
+                begin_item();
                 break;
             }
             case u8'}': {
-                if (brace_level != 0) {
-                    --brace_level;
-                }
-                if (brace_level == 0) {
-                    context = Context::top_level;
+                if (!block_contexts.empty()) {
+                    block_contexts.pop_back();
                 }
                 emit_and_advance(1, Highlight_Type::sym_brace);
+                begin_item();
                 break;
             }
             case u8'0':
@@ -403,6 +525,40 @@ public:
         return true;
     }
 
+    /// @brief Returns the context in which items begin within a block that is opened
+    /// in the current context.
+    [[nodiscard]]
+    Context block_context() const
+    {
+        if (context != Context::at_prelude) {
+            return Context::block;
+        }
+        switch (at_rule) {
+        case At_Rule_Kind::declarations: return Context::block;
+        case At_Rule_Kind::group: return item_context();
+        case At_Rule_Kind::keyframes: return Context::top_level;
+        }
+        ULIGHT_ASSERT_UNREACHABLE();
+    }
+
+    /// @brief Returns the context in which items begin within the innermost block.
+    [[nodiscard]]
+    Context item_context() const
+    {
+        return block_contexts.empty() ? Context::top_level : block_contexts.back();
+    }
+
+    /// @brief Sets the context for the item which starts at the current position.
+    /// Within blocks of declarations, this may also be a nested style rule,
+    /// whose selector is highlighted like a top-level selector.
+    void begin_item()
+    {
+        context = item_context();
+        if (context == Context::block && starts_with_nested_rule(remainder)) {
+            context = Context::top_level;
+        }
+    }
+
     void consume_whitespace()
     {
         advance(html::match_whitespace(remainder));
@@ -476,15 +632,18 @@ public:
 
     void consume_ident_like_token(Highlight_Type default_type)
     {
-        const Ident_Result result = match_ident_like_token(remainder);
-        ULIGHT_ASSERT(result);
-
+        // Only identifiers in values are highlighted according to the kind of token,
+        // so the extra lookahead is unnecessary in other contexts.
+        const Ident_Type ident_type = default_type == Highlight_Type::id
+            ? match_ident_like_token(remainder).type
+            : Ident_Type::ident;
         const auto actual_type = //
-            default_type != Highlight_Type::id    ? default_type
-            : result.type == Ident_Type::function ? Highlight_Type::id_function
-            : result.type == Ident_Type::url      ? Highlight_Type::keyword
-                                                  : Highlight_Type::id;
+            default_type != Highlight_Type::id   ? default_type
+            : ident_type == Ident_Type::function ? Highlight_Type::id_function
+            : ident_type == Ident_Type::url      ? Highlight_Type::keyword
+                                                 : Highlight_Type::id;
 
+        const std::size_t start = index;
         std::size_t length = 0;
         const auto flush = [&] {
             if (length != 0) {
@@ -493,20 +652,17 @@ public:
             }
         };
 
-        while (length < remainder.length()) {
-            if (starts_with_valid_escape(remainder.substr(length))) {
-                flush();
-                const std::size_t escape_length = match_escaped_code_point(remainder.substr(1)) + 1;
-                emit_and_advance(escape_length, Highlight_Type::escape);
-            }
-            else if (is_css_identifier(remainder[length])) {
-                ++length;
-            }
-            else {
+        while (true) {
+            length = skip_identifier(remainder, length);
+            if (!starts_with_valid_escape(remainder.substr(length))) {
                 break;
             }
+            flush();
+            const std::size_t escape_length = match_escaped_code_point(remainder.substr(1)) + 1;
+            emit_and_advance(escape_length, Highlight_Type::escape);
         }
         flush();
+        ULIGHT_ASSERT(index != start);
     }
 };
 
@@ -517,11 +673,11 @@ public:
 bool highlight_css(
     Non_Owning_Buffer<Token>& out,
     std::u8string_view source,
-    std::pmr::memory_resource*,
+    std::pmr::memory_resource* memory,
     const Highlight_Options& options
 )
 {
-    return css::Highlighter { out, source, options }();
+    return css::Highlighter { out, source, memory, options }();
 }
 
 } // namespace ulight
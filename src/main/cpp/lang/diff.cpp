@@ -1,6 +1,18 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 
+#include "ulight/function_ref.hpp"
+
+#include "ulight/impl/ascii_chars.hpp"
 #include "ulight/impl/buffer.hpp"
+#include "ulight/impl/edit_script.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
 #include "ulight/impl/parse_utils.hpp"
@@ -36,20 +48,227 @@ Highlight_Type choose_line_highlight(std::u8string_view line)
 
 namespace {
 
+/// @brief Matches a range like `-1,7` or `+8` in a hunk heading at the start of `str`,
+/// and stores the amount of lines (the part after the comma) in `lines`.
+/// @returns The length of the range, or zero if there is none.
+[[nodiscard]]
+std::size_t match_hunk_range(std::u8string_view str, char8_t sign, std::size_t& lines)
+{
+    if (!str.starts_with(sign)) {
+        return 0;
+    }
+    const auto* const begin = reinterpret_cast<const char*>(str.data());
+    const auto* const end = begin + str.length();
+    std::size_t start = 0;
+    const auto [start_end, start_error] = std::from_chars(begin + 1, end, start);
+    if (start_error != std::errc {}) {
+        return 0;
+    }
+    lines = 1;
+    if (start_end == end || *start_end != ',') {
+        return std::size_t(start_end - begin);
+    }
+    const auto [lines_end, lines_error] = std::from_chars(start_end + 1, end, lines);
+    if (lines_error != std::errc {}) {
+        return 0;
+    }
+    return std::size_t(lines_end - begin);
+}
+
+} // namespace
+
+std::optional<Hunk_Header> match_hunk_header(std::u8string_view line)
+{
+    // https://www.gnu.org/software/diffutils/manual/html_node/Detailed-Unified.html
+    if (!line.starts_with(u8"@@ ")) {
+        return {};
+    }
+    line.remove_prefix(3);
+    Hunk_Header result {};
+    const std::size_t old_length = match_hunk_range(line, u8'-', result.old_lines);
+    if (old_length == 0 || line.substr(old_length, 1) != u8" ") {
+        return {};
+    }
+    line.remove_prefix(old_length + 1);
+    const std::size_t new_length = match_hunk_range(line, u8'+', result.new_lines);
+    if (new_length == 0 || !line.substr(new_length).starts_with(u8" @@")) {
+        return {};
+    }
+    return result;
+}
+
+std::u8string_view file_heading_path(std::u8string_view line)
+{
+    ULIGHT_ASSERT(line.starts_with(u8"--- ") || line.starts_with(u8"+++ "));
+    const std::u8string_view rest = line.substr(4);
+    return rest.substr(0, rest.find(u8'\t'));
+}
+
+namespace {
+
+/// @brief The role of a line within the hunks of a file.
+enum struct Line_Kind : Underlying {
+    /// @brief A hunk heading.
+    hunk_heading,
+    /// @brief A line such as `\ No newline at end of file` which belongs to neither side.
+    note,
+    /// @brief A context line, which belongs to both sides.
+    common,
+    /// @brief A deleted line, which belongs to the old side.
+    deletion,
+    /// @brief An inserted line, which belongs to the new side.
+    insertion,
+};
+
+/// @brief A line within the hunks of a file.
+struct Hunk_Line {
+    /// @brief The position of the first code unit of the line within the source.
+    std::size_t begin;
+    /// @brief The length of the line contents, including the marker.
+    std::size_t length;
+    std::size_t terminator_length;
+    Line_Kind kind;
+    /// @brief The position of the line contents (excluding the marker) within the side
+    /// which provides its highlighting.
+    std::size_t side_begin = 0;
+};
+
+/// @brief The code of the old or new file which is visible in the hunks,
+/// with one line per context line and deletion or insertion,
+/// and the tokens that result from highlighting it.
+/// Because all lines of a side are highlighted in one go,
+/// constructs spanning multiple lines (e.g. block comments) are highlighted correctly,
+/// as long as they are entirely visible in the hunks.
+struct Side {
+    std::pmr::u8string code;
+    std::pmr::vector<Token> tokens;
+    /// @brief The index of the first token which may still overlap upcoming lines.
+    std::size_t next_token = 0;
+
+    [[nodiscard]]
+    explicit Side(std::pmr::memory_resource* memory)
+        : code { memory }
+        , tokens { memory }
+    {
+    }
+
+    /// @brief Appends the contents of a line and returns their position within `code`.
+    std::size_t append_line(std::u8string_view contents)
+    {
+        const std::size_t result = code.length();
+        code += contents;
+        code += u8'\n';
+        return result;
+    }
+
+    void highlight(Lang lang, std::pmr::memory_resource* memory, const Highlight_Options& options)
+    {
+        std::array<Token, 256> buffer;
+        const auto flush = [&](Token* data, std::size_t amount) {
+            tokens.insert(tokens.end(), data, data + amount);
+        };
+        Non_Owning_Buffer<Token> out { buffer, flush };
+        // Even if the code is malformed, the tokens up to that point are useful.
+        ulight::highlight(out, code, lang, memory, options);
+        out.flush();
+    }
+};
+
+/// @brief The cost after which the word diff of two lines settles for a non-minimal result.
+/// This bounds the time spent on very long lines which have little in common.
+constexpr std::size_t word_diff_max_cost = 64;
+
+[[nodiscard]]
+constexpr bool is_diff_word_char(char8_t c) noexcept
+{
+    // Treating all non-ASCII code units as part of words keeps UTF-8 sequences intact.
+    return is_ascii_alphanumeric(c) || c == u8'_' || c >= 0x80;
+}
+
+[[nodiscard]]
+constexpr bool is_diff_blank(char8_t c) noexcept
+{
+    return c == u8' ' || c == u8'\t';
+}
+
+/// @brief Splits `str` into words, runs of blanks, and individual other characters,
+/// which are the units that the intra-line diff operates on.
+void split_words(std::pmr::vector<std::u8string_view>& out, std::u8string_view str)
+{
+    while (!str.empty()) {
+        std::size_t length = 1;
+        if (is_diff_word_char(str[0])) {
+            while (length < str.length() && is_diff_word_char(str[length])) {
+                ++length;
+            }
+        }
+        else if (is_diff_blank(str[0])) {
+            while (length < str.length() && is_diff_blank(str[length])) {
+                ++length;
+            }
+        }
+        out.push_back(str.substr(0, length));
+        str.remove_prefix(length);
+    }
+}
+
+/// @brief A deleted or inserted line outside of language-aware hunks.
+struct Changed_Line {
+    /// @brief The position of the first code unit of the line within the source.
+    std::size_t begin;
+    /// @brief The length of the line contents, including the marker.
+    std::size_t length;
+    std::size_t terminator_length;
+    /// @brief The range of changed words of this line within `Word_Diff::spans`.
+    std::size_t words_begin = 0;
+    std::size_t words_end = 0;
+};
+
+/// @brief A span of changed words, relative to the start of the source.
+struct Word_Span {
+    std::size_t begin;
+    std::size_t length;
+};
+
+/// @brief Buffers for `diff_words`, which are reused between lines.
+struct Word_Diff {
+    std::pmr::vector<std::u8string_view> old_words;
+    std::pmr::vector<std::u8string_view> new_words;
+    std::pmr::vector<Edit_Type> edits;
+    /// @brief The changed words of all lines.
+    std::pmr::vector<Word_Span> spans;
+
+    [[nodiscard]]
+    explicit Word_Diff(std::pmr::memory_resource* memory)
+        : old_words { memory }
+        , new_words { memory }
+        , edits { memory }
+        , spans { memory }
+    {
+    }
+};
+
 struct Highlighter : Highlighter_Base {
 
     Highlighter(
         Non_Owning_Buffer<Token>& out,
         std::u8string_view source,
+        std::pmr::memory_resource* memory,
         const Highlight_Options& options
     )
-        : Highlighter_Base { out, source, options }
+        : Highlighter_Base { out, source, memory, options }
     {
     }
 
     bool operator()()
     {
         while (!remainder.empty()) {
+            if (options.diff_langs && expect_file()) {
+                continue;
+            }
+            if (expect_changed_lines()) {
+                continue;
+            }
             const Line_Result line = match_crlf_line(remainder);
             // If there are remaining characters in the file,
             // how could there not be a remaining line?!
@@ -68,6 +287,340 @@ struct Highlighter : Highlighter_Base {
         const Highlight_Type type = choose_line_highlight(line);
         emit_and_advance(line.length(), type);
     }
+
+    /// @brief Matches a block of deletions that is immediately followed by a block of insertions.
+    /// The i-th deletion and the i-th insertion are considered to be a modification of one line,
+    /// and the words which differ between them are highlighted as `diff_modification`
+    /// within the line.
+    /// A block of deletions without insertions is highlighted line by line.
+    /// @returns `true` if such blocks were matched, otherwise `false`, with no effect.
+    bool expect_changed_lines()
+    {
+        std::pmr::vector<Changed_Line> deletions { memory };
+        std::pmr::vector<Changed_Line> insertions { memory };
+
+        std::size_t pos = index;
+        std::u8string_view rest = remainder;
+        const auto take_lines = [&](std::pmr::vector<Changed_Line>& lines, Highlight_Type type) {
+            while (!rest.empty()) {
+                const Line_Result line = match_crlf_line(rest);
+                if (line.content_length == 0
+                    || choose_line_highlight(rest.substr(0, line.content_length)) != type) {
+                    return;
+                }
+                lines.push_back({ .begin = pos,
+                                  .length = line.content_length,
+                                  .terminator_length = line.terminator_length });
+                const std::size_t length = line.content_length + line.terminator_length;
+                pos += length;
+                rest.remove_prefix(length);
+            }
+        };
+        take_lines(deletions, Highlight_Type::diff_deletion);
+        if (deletions.empty()) {
+            return false;
+        }
+        take_lines(insertions, Highlight_Type::diff_insertion);
+        // The deletions are highlighted right away, even without insertions,
+        // since otherwise, each of the remaining deletions would be scanned again.
+        if (insertions.empty()) {
+            for (const Changed_Line& line : deletions) {
+                emit_and_advance(line.length, Highlight_Type::diff_deletion);
+                advance(line.terminator_length);
+            }
+            return true;
+        }
+
+        Word_Diff diff { memory };
+        const std::size_t pairs = std::min(deletions.size(), insertions.size());
+        for (std::size_t i = 0; i < pairs; ++i) {
+            diff_words(diff, deletions[i], insertions[i]);
+        }
+        for (const Changed_Line& line : deletions) {
+            emit_changed_line(line, diff.spans, Highlight_Type::diff_deletion);
+        }
+        for (const Changed_Line& line : insertions) {
+            emit_changed_line(line, diff.spans, Highlight_Type::diff_insertion);
+        }
+        advance(pos - index);
+        return true;
+    }
+
+    /// @brief Computes the words that differ between `old_line` and `new_line`,
+    /// appends them to `diff.spans`, and stores their ranges in the lines.
+    /// If the lines have too little in common for the result to be helpful,
+    /// no words are considered changed.
+    void diff_words(Word_Diff& diff, Changed_Line& old_line, Changed_Line& new_line)
+    {
+        const std::u8string_view old_contents = source_at(old_line.begin + 1, old_line.length - 1);
+        const std::u8string_view new_contents = source_at(new_line.begin + 1, new_line.length - 1);
+        diff.old_words.clear();
+        diff.new_words.clear();
+        diff.edits.clear();
+        split_words(diff.old_words, old_contents);
+        split_words(diff.new_words, new_contents);
+        myers_edit_script<std::u8string_view>(
+            diff.edits, diff.old_words, diff.new_words, memory, word_diff_max_cost
+        );
+
+        std::size_t common_length = 0;
+        std::size_t old_index = 0;
+        for (const Edit_Type edit : diff.edits) {
+            if (edit == Edit_Type::common && !is_diff_blank(diff.old_words[old_index][0])) {
+                common_length += diff.old_words[old_index].length();
+            }
+            old_index += edit != Edit_Type::ins;
+        }
+        // Unrelated lines which happen to be paired up would only get highlighted
+        // in a noisy patchwork of changes.
+        if (common_length * 2 < std::min(old_contents.length(), new_contents.length())) {
+            return;
+        }
+
+        const auto collect = [&](Changed_Line& line, std::u8string_view contents,
+                                 std::span<const std::u8string_view> words, Edit_Type type) {
+            line.words_begin = diff.spans.size();
+            std::size_t word_index = 0;
+            for (const Edit_Type edit : diff.edits) {
+                if (edit != type && edit != Edit_Type::common) {
+                    continue;
+                }
+                const std::u8string_view word = words[word_index++];
+                // Changed blanks on their own are not worth highlighting.
+                if (edit == Edit_Type::common || is_diff_blank(word[0])) {
+                    continue;
+                }
+                const std::size_t begin
+                    = line.begin + 1 + std::size_t(word.data() - contents.data());
+                // Adjacent changes which are only separated by blanks are merged,
+                // so that e.g. a changed phrase is highlighted as a whole.
+                if (diff.spans.size() > line.words_begin) {
+                    Word_Span& last = diff.spans.back();
+                    const std::size_t last_end = last.begin + last.length;
+                    const std::u8string_view gap = source_at(last_end, begin - last_end);
+                    if (std::ranges::all_of(gap, is_diff_blank)) {
+                        last.length = begin + word.length() - last.begin;
+                        continue;
+                    }
+                }
+                diff.spans.push_back({ begin, word.length() });
+            }
+            line.words_end = diff.spans.size();
+        };
+        collect(old_line, old_contents, diff.old_words, Edit_Type::del);
+        collect(new_line, new_contents, diff.new_words, Edit_Type::ins);
+    }
+
+    /// @brief Emits `line` with `type`, except for its changed words,
+    /// which are emitted as `diff_modification`.
+    void emit_changed_line(
+        const Changed_Line& line,
+        std::span<const Word_Span> spans,
+        Highlight_Type type
+    )
+    {
+        std::size_t pos = line.begin;
+        for (std::size_t i = line.words_begin; i < line.words_end; ++i) {
+            if (spans[i].begin > pos) {
+                emit(pos, spans[i].begin - pos, type);
+            }
+            emit(spans[i].begin, spans[i].length, Highlight_Type::diff_modification);
+            pos = spans[i].begin + spans[i].length;
+        }
+        const std::size_t end = line.begin + line.length;
+        if (pos < end) {
+            emit(pos, end - pos, type);
+        }
+    }
+
+    /// @brief Matches the `---` and `+++` headings of a file in unified format,
+    /// and highlights the hunks that follow in the language of the file.
+    /// @returns `true` if the headings were matched, otherwise `false`, with no effect.
+    bool expect_file()
+    {
+        if (!remainder.starts_with(u8"--- ")) {
+            return false;
+        }
+        const Line_Result old_heading = match_crlf_line(remainder);
+        const std::u8string_view after_old
+            = remainder.substr(old_heading.content_length + old_heading.terminator_length);
+        if (old_heading.terminator_length == 0 || !after_old.starts_with(u8"+++ ")) {
+            return false;
+        }
+        const Line_Result new_heading = match_crlf_line(after_old);
+
+        const std::u8string_view old_path
+            = file_heading_path(remainder.substr(0, old_heading.content_length));
+        const std::u8string_view new_path
+            = file_heading_path(after_old.substr(0, new_heading.content_length));
+        const Lang lang = lang_from_path(new_path == u8"/dev/null" ? old_path : new_path);
+
+        emit_and_advance(old_heading.content_length, Highlight_Type::diff_heading);
+        advance(old_heading.terminator_length);
+        emit_and_advance(new_heading.content_length, Highlight_Type::diff_heading);
+        advance(new_heading.terminator_length);
+
+        // Without a known language,
+        // the hunks are simply highlighted line by line, like the rest of the diff.
+        if (lang != Lang::none) {
+            highlight_hunks(lang);
+        }
+        return true;
+    }
+
+    /// @brief Highlights all hunks that immediately follow the headings of a file.
+    void highlight_hunks(Lang lang)
+    {
+        Side old_side { memory };
+        Side new_side { memory };
+        std::pmr::vector<Hunk_Line> lines { memory };
+
+        // In the first pass, we only gather the lines and the code of each side.
+        // The amounts of lines in the hunk headings tell us where a hunk ends,
+        // so that e.g. a deleted line "-- x" is not mistaken for the heading of another file.
+        std::size_t pos = index;
+        std::u8string_view rest = remainder;
+        const auto take_line = [&](Line_Kind kind) -> Hunk_Line& {
+            const Line_Result line = match_crlf_line(rest);
+            lines.push_back({ .begin = pos,
+                              .length = line.content_length,
+                              .terminator_length = line.terminator_length,
+                              .kind = kind });
+            const std::size_t length = line.content_length + line.terminator_length;
+            pos += length;
+            rest.remove_prefix(length);
+            return lines.back();
+        };
+        const auto contents_of = [&](const Hunk_Line& line) {
+            return line.length == 0 ? std::u8string_view {}
+                                    : source_at(line.begin + 1, line.length - 1);
+        };
+
+        while (const std::optional<Hunk_Header> header
+               = match_hunk_header(rest.substr(0, match_crlf_line(rest).content_length))) {
+            take_line(Line_Kind::hunk_heading);
+            std::size_t old_lines = header->old_lines;
+            std::size_t new_lines = header->new_lines;
+            while (!rest.empty()
+                   && (old_lines != 0 || new_lines != 0 || rest.starts_with(u8'\\'))) {
+                // Some tools strip the trailing space from empty context lines.
+                const char8_t marker = rest.front() == u8'\n' || rest.front() == u8'\r'
+                    ? u8' '
+                    : rest.front();
+                if (marker == u8'\\') {
+                    take_line(Line_Kind::note);
+                }
+                else if (marker == u8' ' && old_lines != 0 && new_lines != 0) {
+                    Hunk_Line& line = take_line(Line_Kind::common);
+                    old_side.append_line(contents_of(line));
+                    line.side_begin = new_side.append_line(contents_of(line));
+                    --old_lines;
+                    --new_lines;
+                }
+                else if (marker == u8'-' && old_lines != 0) {
+                    Hunk_Line& line = take_line(Line_Kind::deletion);
+                    line.side_begin = old_side.append_line(contents_of(line));
+                    --old_lines;
+                }
+                else if (marker == u8'+' && new_lines != 0) {
+                    Hunk_Line& line = take_line(Line_Kind::insertion);
+                    line.side_begin = new_side.append_line(contents_of(line));
+                    --new_lines;
+                }
+                else {
+                    break;
+                }
+            }
+        }
+
+        Highlight_Options nested_options = options;
+        nested_options.diff_langs = false;
+        old_side.highlight(lang, memory, nested_options);
+        new_side.highlight(lang, memory, nested_options);
+
+        for (const Hunk_Line& line : lines) {
+            switch (line.kind) {
+            case Line_Kind::hunk_heading: {
+                emit(line.begin, line.length, Highlight_Type::diff_heading_hunk);
+                break;
+            }
+            case Line_Kind::note: {
+                emit(line.begin, line.length, Highlight_Type::diff_common);
+                break;
+            }
+            case Line_Kind::common: {
+                // Context lines are highlighted like in the new file.
+                emit_code_line(line, new_side, Highlight_Type::diff_common);
+                break;
+            }
+            case Line_Kind::deletion: {
+                emit_code_line(line, old_side, Highlight_Type::diff_deletion);
+                break;
+            }
+            case Line_Kind::insertion: {
+                emit_code_line(line, new_side, Highlight_Type::diff_insertion);
+                break;
+            }
+            }
+        }
+        advance(pos - index);
+    }
+
+    /// @brief Emits the marker of `line` with `type`,
+    /// followed by the tokens of `side` which overlap the contents of `line`.
+    /// The gaps between those tokens are also highlighted with `type`.
+    void emit_code_line(const Hunk_Line& line, Side& side, Highlight_Type type)
+    {
+        // An empty context line without a marker has no contents either.
+        if (line.length == 0) {
+            return;
+        }
+        emit(line.begin, 1, type);
+        const std::size_t contents_begin = line.begin + 1;
+        const std::size_t side_end = line.side_begin + line.length - 1;
+
+        side.next_token = skip_tokens(side, line.side_begin);
+        std::size_t side_pos = line.side_begin;
+        for (std::size_t i = side.next_token; i < side.tokens.size(); ++i) {
+            const Token& token = side.tokens[i];
+            if (token.begin >= side_end) {
+                break;
+            }
+            // Tokens which span multiple lines are clipped to the current line.
+            const std::size_t begin = std::max(token.begin, line.side_begin);
+            const std::size_t end = std::min(token.begin + token.length, side_end);
+            if (begin > side_pos) {
+                emit(contents_begin + (side_pos - line.side_begin), begin - side_pos, type);
+            }
+            emit(
+                contents_begin + (begin - line.side_begin), end - begin,
+                Highlight_Type(token.type)
+            );
+            side_pos = end;
+        }
+        if (side_pos < side_end) {
+            emit(contents_begin + (side_pos - line.side_begin), side_end - side_pos, type);
+        }
+    }
+
+    /// @brief Returns the index of the first token in `side`,
+    /// starting at `side.next_token`, which ends after `side_pos`.
+    [[nodiscard]]
+    static std::size_t skip_tokens(const Side& side, std::size_t side_pos)
+    {
+        std::size_t i = side.next_token;
+        while (i < side.tokens.size() && side.tokens[i].begin + side.tokens[i].length <= side_pos) {
+            ++i;
+        }
+        return i;
+    }
+
+    [[nodiscard]]
+    std::u8string_view source_at(std::size_t begin, std::size_t length) const
+    {
+        ULIGHT_DEBUG_ASSERT(begin >= index);
+        return remainder.substr(begin - index, length);
+    }
 };
 
 } // namespace
@@ -76,11 +629,11 @@ struct Highlighter : Highlighter_Base {
 bool highlight_diff(
     Non_Owning_Buffer<Token>& out,
     std::u8string_view source,
-    std::pmr::memory_resource*,
+    std::pmr::memory_resource* memory,
     const Highlight_Options& options
 )
 {
-    return diff::Highlighter { out, source, options }();
+    return diff::Highlighter { out, source, memory, options }();
 }
 
 } // namespace ulight
@@ -1,6 +1,8 @@
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <memory_resource>
+#include <span>
 #include <string_view>
 
 #include "ulight/impl/ascii_algorithm.hpp"
@@ -10,6 +12,7 @@
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/string_search.hpp"
 #include "ulight/impl/strings.hpp"
 #include "ulight/impl/unicode_algorithm.hpp"
 
@@ -81,41 +84,31 @@ std::size_t match_attribute_name(std::u8string_view str)
 std::size_t match_raw_text(std::u8string_view str, std::u8string_view closing_name)
 {
     // https://html.spec.whatwg.org/dev/syntax.html#cdata-rcdata-restrictions
-    std::size_t length = 0;
-
-    while (!str.empty()) {
-        const std::size_t safe_length = str.find(u8"</");
-        if (safe_length == std::u8string_view::npos) {
-            return length + str.length();
-        }
-        length += safe_length;
-        str.remove_prefix(safe_length);
-        // At this point, there are three parts that can terminate raw text:
-        //   1. "</", which we've already matched.
-        //   2. The closing name.
-        //   3. Whitespace, ">", or "/".
-        //
-        // We're not sure if we'll get all three, so we use new_length as a temporary length
-        // and only commit to updating length once all parts are matched.
-        std::size_t new_length = length + 2;
-        str.remove_prefix(2);
-        if (!starts_with_ascii_ignore_case(str, closing_name)) {
-            length = new_length;
-            continue;
-        }
-        new_length += closing_name.length();
-        str.remove_prefix(closing_name.length());
-        if (str.empty()) {
-            return new_length;
-        }
-        const char8_t c = str.front();
+    // There are three parts that can terminate raw text:
+    //   1. "</".
+    //   2. The closing name.
+    //   3. Whitespace, ">", or "/".
+    // Since raw text is often a large inline script,
+    // we search for the first two parts at once, and check the third part afterwards.
+    std::array<char8_t, 32> terminator_buffer;
+    ULIGHT_ASSERT(closing_name.length() + 2 <= terminator_buffer.size());
+    terminator_buffer[0] = u8'<';
+    terminator_buffer[1] = u8'/';
+    std::ranges::copy(closing_name, terminator_buffer.begin() + 2);
+    const std::u8string_view terminator { terminator_buffer.data(), closing_name.length() + 2 };
+
+    std::size_t pos = 0;
+    while (true) {
+        pos = find_substring_ascii_ignore_case(str, terminator, pos);
+        if (pos == std::u8string_view::npos || pos + terminator.length() == str.length()) {
+            return str.length();
+        }
+        const char8_t c = str[pos + terminator.length()];
         if (is_html_whitespace(c) || c == u8'>' || c == u8'/') {
-            return length;
+            return pos;
         }
-        length += 2;
-        str.remove_prefix(2);
+        pos += 2;
     }
-    return length;
 }
 
 Raw_Text_Result
@@ -125,7 +118,7 @@ match_escapable_raw_text_piece(std::u8string_view str, std::u8string_view closin
     std::size_t length = 0;
 
     while (!str.empty()) {
-        const std::size_t safe_length = str.find_first_of(u8"<&");
+        const std::size_t safe_length = find_either(str, u8'<', u8'&');
         if (safe_length == std::u8string_view::npos) {
             return { .raw_length = length + str.length(), .ref_length = 0 };
         }
@@ -180,7 +173,7 @@ Match_Result match_comment(std::u8string_view str)
     }
 
     while (!str.empty()) {
-        const std::size_t plain_prefix_length = str.find_first_of(u8"<-");
+        const std::size_t plain_prefix_length = find_either(str, u8'<', u8'-');
         if (plain_prefix_length == std::u8string_view::npos) {
             return { .length = length + str.length(), .terminated = false };
         }
@@ -226,7 +219,7 @@ Match_Result match_cdata(std::u8string_view str)
     if (!str.starts_with(cdata_prefix)) {
         return {};
     }
-    const std::size_t result = str.find(cdata_suffix, cdata_prefix.length());
+    const std::size_t result = find_substring(str, cdata_suffix, cdata_prefix.length());
     if (result == std::u8string_view::npos) {
         return { .length = str.length(), .terminated = false };
     }
@@ -263,38 +256,105 @@ End_Tag_Result match_end_tag_permissive(const std::u8string_view str)
     return { .length = end_pos, .name_length = name_length };
 }
 
+std::size_t window_split_position(std::u8string_view str)
+{
+    if (str.length() <= stream_lookahead) {
+        return 0;
+    }
+    std::size_t result = str.length() - stream_lookahead;
+    // Don't split UTF-8 sequences.
+    while (result != 0 && (str[result] & 0xc0) == 0x80) {
+        --result;
+    }
+    return result;
+}
+
 namespace {
 
+[[nodiscard]]
+Raw_Text_Element classify_raw_text_element(std::u8string_view name)
+{
+    if (equals_ascii_ignore_case(name, u8"script")) {
+        return Raw_Text_Element::script;
+    }
+    if (equals_ascii_ignore_case(name, u8"style")) {
+        return Raw_Text_Element::style;
+    }
+    if (equals_ascii_ignore_case(name, u8"textarea")) {
+        return Raw_Text_Element::textarea;
+    }
+    if (equals_ascii_ignore_case(name, u8"title")) {
+        return Raw_Text_Element::title;
+    }
+    return Raw_Text_Element::none;
+}
+
+[[nodiscard]]
+std::u8string_view raw_text_element_name(Raw_Text_Element element)
+{
+    switch (element) {
+    case Raw_Text_Element::none: break;
+    case Raw_Text_Element::script: return u8"script";
+    case Raw_Text_Element::style: return u8"style";
+    case Raw_Text_Element::textarea: return u8"textarea";
+    case Raw_Text_Element::title: return u8"title";
+    }
+    ULIGHT_ASSERT_UNREACHABLE(u8"Invalid Raw_Text_Element.");
+}
+
 struct Highlighter : Highlighter_Base {
+private:
+    Stream_State& state;
+    const bool final;
+    bool suspended = false;
 
+public:
     Highlighter(
         Non_Owning_Buffer<Token>& out,
         std::u8string_view source,
         std::pmr::memory_resource* memory,
-        const Highlight_Options& options
+        const Highlight_Options& options,
+        Stream_State& state,
+        bool final
     )
         : Highlighter_Base { out, source, memory, options }
+        , state { state }
+        , final { final }
     {
     }
 
-    bool operator()()
+    /// @brief Highlights the source, or the source up to the point
+    /// where the highlighter has to wait for the next window.
+    /// @param document_start `true` iff the source starts at the beginning of the document.
+    /// @returns The amount of code units consumed.
+    std::size_t operator()(bool document_start)
     {
-        expect_bom();
-        while (!remainder.empty()) {
-            if (expect_comment() || //
-                expect_doctype() || //
-                expect_cdata() || //
-                expect_end_tag() || //
-                expect_start_tag_permissive() || //
-                expect_normal_text()) {
-                continue;
+        if (document_start) {
+            expect_bom();
+        }
+        while (!remainder.empty() && !suspended) {
+            switch (state.context) {
+            case Stream_Context::text: expect_markup(); break;
+            case Stream_Context::tag: expect_tag_contents(); break;
+            case Stream_Context::attribute_value: expect_quoted_attribute_value_contents(); break;
+            case Stream_Context::raw_text: expect_raw_text(); break;
+            case Stream_Context::comment: expect_comment_contents(); break;
+            case Stream_Context::cdata: expect_cdata_contents(); break;
             }
-            ULIGHT_ASSERT_UNREACHABLE(u8"Unmatched content in HTML.");
         }
-        return true;
+        return index;
     }
 
 private:
+    /// @brief Stops highlighting until the next window,
+    /// which shall begin with the current `remainder`.
+    bool suspend()
+    {
+        ULIGHT_DEBUG_ASSERT(!final);
+        suspended = true;
+        return true;
+    }
+
     bool expect_bom()
     {
         if (remainder.starts_with(byte_order_mark8)) {
@@ -304,9 +364,31 @@ private:
         return false;
     }
 
+    void expect_markup()
+    {
+        // All markup that starts with "<" is either short enough to fit into the lookahead,
+        // or it is checked for completeness by the functions below.
+        if (!final && remainder.starts_with(u8'<') && remainder.length() < stream_lookahead) {
+            suspend();
+            return;
+        }
+        if (expect_comment() || //
+            expect_doctype() || //
+            expect_cdata() || //
+            expect_end_tag() || //
+            expect_start_tag_permissive() || //
+            expect_normal_text()) {
+            return;
+        }
+        ULIGHT_ASSERT_UNREACHABLE(u8"Unmatched content in HTML.");
+    }
+
     bool expect_doctype()
     {
         if (const Match_Result doctype = match_doctype_permissive(remainder)) {
+            if (!doctype.terminated && !final) {
+                return suspend();
+            }
             emit_and_advance(doctype.length, Highlight_Type::macro);
             return true;
         }
@@ -316,6 +398,16 @@ private:
     bool expect_cdata()
     {
         if (const Match_Result cdata = match_cdata(remainder)) {
+            if (!cdata.terminated && !final) {
+                const std::size_t split = window_split_position(remainder);
+                if (split < cdata_prefix.length()) {
+                    return suspend();
+                }
+                emit_and_advance(cdata_prefix.length(), Highlight_Type::macro);
+                advance(split - cdata_prefix.length());
+                state.context = Stream_Context::cdata;
+                return true;
+            }
             emit(index, cdata_prefix.length(), Highlight_Type::macro);
             if (cdata.terminated) {
                 emit(
@@ -329,6 +421,23 @@ private:
         return false;
     }
 
+    void expect_cdata_contents()
+    {
+        const std::size_t suffix_pos = find_substring(remainder, cdata_suffix);
+        if (suffix_pos != std::u8string_view::npos) {
+            advance(suffix_pos);
+            emit_and_advance(cdata_suffix.length(), Highlight_Type::macro);
+            state.context = Stream_Context::text;
+            return;
+        }
+        const std::size_t length = final ? remainder.length() : window_split_position(remainder);
+        if (length == 0) {
+            suspend();
+            return;
+        }
+        advance(length);
+    }
+
     bool expect_whitespace()
     {
         if (const std::size_t whitespace_length = match_whitespace(remainder)) {
@@ -344,6 +453,16 @@ private:
         if (!comment) {
             return false;
         }
+        if (!comment.terminated && !final) {
+            const std::size_t split = window_split_position(remainder);
+            if (split <= comment_prefix.length()) {
+                return suspend();
+            }
+            emit_and_advance(comment_prefix.length(), Highlight_Type::comment_delim);
+            emit_and_advance(split - comment_prefix.length(), Highlight_Type::comment);
+            state.context = Stream_Context::comment;
+            return true;
+        }
         emit_and_advance(comment_prefix.length(), Highlight_Type::comment_delim);
         comment.length -= comment_prefix.length();
 
@@ -359,63 +478,121 @@ private:
         return true;
     }
 
+    void expect_comment_contents()
+    {
+        // Unlike match_comment, we have already committed to the comment in a previous window,
+        // so only the regular comment suffix can end it.
+        const std::size_t suffix_pos = find_substring(remainder, comment_suffix);
+        if (suffix_pos != std::u8string_view::npos) {
+            if (suffix_pos != 0) {
+                emit_and_advance(suffix_pos, Highlight_Type::comment);
+            }
+            emit_and_advance(comment_suffix.length(), Highlight_Type::comment_delim);
+            state.context = Stream_Context::text;
+            return;
+        }
+        const std::size_t length = final ? remainder.length() : window_split_position(remainder);
+        if (length == 0) {
+            suspend();
+            return;
+        }
+        emit_and_advance(length, Highlight_Type::comment);
+    }
+
     bool expect_start_tag_permissive()
     {
         if (!remainder.starts_with(u8'<')) {
             return false;
         }
+        const std::size_t name_length = match_tag_name(remainder.substr(1));
+        if (!final && 1 + name_length == remainder.length()) {
+            return suspend();
+        }
         emit_and_advance(1, Highlight_Type::sym_punc);
-
-        const std::size_t name_length = match_tag_name(remainder);
         if (name_length == 0) {
             return true;
         }
-        const std::u8string_view name = remainder.substr(0, name_length);
+        state.element = classify_raw_text_element(remainder.substr(0, name_length));
+        state.context = Stream_Context::tag;
         emit_and_advance(name_length, Highlight_Type::markup_tag);
+        return true;
+    }
 
-        while (!remainder.empty()) {
-            expect_whitespace();
-
-            if (remainder.starts_with(u8"/>")) {
-                emit_and_advance(2, Highlight_Type::sym_punc);
-                break;
-            }
-            if (remainder.starts_with(u8'>')) {
-                emit_and_advance(1, Highlight_Type::sym_punc);
-                break;
-            }
-            if (!expect_attribute()) {
-                return true;
-            }
+    void expect_tag_contents()
+    {
+        expect_whitespace();
+        if (remainder.empty()) {
+            return;
+        }
+        if (remainder.starts_with(u8"/>")) {
+            emit_and_advance(2, Highlight_Type::sym_punc);
+            enter_element_contents();
+            return;
+        }
+        if (remainder.starts_with(u8'>')) {
+            emit_and_advance(1, Highlight_Type::sym_punc);
+            enter_element_contents();
+            return;
+        }
+        if (!final && remainder == u8"/") {
+            suspend();
+            return;
         }
+        if (!expect_attribute()) {
+            state = {};
+        }
+    }
 
-        constexpr std::u8string_view textarea_tag = u8"textarea";
-        constexpr std::u8string_view title_tag = u8"title";
-        constexpr std::u8string_view script_tag = u8"script";
-        constexpr std::u8string_view style_tag = u8"style";
+    void enter_element_contents()
+    {
+        state.context = state.element == Raw_Text_Element::none ? Stream_Context::text
+                                                                : Stream_Context::raw_text;
+    }
 
-        if (equals_ascii_ignore_case(name, textarea_tag)
-            || equals_ascii_ignore_case(name, title_tag)) {
+    void expect_raw_text()
+    {
+        const std::u8string_view name = raw_text_element_name(state.element);
+
+        if (state.element == Raw_Text_Element::textarea
+            || state.element == Raw_Text_Element::title) {
             while (const Raw_Text_Result result = match_escapable_raw_text_piece(remainder, name)) {
+                if (!final && result.ref_length == 0 && result.raw_length == remainder.length()) {
+                    // The raw text or a character reference may continue in the next window.
+                    const std::size_t split = window_split_position(remainder);
+                    if (split == 0) {
+                        suspend();
+                    }
+                    advance(split);
+                    return;
+                }
                 advance(result.raw_length);
                 if (result.ref_length != 0) {
                     emit_and_advance(result.ref_length, Highlight_Type::escape);
                 }
             }
-            return true;
-        }
-        if (equals_ascii_ignore_case(name, script_tag)) {
-            const std::size_t js_length = match_raw_text(remainder, script_tag);
-            consume_nested_css_or_js(Lang::javascript, js_length);
-            return true;
-        }
-        if (equals_ascii_ignore_case(name, style_tag)) {
-            const std::size_t css_length = match_raw_text(remainder, style_tag);
-            consume_nested_css_or_js(Lang::css, css_length);
-            return true;
+            state = {};
+            return;
         }
 
-        return true;
+        const Lang lang = state.element == Raw_Text_Element::script ? Lang::javascript : Lang::css;
+        const std::size_t length = match_raw_text(remainder, name);
+        if (!final && length == remainder.length()) {
+            // The raw text may continue in the next window.
+            // Since the nested language is highlighted without context from previous windows,
+            // we only highlight whole lines, which are usually self-contained.
+            const std::size_t split = window_split_position(remainder);
+            if (split == 0) {
+                suspend();
+                return;
+            }
+            const std::size_t line_end = remainder.substr(0, split).rfind(u8'\n');
+            consume_nested_css_or_js(
+                lang, line_end == std::u8string_view::npos ? split : line_end + 1
+            );
+            return;
+        }
+        consume_nested_css_or_js(lang, length);
+        state = {};
     }
 
     void consume_nested_css_or_js(Lang lang, std::size_t length)
@@ -436,6 +613,9 @@ private:
         if (name_length == 0) {
             return false;
         }
+        if (!final && match_incomplete_attribute(name_length)) {
+            return suspend();
+        }
         emit_and_advance(name_length, Highlight_Type::markup_attr);
         expect_whitespace();
 
@@ -452,29 +632,35 @@ private:
             || expect_unquoted_attribute_value();
     }
 
-    bool expect_unquoted_attribute_value()
+    /// @brief Returns `true` if the attribute at the start of `remainder` extends to the end
+    /// of the window and cannot be split,
+    /// i.e. if the end of the window is not within a quoted attribute value.
+    [[nodiscard]]
+    bool match_incomplete_attribute(std::size_t name_length) const
     {
-        std::size_t piece_length = 0;
-        const auto flush = [&] {
-            if (piece_length != 0) {
-                emit_and_advance(piece_length, Highlight_Type::string);
-                piece_length = 0;
-            }
-        };
-
-        for (; piece_length < remainder.length(); ++piece_length) {
-            const char8_t c = remainder[piece_length];
-            if (is_html_unquoted_attribute_value_terminator(c)) {
-                flush();
-                return true;
-            }
-            if (const std::size_t ref_length
-                = match_character_reference(remainder.substr(piece_length))) {
-                flush();
-                emit_and_advance(ref_length, Highlight_Type::escape);
-            }
+        std::size_t length = name_length + match_whitespace(remainder.substr(name_length));
+        if (length == remainder.length() || remainder[length] != u8'=') {
+            return length == remainder.length();
+        }
+        ++length;
+        length += match_whitespace(remainder.substr(length));
+        if (length == remainder.length()) {
+            return true;
         }
-        flush();
+        if (remainder[length] == u8'\"' || remainder[length] == u8'\'') {
+            return false;
+        }
+        return std::ranges::none_of(remainder.substr(length), [](char8_t c) {
+            return is_html_unquoted_attribute_value_terminator(c);
+        });
+    }
+
+    bool expect_unquoted_attribute_value()
+    {
+        const std::size_t length = ascii::length_if(remainder, [](char8_t c) {
+            return !is_html_unquoted_attribute_value_terminator(c);
+        });
+        advance(emit_attribute_value(length));
         return true;
     }
 
@@ -483,35 +669,77 @@ private:
         if (!remainder.starts_with(quote_char)) {
             return false;
         }
-        std::size_t piece_length = 1;
-        const auto flush = [&] {
-            if (piece_length != 0) {
-                emit_and_advance(piece_length, Highlight_Type::string);
-                piece_length = 0;
+        state.context = Stream_Context::attribute_value;
+        state.quote = quote_char;
+        expect_quoted_attribute_value_contents(1);
+        return true;
+    }
+
+    /// @brief Highlights the contents of a quoted attribute value, including its closing quote.
+    /// @param start The position within `remainder` where the contents begin,
+    /// which is `1` if `remainder` still starts with the opening quote.
+    void expect_quoted_attribute_value_contents(std::size_t start = 0)
+    {
+        const std::size_t closing_pos = remainder.find(state.quote, start);
+        std::size_t length = remainder.length();
+        if (closing_pos != std::u8string_view::npos) {
+            length = closing_pos + 1;
+        }
+        else if (!final) {
+            length = std::max(window_split_position(remainder), start);
+            if (length == 0) {
+                suspend();
+                return;
             }
-        };
+        }
+        advance(emit_attribute_value(length));
 
-        for (; piece_length < remainder.length(); ++piece_length) {
-            const char8_t c = remainder[piece_length];
-            if (c == quote_char) {
-                ++piece_length;
-                flush();
-                return true;
+        if (closing_pos != std::u8string_view::npos) {
+            state.context = Stream_Context::tag;
+        }
+        else if (!final) {
+            suspend();
+        }
+    }
+
+    /// @brief Emits the strings and character references within the first `length` code units
+    /// of `remainder`, without advancing.
+    /// @returns The length of the emitted code, which can exceed `length`
+    /// if the last character reference crosses it.
+    [[nodiscard]]
+    std::size_t emit_attribute_value(std::size_t length)
+    {
+        std::size_t piece_begin = 0;
+        std::size_t pos = 0;
+        while (pos < length) {
+            const std::size_t ref_length
+                = remainder[pos] == u8'&' ? match_character_reference(remainder.substr(pos)) : 0;
+            if (ref_length == 0) {
+                ++pos;
+                continue;
             }
-            if (const std::size_t ref_length
-                = match_character_reference(remainder.substr(piece_length))) {
-                flush();
-                emit_and_advance(ref_length, Highlight_Type::escape);
+            if (pos != piece_begin) {
+                emit(index + piece_begin, pos - piece_begin, Highlight_Type::string);
             }
+            emit(index + pos, ref_length, Highlight_Type::escape);
+            pos += ref_length;
+            piece_begin = pos;
         }
-        flush();
-        return true;
+        if (pos != piece_begin) {
+            emit(index + piece_begin, pos - piece_begin, Highlight_Type::string);
+        }
+        return pos;
     }
 
     bool expect_end_tag()
     {
         const End_Tag_Result result = match_end_tag_permissive(remainder);
         if (!result) {
+            // The closing ">" of the end tag may be in the next window.
+            if (!final && remainder.starts_with(u8"</")
+                && remainder.find(u8'>') == std::u8string_view::npos) {
+                return suspend();
+            }
             return false;
         }
         ULIGHT_DEBUG_ASSERT(result.name_length != 0);
@@ -525,18 +753,23 @@ private:
     bool expect_normal_text()
     {
         while (!remainder.empty()) {
-            const std::size_t safe_length = remainder.find_first_of(u8"<&");
+            const std::size_t safe_length = find_either(remainder, u8'<', u8'&');
             if (safe_length == std::u8string_view::npos) {
                 advance(remainder.length());
                 break;
             }
-            if (remainder[safe_length] == u8'<') {
-                advance(safe_length);
+            advance(safe_length);
+            if (remainder.starts_with(u8'<')) {
                 break;
             }
-            if (!expect_character_reference()) {
-                advance(1);
+            if (expect_character_reference()) {
+                continue;
+            }
+            // The character reference may be completed in the next window.
+            if (!final && remainder.length() < stream_lookahead) {
+                return suspend();
             }
+            advance(1);
         }
         return true;
     }
@@ -554,6 +787,30 @@ private:
 
 } // namespace
 
+std::size_t highlight_window(
+    Non_Owning_Buffer<Token>& out,
+    std::u8string_view window,
+    std::size_t offset,
+    Stream_State& state,
+    bool final,
+    std::pmr::memory_resource* memory,
+    const Highlight_Options& options
+)
+{
+    const auto flush = [&](Token* tokens, std::size_t amount) {
+        for (std::size_t i = 0; i < amount; ++i) {
+            tokens[i].begin += offset;
+        }
+        out.append_range(std::span<const Token> { tokens, amount });
+    };
+    Token buffer[256];
+    Non_Owning_Buffer<Token> shifted_out { buffer, flush };
+    const std::size_t result
+        = Highlighter { shifted_out, window, memory, options, state, final }(offset == 0);
+    shifted_out.flush();
+    return result;
+}
+
 } // namespace html
 
 bool highlight_html( //
@@ -563,7 +820,9 @@ bool highlight_html( //
     const Highlight_Options& options
 )
 {
-    return html::Highlighter { out, source, memory, options }();
+    html::Stream_State state;
+    html::Highlighter { out, source, memory, options, state, true }(true);
+    return true;
 }
 
 } // namespace ulight
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <memory_resource>
 #include <optional>
@@ -12,6 +13,7 @@
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/profile.hpp"
 #include "ulight/impl/unicode.hpp"
 #include "ulight/impl/unicode_algorithm.hpp"
 
@@ -513,26 +515,41 @@ std::size_t match_name(std::u8string_view str, Name_Type type)
         return 0;
     }
 
-    const auto [first_char, first_units] = utf8::decode_and_length_or_replacement(str);
-    if (!is_js_identifier_start(first_char)) {
-        return 0;
+    std::size_t length = 1;
+    if (is_ascii(str[0])) [[likely]] {
+        if (!is_js_ascii_identifier_start_set.contains(str[0])) {
+            return 0;
+        }
     }
-
-    const auto is_part = [&](char32_t c) {
-        if (is_js_identifier_part(c)) {
-            return true;
+    else {
+        const auto [first_char, first_units] = utf8::decode_and_length_or_replacement(str);
+        if (!is_js_identifier_start(first_char)) {
+            return 0;
         }
+        length = std::size_t(first_units);
+    }
+
+    // The JSX-specific characters are all ASCII,
+    // so non-ASCII characters are always matched using is_js_identifier_part.
+    static constexpr Charset256 jsx_identifier_part_set
+        = is_js_ascii_identifier_part_set | detail::to_charset256(u8"-");
+    static constexpr Charset256 jsx_attribute_name_part_set
+        = is_js_ascii_identifier_part_set | detail::to_charset256(u8"-:");
+    static constexpr Charset256 jsx_element_name_part_set
+        = is_js_ascii_identifier_part_set | detail::to_charset256(u8"-:.");
+
+    const Charset256& ascii_part_set = [&] -> const Charset256& {
         switch (type) {
-        case Name_Type::identifier: return false;
-        case Name_Type::jsx_identifier: return c == U'-';
-        case Name_Type::jsx_attribute_name: return c == U'-' || c == U':';
-        case Name_Type::jsx_element_name: return c == U'-' || c == U':' || c == U'.';
+        case Name_Type::identifier: return is_js_ascii_identifier_part_set;
+        case Name_Type::jsx_identifier: return jsx_identifier_part_set;
+        case Name_Type::jsx_attribute_name: return jsx_attribute_name_part_set;
+        case Name_Type::jsx_element_name: return jsx_element_name_part_set;
         }
         ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"Invalid Name_Type.");
-    };
+    }();
+    constexpr auto is_part = [](char32_t c) { return is_js_identifier_part(c); };
 
-    return std::size_t(first_units)
-        + utf8::length_if(str.substr(std::size_t(first_units)), is_part);
+    return utf8::length_if_likely_ascii(str, ascii_part_set, is_part, length);
 }
 
 [[nodiscard]]
@@ -582,30 +599,29 @@ std::size_t match_private_identifier(std::u8string_view str)
 
 namespace {
 
-struct Whitespace_Comment_Consumer {
-    virtual void whitespace(std::size_t str) = 0;
-    virtual void block_comment(Comment_Result comment) = 0;
-    virtual void line_comment(std::size_t comment) = 0;
-};
+// The consumers below are passed as template arguments rather than through a virtual interface.
+// They are invoked for every whitespace run, comment, and attribute within a JSX tag,
+// so static dispatch matters.
 
-struct Counting_WSC_Consumer : virtual Whitespace_Comment_Consumer {
+struct Counting_WSC_Consumer {
     std::size_t length = 0;
 
-    void whitespace(std::size_t str) final
+    void whitespace(std::size_t str)
     {
         length += str;
     }
-    void block_comment(Comment_Result comment) final
+    void block_comment(Comment_Result comment)
     {
         length += comment.length;
     }
-    void line_comment(std::size_t comment) final
+    void line_comment(std::size_t comment)
     {
         length += comment;
     }
 };
 
-void match_whitespace_comment_sequence(Whitespace_Comment_Consumer& out, std::u8string_view str)
+template <typename Consumer>
+void match_whitespace_comment_sequence(Consumer& out, std::u8string_view str)
 {
     while (!str.empty()) {
         if (const std::size_t w = match_whitespace(str)) {
@@ -637,13 +653,25 @@ std::size_t match_whitespace_comment_sequence(std::u8string_view str)
 
 } // namespace
 
-[[nodiscard]]
-JSX_Braced_Result match_jsx_braced(std::u8string_view str)
+namespace {
+
+struct Ignoring_Brace_Consumer {
+    void opening_brace(std::size_t) { }
+    void closing_brace(std::size_t) { }
+};
+
+/// @brief Matches braced JS code like `match_jsx_braced`.
+/// Additionally, `out.opening_brace(i)` is invoked for every opening brace at `str[i]`,
+/// and `out.closing_brace(i)` is invoked for every closing brace at `str[i]`
+/// which matches some opening brace.
+template <typename Consumer>
+JSX_Braced_Result match_jsx_braced_impl(Consumer& out, std::u8string_view str)
 {
     // https://facebook.github.io/jsx/#prod-JSXSpreadAttribute
     if (!str.starts_with(u8'{')) {
         return {};
     }
+    out.opening_brace(0);
     std::size_t length = 1;
     std::size_t level = 1;
 
@@ -656,11 +684,13 @@ JSX_Braced_Result match_jsx_braced(std::u8string_view str)
         }
         switch (str[length]) {
         case u8'{': {
+            out.opening_brace(length);
             ++level;
             ++length;
             break;
         }
         case u8'}': {
+            out.closing_brace(length);
             ++length;
             if (--level == 0) {
                 return { .length = length, .is_terminated = true };
@@ -681,126 +711,285 @@ JSX_Braced_Result match_jsx_braced(std::u8string_view str)
     return { .length = length, .is_terminated = false };
 }
 
+} // namespace
+
+[[nodiscard]]
+JSX_Braced_Result match_jsx_braced(std::u8string_view str)
+{
+    Ignoring_Brace_Consumer out;
+    return match_jsx_braced_impl(out, str);
+}
+
 namespace {
 
-struct JSX_Tag_Consumer : virtual Whitespace_Comment_Consumer {
-    virtual void done(JSX_Type) = 0;
-    virtual void advance(std::size_t amount) = 0;
-    virtual void opening_symbol() = 0;
-    virtual void element_name(std::size_t name) = 0;
-    virtual void closing_symbol() = 0;
-    virtual void attribute_name(std::size_t name) = 0;
-    virtual void attribute_equals() = 0;
-    virtual void string_literal(String_Literal_Result r) = 0;
-    virtual void braced(JSX_Braced_Result braced) = 0;
+/// @brief Remembers the extent of braced JS code in JSX.
+///
+/// Matching a JSX tag requires scanning ahead over its braced attribute values,
+/// and any tags within those values are matched again once the highlighter reaches them.
+/// If we scanned each value separately,
+/// highlighting deeply nested tags like `<a b={<a b={<a b={...} />} />} />` would take
+/// quadratic time.
+/// Instead, the scan over the outermost value remembers the extent of every value within.
+struct JSX_Braced_Cache {
+    struct Entry {
+        /// @brief The index of the opening brace within the source.
+        std::size_t begin;
+        JSX_Braced_Result result;
+    };
+
+    std::u8string_view source;
+    /// @brief The extent of all braced code scanned so far, sorted by `begin`.
+    std::pmr::vector<Entry> entries;
+    /// @brief The indices of opening braces which are not yet closed during a scan.
+    std::pmr::vector<std::size_t> open_braces;
+
+    JSX_Braced_Cache(std::u8string_view source, std::pmr::memory_resource* memory)
+        : source { source }
+        , entries { memory }
+        , open_braces { memory }
+    {
+    }
+
+    /// @brief Equivalent to `match_jsx_braced(str)`.
+    /// `str` shall be a suffix of `source`.
+    [[nodiscard]]
+    JSX_Braced_Result operator()(std::u8string_view str)
+    {
+        ULIGHT_DEBUG_ASSERT(str.data() + str.length() == source.data() + source.length());
+        const std::size_t begin = source.length() - str.length();
+
+        const auto known = std::ranges::lower_bound(entries, begin, {}, &Entry::begin);
+        if (known != entries.end() && known->begin == begin) {
+            return known->result;
+        }
+
+        struct Recorder {
+            JSX_Braced_Cache& self;
+            std::size_t begin;
+
+            void opening_brace(std::size_t i)
+            {
+                self.open_braces.push_back(begin + i);
+            }
+            void closing_brace(std::size_t i)
+            {
+                const std::size_t opening = self.open_braces.back();
+                self.open_braces.pop_back();
+                self.entries.push_back({
+                    .begin = opening,
+                    .result = { .length = begin + i + 1 - opening, .is_terminated = true },
+                });
+            }
+        } out { *this, begin };
+
+        const std::size_t old_size = entries.size();
+        const JSX_Braced_Result result = match_jsx_braced_impl(out, str);
+        for (const std::size_t opening : open_braces) {
+            entries.push_back({
+                .begin = opening,
+                .result = { .length = source.length() - opening, .is_terminated = false },
+            });
+        }
+        open_braces.clear();
+
+        const auto new_entries = entries.begin() + std::ptrdiff_t(old_size);
+        std::ranges::sort(new_entries, entries.end(), {}, &Entry::begin);
+        // Usually, a scan starts past everything that has been scanned before,
+        // but not if it starts at a brace that a previous scan skipped as part of a string.
+        if (new_entries != entries.begin() && new_entries != entries.end()
+            && new_entries->begin < new_entries[-1].begin) {
+            std::ranges::inplace_merge(entries, new_entries, {}, &Entry::begin);
+            // Any brace that was scanned twice was matched the same way both times.
+            const auto duplicates = std::ranges::unique(entries, {}, &Entry::begin);
+            entries.erase(duplicates.begin(), duplicates.end());
+        }
+        return result;
+    }
 };
 
-struct Counting_JSX_Tag_Consumer final : JSX_Tag_Consumer, Counting_WSC_Consumer {
+struct Counting_JSX_Tag_Consumer : Counting_WSC_Consumer {
     JSX_Type type {};
 
-    void done(JSX_Type t) final
+    void done(JSX_Type t)
     {
         type = t;
     }
-    void advance(std::size_t amount) final
-    {
-        length += amount;
-    }
-    void opening_symbol() final
+    void opening_symbol()
     {
         ++length;
     }
-    void element_name(std::size_t name) final
+    void element_name(std::size_t name)
     {
         length += name;
     }
-    void attribute_name(std::size_t name) final
+    void attribute_name(std::size_t name)
     {
         length += name;
     }
-    void closing_symbol() final
+    void closing_symbol()
     {
         ++length;
     }
-    void attribute_equals() final
+    void attribute_equals()
     {
         ++length;
     }
-    void string_literal(String_Literal_Result r) final
+    void string_literal(String_Literal_Result r)
     {
         length += r.length;
     }
-    void braced(JSX_Braced_Result braced) final
+    void braced(JSX_Braced_Result braced)
     {
         length += braced.length;
     }
 };
 
-struct Matching_JSX_Tag_Consumer final : JSX_Tag_Consumer {
-    JSX_Tag_Consumer& out;
+enum struct JSX_Tag_Piece_Type : Underlying {
+    whitespace,
+    block_comment,
+    line_comment,
+    /// @brief `<`, `>`, `/`, or `=`.
+    symbol,
+    /// @brief An element or attribute name.
+    name,
+    string_literal,
+    braced,
+};
+
+/// @brief A piece of a JSX tag which has been matched,
+/// but not highlighted yet.
+struct JSX_Tag_Piece {
+    JSX_Tag_Piece_Type type;
+    bool is_terminated;
+    std::size_t length;
+};
+
+/// @brief Records the pieces of a JSX tag while matching it,
+/// so that the tag can be highlighted afterwards without matching it again.
+struct Recording_JSX_Tag_Consumer {
+    std::pmr::vector<JSX_Tag_Piece>& pieces;
+    std::size_t length = 0;
+    JSX_Type type {};
+
+    void record(JSX_Tag_Piece_Type piece_type, std::size_t piece_length, bool terminated = true)
+    {
+        pieces.push_back({
+            .type = piece_type,
+            .is_terminated = terminated,
+            .length = piece_length,
+        });
+        length += piece_length;
+    }
+
+    void done(JSX_Type t)
+    {
+        type = t;
+    }
+    void whitespace(std::size_t w)
+    {
+        record(JSX_Tag_Piece_Type::whitespace, w);
+    }
+    void block_comment(Comment_Result comment)
+    {
+        record(JSX_Tag_Piece_Type::block_comment, comment.length, comment.is_terminated);
+    }
+    void line_comment(std::size_t l)
+    {
+        record(JSX_Tag_Piece_Type::line_comment, l);
+    }
+    void opening_symbol()
+    {
+        record(JSX_Tag_Piece_Type::symbol, 1);
+    }
+    void closing_symbol()
+    {
+        record(JSX_Tag_Piece_Type::symbol, 1);
+    }
+    void element_name(std::size_t name)
+    {
+        record(JSX_Tag_Piece_Type::name, name);
+    }
+    void attribute_name(std::size_t name)
+    {
+        record(JSX_Tag_Piece_Type::name, name);
+    }
+    void attribute_equals()
+    {
+        record(JSX_Tag_Piece_Type::symbol, 1);
+    }
+    void string_literal(String_Literal_Result r)
+    {
+        record(JSX_Tag_Piece_Type::string_literal, r.length, r.terminated);
+    }
+    void braced(JSX_Braced_Result braced)
+    {
+        record(JSX_Tag_Piece_Type::braced, braced.length, braced.is_terminated);
+    }
+};
+
+/// @brief Forwards to another consumer,
+/// and removes everything that has been consumed from the front of `str`.
+template <typename Consumer>
+struct Matching_JSX_Tag_Consumer {
+    Consumer& out;
     std::u8string_view& str;
 
-    Matching_JSX_Tag_Consumer(JSX_Tag_Consumer& out, std::u8string_view& str)
+    Matching_JSX_Tag_Consumer(Consumer& out, std::u8string_view& str)
         : out { out }
         , str { str }
     {
     }
 
-    void done(JSX_Type type) final
+    void done(JSX_Type type)
     {
         out.done(type);
     }
-    void whitespace(std::size_t w) final
+    void whitespace(std::size_t w)
     {
         out.whitespace(w);
         str.remove_prefix(w);
     }
-    void block_comment(Comment_Result comment) final
+    void block_comment(Comment_Result comment)
     {
         out.block_comment(comment);
         str.remove_prefix(comment.length);
     }
-    void line_comment(std::size_t l) final
+    void line_comment(std::size_t l)
     {
         out.line_comment(l);
         str.remove_prefix(l);
     }
-    void advance(std::size_t amount) final
-    {
-        out.advance(amount);
-        str.remove_prefix(amount);
-    }
-    void opening_symbol() final
+    void opening_symbol()
     {
         out.opening_symbol();
         str.remove_prefix(1);
     }
-    void closing_symbol() final
+    void closing_symbol()
     {
         out.closing_symbol();
         str.remove_prefix(1);
     }
-    void element_name(std::size_t name) final
+    void element_name(std::size_t name)
     {
         out.element_name(name);
         str.remove_prefix(name);
     }
-    void attribute_name(std::size_t name) final
+    void attribute_name(std::size_t name)
     {
         out.attribute_name(name);
         str.remove_prefix(name);
     }
-    void attribute_equals() final
+    void attribute_equals()
     {
         out.attribute_equals();
         str.remove_prefix(1);
     }
-    void string_literal(String_Literal_Result r) final
+    void string_literal(String_Literal_Result r)
     {
         out.string_literal(r);
         str.remove_prefix(r.length);
     }
-    void braced(JSX_Braced_Result braced) final
+    void braced(JSX_Braced_Result braced)
     {
         out.braced(braced);
         str.remove_prefix(braced.length);
@@ -812,10 +1001,14 @@ enum struct JSX_Tag_Subset : bool {
     non_closing,
 };
 
+/// @brief Matches a JSX tag, passing each of its pieces to `consumer`.
+/// @param match_braced Invoked instead of `match_jsx_braced` to match braced attribute values.
+template <typename Consumer, typename Match_Braced>
 bool match_jsx_tag_impl(
-    JSX_Tag_Consumer& consumer,
+    Consumer& consumer,
     std::u8string_view str,
-    JSX_Tag_Subset subset = JSX_Tag_Subset::all
+    JSX_Tag_Subset subset,
+    Match_Braced&& match_braced
 )
 {
     // https://facebook.github.io/jsx/#prod-JSXElement
@@ -824,7 +1017,7 @@ bool match_jsx_tag_impl(
         return {};
     }
 
-    Matching_JSX_Tag_Consumer out { consumer, str };
+    Matching_JSX_Tag_Consumer<Consumer> out { consumer, str };
 
     out.opening_symbol();
     match_whitespace_comment_sequence(out, str);
@@ -869,7 +1062,7 @@ bool match_jsx_tag_impl(
             return true;
         }
         // https://facebook.github.io/jsx/#prod-JSXAttributes
-        if (const JSX_Braced_Result spread = match_jsx_braced(str)) {
+        if (const JSX_Braced_Result spread = match_braced(str)) {
             if (!spread.is_terminated) {
                 return false;
             }
@@ -890,7 +1083,7 @@ bool match_jsx_tag_impl(
                 out.string_literal(s);
                 continue;
             }
-            if (const JSX_Braced_Result b = match_jsx_braced(str)) {
+            if (const JSX_Braced_Result b = match_braced(str)) {
                 if (!b.is_terminated) {
                     return false;
                 }
@@ -911,24 +1104,17 @@ bool match_jsx_tag_impl(
     return false;
 }
 
-[[nodiscard]]
-JSX_Tag_Result
-match_jsx_tag_impl(std::u8string_view str, JSX_Tag_Subset subset = JSX_Tag_Subset::all)
+} // namespace
+
+JSX_Tag_Result match_jsx_tag(std::u8string_view str)
 {
     Counting_JSX_Tag_Consumer out;
-    if (match_jsx_tag_impl(out, str, subset)) {
+    if (match_jsx_tag_impl(out, str, JSX_Tag_Subset::all, match_jsx_braced)) {
         return { out.length, out.type };
     }
     return {};
 }
 
-} // namespace
-
-JSX_Tag_Result match_jsx_tag(std::u8string_view str)
-{
-    return match_jsx_tag_impl(str);
-}
-
 namespace {
 
 std::optional<Token_Type> match_operator_or_punctuation(std::u8string_view str)
@@ -1060,76 +1246,267 @@ constexpr bool input_element_has_regex(Input_Element goal)
     return goal == Input_Element::hashbang_or_regex || goal == Input_Element::regex;
 }
 
+/// @brief Classifies the first code unit of a token,
+/// which determines the rules in `Highlighter` that can possibly match.
+enum struct Leading_Byte : Underlying {
+    /// @brief Anything not covered by the other classes,
+    /// which can only begin an operator or punctuator, or is an error.
+    other,
+    /// @brief ASCII whitespace or line terminators.
+    whitespace,
+    /// @brief `#`, which begins a hashbang comment, a private identifier, or is an error.
+    hash,
+    /// @brief `/`, which begins a comment, a regex, or an operator.
+    slash,
+    /// @brief `<`, which begins JSX or an operator.
+    less,
+    /// @brief `'` or `"`, which begin a string literal.
+    quote,
+    /// @brief A backtick, which begins a template literal.
+    backtick,
+    /// @brief `.`, which begins a numeric literal like `.5`, or an operator.
+    dot,
+    /// @brief `[0-9]`, which begins a numeric literal.
+    digit,
+    /// @brief `[A-Za-z$_]`, which begins an identifier or keyword.
+    identifier,
+    /// @brief Any non-ASCII code unit, which may begin whitespace or an identifier.
+    non_ascii,
+};
+
+constexpr auto leading_byte_table = [] {
+    std::array<Leading_Byte, 256> result {};
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        const auto c = char32_t(i);
+        if (!is_ascii(c)) {
+            result[i] = Leading_Byte::non_ascii;
+        }
+        else if (is_js_whitespace(c)) {
+            result[i] = Leading_Byte::whitespace;
+        }
+        else if (is_ascii_digit(c)) {
+            result[i] = Leading_Byte::digit;
+        }
+        else if (is_js_identifier_start(c)) {
+            result[i] = Leading_Byte::identifier;
+        }
+    }
+    result[u8'#'] = Leading_Byte::hash;
+    result[u8'/'] = Leading_Byte::slash;
+    result[u8'<'] = Leading_Byte::less;
+    result[u8'\''] = Leading_Byte::quote;
+    result[u8'"'] = Leading_Byte::quote;
+    result[u8'`'] = Leading_Byte::backtick;
+    result[u8'.'] = Leading_Byte::dot;
+    return result;
+}();
+
+/// @brief A construct that the highlighter is nested in,
+/// which determines how the code at the current position is highlighted.
+enum struct Context_Type : Underlying {
+    /// @brief `{}` within JS code that is itself nested in one of the other contexts.
+    brace,
+    /// @brief The characters of a template literal, after the opening backtick.
+    template_characters,
+    /// @brief A template substitution, after the `${`.
+    template_substitution,
+    /// @brief A braced JSX attribute value, spread attribute, or child expression,
+    /// after the `{`.
+    jsx_braced,
+    /// @brief A JSX tag which has been matched and whose pieces are being highlighted.
+    jsx_tag,
+    /// @brief The children of a JSX element or fragment, up to and including its closing tag.
+    jsx_children,
+};
+
+struct Context {
+    Context_Type type;
+    /// @brief For `jsx_braced` within a tag, the expected index past the closing brace.
+    /// For `jsx_tag`, the size of `Highlighter::jsx_tag_pieces` once the tag is highlighted.
+    /// For `jsx_children`, the number of elements within the children which are still open.
+    std::size_t value = 0;
+};
+
 /// @brief  Common JS and JSX highlighter implementation.
 struct [[nodiscard]] Highlighter : Highlighter_Base {
 private:
     Input_Element input_element = Input_Element::hashbang_or_regex;
+    /// @brief The stack of constructs that the highlighter is nested in.
+    /// Template literals, JSX, and braces can be nested arbitrarily deeply,
+    /// and tracking them explicitly rather than through recursion lets us highlight everything
+    /// in a single pass without exhausting the call stack.
+    std::pmr::vector<Context> contexts;
+    /// @brief The pieces of matched JSX tags which have not been highlighted yet.
+    /// The pieces of each tag are stored in reverse order, so that the next piece is at the back.
+    /// Tags can be nested within braced JS code in other tags,
+    /// so the pieces of a nested tag are stored above those of the enclosing tag.
+    std::pmr::vector<JSX_Tag_Piece> jsx_tag_pieces;
+    JSX_Braced_Cache jsx_braced_cache;
 
 public:
     Highlighter(
         Non_Owning_Buffer<Token>& out,
         std::u8string_view source,
+        std::pmr::memory_resource* memory,
         const Highlight_Options& options
     )
-        : Highlighter_Base { out, source, options }
+        : Highlighter_Base { out, source, memory, options }
+        , contexts { memory }
+        , jsx_tag_pieces { memory }
+        , jsx_braced_cache { source, memory }
     {
     }
 
     bool operator()()
     {
         while (!remainder.empty()) {
-            consume_token();
+            if (contexts.empty()) {
+                consume_token();
+                continue;
+            }
+            switch (contexts.back().type) {
+            case Context_Type::brace:
+            case Context_Type::template_substitution:
+            case Context_Type::jsx_braced: {
+                consume_braced_token();
+                break;
+            }
+            case Context_Type::template_characters: {
+                consume_template_characters();
+                break;
+            }
+            case Context_Type::jsx_tag: {
+                highlight_next_jsx_tag_piece();
+                break;
+            }
+            case Context_Type::jsx_children: {
+                consume_jsx_child();
+                break;
+            }
+            }
         }
         return true;
     }
 
 private:
-    /// @brief Consumes braced JS code.
-    /// This is used both for matching braced JS code in JSX, like in `<div id={get_id()}>`,
-    /// and for template literals in regular JS.
-    ///
-    /// The closing brace is not consumed.
-    void consume_js_before_closing_brace()
+    /// @brief Consumes a single token within braced JS code,
+    /// such as a template substitution or a braced JSX attribute value.
+    /// Unlike at the top level, braces are tracked so that the closing brace of the
+    /// enclosing construct can be recognized.
+    void consume_braced_token()
     {
-        input_element = Input_Element::regex;
-        int brace_level = 0;
-        while (!remainder.empty()) {
-            if (remainder[0] == u8'{') {
-                ++brace_level;
-                emit_and_advance(1, Highlight_Type::sym_brace);
-                input_element = Input_Element::regex;
-                continue;
-            }
-            if (remainder[0] == u8'}') {
-                if (--brace_level < 0) {
-                    return;
-                }
-                emit_and_advance(1, Highlight_Type::sym_brace);
-                input_element = Input_Element::div;
-                continue;
-            }
-
+        switch (remainder[0]) {
+        case u8'{': {
+            emit_and_advance(1, Highlight_Type::sym_brace);
+            input_element = Input_Element::regex;
+            contexts.push_back({ .type = Context_Type::brace });
+            return;
+        }
+        case u8'}': {
+            consume_closing_brace();
+            return;
+        }
+        default: {
             consume_token();
+            return;
+        }
         }
     }
 
+    void consume_closing_brace()
+    {
+        ULIGHT_ASSERT(remainder.starts_with(u8'}'));
+        const Context context = contexts.back();
+        contexts.pop_back();
+
+        switch (context.type) {
+        case Context_Type::brace: {
+            emit_and_advance(1, Highlight_Type::sym_brace);
+            input_element = Input_Element::div;
+            return;
+        }
+        case Context_Type::template_substitution: {
+            emit_and_advance(1, Highlight_Type::escape);
+            return;
+        }
+        case Context_Type::jsx_braced: {
+            emit_and_advance(1, Highlight_Type::sym_brace);
+            // The extent of braced attribute values is determined ahead of time
+            // by a simple scan (see match_jsx_braced),
+            // whereas we have actually lexed the JS code,
+            // so the two can disagree in rare cases like "<a b={/}/}>".
+            // If so, the remaining pieces of the tag are meaningless and must be dropped.
+            const bool is_desynchronized = context.value != 0 && context.value != index;
+            if (is_desynchronized && !contexts.empty()
+                && contexts.back().type == Context_Type::jsx_tag) {
+                jsx_tag_pieces.resize(contexts.back().value);
+                leave_jsx_context();
+            }
+            return;
+        }
+        default: break;
+        }
+        ULIGHT_ASSERT_UNREACHABLE(u8"Closing brace in a context that is not braced.");
+    }
+
+    /// @brief Consumes a single token.
+    /// Rather than trying every rule in sequence,
+    /// the first code unit is used to select the only rule that can match,
+    /// or a short sequence of rules in the few ambiguous cases.
     void consume_token()
     {
-        if (expect_whitespace() || //
-            expect_hashbang_comment() || //
-            expect_line_comment() || //
-            expect_block_comment() || //
-            expect_jsx_in_js() || //
-            expect_string_literal() || //
-            expect_template() || //
-            expect_regex() || //
-            expect_numeric_literal() || //
-            expect_private_identifier() || //
-            expect_symbols() || //
-            expect_operator_or_punctuation()) {
+        if (expect_token()) {
             return;
         }
-        consume_error();
+        ULIGHT_PROFILE_RULE(Lang::javascript, consume_error());
+    }
+
+    bool expect_token()
+    {
+        switch (leading_byte_table[remainder[0]]) {
+        case Leading_Byte::whitespace: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_whitespace());
+        }
+        case Leading_Byte::hash: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_hashbang_comment()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_private_identifier()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_operator_or_punctuation());
+        }
+        case Leading_Byte::slash: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_line_comment()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_block_comment()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_regex()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_operator_or_punctuation());
+        }
+        case Leading_Byte::less: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_jsx_in_js()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_operator_or_punctuation());
+        }
+        case Leading_Byte::quote: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_string_literal());
+        }
+        case Leading_Byte::backtick: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_template());
+        }
+        case Leading_Byte::dot: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_numeric_literal()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_operator_or_punctuation());
+        }
+        case Leading_Byte::digit: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_numeric_literal());
+        }
+        case Leading_Byte::identifier: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_symbols());
+        }
+        case Leading_Byte::non_ascii: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_whitespace()) //
+                || ULIGHT_PROFILE_RULE(Lang::javascript, expect_symbols());
+        }
+        case Leading_Byte::other: {
+            return ULIGHT_PROFILE_RULE(Lang::javascript, expect_operator_or_punctuation());
+        }
+        }
+        ULIGHT_ASSERT_UNREACHABLE(u8"Invalid leading byte class.");
     }
 
     void consume_error()
@@ -1149,177 +1526,171 @@ private:
         //
         // Furthermore, we ignore closing tags at the beginning.
 
-        const JSX_Tag_Result opening = match_jsx_tag_impl(remainder, JSX_Tag_Subset::non_closing);
+        const std::size_t first_piece = jsx_tag_pieces.size();
+        const JSX_Tag_Result opening = match_jsx_tag_pieces(JSX_Tag_Subset::non_closing);
         if (!opening) {
             return false;
         }
-        consume_jsx_tag();
         if (opening.type != JSX_Type::self_closing) {
             const bool is_opening
                 = opening.type == JSX_Type::opening || opening.type == JSX_Type::fragment_opening;
             ULIGHT_ASSERT(is_opening);
-            consume_jsx_children_and_closing_tag();
+            // The children are consumed once the opening tag is highlighted,
+            // so their context goes beneath that of the tag.
+            contexts.push_back({ .type = Context_Type::jsx_children });
         }
-        input_element = Input_Element::div;
+        contexts.push_back({ .type = Context_Type::jsx_tag, .value = first_piece });
         return true;
     }
 
-    void consume_jsx_tag()
+    /// @brief Matches a JSX tag at the start of `remainder` and records its pieces,
+    /// so that it can be highlighted without matching it a second time.
+    /// If there is no match, nothing is recorded.
+    [[nodiscard]]
+    JSX_Tag_Result match_jsx_tag_pieces(JSX_Tag_Subset subset = JSX_Tag_Subset::all)
     {
-        struct Highlighter_As_Consumer : JSX_Tag_Consumer {
-            Highlighter& self;
-            Highlighter_As_Consumer(Highlighter& self)
-                : self { self }
-            {
-            }
+        const std::size_t first_piece = jsx_tag_pieces.size();
+        Recording_JSX_Tag_Consumer out { .pieces = jsx_tag_pieces };
+        if (!match_jsx_tag_impl(out, remainder, subset, jsx_braced_cache)) {
+            jsx_tag_pieces.resize(first_piece);
+            return {};
+        }
+        std::reverse(jsx_tag_pieces.begin() + std::ptrdiff_t(first_piece), jsx_tag_pieces.end());
+        return { out.length, out.type };
+    }
 
-            void done(JSX_Type) final { }
-            void whitespace(std::size_t w) final
-            {
-                self.advance(w);
-            }
-            void block_comment(Comment_Result comment) final
-            {
-                self.highlight_block_comment(comment);
-            }
-            void line_comment(std::size_t l) final
-            {
-                self.highlight_line_comment(l);
-            }
-            void advance(std::size_t amount) final
-            {
-                self.advance(amount);
-            }
-            void opening_symbol() final
-            {
-                self.emit_and_advance(1, Highlight_Type::sym_punc);
-            }
-            void closing_symbol() final
-            {
-                self.emit_and_advance(1, Highlight_Type::sym_punc);
-            }
-            void element_name(std::size_t name) final
-            {
-                self.emit_and_advance(name, Highlight_Type::markup_tag);
-            }
-            void attribute_name(std::size_t name) final
-            {
-                self.emit_and_advance(name, Highlight_Type::markup_tag);
-            }
-            void attribute_equals() final
-            {
-                self.emit_and_advance(1, Highlight_Type::sym_punc);
-            }
-            void string_literal(String_Literal_Result r) final
-            {
-                self.highlight_string_literal(r);
-            }
-            void braced(JSX_Braced_Result braced) final
-            {
-                ULIGHT_ASSERT(braced.is_terminated && braced.length >= 2);
-                self.highlight_jsx_braced(braced);
-            }
+    /// @brief Pops a `jsx_tag` or `jsx_children` context.
+    void leave_jsx_context()
+    {
+        ULIGHT_ASSERT(
+            contexts.back().type == Context_Type::jsx_tag
+            || contexts.back().type == Context_Type::jsx_children
+        );
+        contexts.pop_back();
+        input_element = Input_Element::div;
+    }
 
-        } out { *this };
+    void highlight_next_jsx_tag_piece()
+    {
+        ULIGHT_ASSERT(jsx_tag_pieces.size() > contexts.back().value);
+        const JSX_Tag_Piece piece = jsx_tag_pieces.back();
+        jsx_tag_pieces.pop_back();
+        if (jsx_tag_pieces.size() == contexts.back().value) {
+            leave_jsx_context();
+        }
+
+        switch (piece.type) {
+        case JSX_Tag_Piece_Type::whitespace: {
+            advance(piece.length);
+            return;
+        }
+        case JSX_Tag_Piece_Type::block_comment: {
+            highlight_block_comment({ .length = piece.length,
+                                      .is_terminated = piece.is_terminated });
+            return;
+        }
+        case JSX_Tag_Piece_Type::line_comment: {
+            highlight_line_comment(piece.length);
+            return;
+        }
+        case JSX_Tag_Piece_Type::symbol: {
+            emit_and_advance(piece.length, Highlight_Type::sym_punc);
+            return;
+        }
+        case JSX_Tag_Piece_Type::name: {
+            emit_and_advance(piece.length, Highlight_Type::markup_tag);
+            return;
+        }
+        case JSX_Tag_Piece_Type::string_literal: {
+            highlight_string_literal({ .length = piece.length, .terminated = piece.is_terminated });
+            return;
+        }
+        case JSX_Tag_Piece_Type::braced: {
+            ULIGHT_ASSERT(piece.is_terminated && piece.length >= 2);
+            const std::size_t expected_end = index + piece.length;
+            enter_jsx_braced(expected_end);
+            return;
+        }
+        }
+        ULIGHT_ASSERT_UNREACHABLE(u8"Invalid JSX tag piece.");
+    }
 
-        match_jsx_tag_impl(out, remainder);
+    /// @brief Consumes the opening brace of braced JS code in JSX.
+    /// @param expected_end The index past the closing brace, if known, or zero.
+    void enter_jsx_braced(std::size_t expected_end = 0)
+    {
+        ULIGHT_ASSERT(remainder.starts_with(u8'{'));
+        emit_and_advance(1, Highlight_Type::sym_brace);
+        input_element = Input_Element::regex;
+        contexts.push_back({ .type = Context_Type::jsx_braced, .value = expected_end });
     }
 
-    void consume_jsx_children_and_closing_tag()
+    void consume_jsx_child()
     {
         // https://facebook.github.io/jsx/#prod-JSXChildren
-        int depth = 0;
-        std::u8string_view rem = remainder;
-        while (!rem.empty()) {
-            // https://facebook.github.io/jsx/#prod-JSXText
-            const std::size_t safe_length = rem.find_first_of(u8"&{}<>");
-            if (safe_length == std::u8string_view::npos) {
-                advance(rem.length());
-                break;
-            }
-            advance(safe_length);
-            rem.remove_prefix(safe_length);
+        // https://facebook.github.io/jsx/#prod-JSXText
+        const std::size_t safe_length = remainder.find_first_of(u8"&{}<>");
+        if (safe_length == std::u8string_view::npos) {
+            // Unterminated JSX child content.
+            // This isn't really valid code, but it doesn't matter for syntax highlighting.
+            advance(remainder.length());
+            return;
+        }
+        advance(safe_length);
 
-            switch (rem[0]) {
-            case u8'&': {
-                // https://facebook.github.io/jsx/#prod-HTMLCharacterReference
-                if (const std::size_t ref = html::match_character_reference(rem)) {
-                    emit_and_advance(ref, Highlight_Type::escape);
-                    rem.remove_prefix(ref);
-                }
-                else {
-                    advance(1);
-                    rem.remove_prefix(1);
-                }
-                continue;
+        switch (remainder[0]) {
+        case u8'&': {
+            // https://facebook.github.io/jsx/#prod-HTMLCharacterReference
+            if (const std::size_t ref = html::match_character_reference(remainder)) {
+                emit_and_advance(ref, Highlight_Type::escape);
             }
-            case u8'<': {
-                // https://facebook.github.io/jsx/#prod-JSXElement
-                const JSX_Tag_Result tag = match_jsx_tag(rem);
-                if (!tag) {
-                    emit_and_advance(1, Highlight_Type::error);
-                    rem.remove_prefix(1);
-                    continue;
-                }
-                consume_jsx_tag();
-                rem.remove_prefix(tag.length);
-                if (tag.type == JSX_Type::opening || tag.type == JSX_Type::fragment_opening) {
-                    ++depth;
-                }
-                if (tag.type == JSX_Type::closing || tag.type == JSX_Type::fragment_closing) {
-                    if (--depth < 0) {
-                        return;
-                    }
-                }
-                continue;
+            else {
+                advance(1);
             }
-            case u8'>': {
-                // Stray ">".
-                // This should have been part of a tag.
+            return;
+        }
+        case u8'<': {
+            // https://facebook.github.io/jsx/#prod-JSXElement
+            const std::size_t first_piece = jsx_tag_pieces.size();
+            const JSX_Tag_Result tag = match_jsx_tag_pieces();
+            if (!tag) {
                 emit_and_advance(1, Highlight_Type::error);
-                rem.remove_prefix(1);
-                continue;
+                return;
+            }
+            std::size_t& open_elements = contexts.back().value;
+            if (tag.type == JSX_Type::opening || tag.type == JSX_Type::fragment_opening) {
+                ++open_elements;
             }
-            case u8'{': {
-                // https://facebook.github.io/jsx/#prod-JSXChild
-                const JSX_Braced_Result braced = match_jsx_braced(rem);
-                if (braced) {
-                    highlight_jsx_braced(braced);
-                    rem.remove_prefix(braced.length);
+            if (tag.type == JSX_Type::closing || tag.type == JSX_Type::fragment_closing) {
+                if (open_elements == 0) {
+                    // This closes the element that the children belong to.
+                    leave_jsx_context();
                 }
                 else {
-                    emit_and_advance(1, Highlight_Type::error);
-                    rem.remove_prefix(1);
+                    --open_elements;
                 }
-                continue;
-            }
-            case u8'}': {
-                // Stray "}".
-                // This should have been part of a braced child expression.
-                emit_and_advance(1, Highlight_Type::error);
-                rem.remove_prefix(1);
-                continue;
-            }
-            default: ULIGHT_ASSERT_UNREACHABLE();
             }
+            contexts.push_back({ .type = Context_Type::jsx_tag, .value = first_piece });
+            return;
         }
-        // Unterminated JSX child content.
-        // This isn't really valid code, but it doesn't matter for syntax highlighting.
-    }
-
-    void highlight_jsx_braced(const JSX_Braced_Result& braced)
-    {
-        ULIGHT_ASSERT(braced);
-        ULIGHT_ASSERT(remainder.starts_with(u8'{'));
-
-        emit_and_advance(1, Highlight_Type::sym_brace);
-        const std::size_t js_length = braced.length - (braced.is_terminated ? 2 : 1);
-
-        if (js_length != 0) {
-            consume_js_before_closing_brace();
+        case u8'>': {
+            // Stray ">".
+            // This should have been part of a tag.
+            emit_and_advance(1, Highlight_Type::error);
+            return;
         }
-        if (braced.is_terminated) {
-            emit_and_advance(1, Highlight_Type::sym_brace);
+        case u8'{': {
+            // https://facebook.github.io/jsx/#prod-JSXChild
+            enter_jsx_braced();
+            return;
+        }
+        case u8'}': {
+            // Stray "}".
+            // This should have been part of a braced child expression.
+            emit_and_advance(1, Highlight_Type::error);
+            return;
+        }
+        default: ULIGHT_ASSERT_UNREACHABLE();
         }
     }
 
@@ -1436,7 +1807,8 @@ private:
             }
             else {
                 // Find next escape sequence or end of content.
-                const std::size_t next = std::min(remaining, remainder.find(u8'\\'));
+                const std::size_t next
+                    = std::min(remaining, remainder.substr(0, remaining).find(u8'\\'));
                 if (next > 0) {
                     advance(next);
                     chars += next;
@@ -1463,19 +1835,20 @@ private:
     bool expect_template()
     {
         // https://262.ecma-international.org/15.0/index.html#sec-template-literal-lexical-components
-        if (remainder.starts_with(u8'`')) {
-            consume_template();
-            return true;
+        if (!remainder.starts_with(u8'`')) {
+            return false;
         }
-        return false;
+        emit_and_advance(1, Highlight_Type::string_delim);
+        contexts.push_back({ .type = Context_Type::template_characters });
+        return true;
     }
 
-    void consume_template()
+    /// @brief Consumes the characters of a template literal
+    /// up to and including the closing backtick,
+    /// or up to and including the `${` of a template substitution.
+    void consume_template_characters()
     {
         // https://262.ecma-international.org/15.0/index.html#sec-template-literal-lexical-components
-        ULIGHT_ASSERT(remainder.starts_with(u8'`'));
-        emit_and_advance(1, Highlight_Type::string_delim);
-
         std::size_t chars = 0;
         const auto flush_chars = [&] {
             if (chars != 0) {
@@ -1492,19 +1865,16 @@ private:
                 flush_chars();
                 emit_and_advance(1, Highlight_Type::string_delim);
                 input_element = Input_Element::div;
+                contexts.pop_back();
                 return;
             }
             case u8'$': {
                 if (rem.starts_with(u8"${")) {
                     flush_chars();
                     emit_and_advance(2, Highlight_Type::escape);
-                    consume_js_before_closing_brace();
-                    if (!remainder.empty()) {
-                        ULIGHT_ASSERT(remainder.starts_with(u8'}'));
-                        emit_and_advance(1, Highlight_Type::escape);
-                    }
-                    // Otherwise, we have an unterminated substitution.
-                    continue;
+                    input_element = Input_Element::regex;
+                    contexts.push_back({ .type = Context_Type::template_substitution });
+                    return;
                 }
                 advance(1);
                 ++chars;
@@ -1748,11 +2118,14 @@ private:
 bool highlight_javascript(
     Non_Owning_Buffer<Token>& out,
     std::u8string_view source,
-    std::pmr::memory_resource*,
+    std::pmr::memory_resource* memory,
     const Highlight_Options& options
 )
 {
-    return js::Highlighter { out, source, options }();
+    if (!memory) {
+        memory = std::pmr::get_default_resource();
+    }
+    return js::Highlighter { out, source, memory, options }();
 }
 
 } // namespace ulight
@@ -1,8 +1,23 @@
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <charconv>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <string_view>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ulight/json.hpp"
+#include "ulight/json_static.hpp"
 #include "ulight/ulight.hpp"
 
 #include "ulight/impl/ascii_algorithm.hpp"
@@ -11,10 +26,13 @@
 #include "ulight/impl/escapes.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/line_batches.hpp"
 #include "ulight/impl/strings.hpp"
 
 #include "ulight/impl/lang/json.hpp"
 #include "ulight/impl/lang/json_chars.hpp"
+#include "ulight/impl/lang/json_index.hpp"
+#include "ulight/impl/lang/json_parser.hpp"
 
 namespace ulight {
 namespace json {
@@ -42,8 +60,14 @@ Escape_Result match_escape_sequence(std::u8string_view str, Escape_Policy policy
         return {};
     }
     // Almost all escape sequences are two characters.
-    if (str[1] != u8'u') {
-        return { .length = 2, .value = char32_t(str[1]) };
+    switch (str[1]) {
+    case u8'b': return { .length = 2, .value = U'\b' };
+    case u8'f': return { .length = 2, .value = U'\f' };
+    case u8'n': return { .length = 2, .value = U'\n' };
+    case u8'r': return { .length = 2, .value = U'\r' };
+    case u8't': return { .length = 2, .value = U'\t' };
+    case u8'u': break;
+    default: return { .length = 2, .value = char32_t(str[1]) };
     }
     // "\", "u", hex, hex, hex, hex
     const auto [length, erroneous] = match_common_escape<Common_Escape::hex_4>(str, 2);
@@ -132,19 +156,366 @@ Number_Result match_number(std::u8string_view str)
 
 namespace {
 
+/// @brief The decimal representation of a number, split into its components.
+struct Decimal {
+    bool negative = false;
+    /// @brief The first (up to) 19 significant digits, as an integer.
+    std::uint64_t significand = 0;
+    /// @brief The amount of significant digits, including those not held by `significand`.
+    std::size_t digits = 0;
+    /// @brief The value is `significand * 10^exponent`,
+    /// if all significant digits fit into `significand`.
+    std::int64_t exponent = 0;
+    /// @brief `true` iff the exponent part has so many digits that `exponent` is meaningless.
+    bool huge_exponent = false;
+
+    /// @brief The maximum amount of digits that always fit into `significand`.
+    static constexpr std::size_t max_digits = 19;
+
+    [[nodiscard]]
+    bool is_exact() const
+    {
+        return digits <= max_digits && !huge_exponent;
+    }
+
+    /// @brief Returns the approximate decimal logarithm of the magnitude.
+    [[nodiscard]]
+    std::int64_t magnitude() const
+    {
+        return std::int64_t(std::min(digits, max_digits)) + exponent;
+    }
+};
+
+/// @brief Decomposes a number that was matched by `match_number` in a single pass.
+[[nodiscard]]
+Decimal to_decimal(std::u8string_view number)
+{
+    Decimal result;
+    std::size_t i = 0;
+    if (number.starts_with(u8'-')) {
+        result.negative = true;
+        ++i;
+    }
+    const auto append_digit = [&](char8_t c) {
+        if (result.digits == 0 && c == u8'0') {
+            return;
+        }
+        if (result.digits < Decimal::max_digits) {
+            result.significand = (result.significand * 10) + std::uint64_t(c - u8'0');
+        }
+        else {
+            ++result.exponent;
+        }
+        ++result.digits;
+    };
+    for (; i < number.length() && is_ascii_digit(number[i]); ++i) {
+        append_digit(number[i]);
+    }
+    if (i < number.length() && number[i] == u8'.') {
+        for (++i; i < number.length() && is_ascii_digit(number[i]); ++i) {
+            // Fractional digits that don't fit into the significand are simply dropped.
+            if (result.digits < Decimal::max_digits) {
+                append_digit(number[i]);
+                --result.exponent;
+            }
+            else {
+                ++result.digits;
+            }
+        }
+    }
+    if (i < number.length() && (number[i] == u8'e' || number[i] == u8'E')) {
+        ++i;
+        bool negative_exponent = false;
+        if (i < number.length() && (number[i] == u8'+' || number[i] == u8'-')) {
+            negative_exponent = number[i] == u8'-';
+            ++i;
+        }
+        std::int64_t exponent = 0;
+        for (; i < number.length() && is_ascii_digit(number[i]); ++i) {
+            // Exponents this large under- or overflow regardless of the significand.
+            if (exponent > 100'000) {
+                result.huge_exponent = true;
+                exponent = 100'000;
+                continue;
+            }
+            exponent = (exponent * 10) + (number[i] - u8'0');
+        }
+        result.exponent += negative_exponent ? -exponent : exponent;
+    }
+    return result;
+}
+
+/// @brief The powers of ten which are exactly representable as `double`.
+constexpr double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/// @brief Converts `decimal` to `double` using only exact operations,
+/// which is possible if the significand and the power of ten are exactly representable
+/// (Clinger's fast path).
+/// The single multiplication or division is then correctly rounded.
+[[nodiscard]]
+std::optional<double> to_double_exact(const Decimal& decimal)
+{
+    constexpr std::uint64_t max_exact_significand = std::uint64_t(1) << 53;
+    constexpr std::int64_t max_exact_exponent = std::size(exact_powers_of_ten) - 1;
+    if (!decimal.is_exact() || decimal.significand > max_exact_significand
+        || decimal.exponent < -max_exact_exponent || decimal.exponent > max_exact_exponent) {
+        return {};
+    }
+    const auto significand = double(decimal.significand);
+    const double magnitude = decimal.exponent < 0
+        ? significand / exact_powers_of_ten[-decimal.exponent]
+        : significand * exact_powers_of_ten[decimal.exponent];
+    return decimal.negative ? -magnitude : magnitude;
+}
+
+} // namespace
+
+std::optional<double> parse_number_value(std::u8string_view number)
+{
+    const Decimal decimal = to_decimal(number);
+    if (decimal.digits == 0) {
+        // This also handles "-0", which would lose its sign as an integer.
+        return decimal.negative ? -0.0 : 0.0;
+    }
+    if (const std::optional<double> exact = to_double_exact(decimal)) {
+        return exact;
+    }
+
+    // Anything else is converted by std::from_chars, which is correctly rounded.
+    // Unlike std::strtod, it neither depends on the locale
+    // nor requires the number to be followed by a non-digit.
+    const std::string_view chars = as_string_view(number);
+    double value;
+    const auto result = std::from_chars(chars.data(), chars.data() + chars.length(), value);
+    if (result.ec == std::errc::result_out_of_range) {
+        // Like std::strtod, saturate to infinity or zero.
+        const double magnitude
+            = decimal.magnitude() > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+        return decimal.negative ? -magnitude : magnitude;
+    }
+    if (result.ec != std::errc {} || result.ptr != chars.data() + chars.length()) {
+        return {};
+    }
+    return value;
+}
+
+std::optional<JSON_Integer> parse_integer_value(std::u8string_view number)
+{
+    const bool negative = number.starts_with(u8'-');
+    const std::string_view digits = as_string_view(number.substr(negative ? 1 : 0));
+    const char* const digits_end = digits.data() + digits.length();
+    std::uint64_t magnitude;
+    const auto result = std::from_chars(digits.data(), digits_end, magnitude);
+    if (result.ec != std::errc {} || result.ptr != digits_end) {
+        return {};
+    }
+    if (!negative) {
+        return JSON_Integer { .magnitude = magnitude, .negative = false };
+    }
+    // -0 cannot be represented as an integer,
+    // and the magnitude of the least std::int64_t is 2^63.
+    if (magnitude == 0 || magnitude > std::uint64_t(1) << 63) {
+        return {};
+    }
+    return JSON_Integer { .magnitude = magnitude, .negative = true };
+}
+
+namespace {
+
+#ifdef __SSE2__
+[[nodiscard]]
+std::uint64_t movemask(__m128i mask, int chunk)
+{
+    return std::uint64_t(std::uint32_t(_mm_movemask_epi8(mask))) << (chunk * 16);
+}
+
+[[nodiscard]]
+Block_Masks classify_full_block(const char8_t* data)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1f);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i form_feed = _mm_set1_epi8('\f');
+    const __m128i line_feed = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i left_brace = _mm_set1_epi8('{');
+    const __m128i right_brace = _mm_set1_epi8('}');
+    const __m128i left_square = _mm_set1_epi8('[');
+    const __m128i right_square = _mm_set1_epi8(']');
+    const __m128i slash = _mm_set1_epi8('/');
+
+    Block_Masks result {};
+    for (int chunk = 0; chunk < 4; ++chunk) {
+        const __m128i bytes
+            = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + (chunk * 16)));
+        // For unsigned bytes, min(c, 0x1f) == c is equivalent to c <= 0x1f.
+        const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, control_max), bytes);
+        const __m128i is_newline = _mm_cmpeq_epi8(bytes, line_feed);
+        const __m128i is_special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+            is_control
+        );
+        const __m128i is_whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+            _mm_or_si128(
+                _mm_or_si128(is_newline, _mm_cmpeq_epi8(bytes, carriage_return)),
+                _mm_cmpeq_epi8(bytes, form_feed)
+            )
+        );
+        const __m128i is_brace
+            = _mm_or_si128(_mm_cmpeq_epi8(bytes, left_brace), _mm_cmpeq_epi8(bytes, right_brace));
+        const __m128i is_square
+            = _mm_or_si128(_mm_cmpeq_epi8(bytes, left_square), _mm_cmpeq_epi8(bytes, right_square));
+        const __m128i is_nesting
+            = _mm_or_si128(_mm_or_si128(is_brace, is_square), _mm_cmpeq_epi8(bytes, slash));
+        result.string_special |= movemask(is_special, chunk);
+        result.whitespace |= movemask(is_whitespace, chunk);
+        result.newline |= movemask(is_newline, chunk);
+        result.nesting |= movemask(is_nesting, chunk);
+    }
+    return result;
+}
+#else
+[[nodiscard]]
+Block_Masks classify_full_block(const char8_t* data)
+{
+    Block_Masks result {};
+    for (std::size_t i = 0; i < index_block_size; ++i) {
+        const char8_t c = data[i];
+        const std::uint64_t bit = std::uint64_t(1) << i;
+        result.string_special |= (c == u8'"' || c == u8'\\' || c < 0x20) ? bit : 0;
+        result.whitespace |= is_json_whitespace(c) ? bit : 0;
+        result.newline |= c == u8'\n' ? bit : 0;
+        const bool is_nesting
+            = c == u8'{' || c == u8'}' || c == u8'[' || c == u8']' || c == u8'/';
+        result.nesting |= is_nesting ? bit : 0;
+    }
+    return result;
+}
+#endif
+
+/// @brief Returns the position of the first code unit at or after `pos`
+/// whose bit is set in the `Mask` of its block, or `source.length()` if there is none.
+/// If `inverted` is `true`, searches for the first unset bit instead.
+template <std::uint64_t Block_Masks::* Mask, bool inverted = false>
+[[nodiscard]]
+std::size_t
+find_in_masks(std::span<const Block_Masks> blocks, std::u8string_view source, std::size_t pos)
+{
+    const auto mask_of = [&](std::size_t block) -> std::uint64_t {
+        return inverted ? ~(blocks[block].*Mask) : blocks[block].*Mask;
+    };
+
+    std::size_t block = pos / index_block_size;
+    if (block >= blocks.size()) {
+        return source.length();
+    }
+    std::uint64_t mask = mask_of(block) & (~std::uint64_t(0) << (pos % index_block_size));
+    while (mask == 0) {
+        if (++block == blocks.size()) {
+            return source.length();
+        }
+        mask = mask_of(block);
+    }
+    // When searching for unset bits,
+    // the bits past the end of a partial block match, so the result could exceed the source.
+    const std::size_t result = (block * index_block_size) + std::size_t(std::countr_zero(mask));
+    return std::min(result, source.length());
+}
+
+} // namespace
+
+Block_Masks classify_block(std::u8string_view block)
+{
+    ULIGHT_ASSERT(block.length() <= index_block_size);
+    if (block.length() == index_block_size) {
+        return classify_full_block(block.data());
+    }
+    // Partial blocks are padded with a code unit that belongs to no mask.
+    char8_t padded[index_block_size];
+    std::memset(padded, 'x', index_block_size);
+    std::memcpy(padded, block.data(), block.length());
+    return classify_full_block(padded);
+}
+
+Source_Index::Source_Index(std::u8string_view source, std::pmr::memory_resource* memory)
+    : m_source { source }
+    , m_blocks { memory }
+{
+    m_blocks.reserve((source.length() + index_block_size - 1) / index_block_size);
+    for (std::size_t i = 0; i < source.length(); i += index_block_size) {
+        m_blocks.push_back(classify_block(source.substr(i, index_block_size)));
+    }
+}
+
+std::size_t Source_Index::find_string_special(std::size_t pos) const
+{
+    return find_in_masks<&Block_Masks::string_special>(m_blocks, m_source, pos);
+}
+
+std::size_t Source_Index::skip_whitespace(std::size_t pos) const
+{
+    return find_in_masks<&Block_Masks::whitespace, true>(m_blocks, m_source, pos);
+}
+
+std::size_t Source_Index::find_newline(std::size_t pos) const
+{
+    return find_in_masks<&Block_Masks::newline>(m_blocks, m_source, pos);
+}
+
+Source_Position Line_Tracker::position_after_line_break(std::size_t code_unit)
+{
+    ULIGHT_DEBUG_ASSERT(code_unit <= m_index.source().length());
+    if (code_unit < m_code_unit) {
+        m_code_unit = 0;
+        m_line = 0;
+        m_line_start = 0;
+    }
+
+    const std::span<const Block_Masks> blocks = m_index.blocks();
+    const auto newlines_in_block = [&](std::size_t block) -> std::uint64_t {
+        return block < blocks.size() ? blocks[block].newline : 0;
+    };
+    const auto count_newlines = [&](std::size_t block, std::uint64_t newlines) {
+        if (newlines != 0) {
+            m_line += std::size_t(std::popcount(newlines));
+            m_line_start
+                = (block * index_block_size) + 64 - std::size_t(std::countl_zero(newlines));
+        }
+    };
+
+    // Count the line feeds in [m_code_unit, code_unit).
+    std::size_t block = m_code_unit / index_block_size;
+    const std::size_t last_block = code_unit / index_block_size;
+    std::uint64_t newlines
+        = newlines_in_block(block) & (~std::uint64_t(0) << (m_code_unit % index_block_size));
+    for (; block < last_block; ++block) {
+        count_newlines(block, newlines);
+        newlines = newlines_in_block(block + 1);
+    }
+    count_newlines(block, newlines & ((std::uint64_t(1) << (code_unit % index_block_size)) - 1));
+
+    m_code_unit = code_unit;
+    m_next_newline = m_index.find_newline(code_unit);
+    return { .code_unit = code_unit, .line = m_line, .line_code_unit = code_unit - m_line_start };
+}
+
+namespace {
+
 enum struct Comment_Policy : bool {
     not_if_strict,
     always_allow,
 };
 
-enum struct String_Type : bool {
-    value,
-    property,
-};
-
 struct Highlighter : Highlighter_Base {
 private:
     const bool has_comments;
+    const Source_Index source_index;
 
 public:
     Highlighter(
@@ -156,6 +527,7 @@ public:
     )
         : Highlighter_Base { out, source, memory, options }
         , has_comments { comments == Comment_Policy::always_allow || !options.strict }
+        , source_index { source, memory }
     {
     }
 
@@ -164,6 +536,14 @@ public:
         consume_whitespace_comments();
         expect_value();
         consume_whitespace_comments();
+        // There should only be one value, but we keep highlighting whatever follows,
+        // so that e.g. a stray bracket doesn't leave the rest of the file unhighlighted.
+        while (!remainder.empty()) {
+            if (!expect_value()) {
+                emit_and_advance(1, Highlight_Type::error, Coalescing::forced);
+            }
+            consume_whitespace_comments();
+        }
         return true;
     }
 
@@ -171,8 +551,7 @@ private:
     void consume_whitespace_comments()
     {
         while (true) {
-            const std::size_t white_length = match_whitespace(remainder);
-            advance(white_length);
+            advance(source_index.skip_whitespace(index) - index);
             if (has_comments && (expect_line_comment() || expect_block_comment())) {
                 continue;
             }
@@ -241,7 +620,12 @@ private:
             }
         };
 
-        while (length < remainder.length()) {
+        while (true) {
+            // Literal characters are skipped in bulk using the index.
+            length = source_index.find_string_special(index + length) - index;
+            if (length == remainder.length()) {
+                break;
+            }
             switch (const char8_t c = remainder[length]) {
             case u8'"': {
                 if (highlight == Highlight_Type::string) {
@@ -278,12 +662,9 @@ private:
                 break;
             }
             default: {
-                if (c < 0x20) {
-                    flush();
-                    emit_and_advance(1, Highlight_Type::error);
-                    break;
-                }
-                ++length;
+                ULIGHT_DEBUG_ASSERT(c < 0x20);
+                flush();
+                emit_and_advance(1, Highlight_Type::error);
                 break;
             }
             }
@@ -323,6 +704,11 @@ private:
                 emit_and_advance(1, Highlight_Type::sym_punc);
                 continue;
             }
+            // Like the parser, we assume that a mismatched bracket was meant to close the object.
+            if (remainder.starts_with(u8']')) {
+                emit_and_advance(1, Highlight_Type::error, Coalescing::forced);
+                return true;
+            }
             if (!remainder.empty()) {
                 emit_and_advance(1, Highlight_Type::error, Coalescing::forced);
             }
@@ -379,6 +765,10 @@ private:
             if (expect_value()) {
                 continue;
             }
+            if (remainder.starts_with(u8'}')) {
+                emit_and_advance(1, Highlight_Type::error, Coalescing::forced);
+                return true;
+            }
             if (!remainder.empty()) {
                 emit_and_advance(1, Highlight_Type::error, Coalescing::forced);
             }
@@ -398,416 +788,279 @@ private:
             const auto coalescing
                 = highlight == Highlight_Type::error ? Coalescing::forced : Coalescing::normal;
             emit_and_advance(id.length, highlight, coalescing);
+            return true;
         }
         return false;
     }
 };
 
-struct Parser {
-private:
-    JSON_Visitor& out;
-    const std::size_t source_length;
-    const JSON_Options options;
+/// @brief Invokes `f(std::size_t offset, std::size_t line, std::u8string_view record)`
+/// for every line within `lines` that is not entirely whitespace,
+/// where `offset` and `line` are relative to the start of `lines`.
+/// @returns The amount of lines.
+template <typename F>
+std::size_t for_each_record(std::u8string_view lines, F f)
+{
+    std::size_t line = 0;
+    for (std::size_t begin = 0; begin < lines.length(); ++line) {
+        const std::size_t end = std::min(lines.find(u8'\n', begin), lines.length());
+        const std::u8string_view record = lines.substr(begin, end - begin);
+        if (match_whitespace(record) != record.length()) {
+            f(begin, line, record);
+        }
+        begin = end + 1;
+    }
+    return line;
+}
 
-    std::u8string_view remainder;
+enum struct Event_Type : Underlying {
+    line_comment,
+    block_comment,
+    literal,
+    escape,
+    escape_code_point,
+    escape_code_units,
+    number,
+    number_value,
+    integer,
+    null,
+    boolean,
+    push_string,
+    pop_string,
+    push_property,
+    pop_property,
+    push_object,
+    pop_object,
+    push_array,
+    pop_array,
+    push_record,
+    pop_record,
+    error,
+};
+
+/// @brief A recorded invocation of a `JSON_Visitor` member function.
+struct Recorded_Event {
+    Event_Type type;
+    JSON_Error error = {};
+    bool boolean = false;
+    unsigned char code_units_length = 0;
+    std::array<char8_t, 4> code_units {};
+    char32_t code_point = 0;
     Source_Position pos {};
+    /// @brief Text within the source, such as a comment or the digits of a number.
+    std::u8string_view text {};
+    double number = 0;
+    JSON_Integer integer {};
+};
+
+/// @brief A visitor which records all events within a batch of lines,
+/// so that they can be replayed on another thread.
+/// Positions are recorded relative to the start of the batch.
+struct Event_Recorder final : JSON_Visitor {
+private:
+    std::vector<Recorded_Event>& m_events;
+    /// @brief The start of the current record, relative to the start of the batch.
+    /// The parser only sees the record itself,
+    /// so the positions it reports are offset by this amount.
+    Source_Position m_record_start {};
 
 public:
     [[nodiscard]]
-    Parser(JSON_Visitor& out, std::u8string_view source, JSON_Options options)
-        : out { out }
-        , source_length { source.length() }
-        , options { options }
-        , remainder { source }
+    explicit Event_Recorder(std::vector<Recorded_Event>& events)
+        : m_events { events }
     {
     }
 
-    [[nodiscard]]
-    bool operator()()
+    void push_record(const Source_Position& pos) final
     {
-        return consume_whitespace_comments() && consume_value() && consume_whitespace_comments();
+        m_record_start = pos;
+        m_events.push_back({ .type = Event_Type::push_record, .pos = pos });
     }
-
-private:
-    void error(JSON_Error error)
+    void pop_record(const Source_Position& pos) final
     {
-        out.error(pos, error);
+        m_events.push_back({ .type = Event_Type::pop_record, .pos = pos });
     }
 
-    void advance_on_same_line(std::size_t amount)
+    void line_comment(const Source_Position& pos, std::u8string_view comment) final
     {
-        pos.code_unit += amount;
-        pos.line_code_unit += amount;
-        remainder.remove_prefix(amount);
+        record({ .type = Event_Type::line_comment, .text = comment }, pos);
     }
-
-    void advance(std::size_t amount)
+    void block_comment(const Source_Position& pos, std::u8string_view comment) final
     {
-        while (amount != 0) {
-            const std::size_t newline_pos = remainder.substr(0, amount).find(u8'\n');
-            if (newline_pos == std::u8string_view::npos) {
-                advance_on_same_line(amount);
-                return;
-            }
-            const std::size_t remaining_line_length = newline_pos + 1;
-            pos.code_unit += remaining_line_length;
-            pos.line += 1;
-            pos.line_code_unit = 0;
-            remainder.remove_prefix(remaining_line_length);
-
-            ULIGHT_DEBUG_ASSERT(amount >= remaining_line_length);
-            amount -= remaining_line_length;
-        }
+        record({ .type = Event_Type::block_comment, .text = comment }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_whitespace_comments()
+    void literal(const Source_Position& pos, std::u8string_view chars) final
     {
-        if (!options.allow_comments) {
-            const std::size_t white_length = match_whitespace(remainder);
-            advance(white_length);
-            return true;
-        }
-        while (true) {
-            const std::size_t white_length = match_whitespace(remainder);
-            advance(white_length);
-            if (remainder.starts_with(u8"//")) {
-                if (!consume_line_comment()) {
-                    return false;
-                }
-                continue;
-            }
-            if (remainder.starts_with(u8"/*")) {
-                if (!consume_block_comment()) {
-                    return false;
-                }
-                continue;
-            }
-            break;
-        }
-        return true;
+        record({ .type = Event_Type::literal, .text = chars }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_line_comment()
+    void escape(const Source_Position& pos, std::u8string_view escape) final
     {
-        if (const std::size_t length = match_line_comment(remainder)) {
-            out.line_comment(pos, remainder.substr(0, length));
-            advance_on_same_line(length);
-            return true;
-        }
-        ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"// should have been tested.");
-        error(JSON_Error::error);
-        return false;
+        record({ .type = Event_Type::escape, .text = escape }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_block_comment()
+    void escape(const Source_Position& pos, std::u8string_view escape, char32_t code_point) final
     {
-        if (const js::Comment_Result block_comment = match_block_comment(remainder)) {
-            if (!block_comment.is_terminated) {
-                error(JSON_Error::comment);
-                return false;
-            }
-            advance(block_comment.length);
-            out.block_comment(pos, remainder.substr(0, block_comment.length));
-            return true;
-        }
-        ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"/* should have been tested.");
-        error(JSON_Error::error);
-        return false;
+        record(
+            { .type = Event_Type::escape_code_point, .code_point = code_point, .text = escape }, pos
+        );
     }
-
-    [[nodiscard]]
-    bool consume_value()
+    void escape(
+        const Source_Position& pos,
+        std::u8string_view escape,
+        char32_t code_point,
+        std::u8string_view code_units
+    ) final
     {
-        switch (remainder[0]) {
-        case u8'"': {
-            return consume_string(String_Type::value);
-        }
-        case u8'[': {
-            return consume_array();
-        }
-        case u8'{': {
-            return consume_object();
-        }
-        case u8'0':
-        case u8'1':
-        case u8'2':
-        case u8'3':
-        case u8'4':
-        case u8'5':
-        case u8'6':
-        case u8'7':
-        case u8'8':
-        case u8'9': {
-            return consume_number();
-        }
-        case u8't': {
-            if (remainder.starts_with(u8"true")) {
-                out.boolean(pos, true);
-                advance_on_same_line(4);
-                return true;
-            }
-            return false;
-        }
-        case u8'f': {
-            if (remainder.starts_with(u8"false")) {
-                out.boolean(pos, false);
-                advance_on_same_line(5);
-                return true;
-            }
-            return false;
-        }
-        case u8'n': {
-            if (remainder.starts_with(u8"null")) {
-                out.null(pos);
-                advance_on_same_line(4);
-                return true;
-            }
-            return false;
-        }
-        default: error(JSON_Error::illegal_escape); return false;
-        }
+        // The code units are a temporary, so they need to be copied.
+        Recorded_Event event { .type = Event_Type::escape_code_units,
+                               .code_units_length = static_cast<unsigned char>(code_units.length()),
+                               .code_point = code_point,
+                               .text = escape };
+        ULIGHT_DEBUG_ASSERT(code_units.length() <= event.code_units.size());
+        std::ranges::copy(code_units, event.code_units.begin());
+        record(event, pos);
     }
-
-    [[nodiscard]]
-    bool consume_string(String_Type type)
+    void number(const Source_Position& pos, std::u8string_view number) final
     {
-        if (!remainder.starts_with(u8'"')) {
-            ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"Should have checked for quotes already.");
-            return false;
-        }
-        if (type == String_Type::property) {
-            out.push_property(pos);
-        }
-        else {
-            out.push_string(pos);
-        }
-        std::size_t length = 0;
-        advance_on_same_line(1);
-
-        const auto flush = [&] {
-            if (length != 0) {
-                out.literal(pos, remainder.substr(0, length));
-                advance_on_same_line(length);
-                length = 0;
-            }
-        };
-
-        while (length < remainder.length()) {
-            switch (const char8_t c = remainder[length]) {
-            case u8'"': {
-                flush();
-                if (type == String_Type::property) {
-                    out.pop_property(pos);
-                }
-                else {
-                    out.pop_string(pos);
-                }
-                advance_on_same_line(1);
-                return true;
-            }
-            case u8'\\': {
-                flush();
-                if (!consume_escape()) {
-                    return false;
-                }
-                continue;
-            }
-            default: {
-                if (c < 0x20) {
-                    flush();
-                    error(JSON_Error::illegal_character);
-                    return false;
-                }
-                ++length;
-                break;
-            }
-            }
-        }
-
-        error(JSON_Error::unterminated_string);
-        return false;
+        record({ .type = Event_Type::number, .text = number }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_escape()
+    void number(const Source_Position& pos, std::u8string_view number, double value) final
     {
-        const auto policy = options.escapes == Escape_Parsing::none ? Escape_Policy::match_only
-                                                                    : Escape_Policy::parse;
-        const Escape_Result escape = match_escape_sequence(remainder, policy);
-        if (!escape || escape.value == Escape_Result::no_value) {
-            error(JSON_Error::illegal_escape);
-            return false;
-        }
-
-        switch (options.escapes) {
-        case Escape_Parsing::none: //
-            out.escape(pos, remainder.substr(0, escape.length));
-            break;
-        case Escape_Parsing::parse: //
-            out.escape(pos, remainder.substr(0, escape.length), escape.value);
-            break;
-        case Escape_Parsing::parse_encode: {
-            const auto [code_units, length] = utf8::encode8_unchecked(escape.value);
-            const std::u8string_view encoded { code_units.data(), std::size_t(length) };
-            out.escape(pos, remainder.substr(0, escape.length), escape.value, encoded);
-            break;
-        }
-        }
-
-        advance_on_same_line(escape.length);
-        return true;
+        record({ .type = Event_Type::number_value, .text = number, .number = value }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_number()
+    void integer(const Source_Position& pos, std::u8string_view number, JSON_Integer value) final
     {
-        const Number_Result number = match_number(remainder);
-        if (!number || number.erroneous) {
-            error(JSON_Error::illegal_number);
-            return false;
-        }
-
-        const std::u8string_view number_string = remainder.substr(0, number.length);
-        if (options.parse_numbers) {
-            const auto* const str_begin = reinterpret_cast<const char*>(number_string.data());
-            char* str_end = nullptr;
-            const double value = std::strtod(str_begin, &str_end);
-            if (str_end == str_begin) {
-                error(JSON_Error::illegal_number);
-                return false;
-            }
-            out.number(pos, number_string, value);
-        }
-        else {
-            out.number(pos, number_string);
-        }
-        advance_on_same_line(number.length);
-        return true;
+        record({ .type = Event_Type::integer, .text = number, .integer = value }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_object()
+    void null(const Source_Position& pos) final
     {
-        if (!remainder.starts_with(u8'{')) {
-            ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"This should have been tested outside.");
-            error(JSON_Error::error);
-            return false;
-        }
-        out.push_object(pos);
-        advance_on_same_line(1);
-
-        bool first_member = true;
-        while (!remainder.empty()) {
-            if (!consume_whitespace_comments()) {
-                return false;
-            }
-            if (remainder.starts_with(u8'}')) {
-                out.pop_object(pos);
-                advance_on_same_line(1);
-                return true;
-            }
-            if (first_member) {
-                if (!consume_member()) {
-                    return false;
-                }
-                first_member = false;
-                continue;
-            }
-            if (remainder.starts_with(u8',')) {
-                advance_on_same_line(1);
-                if (!consume_whitespace_comments() || !consume_member()) {
-                    return false;
-                }
-                continue;
-            }
-            error(JSON_Error::illegal_character);
-            return false;
-        }
-
-        error(JSON_Error::unterminated_object);
-        return false;
+        record({ .type = Event_Type::null }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_member()
+    void boolean(const Source_Position& pos, bool value) final
     {
-        if (!consume_string(String_Type::property)) {
-            return false;
-        }
-
-        const auto at_end = [&] {
-            return remainder.empty() || remainder.starts_with(u8'}')
-                || remainder.starts_with(u8',');
-        };
-        if (!consume_whitespace_comments()) {
-            return false;
-        }
-        if (!remainder.starts_with(u8':')) {
-            error(JSON_Error::valueless_member);
-            return false;
-        }
-        advance_on_same_line(1);
-
-        if (!consume_whitespace_comments()) {
-            return false;
-        }
-        if (at_end()) {
-            error(JSON_Error::valueless_member);
-            return false;
-        }
-        return consume_value();
+        record({ .type = Event_Type::boolean, .boolean = value }, pos);
     }
-
-    [[nodiscard]]
-    bool consume_array()
+    void push_string(const Source_Position& pos) final
     {
-        if (!remainder.starts_with(u8'[')) {
-            ULIGHT_DEBUG_ASSERT_UNREACHABLE(u8"This should have been tested outside.");
-            error(JSON_Error::error);
-            return false;
-        }
-        out.push_array(pos);
-        advance_on_same_line(1);
-        if (!consume_whitespace_comments()) {
-            return false;
-        }
+        record({ .type = Event_Type::push_string }, pos);
+    }
+    void pop_string(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::pop_string }, pos);
+    }
+    void push_property(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::push_property }, pos);
+    }
+    void pop_property(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::pop_property }, pos);
+    }
+    void push_object(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::push_object }, pos);
+    }
+    void pop_object(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::pop_object }, pos);
+    }
+    void push_array(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::push_array }, pos);
+    }
+    void pop_array(const Source_Position& pos) final
+    {
+        record({ .type = Event_Type::pop_array }, pos);
+    }
+    Error_Reaction error(const Source_Position& pos, JSON_Error error) final
+    {
+        record({ .type = Event_Type::error, .error = error }, pos);
+        return Error_Reaction::abort;
+    }
 
-        bool first_element = true;
-        while (!remainder.empty()) {
-            if (!consume_whitespace_comments()) {
-                return false;
-            }
-            if (remainder.starts_with(u8']')) {
-                out.pop_array(pos);
-                advance_on_same_line(1);
-                return true;
-            }
-            if (first_element) {
-                if (!consume_value()) {
-                    return false;
-                }
-                first_element = false;
-                continue;
-            }
-            if (remainder.starts_with(u8',')) {
-                advance_on_same_line(1);
-                if (!consume_whitespace_comments() || !consume_value()) {
-                    return false;
-                }
-                continue;
-            }
-            error(JSON_Error::illegal_character);
-            return false;
-        }
+private:
+    void record(Recorded_Event event, const Source_Position& pos)
+    {
+        // Records contain no line feeds, but they may contain other line terminators.
+        event.pos = { .code_unit = m_record_start.code_unit + pos.code_unit,
+                      .line = m_record_start.line + pos.line,
+                      .line_code_unit = pos.line_code_unit };
+        m_events.push_back(event);
+    }
+};
 
-        error(JSON_Error::unterminated_array);
-        return false;
+/// @brief Invokes the member function of `out` that corresponds to `event`,
+/// with the position of the event offset by `code_unit_offset` and `line_offset`.
+void replay(
+    JSON_Visitor& out,
+    const Recorded_Event& event,
+    std::size_t code_unit_offset,
+    std::size_t line_offset
+)
+{
+    const Source_Position pos { .code_unit = event.pos.code_unit + code_unit_offset,
+                                .line = event.pos.line + line_offset,
+                                .line_code_unit = event.pos.line_code_unit };
+    switch (event.type) {
+    case Event_Type::line_comment: out.line_comment(pos, event.text); return;
+    case Event_Type::block_comment: out.block_comment(pos, event.text); return;
+    case Event_Type::literal: out.literal(pos, event.text); return;
+    case Event_Type::escape: out.escape(pos, event.text); return;
+    case Event_Type::escape_code_point: out.escape(pos, event.text, event.code_point); return;
+    case Event_Type::escape_code_units: {
+        const std::u8string_view code_units { event.code_units.data(), event.code_units_length };
+        out.escape(pos, event.text, event.code_point, code_units);
+        return;
+    }
+    case Event_Type::number: out.number(pos, event.text); return;
+    case Event_Type::number_value: out.number(pos, event.text, event.number); return;
+    case Event_Type::integer: out.integer(pos, event.text, event.integer); return;
+    case Event_Type::null: out.null(pos); return;
+    case Event_Type::boolean: out.boolean(pos, event.boolean); return;
+    case Event_Type::push_string: out.push_string(pos); return;
+    case Event_Type::pop_string: out.pop_string(pos); return;
+    case Event_Type::push_property: out.push_property(pos); return;
+    case Event_Type::pop_property: out.pop_property(pos); return;
+    case Event_Type::push_object: out.push_object(pos); return;
+    case Event_Type::pop_object: out.pop_object(pos); return;
+    case Event_Type::push_array: out.push_array(pos); return;
+    case Event_Type::pop_array: out.pop_array(pos); return;
+    case Event_Type::push_record: out.push_record(pos); return;
+    case Event_Type::pop_record: out.pop_record(pos); return;
+    // Errors always abort the record, regardless of the reaction,
+    // because the record has already been parsed at this point.
+    case Event_Type::error: (void)out.error(pos, event.error); return;
     }
+    ULIGHT_ASSERT_UNREACHABLE(u8"Invalid event type.");
+}
+
+/// @brief The result of parsing a batch of JSON Lines.
+struct Parsed_Batch {
+    std::vector<Recorded_Event> events;
+    /// @brief The amount of lines in the batch.
+    std::size_t lines = 0;
+    /// @brief `true` iff all records in the batch were parsed successfully.
+    bool success = true;
 };
 
+void parse_json_lines_batch(const Line_Batch& batch, Parsed_Batch& out, JSON_Options options)
+{
+    out.events.clear();
+    out.success = true;
+
+    std::pmr::unsynchronized_pool_resource memory;
+    Event_Recorder recorder { out.events };
+    out.lines = for_each_record(
+        batch.lines, [&](std::size_t offset, std::size_t line, std::u8string_view record) {
+            recorder.push_record({ .code_unit = offset, .line = line, .line_code_unit = 0 });
+            const Source_Index index { record, &memory };
+            out.success &= Parser { recorder, index, 0, options }();
+            recorder.pop_record({ .code_unit = offset + record.length(),
+                                  .line = line,
+                                  .line_code_unit = record.length() });
+        }
+    );
+}
+
 } // namespace
 } // namespace json
 
@@ -818,6 +1071,9 @@ bool highlight_json(
     const Highlight_Options& options
 )
 {
+    if (!memory) {
+        memory = std::pmr::get_default_resource();
+    }
     return json::Highlighter { out, source, memory, options,
                                json::Comment_Policy::not_if_strict }();
 }
@@ -829,12 +1085,70 @@ bool highlight_jsonc(
     const Highlight_Options& options
 )
 {
+    if (!memory) {
+        memory = std::pmr::get_default_resource();
+    }
     return json::Highlighter { out, source, memory, options, json::Comment_Policy::always_allow }();
 }
 
+bool highlight_jsonl(
+    Non_Owning_Buffer<Token>& out,
+    std::u8string_view source,
+    std::pmr::memory_resource* memory,
+    const Highlight_Options& options
+)
+{
+    if (!memory) {
+        memory = std::pmr::get_default_resource();
+    }
+    // Each record is highlighted separately,
+    // so that errors such as unterminated strings cannot spill over into subsequent records.
+    const auto highlight_batch = [&](const Line_Batch& batch, std::vector<Token>& tokens) {
+        tokens.clear();
+        std::pmr::unsynchronized_pool_resource record_memory { memory };
+        std::size_t record_begin = 0;
+        const auto flush = [&](Token* record_tokens, std::size_t amount) {
+            for (const Token& token : std::span<const Token> { record_tokens, amount }) {
+                tokens.push_back(token);
+                tokens.back().begin += record_begin;
+            }
+        };
+        Token buffer[256];
+        Non_Owning_Buffer<Token> record_out { buffer, flush };
+        json::for_each_record(
+            batch.lines, [&](std::size_t offset, std::size_t, std::u8string_view record) {
+                record_begin = batch.begin + offset;
+                json::Highlighter { record_out, record, &record_memory, options,
+                                    json::Comment_Policy::not_if_strict }();
+                record_out.flush();
+            }
+        );
+    };
+    const auto deliver = [&](const Line_Batch&, const std::vector<Token>& tokens) {
+        out.append_range(tokens);
+    };
+    process_line_batches<std::vector<Token>>(source, options.threads, highlight_batch, deliver);
+    return true;
+}
+
+namespace json {
+
+bool parse_json_value(
+    JSON_Visitor& visitor,
+    const Source_Index& index,
+    std::size_t begin,
+    JSON_Options options
+)
+{
+    return Parser { visitor, index, begin, options }.parse_value();
+}
+
+} // namespace json
+
 bool parse_json(JSON_Visitor& visitor, std::u8string_view source, JSON_Options options)
 {
-    return json::Parser { visitor, source, options }();
+    // The virtual interface is merely the static one, instantiated for the polymorphic base.
+    return parse_json<JSON_Visitor>(visitor, source, options);
 }
 
 bool parse_json(JSON_Visitor& visitor, std::string_view source, JSON_Options options)
@@ -844,4 +1158,26 @@ bool parse_json(JSON_Visitor& visitor, std::string_view source, JSON_Options opt
     return parse_json(visitor, u8source, options);
 }
 
+bool parse_json_lines(
+    JSON_Visitor& visitor,
+    std::u8string_view source,
+    const JSON_Lines_Options& options
+)
+{
+    const auto parse_batch = [&](const Line_Batch& batch, json::Parsed_Batch& result) {
+        json::parse_json_lines_batch(batch, result, options.json);
+    };
+    std::size_t lines_before_batch = 0;
+    bool success = true;
+    const auto deliver = [&](const Line_Batch& batch, const json::Parsed_Batch& result) {
+        for (const json::Recorded_Event& event : result.events) {
+            json::replay(visitor, event, batch.begin, lines_before_batch);
+        }
+        lines_before_batch += result.lines;
+        success &= result.success;
+    };
+    process_line_batches<json::Parsed_Batch>(source, options.threads, parse_batch, deliver);
+    return success;
+}
+
 } // namespace ulight
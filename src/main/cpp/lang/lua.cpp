@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cstddef>
 #include <memory_resource>
@@ -9,6 +10,7 @@
 #include "ulight/impl/ascii_algorithm.hpp"
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
+#include "ulight/impl/profile.hpp"
 #include "ulight/ulight.hpp"
 
 #include "ulight/impl/unicode.hpp"
@@ -99,105 +101,69 @@ std::size_t match_non_whitespace(std::u8string_view str)
     return ascii::length_if_not(str, is_lua_whitespace_lambda);
 }
 
-std::size_t match_line_comment(std::u8string_view s) noexcept
+std::size_t match_opening_long_bracket(std::u8string_view str) noexcept
 {
-    if (!s.starts_with(u8"--")) {
+    if (!str.starts_with(u8'[')) {
         return 0;
     }
+    const std::size_t level_end = str.find_first_not_of(u8'=', 1);
+    return level_end != std::u8string_view::npos && str[level_end] == u8'[' ? level_end + 1 : 0;
+}
 
-    // Skip the -- prefix
-    std::size_t length = 2;
-
-    // If it's not a block comment (--[[), then it's a line comment
-    if (s.length() >= 4 && s.substr(0, 4) == u8"--[[") {
-        return 0;
+std::size_t
+find_closing_long_bracket(std::u8string_view str, std::size_t level, std::size_t start) noexcept
+{
+    // Long strings in generated data files can be megabytes long,
+    // so rather than testing every position for the closing bracket,
+    // we skip to each "]" with std::memchr (via find), and only verify the "=" run there.
+    while (true) {
+        const std::size_t bracket = str.find(u8']', start);
+        if (bracket == std::u8string_view::npos) {
+            return bracket;
+        }
+        std::size_t equals_end = bracket + 1;
+        while (equals_end < str.length() && equals_end - bracket - 1 < level
+               && str[equals_end] == u8'=') {
+            ++equals_end;
+        }
+        if (equals_end - bracket - 1 == level && equals_end < str.length()
+            && str[equals_end] == u8']') {
+            return bracket;
+        }
+        // No closing bracket can start within the "=" run,
+        // but the code unit that ended it may be another "]".
+        start = equals_end;
     }
+}
 
-    // Check for long comment syntax with equals (--[=[ ]=])
-    if (s.length() >= 3 && s[2] == u8'[') {
-        std::size_t idx = 3;
-
-        // Count equals signs
-        while (idx < s.length() && s[idx] == u8'=') {
-            idx++;
-        }
-
-        // If we have a well-formed opening [, it's a block comment, not a line comment.
-        if (idx < s.length() && s[idx] == u8'[') {
-            return 0;
-        }
+std::size_t match_line_comment(std::u8string_view s) noexcept
+{
+    if (!s.starts_with(u8"--")) {
+        return 0;
     }
-
-    // Continue until EoL
-    while (length < s.length()) {
-        if (s[length] == u8'\n') {
-            return length;
-        }
-        ++length;
+    // If the comment starts with an opening long bracket, it's a block comment.
+    if (match_opening_long_bracket(s.substr(2)) != 0) {
+        return 0;
     }
-
-    return length;
+    const std::size_t line_end = s.find(u8'\n', 2);
+    return line_end == std::u8string_view::npos ? s.length() : line_end;
 }
 
 Comment_Result match_block_comment(std::u8string_view s) noexcept
 {
-    // Check for --[[ style comment
-    if (s.length() < 4 || !s.starts_with(u8"--[[")) {
-        // Check for --[=[ style comment with equals signs
-        if (s.length() < 5 || !s.starts_with(u8"--[")) {
-            return {};
-        }
-
-        std::size_t eq_count = 0;
-        std::size_t idx = 3;
-
-        // Count equals signs
-        while (idx < s.length() && s[idx] == u8'=') {
-            eq_count++;
-            idx++;
-        }
-
-        // We need at least one equals sign and an opening bracket
-        if (eq_count == 0 || idx >= s.length() || s[idx] != u8'[') {
-            return {};
-        }
-
-        // Now find the matching closing delimiter
-        std::size_t closing_idx = idx + 1;
-        while (closing_idx < s.length()) {
-            // Look for ]={eq_count}]
-            if (s[closing_idx] == u8']') {
-                bool found = true;
-                for (std::size_t i = 0; i < eq_count; i++) {
-                    if (closing_idx + 1 + i >= s.length() || s[closing_idx + 1 + i] != u8'=') {
-                        found = false;
-                        break;
-                    }
-                }
-
-                if (found && closing_idx + 1 + eq_count < s.length()
-                    && s[closing_idx + 1 + eq_count] == u8']') {
-                    return Comment_Result { .length = closing_idx + 2 + eq_count,
-                                            .is_terminated = true };
-                }
-            }
-            closing_idx++;
-        }
-
-        return Comment_Result { .length = s.length(), .is_terminated = false };
+    if (!s.starts_with(u8"--")) {
+        return {};
     }
-
-    // Find the matching closing ]].
-    std::size_t closing_idx = 4;
-    while (closing_idx < s.length() - 1) {
-        if (s[closing_idx] == u8']' && s[closing_idx + 1] == u8']') {
-            return Comment_Result { .length = closing_idx + 2, .is_terminated = true };
-        }
-        closing_idx++;
+    const std::size_t opening_length = match_opening_long_bracket(s.substr(2));
+    if (opening_length == 0) {
+        return {};
     }
-
-    // No match.
-    return Comment_Result { .length = s.length(), .is_terminated = false };
+    const std::size_t level = opening_length - 2;
+    const std::size_t closing = find_closing_long_bracket(s, level, 2 + opening_length);
+    if (closing == std::u8string_view::npos) {
+        return Comment_Result { .length = s.length(), .is_terminated = false };
+    }
+    return Comment_Result { .length = closing + level + 2, .is_terminated = true };
 }
 
 String_Literal_Result match_string_literal(std::u8string_view str)
@@ -243,67 +209,20 @@ String_Literal_Result match_string_literal(std::u8string_view str)
     }
 
     // Long bracket strings [[ ]] or [=[ ]=].
-    if (str.starts_with(u8"[[")) {
-        std::size_t length = 2;
-
-        while (length < str.length() - 1) {
-            if (str[length] == u8']' && str[length + 1] == u8']') {
-                return String_Literal_Result { .length = length + 2,
-                                               .is_long_string = true,
-                                               .terminated = true };
-            }
-            length++;
-        }
-
-        // Unterminated long string.
-        return String_Literal_Result { .length = str.length(),
-                                       .is_long_string = true,
-                                       .terminated = false };
+    const std::size_t opening_length = match_opening_long_bracket(str);
+    if (opening_length == 0) {
+        return {};
     }
-
-    // [=[ ]=] strings with equals signs.
-    if (str.starts_with(u8"[") && str.length() >= 3) {
-        std::size_t eq_count = 0;
-        std::size_t idx = 1;
-
-        while (idx < str.length() && str[idx] == u8'=') {
-            eq_count++;
-            idx++;
-        }
-
-        if (eq_count == 0 || idx >= str.length() || str[idx] != u8'[') {
-            return {};
-        }
-
-        std::size_t closing_idx = idx + 1;
-        while (closing_idx < str.length()) {
-            // Look for ]={eq_count}].
-            if (str[closing_idx] == u8']') {
-                bool found = true;
-                for (std::size_t i = 0; i < eq_count; i++) {
-                    if (closing_idx + 1 + i >= str.length() || str[closing_idx + 1 + i] != u8'=') {
-                        found = false;
-                        break;
-                    }
-                }
-
-                if (found && closing_idx + 1 + eq_count < str.length()
-                    && str[closing_idx + 1 + eq_count] == u8']') {
-                    return String_Literal_Result { .length = closing_idx + 2 + eq_count,
-                                                   .is_long_string = true,
-                                                   .terminated = true };
-                }
-            }
-            closing_idx++;
-        }
-
-        // No matches.
+    const std::size_t level = opening_length - 2;
+    const std::size_t closing = find_closing_long_bracket(str, level, opening_length);
+    if (closing == std::u8string_view::npos) {
         return String_Literal_Result { .length = str.length(),
                                        .is_long_string = true,
                                        .terminated = false };
     }
-
-    return {};
+    return String_Literal_Result { .length = closing + level + 2,
+                                   .is_long_string = true,
+                                   .terminated = true };
 }
 
 std::size_t match_number(std::u8string_view str)
@@ -399,28 +318,11 @@ std::size_t match_number(std::u8string_view str)
 
 std::size_t match_identifier(std::u8string_view str)
 {
-    if (str.empty()) {
-        return 0;
-    }
-
-    // Check first character.
-    const auto [first_char, first_units] = utf8::decode_and_length_or_replacement(str);
-    if (!is_lua_identifier_start(first_char)) {
-        return 0;
-    }
-
-    auto length = static_cast<std::size_t>(first_units);
-
-    // Check rest of the characters.
-    while (length < str.length()) {
-        const auto [code_point, units] = utf8::decode_and_length_or_replacement(str.substr(length));
-        if (!is_lua_identifier_continue(code_point)) {
-            break;
-        }
-        length += static_cast<std::size_t>(units);
-    }
-
-    return length;
+    // Lua identifiers are pure ASCII, so no decoding is necessary.
+    // Any non-ASCII code unit simply ends the identifier.
+    constexpr auto is_start = [](char8_t c) { return is_lua_identifier_start(c); };
+    constexpr auto is_continue = [](char8_t c) { return is_lua_identifier_continue(c); };
+    return ascii::length_if_head_tail(str, is_start, is_continue);
 }
 
 std::optional<Lua_Token_Type> match_operator_or_punctuation(std::u8string_view str)
@@ -527,6 +429,59 @@ std::optional<Lua_Token_Type> match_operator_or_punctuation(std::u8string_view s
 
 } // namespace lua
 
+namespace lua {
+namespace {
+
+/// @brief Classifies the first code unit of a token,
+/// which determines the rules in `highlight_lua` that can possibly match.
+enum struct Leading_Byte : Underlying {
+    /// @brief Anything not covered by the other classes,
+    /// which can only begin an operator or punctuator, or is highlighted as a symbol.
+    other,
+    /// @brief See `is_lua_whitespace`.
+    whitespace,
+    /// @brief `<`, which begins the `<const>` attribute or an operator.
+    less,
+    /// @brief `-`, which begins a comment or an operator.
+    minus,
+    /// @brief `'` or `"`, which begin a string literal.
+    quote,
+    /// @brief `[`, which begins a long string literal or an operator.
+    square,
+    /// @brief `.`, which begins a number like `.5`, or an operator.
+    dot,
+    /// @brief `[0-9]`, which begins a number.
+    digit,
+    /// @brief `[A-Za-z_]`, which begins an identifier or keyword.
+    identifier,
+};
+
+constexpr auto leading_byte_table = [] {
+    std::array<Leading_Byte, 256> result {};
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        const auto c = char8_t(i);
+        if (is_lua_whitespace(c)) {
+            result[i] = Leading_Byte::whitespace;
+        }
+        else if (is_ascii_digit(c)) {
+            result[i] = Leading_Byte::digit;
+        }
+        else if (is_lua_identifier_start(c)) {
+            result[i] = Leading_Byte::identifier;
+        }
+    }
+    result[u8'<'] = Leading_Byte::less;
+    result[u8'-'] = Leading_Byte::minus;
+    result[u8'\''] = Leading_Byte::quote;
+    result[u8'"'] = Leading_Byte::quote;
+    result[u8'['] = Leading_Byte::square;
+    result[u8'.'] = Leading_Byte::dot;
+    return result;
+}();
+
+} // namespace
+} // namespace lua
+
 bool highlight_lua(
     Non_Owning_Buffer<Token>& out,
     std::u8string_view source,
@@ -551,9 +506,12 @@ bool highlight_lua(
 
     while (index < source.size()) {
         const std::u8string_view remainder = source.substr(index);
+        // Every rule below is only tried if it can begin with the first code unit,
+        // so that typically, only a single rule is tried.
+        const lua::Leading_Byte leading = lua::leading_byte_table[remainder[0]];
 
         // Special case (s).
-        if (remainder.length() >= 7 && remainder.substr(0, 7) == u8"<const>") {
+        if (leading == lua::Leading_Byte::less && remainder.starts_with(u8"<const>")) {
             // Emit '<' with attr_delim highlight.
             emit(index, 1, Highlight_Type::attr_delim);
             // Emit 'const' with attr highlight.
@@ -566,13 +524,17 @@ bool highlight_lua(
         }
 
         // Whitespace.
-        if (const std::size_t white_length = lua::match_whitespace(remainder)) {
+        if (const std::size_t white_length = leading != lua::Leading_Byte::whitespace
+                ? 0
+                : ULIGHT_PROFILE_RULE(Lang::lua, lua::match_whitespace(remainder))) {
             index += white_length;
             continue;
         }
 
         // Line comments - Lua treats each line separately, no backslash continuation
-        if (const std::size_t line_comment_length = lua::match_line_comment(remainder)) {
+        if (const std::size_t line_comment_length = leading != lua::Leading_Byte::minus
+                ? 0
+                : ULIGHT_PROFILE_RULE(Lang::lua, lua::match_line_comment(remainder))) {
             emit(index, 2, Highlight_Type::comment_delim);
             emit(index + 2, line_comment_length - 2, Highlight_Type::comment);
             index += line_comment_length;
@@ -580,20 +542,14 @@ bool highlight_lua(
         }
 
         // Block comments.
-        if (const lua::Comment_Result block_comment = lua::match_block_comment(remainder)) {
-            // Prefix --[[ or --[=[.
-            std::size_t prefix_length = 4; // Default for --[[.
-            if (remainder[2] == u8'[' && remainder[3] != u8'[') {
-                prefix_length = 3;
-                while (prefix_length < remainder.length() && remainder[prefix_length] == u8'=') {
-                    prefix_length++;
-                }
-                prefix_length++; // Handles the [ after equals.
-            }
-
-            const std::size_t closing_delim_length = block_comment.is_terminated
-                ? (remainder[2] == u8'[' && remainder[3] != u8'[' ? 2 + (prefix_length - 4) : 2)
-                : 0;
+        if (const lua::Comment_Result block_comment = leading != lua::Leading_Byte::minus
+                ? lua::Comment_Result {}
+                : ULIGHT_PROFILE_RULE(Lang::lua, lua::match_block_comment(remainder))) {
+            // Prefix --[[ or --[=[, and the closing bracket of the same level.
+            const std::size_t prefix_length
+                = 2 + lua::match_opening_long_bracket(remainder.substr(2));
+            const std::size_t closing_delim_length
+                = block_comment.is_terminated ? prefix_length - 2 : 0;
 
             emit(index, prefix_length, Highlight_Type::comment_delim);
             emit(
@@ -613,25 +569,14 @@ bool highlight_lua(
         }
 
         // String literals.
-        if (const lua::String_Literal_Result string = lua::match_string_literal(remainder)) {
+        if (const lua::String_Literal_Result string
+            = leading != lua::Leading_Byte::quote && leading != lua::Leading_Byte::square
+                ? lua::String_Literal_Result {}
+                : ULIGHT_PROFILE_RULE(Lang::lua, lua::match_string_literal(remainder))) {
             if (string.is_long_string) {
                 // [[ ]] or [=[ ]=] multi-line strings, highlight the delimiters separately.
-                std::size_t opening_delim_len = 2;
-                std::size_t closing_delim_len = string.terminated ? 2 : 0;
-
-                // [=[ style with equals signs.
-                if (remainder[0] == u8'[' && remainder.length() >= 3 && remainder[1] == u8'=') {
-                    opening_delim_len = 1;
-                    while (opening_delim_len < remainder.length()
-                           && remainder[opening_delim_len] == u8'=') {
-                        opening_delim_len++;
-                    }
-                    opening_delim_len++; // Second [.
-
-                    if (string.terminated) {
-                        closing_delim_len = opening_delim_len;
-                    }
-                }
+                const std::size_t opening_delim_len = lua::match_opening_long_bracket(remainder);
+                const std::size_t closing_delim_len = string.terminated ? opening_delim_len : 0;
 
                 emit(index, opening_delim_len, Highlight_Type::string);
                 emit(
@@ -656,14 +601,19 @@ bool highlight_lua(
         }
 
         // Number literals.
-        if (const std::size_t number_length = lua::match_number(remainder)) {
+        if (const std::size_t number_length
+            = leading != lua::Leading_Byte::digit && leading != lua::Leading_Byte::dot
+                ? 0
+                : ULIGHT_PROFILE_RULE(Lang::lua, lua::match_number(remainder))) {
             emit(index, number_length, Highlight_Type::number);
             index += number_length;
             continue;
         }
 
         // Identifiers and keywords.
-        if (const std::size_t id_length = lua::match_identifier(remainder)) {
+        if (const std::size_t id_length = leading != lua::Leading_Byte::identifier
+                ? 0
+                : ULIGHT_PROFILE_RULE(Lang::lua, lua::match_identifier(remainder))) {
             const std::optional<lua::Lua_Token_Type> keyword
                 = lua::lua_token_type_by_code(remainder.substr(0, id_length));
 
@@ -677,7 +627,7 @@ bool highlight_lua(
 
         // Operation and punctuation.
         if (const std::optional<lua::Lua_Token_Type> op
-            = lua::match_operator_or_punctuation(remainder)) {
+            = ULIGHT_PROFILE_RULE(Lang::lua, lua::match_operator_or_punctuation(remainder))) {
 
             const std::size_t op_length = lua::lua_token_type_length(*op);
             const Highlight_Type op_highlight = lua::lua_token_type_highlight(*op);
@@ -1,6 +1,14 @@
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
 
 #include "ulight/impl/ascii_algorithm.hpp"
+#include "ulight/impl/assert.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
 #include "ulight/impl/numbers.hpp"
@@ -268,28 +276,197 @@ static_assert(std::ranges::is_sorted(registers));
 constexpr std::u8string_view label_instructions[] {
     u8"call",
 
-    u8"ja",   u8"jae",   u8"jb",     u8"jbe",    u8"jc",    u8"je",   u8"jg",  u8"jge",
-    u8"jl",   u8"jle",   u8"jmp",    u8"jna",    u8"jna",   u8"jnae", u8"jnb", u8"jnbe",
-    u8"jnc",  u8"jne",   u8"jng",    u8"jnge",   u8"jnl",   u8"jnle", u8"jno", u8"jnp",
-    u8"jnz",  u8"jo",    u8"jp",     u8"jpe",    u8"jpo",   u8"js",   u8"jz",
+    u8"ja",   u8"jae",   u8"jb",     u8"jbe",    u8"jc",   u8"je",   u8"jg",  u8"jge",
+    u8"jl",   u8"jle",   u8"jmp",    u8"jna",    u8"jnae", u8"jnb",  u8"jnbe",
+    u8"jnc",  u8"jne",   u8"jng",    u8"jnge",   u8"jnl",  u8"jnle", u8"jno", u8"jnp",
+    u8"jnz",  u8"jo",    u8"jp",     u8"jpe",    u8"jpo",  u8"js",   u8"jz",
 
     u8"loop", u8"loope", u8"loopne", u8"loopnz", u8"loopz",
 };
 
 static_assert(std::ranges::is_sorted(label_instructions));
 
+/// @brief The maximum length of any keyword.
+/// Keywords are packed into a single 64-bit word together with their length,
+/// so this cannot exceed seven.
+constexpr std::size_t max_keyword_length = [] {
+    std::size_t result = 0;
+    for (const auto table : { std::span<const std::u8string_view> { pseudo_instructions },
+                              std::span<const std::u8string_view> { types },
+                              std::span<const std::u8string_view> { operator_keywords },
+                              std::span<const std::u8string_view> { registers },
+                              std::span<const std::u8string_view> { label_instructions } }) {
+        for (const std::u8string_view keyword : table) {
+            result = std::max(result, keyword.length());
+        }
+    }
+    return result;
+}();
+
+static_assert(max_keyword_length < sizeof(std::uint64_t));
+
+/// @brief Packs up to seven code units into a word, with the first code unit in the least
+/// significant byte, and unused bytes being zero.
 [[nodiscard]]
-constexpr bool binary_search_case_insensitive(
-    std::span<const std::u8string_view> haystack,
-    std::u8string_view needle
-)
+constexpr std::uint64_t pack_word(std::u8string_view str) noexcept
+{
+    ULIGHT_DEBUG_ASSERT(str.length() < sizeof(std::uint64_t));
+    std::uint64_t result = 0;
+    if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+        std::memcpy(&result, str.data(), str.length());
+        return result;
+    }
+    for (std::size_t i = 0; i < str.length(); ++i) {
+        result |= std::uint64_t(str[i]) << (i * 8);
+    }
+    return result;
+}
+
+/// @brief Applies `to_ascii_lower` to all eight code units in `word` at once.
+[[nodiscard]]
+constexpr std::uint64_t to_ascii_lower_word(std::uint64_t word) noexcept
+{
+    constexpr std::uint64_t ones = 0x0101'0101'0101'0101;
+    constexpr std::uint64_t high_bits = ones * 0x80;
+    // Within each byte, only the low seven bits are added to,
+    // so that no carry can propagate into the next byte.
+    // The high bit of each byte in the sum then tells us whether the byte exceeds a threshold.
+    const std::uint64_t low_bits = word & ~high_bits;
+    const std::uint64_t at_least_a = low_bits + (ones * (0x80 - u8'A'));
+    const std::uint64_t above_z = low_bits + (ones * (0x7f - u8'Z'));
+    const std::uint64_t is_upper = (at_least_a ^ above_z) & ~word & high_bits;
+    // 0x80 >> 2 == 0x20, which is the bit that distinguishes upper and lower case letters.
+    return word | (is_upper >> 2);
+}
+
+/// @brief Returns the key of `str` within the `Keyword_Table`,
+/// which consists of the code units of `str` in lower case,
+/// and of the length of `str` in the most significant byte.
+/// The length distinguishes keywords from strings which have trailing null characters.
+/// `str` shall be no longer than `max_keyword_length`.
+[[nodiscard]]
+constexpr std::uint64_t make_key(std::u8string_view str) noexcept
 {
-    constexpr auto case_insensitive_less = [](std::u8string_view x, std::u8string_view y) {
-        return compare_ascii_to_lower(x, y) < 0;
+    return to_ascii_lower_word(pack_word(str)) | (std::uint64_t(str.length()) << 56);
+}
+
+/// @brief A perfect hash table which maps every keyword (in lower case) to its `Keyword_Type`.
+/// The table is built at compile time using "hash and displace":
+/// keywords are first hashed into buckets,
+/// and each bucket is assigned a seed for a second hash function
+/// such that all keywords in all buckets land in distinct slots.
+/// A lookup is thus two multiplications, a load of the seed, and a single probe.
+struct Keyword_Table {
+    static constexpr int bucket_bits = 7;
+    static constexpr int slot_bits = 9;
+    static constexpr std::size_t bucket_count = std::size_t(1) << bucket_bits;
+    static constexpr std::size_t slot_count = std::size_t(1) << slot_bits;
+
+    std::array<std::uint16_t, bucket_count> seeds {};
+    /// @brief The results of `make_key` for the keywords, or zero for empty slots.
+    std::array<std::uint64_t, slot_count> keys {};
+    std::array<Keyword_Type, slot_count> types {};
+
+    [[nodiscard]]
+    static constexpr std::size_t bucket_of(std::uint64_t key) noexcept
+    {
+        return std::size_t((key * 0x9e37'79b9'7f4a'7c15) >> (64 - bucket_bits));
+    }
+
+    [[nodiscard]]
+    static constexpr std::size_t slot_of(std::uint64_t key, std::uint16_t seed) noexcept
+    {
+        return std::size_t(((key + (seed * 0xbf58'476d'1ce4'e5b9)) * 0x94d0'49bb'1331'11eb)
+                           >> (64 - slot_bits));
+    }
+
+    /// @brief Returns the type of the keyword whose key is `key`,
+    /// or `Keyword_Type::none` if `key` is not a keyword.
+    [[nodiscard]]
+    constexpr Keyword_Type find(std::uint64_t key) const noexcept
+    {
+        const std::size_t slot = slot_of(key, seeds[bucket_of(key)]);
+        // Empty slots have a key of zero, which no key is equal to.
+        return keys[slot] == key ? types[slot] : Keyword_Type::none;
+    }
+};
+
+struct Keyword_Entry {
+    std::uint64_t key;
+    Keyword_Type type;
+};
+
+constexpr std::size_t keyword_count = std::size(pseudo_instructions) + std::size(types)
+    + std::size(operator_keywords) + std::size(registers) + std::size(label_instructions);
+
+/// @brief Builds the `Keyword_Table`.
+/// Fails to be a constant expression if no seed can be found for some bucket.
+/// This happens if a keyword is duplicated (since its copies always land in the same slot),
+/// or if the table is too full, in which case `Keyword_Table::slot_bits` needs to be raised.
+consteval Keyword_Table make_keyword_table()
+{
+    std::array<Keyword_Entry, keyword_count> entries {};
+    std::size_t entry_count = 0;
+    const auto add_all = [&](std::span<const std::u8string_view> keywords, Keyword_Type type) {
+        for (const std::u8string_view keyword : keywords) {
+            entries[entry_count++] = { .key = make_key(keyword), .type = type };
+        }
     };
-    return std::ranges::binary_search(haystack, needle, case_insensitive_less);
+    add_all(pseudo_instructions, Keyword_Type::pseudo_instruction);
+    add_all(types, Keyword_Type::type);
+    add_all(operator_keywords, Keyword_Type::operator_keyword);
+    add_all(registers, Keyword_Type::register_);
+    add_all(label_instructions, Keyword_Type::label_instruction);
+
+    std::array<std::size_t, Keyword_Table::bucket_count> bucket_sizes {};
+    for (const Keyword_Entry& entry : entries) {
+        ++bucket_sizes[Keyword_Table::bucket_of(entry.key)];
+    }
+    const std::size_t max_bucket_size = std::ranges::max(bucket_sizes);
+
+    Keyword_Table result;
+    std::array<bool, Keyword_Table::slot_count> occupied {};
+    // Large buckets are the hardest to place, so they are placed first, while the table is empty.
+    for (std::size_t size = max_bucket_size; size != 0; --size) {
+        for (std::size_t bucket = 0; bucket < Keyword_Table::bucket_count; ++bucket) {
+            if (bucket_sizes[bucket] != size) {
+                continue;
+            }
+            std::array<std::size_t, Keyword_Table::slot_count> slots {};
+            std::array<const Keyword_Entry*, Keyword_Table::slot_count> members {};
+            std::size_t member_count = 0;
+            for (const Keyword_Entry& entry : entries) {
+                if (Keyword_Table::bucket_of(entry.key) == bucket) {
+                    members[member_count++] = &entry;
+                }
+            }
+            for (std::uint32_t seed = 0;; ++seed) {
+                ULIGHT_ASSERT(seed <= std::uint16_t(-1));
+                bool success = true;
+                for (std::size_t i = 0; success && i < member_count; ++i) {
+                    slots[i] = Keyword_Table::slot_of(members[i]->key, std::uint16_t(seed));
+                    success = !occupied[slots[i]]
+                        && std::find(slots.begin(), slots.begin() + i, slots[i])
+                            == slots.begin() + i;
+                }
+                if (!success) {
+                    continue;
+                }
+                for (std::size_t i = 0; i < member_count; ++i) {
+                    occupied[slots[i]] = true;
+                    result.keys[slots[i]] = members[i]->key;
+                    result.types[slots[i]] = members[i]->type;
+                }
+                result.seeds[bucket] = std::uint16_t(seed);
+                break;
+            }
+        }
+    }
+    return result;
 }
 
+constexpr Keyword_Table keyword_table = make_keyword_table();
+
 [[nodiscard]]
 constexpr Base_Suffix determine_suffix(std::u8string_view str)
 {
@@ -305,34 +482,43 @@ constexpr Base_Suffix determine_suffix(std::u8string_view str)
 
 } // namespace
 
+[[nodiscard]]
+Keyword_Type classify_keyword(std::u8string_view name) noexcept
+{
+    if (name.empty() || name.length() > max_keyword_length) {
+        return Keyword_Type::none;
+    }
+    return keyword_table.find(make_key(name));
+}
+
 [[nodiscard]]
 bool is_pseudo_instruction(std::u8string_view name) noexcept
 {
-    return binary_search_case_insensitive(pseudo_instructions, name);
+    return classify_keyword(name) == Keyword_Type::pseudo_instruction;
 }
 
 [[nodiscard]]
 bool is_type(std::u8string_view name) noexcept
 {
-    return binary_search_case_insensitive(types, name);
+    return classify_keyword(name) == Keyword_Type::type;
 }
 
 [[nodiscard]]
 bool is_operator_keyword(std::u8string_view name) noexcept
 {
-    return binary_search_case_insensitive(operator_keywords, name);
+    return classify_keyword(name) == Keyword_Type::operator_keyword;
 }
 
 [[nodiscard]]
 bool is_register(std::u8string_view name) noexcept
 {
-    return binary_search_case_insensitive(registers, name);
+    return classify_keyword(name) == Keyword_Type::register_;
 }
 
 [[nodiscard]]
 bool is_label_instruction(std::u8string_view name) noexcept
 {
-    return binary_search_case_insensitive(label_instructions, name);
+    return classify_keyword(name) == Keyword_Type::label_instruction;
 }
 
 namespace {
@@ -473,8 +659,8 @@ private:
         const std::size_t length = match_identifier(remainder);
         ULIGHT_ASSUME(length > 0);
         const std::u8string_view identifier = remainder.substr(0, length);
-        if (equals_ascii_ignore_case(identifier, u8"seg")
-            || equals_ascii_ignore_case(identifier, u8"wrt")) {
+        const Keyword_Type keyword = classify_keyword(identifier);
+        if (keyword == Keyword_Type::operator_keyword) {
             emit_and_advance(length, Highlight_Type::keyword_op);
             return;
         }
@@ -488,26 +674,24 @@ private:
             id_highlight = Highlight_Type::asm_instruction;
             return;
         }
-        if (is_type(identifier)) {
+        switch (keyword) {
+        case Keyword_Type::type: {
             emit_and_advance(length, Highlight_Type::keyword_type);
             id_highlight = Highlight_Type::id_var;
             return;
         }
-        if (is_operator_keyword(identifier)) {
-            emit_and_advance(length, Highlight_Type::keyword_op);
-            id_highlight = Highlight_Type::id_var;
-            return;
-        }
-        if (is_register(identifier)) {
+        case Keyword_Type::register_: {
             emit_and_advance(length, Highlight_Type::id_var);
             id_highlight = Highlight_Type::id_var;
             return;
         }
-        if (is_label_instruction(identifier)) {
+        case Keyword_Type::label_instruction: {
             emit_and_advance(length, Highlight_Type::asm_instruction);
             id_highlight = Highlight_Type::id_label;
             return;
         }
+        default: break;
+        }
         if (identifier.starts_with(u8'$')) {
             emit_and_advance(length, Highlight_Type::id);
             id_highlight = Highlight_Type::id_var;
@@ -567,14 +751,17 @@ private:
             // The only thing we can really do in this case is detect special cases that shouldn't
             // be parsed as numbers.
             const std::u8string_view number = remainder.substr(0, suffixed.digits + 1);
-            if (is_pseudo_instruction(number)) {
+            switch (classify_keyword(number)) {
+            case Keyword_Type::pseudo_instruction: {
                 emit_and_advance(number.length(), Highlight_Type::asm_instruction_pseudo);
                 return true;
             }
-            if (is_register(number)) {
+            case Keyword_Type::register_: {
                 emit_and_advance(number.length(), Highlight_Type::id_var);
                 return true;
             }
+            default: break;
+            }
         }
         if (suffixed.erroneous) {
             emit_and_advance(suffixed.digits + suffixed.suffix, Highlight_Type::error);
@@ -6,12 +6,16 @@
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
 #include "ulight/impl/highlighter.hpp"
+#include "ulight/impl/string_search.hpp"
 #include "ulight/impl/strings.hpp"
 #include "ulight/impl/unicode.hpp"
 
 #include "ulight/ulight.hpp"
 
+#include <algorithm>
 #include <cctype>
+#include <cstddef>
+#include <span>
 
 namespace ulight {
 
@@ -24,6 +28,61 @@ constexpr std::u8string_view comment_suffix = u8"-->";
 constexpr std::u8string_view illegal_comment_sequence = u8"--";
 constexpr std::u8string_view cdata_section_prefix = u8"<![CDATA[";
 constexpr std::u8string_view cdata_section_suffix = u8"]]>";
+constexpr std::u8string_view doctype_prefix = u8"<!DOCTYPE";
+constexpr std::u8string_view processing_instruction_prefix = u8"<?";
+constexpr std::u8string_view processing_instruction_suffix = u8"?>";
+
+/// @brief The characters which are significant when searching for the end of a DOCTYPE.
+constexpr Charset256 doctype_special_set = detail::to_charset256(u8"\"'[]<>");
+
+/// @brief Matches a parameter-entity reference like `%name;` at the start of `str`,
+/// and returns its length, or zero if there is none.
+[[nodiscard]]
+std::size_t match_parameter_entity_reference(std::u8string_view str)
+{
+    if (!str.starts_with(u8'%')) {
+        return 0;
+    }
+    const std::size_t name_length = match_name(str.substr(1));
+    if (name_length == 0 || !str.substr(1 + name_length).starts_with(u8';')) {
+        return 0;
+    }
+    return name_length + 2;
+}
+
+enum struct Declaration_Kind : Underlying {
+    doctype,
+    element,
+    attlist,
+    entity,
+    notation,
+};
+
+struct Markup_Declaration {
+    std::u8string_view prefix;
+    Declaration_Kind kind;
+};
+
+constexpr Markup_Declaration markup_declarations[] {
+    { u8"<!ELEMENT", Declaration_Kind::element },
+    { u8"<!ATTLIST", Declaration_Kind::attlist },
+    { u8"<!ENTITY", Declaration_Kind::entity },
+    { u8"<!NOTATION", Declaration_Kind::notation },
+};
+
+/// @brief The keywords within markup declarations.
+/// Keywords starting with `#` are only recognized including the `#`.
+constexpr std::u8string_view declaration_keywords[] {
+    u8"#FIXED",  u8"#IMPLIED", u8"#PCDATA", u8"#REQUIRED", u8"ANY",      u8"CDATA",
+    u8"EMPTY",   u8"ENTITIES", u8"ENTITY",  u8"ID",        u8"IDREF",    u8"IDREFS",
+    u8"NDATA",   u8"NMTOKEN",  u8"NMTOKENS", u8"NOTATION", u8"PUBLIC",   u8"SYSTEM",
+};
+
+[[nodiscard]]
+bool is_declaration_keyword(std::u8string_view name)
+{
+    return std::ranges::find(declaration_keywords, name) != std::ranges::end(declaration_keywords);
+}
 
 } // namespace
 
@@ -33,12 +92,105 @@ std::size_t match_whitespace(std::u8string_view str)
     return ascii::length_if(str, [](char8_t c) { return is_xml_whitespace(c); });
 }
 
+std::size_t match_nmtoken(std::u8string_view str)
+{
+    std::size_t length = 0;
+    while (length < str.length()) {
+        // Almost all name characters are ASCII, so we only decode UTF-8 when necessary.
+        length = ascii::length_if(str, [](char8_t c) { return is_xml_ascii_name(c); }, length);
+        if (length == str.length() || is_ascii(str[length])) {
+            break;
+        }
+        const auto [code_point, units]
+            = utf8::decode_and_length_or_replacement(str.substr(length));
+        if (!is_xml_name(code_point)) {
+            break;
+        }
+        length += std::size_t(units);
+    }
+    return length;
+}
+
+std::size_t match_name(std::u8string_view str)
+{
+    if (str.empty()) {
+        return 0;
+    }
+    const bool valid_start = is_ascii(str.front())
+        ? is_xml_ascii_name_start(str.front())
+        : is_xml_name_start(utf8::decode_and_length_or_replacement(str).code_point);
+    return valid_start ? match_nmtoken(str) : 0;
+}
+
+Qualified_Name split_qualified_name(std::u8string_view name)
+{
+    // https://www.w3.org/TR/xml-names/#ns-qualnames
+    const std::size_t colon = name.find(u8':');
+    if (colon == 0 || colon == std::u8string_view::npos || colon + 1 == name.length()) {
+        return { .prefix = {}, .local_name = name };
+    }
+    return { .prefix = name.substr(0, colon), .local_name = name.substr(colon + 1) };
+}
+
+html::Match_Result match_doctype(std::u8string_view str)
+{
+    // https://www.w3.org/TR/REC-xml/#NT-doctypedecl
+    if (!str.starts_with(doctype_prefix)) {
+        return {};
+    }
+    // Literals, comments, and processing instructions can contain the characters which
+    // delimit the internal subset and the declaration, so they are skipped as a whole.
+    bool in_internal_subset = false;
+    std::size_t pos = doctype_prefix.length();
+    while (true) {
+        pos = ascii::find_if(str, [](char8_t c) { return doctype_special_set.contains(c); }, pos);
+        if (pos == std::u8string_view::npos) {
+            return { .length = str.length(), .terminated = false };
+        }
+        const std::u8string_view rest = str.substr(pos);
+        std::size_t skipped_prefix_length = 1;
+        std::u8string_view skipped_suffix;
+        if (rest.starts_with(u8'"')) {
+            skipped_suffix = u8"\"";
+        }
+        else if (rest.starts_with(u8'\'')) {
+            skipped_suffix = u8"'";
+        }
+        else if (in_internal_subset && rest.starts_with(comment_prefix)) {
+            skipped_prefix_length = comment_prefix.length();
+            skipped_suffix = comment_suffix;
+        }
+        else if (in_internal_subset && rest.starts_with(processing_instruction_prefix)) {
+            skipped_prefix_length = processing_instruction_prefix.length();
+            skipped_suffix = processing_instruction_suffix;
+        }
+
+        if (!skipped_suffix.empty()) {
+            const std::size_t end
+                = find_substring(str, skipped_suffix, pos + skipped_prefix_length);
+            if (end == std::u8string_view::npos) {
+                return { .length = str.length(), .terminated = false };
+            }
+            pos = end + skipped_suffix.length();
+            continue;
+        }
+        if (rest.front() == u8'>' && !in_internal_subset) {
+            return { .length = pos + 1, .terminated = true };
+        }
+        if (rest.front() == u8'[') {
+            in_internal_subset = true;
+        }
+        else if (rest.front() == u8']') {
+            in_internal_subset = false;
+        }
+        ++pos;
+    }
+}
+
 [[nodiscard]]
 std::size_t match_text(std::u8string_view str)
 {
-    const std::size_t result
-        = ascii::length_if_not(str, [](char8_t c) { return c == u8'<' || c == u8'&'; });
-
+    const std::size_t result = find_either(str, u8'<', u8'&');
     return result == std::u8string_view::npos ? str.length() : result;
 }
 
@@ -50,59 +202,322 @@ html::Match_Result match_comment(std::u8string_view str)
     }
     str.remove_prefix(comment_prefix.length());
 
-    std::size_t length = comment_prefix.length();
-    while (!str.empty()) {
+    // Both the comment suffix and illegal sequences start with "--",
+    // so we can skip right to the first occurrence.
+    const std::size_t dashes = find_substring(str, illegal_comment_sequence);
+    if (dashes == std::u8string_view::npos) {
+        return { comment_prefix.length() + str.length(), false };
+    }
+    const std::size_t length = comment_prefix.length() + dashes;
+    if (str.substr(dashes).starts_with(comment_suffix)) {
+        return { length + comment_suffix.length(), true };
+    }
+    return { length, false };
+}
 
-        if (str.starts_with(comment_suffix)) {
-            return { length + comment_suffix.length(), true };
-        }
+constexpr auto is_tag_name_end = [](std::u8string_view str) {
+    return match_whitespace(str) || str.starts_with(u8"/>") || str.starts_with(u8'>');
+};
 
-        if (str.starts_with(illegal_comment_sequence)) {
-            return { length, false };
-        }
+constexpr auto is_end_tag_name_end = [](std::u8string_view str) {
+    return match_whitespace(str) || str.starts_with(u8'>');
+};
 
-        length++;
-        str.remove_prefix(1);
-    }
+constexpr auto is_attribute_name_end = [](std::u8string_view str) {
+    return match_whitespace(str) //
+        || str.starts_with(u8"/>") //
+        || str.starts_with(u8'>') //
+        || str.starts_with(u8'=');
+};
 
-    return { length, false };
-}
+enum struct Name_Kind : bool {
+    /// @brief A name, which is highlighted as a whole.
+    name,
+    /// @brief A name which may be qualified with a namespace prefix.
+    qualified,
+};
 
 struct XML_Highlighter : Highlighter_Base {
+private:
+    html::Stream_State& state;
+    const bool final;
+    bool suspended = false;
 
+public:
     XML_Highlighter(
         Non_Owning_Buffer<Token>& out,
         std::u8string_view source,
-        const Highlight_Options& options
+        const Highlight_Options& options,
+        html::Stream_State& state,
+        bool final
     )
         : Highlighter_Base(out, source, options)
+        , state { state }
+        , final { final }
     {
     }
 
+    /// @brief Highlights the source, or the source up to the point
+    /// where the highlighter has to wait for the next window.
+    /// @returns The amount of code units consumed.
     // TODO: add prolog (declaration)
-    bool operator()()
+    std::size_t operator()()
+    {
+        while (!remainder.empty() && !suspended) {
+            switch (state.context) {
+            case html::Stream_Context::text: expect_markup(); break;
+            case html::Stream_Context::tag: expect_tag_contents(); break;
+            case html::Stream_Context::attribute_value: expect_attribute_value_contents(); break;
+            case html::Stream_Context::comment: expect_comment_contents(); break;
+            case html::Stream_Context::cdata: expect_cdata_section_contents(); break;
+            case html::Stream_Context::raw_text:
+                ULIGHT_ASSERT_UNREACHABLE(u8"XML has no raw text elements.");
+            }
+        }
+        return index;
+    }
+
+private:
+    /// @brief Stops highlighting until the next window,
+    /// which shall begin with the current `remainder`.
+    bool suspend()
+    {
+        ULIGHT_DEBUG_ASSERT(!final);
+        suspended = true;
+        return true;
+    }
+
+    void expect_markup()
+    {
+        // All markup that starts with "<" is either short enough to fit into the lookahead,
+        // or it is checked for completeness by the functions below.
+        if (!final && remainder.starts_with(u8'<') && remainder.length() < html::stream_lookahead) {
+            suspend();
+            return;
+        }
+        if (expect_comment() || //
+            expect_cdata_section() || //
+            expect_doctype() || //
+            expect_processing_instruction() || //
+            expect_end_tag() || //
+            expect_start_tag() || //
+            expect_text()) {
+            return;
+        }
+        ULIGHT_ASSERT_UNREACHABLE(u8"Unmatched XML.");
+    }
+
+    bool expect_doctype()
+    {
+        if (!remainder.starts_with(doctype_prefix)) {
+            return false;
+        }
+        const html::Match_Result doctype = match_doctype(remainder);
+        if (!doctype.terminated && !final) {
+            return suspend();
+        }
+        // The DOCTYPE is highlighted by a separate highlighter which only sees the DOCTYPE,
+        // so that malformed declarations within cannot extend past it.
+        Token nested_tokens[256];
+        Non_Owning_Buffer<Token> sub = sub_buffer(nested_tokens);
+        html::Stream_State doctype_state;
+        const std::u8string_view doctype_source = remainder.substr(0, doctype.length);
+        XML_Highlighter { sub, doctype_source, options, doctype_state, true }.highlight_doctype();
+        sub.flush();
+        advance(doctype.length);
+        return true;
+    }
+
+    void highlight_doctype()
+    {
+        emit_and_advance(doctype_prefix.length(), Highlight_Type::macro);
+        while (!remainder.empty()) {
+            expect_declaration_contents(Declaration_Kind::doctype);
+        }
+    }
+
+    void expect_internal_subset()
     {
+        // https://www.w3.org/TR/REC-xml/#NT-intSubset
         while (!remainder.empty()) {
-            if (expect_comment() || //
-                expect_cdata_section() || //
+            advance(match_whitespace(remainder));
+            if (remainder.starts_with(u8']')) {
+                emit_and_advance(1, Highlight_Type::sym_square);
+                return;
+            }
+            if (remainder.empty() || //
+                expect_comment() || //
                 expect_processing_instruction() || //
-                expect_end_tag() || //
-                expect_start_tag() || //
-                expect_text()) {
+                expect_markup_declaration()) {
+                continue;
+            }
+            if (const std::size_t ref_length = match_parameter_entity_reference(remainder)) {
+                emit_and_advance(ref_length, Highlight_Type::escape);
                 continue;
             }
+            emit_and_advance(1, Highlight_Type::error);
+        }
+    }
 
-            ULIGHT_ASSERT_UNREACHABLE(u8"Unmatched XML.");
+    bool expect_markup_declaration()
+    {
+        for (const auto& [prefix, kind] : markup_declarations) {
+            if (remainder.starts_with(prefix)) {
+                emit_and_advance(prefix.length(), Highlight_Type::macro);
+                expect_declaration_contents(kind);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief Highlights the contents of a DOCTYPE or markup declaration up to and including
+    /// its closing `>`.
+    /// Rather than validating the grammar of each kind of declaration,
+    /// names, keywords, literals, and punctuation are highlighted wherever they appear.
+    void expect_declaration_contents(Declaration_Kind kind)
+    {
+        bool has_name = false;
+        std::size_t paren_depth = 0;
+        while (!remainder.empty()) {
+            advance(match_whitespace(remainder));
+            if (remainder.empty()) {
+                return;
+            }
+            const char8_t c = remainder.front();
+            if (c == u8'>') {
+                emit_and_advance(1, Highlight_Type::sym_punc);
+                return;
+            }
+            if (c == u8'[' && kind == Declaration_Kind::doctype) {
+                emit_and_advance(1, Highlight_Type::sym_square);
+                expect_internal_subset();
+                continue;
+            }
+            if (c == u8'"' || c == u8'\'') {
+                expect_declaration_literal();
+                continue;
+            }
+            if (c == u8'(' || c == u8')') {
+                paren_depth = c == u8'(' ? paren_depth + 1 : paren_depth - (paren_depth != 0);
+                emit_and_advance(1, Highlight_Type::sym_parens);
+                continue;
+            }
+            if (c == u8'|' || c == u8',') {
+                emit_and_advance(1, Highlight_Type::sym_punc);
+                continue;
+            }
+            if (c == u8'?' || c == u8'*' || c == u8'+') {
+                emit_and_advance(1, Highlight_Type::sym_op);
+                continue;
+            }
+            if (c == u8'%') {
+                // Either a reference like "%name;" or the "%" in "<!ENTITY % name ...>".
+                const std::size_t ref_length = match_parameter_entity_reference(remainder);
+                emit_and_advance(
+                    ref_length != 0 ? ref_length : 1,
+                    ref_length != 0 ? Highlight_Type::escape : Highlight_Type::sym_punc
+                );
+                continue;
+            }
+            if (c == u8'#') {
+                const std::size_t keyword_length = 1 + match_nmtoken(remainder.substr(1));
+                const bool is_keyword = is_declaration_keyword(remainder.substr(0, keyword_length));
+                emit_and_advance(
+                    is_keyword ? keyword_length : 1,
+                    is_keyword ? Highlight_Type::keyword : Highlight_Type::error
+                );
+                continue;
+            }
+            if (const std::size_t name_length = match_nmtoken(remainder)) {
+                expect_declaration_name(kind, name_length, has_name, paren_depth);
+                continue;
+            }
+            emit_and_advance(1, Highlight_Type::error);
+        }
+    }
+
+    void expect_declaration_name(
+        Declaration_Kind kind,
+        std::size_t length,
+        bool& has_name,
+        std::size_t paren_depth
+    )
+    {
+        if (is_declaration_keyword(remainder.substr(0, length))) {
+            emit_and_advance(length, Highlight_Type::keyword);
+            return;
+        }
+        // The first name is the declared name, like the root element in a DOCTYPE.
+        if (!has_name) {
+            has_name = true;
+            if (kind == Declaration_Kind::entity || kind == Declaration_Kind::notation) {
+                emit_and_advance(length, Highlight_Type::id_decl);
+            }
+            else {
+                emit_qualified_name(length, Highlight_Type::markup_tag);
+            }
+            return;
+        }
+        if (kind == Declaration_Kind::element) {
+            // Names within content models like (head, body) are element names.
+            emit_qualified_name(length, Highlight_Type::markup_tag);
+            return;
+        }
+        if (kind == Declaration_Kind::attlist && paren_depth == 0) {
+            emit_qualified_name(length, Highlight_Type::markup_attr);
+            return;
+        }
+        // Enumerated attribute values, notation names, etc.
+        emit_and_advance(length, Highlight_Type::id);
+    }
+
+    void expect_declaration_literal()
+    {
+        const char8_t quote = remainder.front();
+        emit_and_advance(1, Highlight_Type::string_delim);
+
+        const std::size_t closing_pos = remainder.find(quote);
+        const std::size_t length
+            = closing_pos == std::u8string_view::npos ? remainder.length() : closing_pos;
+
+        std::size_t piece_begin = 0;
+        std::size_t pos = 0;
+        const auto flush_piece = [&] {
+            if (pos != piece_begin) {
+                emit(index + piece_begin, pos - piece_begin, Highlight_Type::string);
+            }
+        };
+        while (pos < length) {
+            const std::u8string_view rest = remainder.substr(pos, length - pos);
+            const std::size_t ref_length = rest.starts_with(u8'&')
+                ? html::match_character_reference(rest)
+                : match_parameter_entity_reference(rest);
+            if (ref_length == 0) {
+                ++pos;
+                continue;
+            }
+            flush_piece();
+            emit(index + pos, ref_length, Highlight_Type::escape);
+            pos += ref_length;
+            piece_begin = pos;
+        }
+        flush_piece();
+        advance(length);
+
+        if (closing_pos != std::u8string_view::npos) {
+            emit_and_advance(1, Highlight_Type::string_delim);
         }
-        return true;
     }
 
-private:
     bool expect_processing_instruction()
     {
         if (!remainder.starts_with(u8"<?")) {
             return false;
         }
+        if (!final && find_substring(remainder, u8"?>", 2) == std::u8string_view::npos) {
+            return suspend();
+        }
         emit_and_advance(2, Highlight_Type::sym_punc);
 
         constexpr auto is_processing_name_end = [](std::u8string_view str) {
@@ -122,13 +537,12 @@ private:
 
         advance(match_whitespace(remainder));
 
-        while (!remainder.empty() && !remainder.starts_with(u8"?>")) {
-            advance(1);
-        }
-
-        if (!remainder.starts_with(u8"?>")) {
+        const std::size_t content_length = find_substring(remainder, u8"?>");
+        if (content_length == std::u8string_view::npos) {
+            advance(remainder.length());
             return true;
         }
+        advance(content_length);
 
         emit_and_advance(2, Highlight_Type::sym_punc);
 
@@ -138,6 +552,17 @@ private:
     bool expect_cdata_section()
     {
         if (const auto cdata_section = html::match_cdata(remainder)) {
+            if (!cdata_section.terminated && !final) {
+                const std::size_t split = html::window_split_position(remainder);
+                if (split < cdata_section_prefix.length()) {
+                    return suspend();
+                }
+                emit_and_advance(cdata_section_prefix.length(), Highlight_Type::macro);
+                advance(split - cdata_section_prefix.length());
+                state.context = html::Stream_Context::cdata;
+                return true;
+            }
+
             std::size_t pure_cdata_len = cdata_section.length - cdata_section_prefix.length();
 
             if (cdata_section.terminated) {
@@ -158,6 +583,24 @@ private:
         return false;
     }
 
+    void expect_cdata_section_contents()
+    {
+        const std::size_t suffix_pos = find_substring(remainder, cdata_section_suffix);
+        if (suffix_pos != std::u8string_view::npos) {
+            advance(suffix_pos);
+            emit_and_advance(cdata_section_suffix.length(), Highlight_Type::macro);
+            state.context = html::Stream_Context::text;
+            return;
+        }
+        const std::size_t length
+            = final ? remainder.length() : html::window_split_position(remainder);
+        if (length == 0) {
+            suspend();
+            return;
+        }
+        advance(length);
+    }
+
     bool expect_reference()
     {
         if (std::size_t ref_length = html::match_character_reference(remainder)) {
@@ -172,50 +615,69 @@ private:
         if (!remainder.starts_with(u8'<')) {
             return false;
         }
+        if (!final && match_name_end(1, is_tag_name_end) == remainder.length()) {
+            return suspend();
+        }
 
         emit_and_advance(1, Highlight_Type::sym_punc);
 
-        constexpr auto is_tag_name_end = [](std::u8string_view str) {
-            return match_whitespace(str) || str.starts_with(u8"/>") || str.starts_with(u8'>');
-        };
-        const std::size_t name_length = expect_name(Highlight_Type::markup_tag, is_tag_name_end);
+        const std::size_t name_length
+            = expect_name(Highlight_Type::markup_tag, is_tag_name_end, Name_Kind::qualified);
 
-        if (!name_length) {
-            return true;
+        if (name_length) {
+            state.context = html::Stream_Context::tag;
         }
+        return true;
+    }
 
-        while (!remainder.empty()) {
-
-            advance(match_whitespace(remainder));
-
-            if (remainder.starts_with(u8'>') || remainder.starts_with(u8"/>")) {
-                break;
-            }
+    void expect_tag_contents()
+    {
+        advance(match_whitespace(remainder));
 
-            if (!expect_attribute()) {
-                break;
-            }
+        if (remainder.empty() || expect_tag_end()) {
+            return;
+        }
+        if (!final && remainder == u8"/") {
+            suspend();
+            return;
+        }
+        if (!expect_attribute()) {
+            expect_tag_end();
+            state.context = html::Stream_Context::text;
         }
+    }
 
+    bool expect_tag_end()
+    {
         if (remainder.starts_with(u8'>')) {
             emit_and_advance(1, Highlight_Type::sym_punc);
         }
         else if (remainder.starts_with(u8"/>")) {
             emit_and_advance(2, Highlight_Type::sym_punc);
         }
-
+        else {
+            return false;
+        }
+        state.context = html::Stream_Context::text;
         return true;
     }
 
     bool expect_attribute()
     {
-        constexpr auto is_attribute_name_end = [](std::u8string_view str) {
-            return match_whitespace(str) //
-                || str.starts_with(u8"/>") //
-                || str.starts_with(u8'>') //
-                || str.starts_with(u8'=');
-        };
-        expect_name(Highlight_Type::markup_attr, is_attribute_name_end);
+        if (!final) {
+            // The attribute up to the opening quote of its value cannot be split.
+            std::size_t length = match_name_end(0, is_attribute_name_end);
+            length += match_whitespace(remainder.substr(length));
+            if (length < remainder.length() && remainder[length] == u8'=') {
+                ++length;
+                length += match_whitespace(remainder.substr(length));
+            }
+            if (length == remainder.length()) {
+                return suspend();
+            }
+        }
+
+        expect_name(Highlight_Type::markup_attr, is_attribute_name_end, Name_Kind::qualified);
 
         advance(match_whitespace(remainder));
 
@@ -244,41 +706,62 @@ private:
         }
 
         emit_and_advance(1, Highlight_Type::string_delim);
+        state.context = html::Stream_Context::attribute_value;
+        state.quote = quote_type;
+        expect_attribute_value_contents();
+        return true;
+    }
 
-        std::size_t piece_length = 0;
+    void expect_attribute_value_contents()
+    {
+        const std::size_t closing_pos = remainder.find(state.quote);
+        std::size_t length = closing_pos == std::u8string_view::npos ? remainder.length() //
+                                                                     : closing_pos;
+        if (closing_pos == std::u8string_view::npos && !final) {
+            length = html::window_split_position(remainder);
+            if (length == 0) {
+                suspend();
+                return;
+            }
+        }
 
-        auto highlight_piece = [&]() {
-            if (piece_length && piece_length <= remainder.length()) {
-                emit_and_advance(piece_length, Highlight_Type::string);
+        // The length can be exceeded by a character reference which crosses the window split.
+        std::size_t piece_begin = 0;
+        std::size_t pos = 0;
+        const auto flush_piece = [&] {
+            if (pos != piece_begin) {
+                emit(index + piece_begin, pos - piece_begin, Highlight_Type::string);
             }
         };
-
-        while (!remainder.empty() && piece_length < remainder.length()
-               && remainder[piece_length] != quote_type) {
-            if ((remainder[piece_length] == u8'&' && !html::match_character_reference(remainder))
-                || remainder[piece_length] == u8'<') {
-                highlight_piece();
-                emit_and_advance(1, Highlight_Type::error);
-                piece_length = 0;
+        while (pos < length) {
+            const char8_t c = remainder[pos];
+            if (c != u8'&' && c != u8'<') {
+                ++pos;
+                continue;
             }
-            else if (remainder[piece_length] == u8'&'
-                     && html::match_character_reference(remainder)) {
-                highlight_piece();
-                expect_reference();
-                piece_length = 0;
+            flush_piece();
+            const std::size_t ref_length
+                = c == u8'&' ? html::match_character_reference(remainder.substr(pos)) : 0;
+            if (ref_length != 0) {
+                emit(index + pos, ref_length, Highlight_Type::escape);
+                pos += ref_length;
             }
             else {
-                piece_length++;
+                emit(index + pos, 1, Highlight_Type::error);
+                ++pos;
             }
+            piece_begin = pos;
         }
+        flush_piece();
+        advance(pos);
 
-        highlight_piece();
-
-        if (!remainder.empty() && remainder.starts_with(quote_type)) {
+        if (closing_pos != std::u8string_view::npos) {
             emit_and_advance(1, Highlight_Type::string_delim);
+            state.context = html::Stream_Context::tag;
+        }
+        else if (!final) {
+            suspend();
         }
-
-        return true;
     }
 
     bool expect_comment()
@@ -288,6 +771,23 @@ private:
             return false;
         }
 
+        // If the comment ends with the window, or with "--" at the end of the window,
+        // it may continue in the next window.
+        if (!final && !comment.terminated
+            && remainder.length() - comment.length < comment_suffix.length()) {
+            const std::size_t split
+                = std::min(html::window_split_position(remainder), comment.length);
+            if (split < comment_prefix.length()) {
+                return suspend();
+            }
+            emit_and_advance(comment_prefix.length(), Highlight_Type::comment_delim);
+            if (split != comment_prefix.length()) {
+                emit_and_advance(split - comment_prefix.length(), Highlight_Type::comment);
+            }
+            state.context = html::Stream_Context::comment;
+            return true;
+        }
+
         std::size_t pure_comment_length = comment.length - comment_prefix.length();
 
         if (comment.terminated) {
@@ -310,18 +810,48 @@ private:
         return true;
     }
 
+    void expect_comment_contents()
+    {
+        const std::size_t dashes = find_substring(remainder, illegal_comment_sequence);
+        if (dashes == std::u8string_view::npos) {
+            const std::size_t length
+                = final ? remainder.length() : html::window_split_position(remainder);
+            if (length == 0) {
+                suspend();
+                return;
+            }
+            emit_and_advance(length, Highlight_Type::comment);
+            return;
+        }
+        if (dashes != 0) {
+            emit_and_advance(dashes, Highlight_Type::comment);
+        }
+        if (!final && remainder.length() < comment_suffix.length()) {
+            suspend();
+            return;
+        }
+        if (remainder.starts_with(comment_suffix)) {
+            emit_and_advance(comment_suffix.length(), Highlight_Type::comment_delim);
+        }
+        state.context = html::Stream_Context::text;
+    }
+
     bool expect_end_tag()
     {
         if (!remainder.starts_with(u8"</")) {
             return false;
         }
+        if (!final) {
+            const std::size_t name_end = match_name_end(2, is_end_tag_name_end);
+            if (name_end + match_whitespace(remainder.substr(name_end)) == remainder.length()) {
+                return suspend();
+            }
+        }
 
         emit_and_advance(2, Highlight_Type::sym_punc);
 
-        constexpr auto is_tag_name_end = [](std::u8string_view str) {
-            return match_whitespace(str) || str.starts_with(u8'>');
-        };
-        const std::size_t name_length = expect_name(Highlight_Type::markup_tag, is_tag_name_end);
+        const std::size_t name_length
+            = expect_name(Highlight_Type::markup_tag, is_end_tag_name_end, Name_Kind::qualified);
 
         if (!name_length) {
             return true;
@@ -344,6 +874,10 @@ private:
         }
 
         if (remainder.starts_with(u8'&') && !expect_reference()) {
+            // The reference may be completed in the next window.
+            if (!final && remainder.length() < html::stream_lookahead) {
+                return suspend();
+            }
             emit_and_advance(1, Highlight_Type::error);
             return true;
         }
@@ -356,10 +890,48 @@ private:
         return true;
     }
 
+    /// @brief Returns the position of the first name end at or after `start`,
+    /// or the length of `remainder` if there is none.
     template <typename Stop>
         requires std::is_invocable_r_v<bool, Stop, std::u8string_view>
-    std::size_t expect_name(Highlight_Type type, Stop is_stop)
+    [[nodiscard]]
+    std::size_t match_name_end(std::size_t start, Stop is_stop) const
     {
+        // All stops start with a character that cannot appear in names.
+        std::size_t length = start;
+        while (true) {
+            length = ascii::length_if(
+                remainder, [](char8_t c) { return is_xml_ascii_name(c); }, length
+            );
+            if (length == remainder.length() || is_stop(remainder.substr(length))) {
+                return length;
+            }
+            ++length;
+        }
+    }
+
+    /// @brief Highlights a name up to the first position that satisfies `is_stop`,
+    /// where characters that cannot appear in the name are highlighted as errors.
+    /// @returns The length of the name, including any erroneous characters.
+    template <typename Stop>
+        requires std::is_invocable_r_v<bool, Stop, std::u8string_view>
+    std::size_t expect_name(Highlight_Type type, Stop is_stop, Name_Kind kind = Name_Kind::name)
+    {
+        // Fast path: a valid name that is directly followed by the stop.
+        // Since all stops start with a character that cannot appear in names,
+        // this matches exactly when the loop below would not find any errors.
+        const std::size_t valid_length = match_name(remainder);
+        if (valid_length != 0
+            && (valid_length == remainder.length() || is_stop(remainder.substr(valid_length)))) {
+            if (kind == Name_Kind::qualified) {
+                emit_qualified_name(valid_length, type);
+            }
+            else {
+                emit_and_advance(valid_length, type);
+            }
+            return valid_length;
+        }
+
         std::size_t total_length = 0;
         std::size_t piece_length = 0;
 
@@ -387,8 +959,43 @@ private:
 
         return total_length;
     }
+
+    /// @brief Highlights a valid name of the given `length`,
+    /// where the prefix of a qualified name like `svg:rect` is highlighted separately.
+    void emit_qualified_name(std::size_t length, Highlight_Type type)
+    {
+        const Qualified_Name name = split_qualified_name(remainder.substr(0, length));
+        if (!name.prefix.empty()) {
+            emit_and_advance(name.prefix.length(), Highlight_Type::id_module);
+            emit_and_advance(1, Highlight_Type::sym_punc);
+        }
+        emit_and_advance(name.local_name.length(), type);
+    }
 };
 
+std::size_t highlight_window(
+    Non_Owning_Buffer<Token>& out,
+    std::u8string_view window,
+    std::size_t offset,
+    html::Stream_State& state,
+    bool final,
+    std::pmr::memory_resource*,
+    const Highlight_Options& options
+)
+{
+    const auto flush = [&](Token* tokens, std::size_t amount) {
+        for (std::size_t i = 0; i < amount; ++i) {
+            tokens[i].begin += offset;
+        }
+        out.append_range(std::span<const Token> { tokens, amount });
+    };
+    Token buffer[256];
+    Non_Owning_Buffer<Token> shifted_out { buffer, flush };
+    const std::size_t result = XML_Highlighter(shifted_out, window, options, state, final)();
+    shifted_out.flush();
+    return result;
+}
+
 } // namespace xml
 
 bool highlight_xml(
@@ -398,7 +1005,9 @@ bool highlight_xml(
     const Highlight_Options& options
 )
 {
-    return xml::XML_Highlighter(out, source, options)();
+    html::Stream_State state;
+    xml::XML_Highlighter(out, source, options, state, true)();
+    return true;
 }
 
 } // namespace ulight
@@ -1,24 +1,240 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
 #include <cstdlib>
 #include <expected>
+#include <iomanip>
 #include <iostream>
 #include <span>
 #include <string_view>
+#include <vector>
 
+#include "ulight/function_ref.hpp"
 #include "ulight/ulight.hpp"
 
 #include "ulight/impl/assert.hpp"
+#include "ulight/impl/buffer.hpp"
+#include "ulight/impl/html_output.hpp"
 #include "ulight/impl/io.hpp"
+#include "ulight/impl/unicode.hpp"
 
 namespace ulight {
 namespace {
 
+using Clock = std::chrono::steady_clock;
+using Duration = std::chrono::duration<double>;
+
+/// @brief Statistics about a `Non_Owning_Buffer`,
+/// gathered by observing its flushes.
+struct Buffer_Stats {
+    std::size_t capacity = 0;
+    std::size_t flush_count = 0;
+    std::size_t peak_size = 0;
+    std::size_t total_size = 0;
+
+    void on_flush(std::size_t amount)
+    {
+        ++flush_count;
+        peak_size = std::max(peak_size, amount);
+        total_size += amount;
+    }
+};
+
+struct Stats {
+    Duration load {};
+    Duration validate {};
+    /// @brief Time spent in the highlighter, excluding the time spent in `emit` and `write`,
+    /// which are run whenever the token buffer is flushed.
+    Duration lex {};
+    /// @brief Time spent converting tokens to HTML, excluding `write`.
+    Duration emit {};
+    /// @brief Time spent writing HTML to the output file.
+    Duration write {};
+
+    std::size_t source_bytes = 0;
+    std::size_t token_count = 0;
+    std::array<std::size_t, 256> histogram {};
+
+    Buffer_Stats token_buffer;
+    Buffer_Stats text_buffer;
+};
+
+[[nodiscard]]
+double per_second(std::size_t amount, Duration time)
+{
+    return time.count() == 0 ? 0 : double(amount) / time.count();
+}
+
+void print_duration(std::ostream& out, std::string_view name, Duration time, Duration total)
+{
+    const double percentage = total.count() == 0 ? 0 : 100 * time.count() / total.count();
+    out << "  " << std::left << std::setw(10) << name << std::right << std::setw(12)
+        << std::fixed << std::setprecision(3) << time.count() * 1000 << " ms" //
+        << std::setw(8) << std::setprecision(1) << percentage << " %\n";
+}
+
+void print_buffer_stats(std::ostream& out, std::string_view name, const Buffer_Stats& stats)
+{
+    out << "  " << std::left << std::setw(10) << name << std::right //
+        << "peak " << stats.peak_size << '/' << stats.capacity //
+        << ", " << stats.flush_count << " flushes" //
+        << ", " << stats.total_size << " total\n";
+}
+
+void print_stats(std::ostream& out, const Stats& stats)
+{
+    const Duration total = stats.load + stats.validate + stats.lex + stats.emit + stats.write;
+    const Duration highlight = stats.lex + stats.emit;
+
+    out << "Phases:\n";
+    print_duration(out, "load", stats.load, total);
+    print_duration(out, "validate", stats.validate, total);
+    print_duration(out, "lex", stats.lex, total);
+    print_duration(out, "emit", stats.emit, total);
+    print_duration(out, "write", stats.write, total);
+    print_duration(out, "total", total, total);
+
+    out << "Throughput:\n" << std::setprecision(1);
+    out << "  lex       " << per_second(stats.source_bytes, stats.lex) / 1e6 << " MB/s, "
+        << per_second(stats.token_count, stats.lex) / 1e6 << " M tokens/s\n";
+    out << "  lex+emit  " << per_second(stats.source_bytes, highlight) / 1e6 << " MB/s, "
+        << per_second(stats.token_count, highlight) / 1e6 << " M tokens/s\n";
+
+    out << "Buffers:\n";
+    print_buffer_stats(out, "tokens", stats.token_buffer);
+    print_buffer_stats(out, "text", stats.text_buffer);
+
+    out << "Tokens: " << stats.token_count << " in " << stats.source_bytes << " bytes\n";
+    std::vector<Underlying> types;
+    for (std::size_t i = 0; i < stats.histogram.size(); ++i) {
+        if (stats.histogram[i] != 0) {
+            types.push_back(Underlying(i));
+        }
+    }
+    std::ranges::stable_sort(types, std::ranges::greater {}, [&](Underlying type) {
+        return stats.histogram[type];
+    });
+    for (const Underlying type : types) {
+        const std::size_t count = stats.histogram[type];
+        const std::string_view name = highlight_type_long_string(Highlight_Type(type));
+        out << "  " << std::left << std::setw(24) << (name.empty() ? "?" : name) << std::right
+            << std::setw(12) << count << std::setw(8) << std::setprecision(1)
+            << 100 * double(count) / double(stats.token_count) << " %\n";
+    }
+}
+
+/// @brief Prints the counters of each highlighter rule, most expensive rules first.
+/// This only prints something if ulight was built with `ULIGHT_PROFILE`.
+void print_profile(std::ostream& out)
+{
+    std::vector<Profile_Entry> entries(profile_entries({}));
+    if (entries.empty()) {
+        return;
+    }
+    entries.resize(profile_entries(entries));
+    std::ranges::stable_sort(entries, std::ranges::greater {}, &Profile_Entry::cycles);
+
+    out << "Rules:\n";
+    for (const Profile_Entry& entry : entries) {
+        const std::string_view rule { entry.rule, entry.rule_length };
+        const double hit_rate
+            = entry.attempts == 0 ? 0 : 100 * double(entry.hits) / double(entry.attempts);
+        out << "  " << std::left << std::setw(12) << lang_display_name(Lang(entry.lang)) //
+            << std::setw(56) << rule << std::right //
+            << std::setw(12) << entry.attempts << " tries" //
+            << std::setw(8) << std::setprecision(1) << hit_rate << " % hit" //
+            << std::setw(14) << entry.cycles << " cycles\n";
+    }
+}
+
+/// @brief Highlights `source` as HTML into `out_file`,
+/// like `State::source_to_html`, but with each stage of the pipeline measured separately.
+Status source_to_html_measured(
+    State& state,
+    std::span<Token> token_buffer,
+    std::span<char> text_buffer,
+    std::FILE* out_file,
+    Stats& stats
+)
+{
+    stats.token_buffer.capacity = token_buffer.size();
+    stats.text_buffer.capacity = text_buffer.size();
+
+    const auto flush_text = [&](char* str, std::size_t length) {
+        const Clock::time_point start = Clock::now();
+        std::fwrite(str, 1, length, out_file);
+        stats.write += Clock::now() - start;
+        stats.text_buffer.on_flush(length);
+    };
+    Non_Owning_Buffer<char> text_out { text_buffer, flush_text };
+    Html_Token_Writer writer { .out = text_out,
+                               .source = state.get_source(),
+                               .tag_name = "h-",
+                               .attr_name = "data-h" };
+
+    // The time spent in this callback includes the time spent writing,
+    // so we need to keep track of it to subtract it from the emit time later.
+    Duration emit_and_write {};
+    const auto flush_tokens = [&](Token* tokens, std::size_t amount) {
+        const Clock::time_point start = Clock::now();
+        stats.token_buffer.on_flush(amount);
+        stats.token_count += amount;
+        for (std::size_t i = 0; i < amount; ++i) {
+            ++stats.histogram[tokens[i].type];
+        }
+        writer.write({ tokens, amount });
+        emit_and_write += Clock::now() - start;
+    };
+    state.set_token_buffer(token_buffer);
+    state.on_flush_tokens(flush_tokens);
+
+    const Clock::time_point start = Clock::now();
+    const Status status = state.source_to_tokens();
+    const Duration highlight_time = Clock::now() - start;
+    if (status != Status::ok) {
+        return status;
+    }
+    stats.lex = highlight_time - emit_and_write;
+
+    const Clock::time_point finish_start = Clock::now();
+    writer.finish();
+    emit_and_write += Clock::now() - finish_start;
+    // Up to this point, all writes happened as part of emitting,
+    // so the final flush is the only write that is not included in emit_and_write.
+    stats.emit = emit_and_write - stats.write;
+    text_out.flush();
+
+    return Status::ok;
+}
+
 // NOLINTNEXTLINE(bugprone-exception-escape)
 int main(int argc, const char** argv)
 {
-    const std::span<const char*> args { argv, std::size_t(argc) };
+    ULIGHT_ASSERT(argc >= 1);
+    std::vector<const char*> args;
+    bool print_stats_requested = false;
+    bool parallel_requested = false;
+    bool diff_langs_requested = false;
+    for (const char* arg : std::span<const char*> { argv, std::size_t(argc) }) {
+        if (std::string_view(arg) == "--stats") {
+            print_stats_requested = true;
+        }
+        else if (std::string_view(arg) == "--parallel") {
+            parallel_requested = true;
+        }
+        else if (std::string_view(arg) == "--diff-langs") {
+            diff_langs_requested = true;
+        }
+        else {
+            args.push_back(arg);
+        }
+    }
+
     if (args.size() < 2) {
-        ULIGHT_ASSERT(!args.empty());
-        std::cerr << "Usage: " << args[0] << " INPUT_FILE [OUTPUT_FILE]\n";
+        std::cerr << "Usage: " << args[0]
+                  << " [--stats] [--parallel] [--diff-langs] INPUT_FILE [OUTPUT_FILE]\n";
         return EXIT_FAILURE;
     }
 
@@ -29,12 +245,27 @@ int main(int argc, const char** argv)
         return EXIT_FAILURE;
     }
 
-    const std::expected<std::vector<char8_t>, IO_Error_Code> input = load_utf8_file(args[1]);
-    if (!input) {
+    Stats stats;
+
+    // Loading and validating UTF-8 is done separately (rather than using load_utf8_file)
+    // so that we can measure each step.
+    const Clock::time_point load_start = Clock::now();
+    std::vector<char8_t> input;
+    const std::expected<void, IO_Error_Code> load_result = file_to_bytes(input, in_path);
+    const Clock::time_point validate_start = Clock::now();
+    stats.load = validate_start - load_start;
+    if (!load_result) {
         std::cerr << in_path << ": failed to load file.\n";
         return EXIT_FAILURE;
     }
-    const std::u8string_view source_string { input->data(), input->size() };
+    const std::u8string_view source_string { input.data(), input.size() };
+    const bool is_valid = utf8::is_valid(source_string).has_value();
+    stats.validate = Clock::now() - validate_start;
+    if (!is_valid) {
+        std::cerr << in_path << ": failed to load file.\n";
+        return EXIT_FAILURE;
+    }
+    stats.source_bytes = source_string.size();
 
     Unique_File unique_out;
     std::FILE* out_file = stdout;
@@ -51,9 +282,30 @@ int main(int argc, const char** argv)
     State state;
     state.set_source(source_string);
     state.set_lang(lang);
+    Flag flags = Flag::no_flags;
+    if (parallel_requested) {
+        flags = flags | Flag::parallel;
+    }
+    if (diff_langs_requested) {
+        flags = flags | Flag::diff_langs;
+    }
+    state.set_flags(flags);
 
     Token token_buffer[1024];
     char text_buffer[1024 * 32];
+
+    if (print_stats_requested) {
+        const Status status = source_to_html_measured(
+            state, token_buffer, text_buffer, out_file, stats
+        );
+        if (status != Status::ok) {
+            std::cerr << "Error: " << state.get_error_string() << '\n';
+        }
+        print_stats(std::cerr, stats);
+        print_profile(std::cerr);
+        return 0;
+    }
+
     state.set_token_buffer(token_buffer);
     state.set_text_buffer(text_buffer);
 
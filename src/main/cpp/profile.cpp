@@ -0,0 +1,92 @@
+#include <cstddef>
+
+#include "ulight/ulight.h"
+
+#include "ulight/impl/platform.h"
+#include "ulight/impl/profile.hpp"
+
+#ifdef ULIGHT_PROFILE
+#include <atomic>
+#include <string_view>
+
+namespace ulight {
+namespace {
+
+constinit std::atomic<Profile_Rule*> profile_head = nullptr;
+
+} // namespace
+
+Profile_Rule::Profile_Rule(std::string_view name) noexcept
+    : name { name }
+{
+    Profile_Rule* old_head = profile_head.load(std::memory_order::relaxed);
+    do {
+        next = old_head;
+    } while (!profile_head.compare_exchange_weak(
+        old_head, this, std::memory_order::release, std::memory_order::relaxed
+    ));
+}
+
+Profile_Rule* profile_rules_head() noexcept
+{
+    return profile_head.load(std::memory_order::acquire);
+}
+
+} // namespace ulight
+#endif
+
+extern "C" {
+
+ULIGHT_EXPORT
+size_t ulight_profile_entries(ulight_profile_entry* out, size_t capacity) noexcept
+{
+#ifdef ULIGHT_PROFILE
+    constexpr auto relaxed = std::memory_order::relaxed;
+
+    std::size_t result = 0;
+    for (const ulight::Profile_Rule* rule = ulight::profile_rules_head(); rule;
+         rule = rule->next) {
+        for (std::size_t lang = 0; lang < ULIGHT_LANG_COUNT; ++lang) {
+            const ulight::Profile_Counters& counters = rule->counters[lang];
+            const std::size_t attempts = counters.attempts.load(relaxed);
+            if (attempts == 0) {
+                continue;
+            }
+            if (result < capacity) {
+                out[result] = {
+                    .lang = ulight_lang(lang),
+                    .rule = rule->name.data(),
+                    .rule_length = rule->name.size(),
+                    .attempts = attempts,
+                    .hits = counters.hits.load(relaxed),
+                    .cycles = counters.cycles.load(relaxed),
+                };
+            }
+            ++result;
+        }
+    }
+    return result;
+#else
+    static_cast<void>(out);
+    static_cast<void>(capacity);
+    return 0;
+#endif
+}
+
+ULIGHT_EXPORT
+void ulight_profile_reset(void) noexcept
+{
+#ifdef ULIGHT_PROFILE
+    constexpr auto relaxed = std::memory_order::relaxed;
+
+    for (ulight::Profile_Rule* rule = ulight::profile_rules_head(); rule; rule = rule->next) {
+        for (ulight::Profile_Counters& counters : rule->counters) {
+            counters.attempts.store(0, relaxed);
+            counters.hits.store(0, relaxed);
+            counters.cycles.store(0, relaxed);
+        }
+    }
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "ulight/impl/ascii_chars.hpp"
+#include "ulight/impl/assert.hpp"
+#include "ulight/impl/string_search.hpp"
+#include "ulight/impl/strings.hpp"
+
+namespace ulight {
+
+namespace {
+
+constexpr std::size_t npos = std::u8string_view::npos;
+
+/// @brief Matches a single code unit,
+/// possibly ignoring the case of ASCII alphabetic characters.
+struct Unit_Matcher {
+    /// @brief The code unit to match, in lower case if case is ignored.
+    char8_t value;
+    /// @brief `0x20` if case is ignored, otherwise zero.
+    /// Setting this bit in an upper case ASCII letter turns it into lower case.
+    /// For other characters, this may produce false positives,
+    /// which are ruled out by verifying candidates afterwards.
+    char8_t fold;
+
+    [[nodiscard]]
+    static constexpr Unit_Matcher make(char8_t c, bool ignore_case) noexcept
+    {
+        if (ignore_case && is_ascii_alpha(c)) {
+            return { to_ascii_lower(c), 0x20 };
+        }
+        return { c, 0 };
+    }
+
+    [[nodiscard]]
+    constexpr bool operator()(char8_t c) const noexcept
+    {
+        return char8_t(c | fold) == value;
+    }
+};
+
+#ifdef __SSE2__
+constexpr std::size_t block_size = 16;
+
+[[nodiscard]]
+__m128i load_block(const char8_t* data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+[[nodiscard]]
+__m128i match_block(__m128i bytes, const Unit_Matcher& matcher)
+{
+    const __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(char(matcher.fold)));
+    return _mm_cmpeq_epi8(folded, _mm_set1_epi8(char(matcher.value)));
+}
+
+[[nodiscard]]
+__m128i match_block(__m128i bytes, Code_Unit_Range range)
+{
+    // For unsigned bytes, clamping c to [min, max] leaves c unchanged iff c is in range.
+    const __m128i clamped = _mm_min_epu8(
+        _mm_max_epu8(bytes, _mm_set1_epi8(char(range.min))), _mm_set1_epi8(char(range.max))
+    );
+    return _mm_cmpeq_epi8(clamped, bytes);
+}
+
+[[nodiscard]]
+std::uint32_t to_mask(__m128i matches)
+{
+    return std::uint32_t(_mm_movemask_epi8(matches));
+}
+#endif
+
+template <bool ignore_case>
+[[nodiscard]]
+std::size_t
+find_substring_impl(std::u8string_view haystack, std::u8string_view needle, std::size_t start)
+{
+    if (start > haystack.length() || needle.length() > haystack.length() - start) {
+        return npos;
+    }
+    if (needle.empty()) {
+        return start;
+    }
+    const auto verify = [&](std::size_t pos) {
+        const std::u8string_view candidate = haystack.substr(pos, needle.length());
+        if constexpr (ignore_case) {
+            return equals_ascii_ignore_case(candidate, needle);
+        }
+        else {
+            return std::memcmp(candidate.data(), needle.data(), needle.length()) == 0;
+        }
+    };
+
+    // See http://0x80.pl/notesen/2016-11-28-simd-strfind.html
+    // We look for positions where both the first and the last code unit of the needle match.
+    // In text like HTML or JS, this rules out almost every position,
+    // so the remaining candidates can be verified one by one.
+    const std::size_t last_offset = needle.length() - 1;
+    const auto first = Unit_Matcher::make(needle.front(), ignore_case);
+    const auto last = Unit_Matcher::make(needle.back(), ignore_case);
+    const char8_t* const data = haystack.data();
+
+    std::size_t i = start;
+#ifdef __SSE2__
+    for (; i + last_offset + block_size <= haystack.length(); i += block_size) {
+        const __m128i first_matches = match_block(load_block(data + i), first);
+        const __m128i last_matches = match_block(load_block(data + i + last_offset), last);
+        std::uint32_t mask = to_mask(_mm_and_si128(first_matches, last_matches));
+        while (mask != 0) {
+            const std::size_t pos = i + std::size_t(std::countr_zero(mask));
+            if (verify(pos)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i + last_offset < haystack.length(); ++i) {
+        if (first(data[i]) && last(data[i + last_offset]) && verify(i)) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+} // namespace
+
+std::size_t find_either(std::u8string_view str, char8_t a, char8_t b, std::size_t start) noexcept
+{
+    ULIGHT_DEBUG_ASSERT(start <= str.length());
+    const char8_t* const data = str.data();
+
+    std::size_t i = start;
+#ifdef __SSE2__
+    const __m128i a_block = _mm_set1_epi8(char(a));
+    const __m128i b_block = _mm_set1_epi8(char(b));
+    for (; i + block_size <= str.length(); i += block_size) {
+        const __m128i bytes = load_block(data + i);
+        const __m128i matches
+            = _mm_or_si128(_mm_cmpeq_epi8(bytes, a_block), _mm_cmpeq_epi8(bytes, b_block));
+        if (const std::uint32_t mask = to_mask(matches)) {
+            return i + std::size_t(std::countr_zero(mask));
+        }
+    }
+#endif
+    for (; i < str.length(); ++i) {
+        if (data[i] == a || data[i] == b) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+std::size_t find_first_not_in_ranges(
+    std::u8string_view str,
+    std::span<const Code_Unit_Range> ranges,
+    std::size_t start
+) noexcept
+{
+    ULIGHT_DEBUG_ASSERT(start <= str.length());
+    const char8_t* const data = str.data();
+
+    std::size_t i = start;
+#ifdef __SSE2__
+    for (; i + block_size <= str.length(); i += block_size) {
+        const __m128i bytes = load_block(data + i);
+        __m128i matches = _mm_setzero_si128();
+        for (const Code_Unit_Range range : ranges) {
+            matches = _mm_or_si128(matches, match_block(bytes, range));
+        }
+        if (const std::uint32_t mask = ~to_mask(matches) & 0xffff) {
+            return i + std::size_t(std::countr_zero(mask));
+        }
+    }
+#endif
+    const auto is_in_range = [](char8_t c, Code_Unit_Range range) {
+        return c >= range.min && c <= range.max;
+    };
+    for (; i < str.length(); ++i) {
+        const char8_t c = data[i];
+        if (std::ranges::none_of(ranges, [&](Code_Unit_Range r) { return is_in_range(c, r); })) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+std::size_t
+find_substring(std::u8string_view haystack, std::u8string_view needle, std::size_t start) noexcept
+{
+    // For single code units, std::memchr is already vectorized.
+    if (needle.length() == 1) {
+        return haystack.find(needle.front(), start);
+    }
+    return find_substring_impl<false>(haystack, needle, start);
+}
+
+std::size_t find_substring_ascii_ignore_case(
+    std::u8string_view haystack,
+    std::u8string_view needle,
+    std::size_t start
+) noexcept
+{
+    return find_substring_impl<true>(haystack, needle, start);
+}
+
+} // namespace ulight
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cstddef>
+#include <memory_resource>
 #include <new>
 #include <string_view>
 
@@ -10,11 +11,15 @@
 #include "ulight/impl/assert.hpp"
 #include "ulight/impl/buffer.hpp"
 #include "ulight/impl/highlight.hpp"
+#include "ulight/impl/html_output.hpp"
 #include "ulight/impl/memory.hpp"
 #include "ulight/impl/platform.h"
 #include "ulight/impl/strings.hpp"
 #include "ulight/impl/unicode.hpp"
 
+#include "ulight/impl/lang/html.hpp"
+#include "ulight/impl/lang/xml.hpp"
+
 namespace ulight {
 namespace {
 
@@ -23,6 +28,8 @@ ulight::Highlight_Options to_options(ulight_flag flags) noexcept
     return {
         .coalescing = (flags & ULIGHT_COALESCE) != 0,
         .strict = (flags & ULIGHT_STRICT) != 0,
+        .threads = (flags & ULIGHT_PARALLEL) != 0 ? 0u : 1u,
+        .diff_langs = (flags & ULIGHT_DIFF_LANGS) != 0,
     };
 }
 
@@ -39,6 +46,8 @@ std::u8string_view html_entity_of(char8_t c)
     }
 }
 
+} // namespace
+
 void append_html_escaped(Non_Owning_Buffer<char>& out, std::string_view text)
 {
     constexpr std::u8string_view escaped_chars = u8"<>&";
@@ -54,7 +63,46 @@ void append_html_escaped(Non_Owning_Buffer<char>& out, std::string_view text)
     }
 }
 
-} // namespace
+void Html_Token_Writer::write(std::span<const Token> tokens)
+{
+    using namespace std::literals;
+
+    for (const Token& t : tokens) {
+        ULIGHT_DEBUG_ASSERT(t.begin >= previous_end);
+        if (t.begin > previous_end) {
+            out.append_range(source.substr(previous_end, t.begin - previous_end));
+        }
+
+        const std::string_view id = highlight_type_short_string(Highlight_Type(t.type));
+        const std::string_view source_part = source.substr(t.begin, t.length);
+
+        out.push_back('<');
+        out.append_range(tag_name);
+        out.push_back(' ');
+        out.append_range(attr_name);
+        out.push_back('=');
+        out.append_range(id);
+        out.push_back('>');
+        append_html_escaped(out, source_part);
+        out.append_range("</"sv);
+        out.append_range(tag_name);
+        out.push_back('>');
+
+        previous_end = t.begin + t.length;
+    }
+}
+
+void Html_Token_Writer::finish()
+{
+    // It is common that the final token doesn't encompass the last code unit in the source.
+    // For example, there can be a trailing '\n' at the end of the file, without highlighting.
+    ULIGHT_ASSERT(previous_end <= source.length());
+    if (previous_end != source.length()) {
+        append_html_escaped(out, source.substr(previous_end));
+        previous_end = source.length();
+    }
+}
+
 } // namespace ulight
 
 extern "C" {
@@ -109,10 +157,12 @@ constexpr ulight_lang_entry ulight_lang_list[] {
     make_lang_entry("js", ULIGHT_LANG_JS),
     make_lang_entry("json", ULIGHT_LANG_JSON),
     make_lang_entry("jsonc", ULIGHT_LANG_JSONC),
+    make_lang_entry("jsonl", ULIGHT_LANG_JSONL),
     make_lang_entry("jsx", ULIGHT_LANG_JS),
     make_lang_entry("latex", ULIGHT_LANG_LATEX),
     make_lang_entry("lua", ULIGHT_LANG_LUA),
     make_lang_entry("nasm", ULIGHT_LANG_NASM),
+    make_lang_entry("ndjson", ULIGHT_LANG_JSONL),
     // make_lang_entry( u8"mts", ULIGHT_LANG_typescript ),
     // make_lang_entry( u8"ts", ULIGHT_LANG_typescript ),
     // make_lang_entry( u8"tsx", ULIGHT_LANG_typescript ),
@@ -157,6 +207,7 @@ constexpr ulight_string_view ulight_lang_display_names[ULIGHT_LANG_COUNT] {
     make_sv("TeX"),
     make_sv("LaTeX"),
     make_sv("NASM"),
+    make_sv("JSON Lines"),
 };
 // clang-format on
 
@@ -232,7 +283,7 @@ ulight_lang ulight_lang_from_path(const char* path, size_t path_length) noexcept
 ULIGHT_EXPORT
 ulight_lang ulight_lang_from_path_u8(const char8_t* path, size_t path_length) noexcept
 {
-    return ulight_get_lang(reinterpret_cast<const char*>(path), path_length);
+    return ulight_lang_from_path(reinterpret_cast<const char*>(path), path_length);
 }
 
 ULIGHT_EXPORT
@@ -364,17 +415,14 @@ void check_flush_validity(ulight_state* state, std::span<const ulight_token> tok
     }
 }
 
-} // namespace
-
-ULIGHT_EXPORT
-// NOLINTNEXTLINE(bugprone-exception-escape)
-ulight_status ulight_source_to_tokens(ulight_state* state) noexcept
+/// @brief Checks the members of `state` which are needed to produce tokens.
+/// @returns `ULIGHT_STATUS_OK` if they are valid, else the error.
+ulight_status check_tokens_state(ulight_state* state) noexcept
 {
     if (state->source == nullptr && state->source_length != 0) {
         return error(
             state, ULIGHT_STATUS_BAD_STATE, u8"source is null, but source_length is nonzero."
         );
-        return ULIGHT_STATUS_BAD_STATE;
     }
     if (state->token_buffer == nullptr) {
         return error(state, ULIGHT_STATUS_BAD_BUFFER, u8"token_buffer must not be null.");
@@ -390,7 +438,23 @@ ulight_status ulight_source_to_tokens(ulight_state* state) noexcept
             state, ULIGHT_STATUS_BAD_LANG, u8"The given language (numeric value) is invalid."
         );
     }
+    return ULIGHT_STATUS_OK;
+}
+
+using Highlight_Tokens = ulight::Status(
+    ulight::Non_Owning_Buffer<ulight_token>& out,
+    std::u8string_view source,
+    std::pmr::memory_resource* memory,
+    const ulight::Highlight_Options& options
+);
 
+/// @brief Invokes `highlight` with the token buffer, source, and options given by `state`,
+/// and flushes the token buffer afterwards.
+/// If exceptions are enabled, they are turned into the corresponding status.
+// NOLINTNEXTLINE(bugprone-exception-escape)
+ulight_status
+highlight_tokens(ulight_state* state, ulight::Function_Ref<Highlight_Tokens> highlight) noexcept
+{
     ulight::Non_Owning_Buffer<ulight_token> buffer { state->token_buffer,
                                                      state->token_buffer_length,
                                                      state->flush_tokens_data,
@@ -405,8 +469,7 @@ ulight_status ulight_source_to_tokens(ulight_state* state) noexcept
 #ifdef ULIGHT_EXCEPTIONS
     try {
 #endif
-        const ulight::Status result
-            = ulight::highlight(buffer, source, ulight::Lang(state->lang), &memory, options);
+        const ulight::Status result = highlight(buffer, source, &memory, options);
         // We've already checked for language validity.
         // bad_lang at this point can only be developer error.
         ULIGHT_ASSERT(result != ulight::Status::bad_lang);
@@ -428,13 +491,70 @@ ulight_status ulight_source_to_tokens(ulight_state* state) noexcept
 #endif
 }
 
+} // namespace
+
+ULIGHT_EXPORT
+// NOLINTNEXTLINE(bugprone-exception-escape)
+ulight_status ulight_source_to_tokens(ulight_state* state) noexcept
+{
+    if (const ulight_status status = check_tokens_state(state); status != ULIGHT_STATUS_OK) {
+        return status;
+    }
+    const auto highlight = [&](ulight::Non_Owning_Buffer<ulight_token>& out,
+                               std::u8string_view source, std::pmr::memory_resource* memory,
+                               const ulight::Highlight_Options& options) {
+        return ulight::highlight(out, source, ulight::Lang(state->lang), memory, options);
+    };
+    return highlight_tokens(state, highlight);
+}
+
+ULIGHT_EXPORT
+// NOLINTNEXTLINE(bugprone-exception-escape)
+ulight_status ulight_window_to_tokens(ulight_state* state, ulight_window_state* window) noexcept
+{
+    if (const ulight_status status = check_tokens_state(state); status != ULIGHT_STATUS_OK) {
+        return status;
+    }
+    if (state->lang != ULIGHT_LANG_HTML && state->lang != ULIGHT_LANG_XML) {
+        return error(
+            state, ULIGHT_STATUS_BAD_LANG, u8"Only HTML and XML can be highlighted in windows."
+        );
+    }
+    if (window == nullptr) {
+        return error(state, ULIGHT_STATUS_BAD_STATE, u8"window must not be null.");
+    }
+
+    ulight::html::Stream_State stream {
+        .context = ulight::html::Stream_Context(window->internal[0]),
+        .element = ulight::html::Raw_Text_Element(window->internal[1]),
+        .quote = char8_t(window->internal[2]),
+    };
+    const bool last = window->last != 0;
+    const auto highlight = [&](ulight::Non_Owning_Buffer<ulight_token>& out,
+                               std::u8string_view source, std::pmr::memory_resource* memory,
+                               const ulight::Highlight_Options& options) {
+        const auto highlight_window = state->lang == ULIGHT_LANG_HTML
+            ? ulight::html::highlight_window
+            : ulight::xml::highlight_window;
+        window->consumed
+            = highlight_window(out, source, window->offset, stream, last, memory, options);
+        return ulight::Status::ok;
+    };
+    const ulight_status result = highlight_tokens(state, highlight);
+    if (result == ULIGHT_STATUS_OK) {
+        window->offset += window->consumed;
+        window->internal[0] = static_cast<unsigned char>(stream.context);
+        window->internal[1] = static_cast<unsigned char>(stream.element);
+        window->internal[2] = static_cast<unsigned char>(stream.quote);
+    }
+    return result;
+}
+
 ULIGHT_EXPORT
 // Suppress false positive: https://github.com/llvm/llvm-project/issues/132605
 // NOLINTNEXTLINE(bugprone-exception-escape)
 ulight_status ulight_source_to_html(ulight_state* state) noexcept
 {
-    using namespace std::literals;
-
     if (state->token_buffer == nullptr && state->token_buffer_length != 0) {
         return error(
             state, ULIGHT_STATUS_BAD_BUFFER,
@@ -470,42 +590,18 @@ ulight_status ulight_source_to_html(ulight_state* state) noexcept
     ulight::Non_Owning_Buffer<char> buffer { state->text_buffer, state->text_buffer_length,
                                              state->flush_text_data, state->flush_text };
 
-    std::size_t previous_end = 0;
-    auto flush_text = // clang-format off
-    [&](ulight_token* tokens, std::size_t amount) mutable  {
-        #ifndef NDEBUG
-        check_flush_validity(state, {tokens, amount}); 
-        #endif
-
-        for (std::size_t i = 0; i < amount; ++i) {
-            const auto& t = tokens[i];
-            if (t.begin > previous_end) {
-                const std::string_view source_gap { state->source + previous_end, t.begin - previous_end };
-                buffer.append_range(source_gap);
-            }
-
-            const std::string_view id
-                = highlight_type_short_string(ulight::Highlight_Type(t.type));
-            const auto source_part = source_string.substr(t.begin, t.length);
-
-            buffer.push_back('<');
-            buffer.append_range(html_tag_name);
-            buffer.push_back(' ');
-            buffer.append_range(html_attr_name);
-            buffer.push_back('=');
-            buffer.append_range(id);
-            buffer.push_back('>');
-            ulight::append_html_escaped(buffer, source_part);
-            buffer.append_range("</"sv);
-            buffer.append_range(html_tag_name);
-            buffer.push_back('>');
-
-            previous_end = t.begin + t.length;
-        }
+    ulight::Html_Token_Writer writer { .out = buffer,
+                                       .source = source_string,
+                                       .tag_name = html_tag_name,
+                                       .attr_name = html_attr_name };
+    auto flush_text = [&](ulight_token* tokens, std::size_t amount) {
+#ifndef NDEBUG
+        check_flush_validity(state, { tokens, amount });
+#endif
+        writer.write({ tokens, amount });
     };
-    ulight::Function_Ref<void( ulight_token*, std::size_t)> flush_text_ref = flush_text;
+    ulight::Function_Ref<void(ulight_token*, std::size_t)> flush_text_ref = flush_text;
 
-    // clang-format on
     state->flush_tokens_data = flush_text_ref.get_entity();
     state->flush_tokens = flush_text_ref.get_invoker();
 
@@ -516,12 +612,7 @@ ulight_status ulight_source_to_html(ulight_state* state) noexcept
 #ifdef ULIGHT_EXCEPTIONS
     try {
 #endif
-        // It is common that the final token doesn't encompass the last code unit in the source.
-        // For example, there can be a trailing '\n' at the end of the file, without highlighting.
-        ULIGHT_ASSERT(previous_end <= state->source_length);
-        if (previous_end != state->source_length) {
-            ulight::append_html_escaped(buffer, source_string.substr(previous_end));
-        }
+        writer.finish();
         buffer.flush();
         return ULIGHT_STATUS_OK;
 #ifdef ULIGHT_EXCEPTIONS
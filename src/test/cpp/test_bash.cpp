@@ -0,0 +1,100 @@
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "ulight/ulight.hpp"
+
+#include "ulight/impl/buffer.hpp"
+#include "ulight/impl/highlight.hpp"
+
+#include "ulight/impl/lang/bash.hpp"
+
+namespace ulight::bash {
+namespace {
+
+TEST(Bash, match_heredoc_delimiter)
+{
+    EXPECT_EQ(match_heredoc_delimiter(u8""), Heredoc_Delimiter_Result {});
+    EXPECT_EQ(match_heredoc_delimiter(u8" EOF"), Heredoc_Delimiter_Result {});
+
+    EXPECT_EQ(match_heredoc_delimiter(u8"EOF"), (Heredoc_Delimiter_Result { 3, false }));
+    EXPECT_EQ(match_heredoc_delimiter(u8"EOF > out"), (Heredoc_Delimiter_Result { 3, false }));
+    EXPECT_EQ(match_heredoc_delimiter(u8"EOF;"), (Heredoc_Delimiter_Result { 3, false }));
+    EXPECT_EQ(match_heredoc_delimiter(u8"'EOF' x"), (Heredoc_Delimiter_Result { 5, true }));
+    EXPECT_EQ(match_heredoc_delimiter(u8"\"E O\"F"), (Heredoc_Delimiter_Result { 6, true }));
+    EXPECT_EQ(match_heredoc_delimiter(u8"\\EOF"), (Heredoc_Delimiter_Result { 4, true }));
+    EXPECT_EQ(match_heredoc_delimiter(u8"'EOF"), (Heredoc_Delimiter_Result { 4, true }));
+}
+
+TEST(Bash, append_unquoted)
+{
+    std::pmr::u8string result;
+    const auto unquoted = [&](std::u8string_view word) -> std::u8string_view {
+        result.clear();
+        append_unquoted(result, word);
+        return result;
+    };
+    EXPECT_EQ(unquoted(u8"EOF"), u8"EOF");
+    EXPECT_EQ(unquoted(u8"'EOF'"), u8"EOF");
+    EXPECT_EQ(unquoted(u8"\"E O\"F"), u8"E OF");
+    EXPECT_EQ(unquoted(u8"\\EOF"), u8"EOF");
+    EXPECT_EQ(unquoted(u8"'\\'"), u8"\\");
+}
+
+TEST(Bash, match_heredoc_body)
+{
+    EXPECT_EQ(
+        match_heredoc_body(u8"EOF\nrest", u8"EOF", false), (Heredoc_Body_Result { 0, 3, true })
+    );
+    EXPECT_EQ(
+        match_heredoc_body(u8"a\nb EOF\nEOF", u8"EOF", false), (Heredoc_Body_Result { 8, 3, true })
+    );
+    EXPECT_EQ(
+        match_heredoc_body(u8"EOFx\nxEOF\nEOF\n", u8"EOF", false),
+        (Heredoc_Body_Result { 10, 3, true })
+    );
+    EXPECT_EQ(
+        match_heredoc_body(u8"a\n\tEOF\n", u8"EOF", false), (Heredoc_Body_Result { 7, 0, false })
+    );
+    EXPECT_EQ(
+        match_heredoc_body(u8"a\n\t\tEOF\n", u8"EOF", true), (Heredoc_Body_Result { 2, 5, true })
+    );
+    EXPECT_EQ(match_heredoc_body(u8"a\n\nb", u8"", false), (Heredoc_Body_Result { 2, 0, true }));
+}
+
+TEST(Bash, many_shifts_are_not_heredocs)
+{
+    // Each "<<" looks for a delimiter line "2", which does not exist.
+    // This should only be searched for once rather than once per shift.
+    constexpr std::u8string_view line = u8"echo $((a << 2))\n";
+    constexpr std::size_t line_count = 20'000;
+    std::u8string source;
+    for (std::size_t i = 0; i < line_count; ++i) {
+        source += line;
+    }
+
+    std::size_t token_count = 0;
+    std::size_t shift_count = 0;
+    Token buffer[256];
+    const auto flush = [&](Token* tokens, std::size_t amount) {
+        token_count += amount;
+        for (std::size_t i = 0; i < amount; ++i) {
+            EXPECT_NE(Highlight_Type(tokens[i].type), Highlight_Type::string_delim);
+            shift_count += std::u8string_view { source }.substr(tokens[i].begin, tokens[i].length)
+                == u8"<<";
+        }
+    };
+    Non_Owning_Buffer<Token> out { buffer, flush };
+    ASSERT_TRUE(highlight_bash(out, source, std::pmr::get_default_resource(), {}));
+    out.flush();
+
+    // "echo", "$(", "(", "a", "<<", "2", ")", and ")" on each line.
+    EXPECT_EQ(token_count, 8 * line_count);
+    EXPECT_EQ(shift_count, line_count);
+}
+
+} // namespace
+} // namespace ulight::bash
@@ -110,6 +110,10 @@ TEST(Cpp, match_escape_sequence)
     EXPECT_EQ(match_escape_sequence(u8"\\$x"), Escape_Result(2, Escape_Type::conditional));
     EXPECT_EQ(match_escape_sequence(u8"\\#x"), Escape_Result(2, Escape_Type::conditional));
     EXPECT_EQ(match_escape_sequence(u8"\\#@"), Escape_Result(2, Escape_Type::conditional));
+    EXPECT_EQ(
+        match_escape_sequence(u8"\\\u3042x"),
+        Escape_Result(4, Escape_Type::conditional, true)
+    );
 }
 
 } // namespace
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <string>
+#include <string_view>
 
 #include <gtest/gtest.h>
 
@@ -88,6 +90,10 @@ TEST(CSS, match_number)
     EXPECT_EQ(match_number(u8"-123E5"), 6);
     EXPECT_EQ(match_number(u8"-123E+5"), 7);
     EXPECT_EQ(match_number(u8"-123E-5"), 7);
+
+    // Long runs of digits are matched in blocks.
+    EXPECT_EQ(match_number(u8"12345678901234567890"), 20);
+    EXPECT_EQ(match_number(u8"1234567890123456.789012345678901234px"), 35);
 }
 
 TEST(CSS, match_escaped_code_point)
@@ -128,6 +134,17 @@ TEST(CSS, match_ident_sequence)
     EXPECT_EQ(match_ident_sequence(u8"\\xabc"), 5);
 
     EXPECT_EQ(match_ident_sequence(u8"abc;def"), 3);
+
+    // Long runs of identifier characters are matched in blocks,
+    // so the end of the run needs to be found at any position within a block.
+    const std::u8string_view long_ident = u8"navbar-expand_LG-0123456789-naïve-Zz";
+    for (std::size_t length = 0; length <= long_ident.length(); ++length) {
+        const std::u8string str = std::u8string(long_ident.substr(0, length)) + u8'{'
+            + std::u8string(long_ident);
+        EXPECT_EQ(match_ident_sequence(str), length);
+    }
+    EXPECT_EQ(match_ident_sequence(u8"navbar-expand-lg-dropdown-menu{position:absolute}"), 30);
+    EXPECT_EQ(match_ident_sequence(u8"navbar-expand-lg-\\31 dropdown-menu"), 34);
 }
 
 } // namespace
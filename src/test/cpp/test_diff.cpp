@@ -0,0 +1,189 @@
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ulight/ulight.hpp"
+
+#include "ulight/impl/lang/diff.hpp"
+
+namespace ulight::diff {
+namespace {
+
+using namespace std::literals;
+
+[[nodiscard]]
+std::vector<Token> highlight_tokens(std::u8string_view source, Flag flags)
+{
+    Token token_buffer[16];
+    std::vector<Token> result;
+    State state;
+    state.set_source(source);
+    state.set_lang(Lang::diff);
+    state.set_flags(flags);
+    state.set_token_buffer(token_buffer);
+    const auto flush = [&](Token* tokens, std::size_t amount) {
+        result.insert(result.end(), tokens, tokens + amount);
+    };
+    state.on_flush_tokens(flush);
+    EXPECT_EQ(state.source_to_tokens(), Status::ok);
+    return result;
+}
+
+/// @brief Returns the type of the token which contains the first code unit of `needle`
+/// within `source`, or `std::nullopt` if there is no such token.
+[[nodiscard]]
+std::optional<Highlight_Type>
+type_at(std::u8string_view source, const std::vector<Token>& tokens, std::u8string_view needle)
+{
+    const std::size_t pos = source.find(needle);
+    EXPECT_NE(pos, std::u8string_view::npos);
+    for (const Token& token : tokens) {
+        if (token.begin <= pos && pos < token.begin + token.length) {
+            return Highlight_Type(token.type);
+        }
+    }
+    return {};
+}
+
+TEST(Diff, match_hunk_header)
+{
+    EXPECT_EQ(match_hunk_header(u8"@@ -1,7 +1,6 @@"), (Hunk_Header { 7, 6 }));
+    EXPECT_EQ(match_hunk_header(u8"@@ -1,7 +1,6 @@ int main()"), (Hunk_Header { 7, 6 }));
+    EXPECT_EQ(match_hunk_header(u8"@@ -1 +1 @@"), (Hunk_Header { 1, 1 }));
+    EXPECT_EQ(match_hunk_header(u8"@@ -0,0 +1,3 @@"), (Hunk_Header { 0, 3 }));
+
+    EXPECT_EQ(match_hunk_header(u8""), std::nullopt);
+    EXPECT_EQ(match_hunk_header(u8"@@"), std::nullopt);
+    EXPECT_EQ(match_hunk_header(u8"@@ -1,7 +1,6"), std::nullopt);
+    EXPECT_EQ(match_hunk_header(u8"@@ -1,7 @@"), std::nullopt);
+    EXPECT_EQ(match_hunk_header(u8"@@ +1,7 -1,6 @@"), std::nullopt);
+    EXPECT_EQ(match_hunk_header(u8"@@ -x,7 +1,6 @@"), std::nullopt);
+    EXPECT_EQ(match_hunk_header(u8"@@ -1, +1,6 @@"), std::nullopt);
+}
+
+TEST(Diff, file_heading_path)
+{
+    EXPECT_EQ(file_heading_path(u8"--- a/main.cpp"), u8"a/main.cpp"sv);
+    EXPECT_EQ(file_heading_path(u8"+++ b/main.cpp\t2002-02-21 23:30:39"), u8"b/main.cpp"sv);
+    EXPECT_EQ(file_heading_path(u8"+++ /dev/null"), u8"/dev/null"sv);
+    EXPECT_EQ(file_heading_path(u8"+++ "), u8""sv);
+}
+
+TEST(Diff, langs_disabled)
+{
+    constexpr std::u8string_view source = u8"--- a/x.cpp\n"
+                                          u8"+++ b/x.cpp\n"
+                                          u8"@@ -1 +1 @@\n"
+                                          u8"-int value = 0;\n"
+                                          u8"+float value = 0;\n";
+    const std::vector<Token> tokens = highlight_tokens(source, Flag::no_flags);
+    EXPECT_EQ(type_at(source, tokens, u8"-int"), Highlight_Type::diff_deletion);
+    EXPECT_EQ(type_at(source, tokens, u8"int"), Highlight_Type::diff_modification);
+    EXPECT_EQ(type_at(source, tokens, u8" value = 0;\n+"), Highlight_Type::diff_deletion);
+    EXPECT_EQ(type_at(source, tokens, u8"+float"), Highlight_Type::diff_insertion);
+    EXPECT_EQ(type_at(source, tokens, u8"float"), Highlight_Type::diff_modification);
+}
+
+TEST(Diff, words_long_lines)
+{
+    // The lines have nothing in common except for their blanks,
+    // which would make the minimal diff quadratic without a cost limit.
+    std::u8string source = u8"-";
+    for (int i = 0; i < 20'000; ++i) {
+        source += u8"a ";
+    }
+    source += u8"\n+";
+    for (int i = 0; i < 20'000; ++i) {
+        source += u8"b ";
+    }
+    source += u8"\n";
+    const std::vector<Token> tokens = highlight_tokens(source, Flag::no_flags);
+    ASSERT_EQ(tokens.size(), 2);
+    EXPECT_EQ(Highlight_Type(tokens[0].type), Highlight_Type::diff_deletion);
+    EXPECT_EQ(Highlight_Type(tokens[1].type), Highlight_Type::diff_insertion);
+}
+
+TEST(Diff, deletions_without_insertions)
+{
+    // Deleting a whole file results in a long block of deletions that is not followed by
+    // insertions, which must be highlighted in one pass rather than rescanned for every line.
+    constexpr std::size_t line_count = 20'000;
+    std::u8string source = u8"@@ -1,20000 +0,0 @@\n";
+    for (std::size_t i = 0; i < line_count; ++i) {
+        source += u8"-deleted line\n";
+    }
+    source += u8" context\n";
+    const std::vector<Token> tokens = highlight_tokens(source, Flag::no_flags);
+    ASSERT_EQ(tokens.size(), line_count + 2);
+    for (std::size_t i = 1; i <= line_count; ++i) {
+        EXPECT_EQ(Highlight_Type(tokens[i].type), Highlight_Type::diff_deletion);
+        EXPECT_EQ(tokens[i].length, 13);
+    }
+    EXPECT_EQ(Highlight_Type(tokens.back().type), Highlight_Type::diff_common);
+}
+
+TEST(Diff, langs_per_side)
+{
+    // The block comment spans a context line and a deletion, or an insertion respectively,
+    // so it is only highlighted correctly if each side is lexed as a whole.
+    constexpr std::u8string_view source = u8"--- a/x.cpp\n"
+                                          u8"+++ b/x.cpp\n"
+                                          u8"@@ -1,2 +1,2 @@\n"
+                                          u8" /* a\n"
+                                          u8"-old */ int x;\n"
+                                          u8"+new */ float x;\n"
+                                          u8"\\ No newline at end of file\n";
+    const std::vector<Token> tokens = highlight_tokens(source, Flag::diff_langs);
+
+    EXPECT_EQ(type_at(source, tokens, u8"--- "), Highlight_Type::diff_heading);
+    EXPECT_EQ(type_at(source, tokens, u8"+++ "), Highlight_Type::diff_heading);
+    EXPECT_EQ(type_at(source, tokens, u8"@@ "), Highlight_Type::diff_heading_hunk);
+    EXPECT_EQ(type_at(source, tokens, u8" /*"), Highlight_Type::diff_common);
+    EXPECT_EQ(type_at(source, tokens, u8"/* a"), Highlight_Type::comment_delim);
+    EXPECT_EQ(type_at(source, tokens, u8"-old"), Highlight_Type::diff_deletion);
+    EXPECT_EQ(type_at(source, tokens, u8"old"), Highlight_Type::comment);
+    EXPECT_EQ(type_at(source, tokens, u8"+new"), Highlight_Type::diff_insertion);
+    EXPECT_EQ(type_at(source, tokens, u8"new"), Highlight_Type::comment);
+    EXPECT_EQ(type_at(source, tokens, u8"int"), Highlight_Type::keyword_type);
+    EXPECT_EQ(type_at(source, tokens, u8"float"), Highlight_Type::keyword_type);
+    // Code which the nested highlighter leaves alone keeps the line type.
+    EXPECT_EQ(type_at(source, tokens, u8" x;\n+"), Highlight_Type::diff_deletion);
+    EXPECT_EQ(type_at(source, tokens, u8"\\ No"), Highlight_Type::diff_common);
+}
+
+TEST(Diff, langs_unknown)
+{
+    constexpr std::u8string_view source = u8"--- a/x.unknown\n"
+                                          u8"+++ b/x.unknown\n"
+                                          u8"@@ -1 +1 @@\n"
+                                          u8"-int value = 0;\n"
+                                          u8"+float value = 0;\n";
+    const std::vector<Token> tokens = highlight_tokens(source, Flag::diff_langs);
+    // Without a language, the changed words are highlighted instead.
+    EXPECT_EQ(type_at(source, tokens, u8"int"), Highlight_Type::diff_modification);
+    EXPECT_EQ(type_at(source, tokens, u8"float"), Highlight_Type::diff_modification);
+    EXPECT_EQ(type_at(source, tokens, u8" value = 0;\n+"), Highlight_Type::diff_deletion);
+}
+
+TEST(Diff, langs_counts_lines)
+{
+    // The deletion "-- x" looks like a file heading,
+    // but the hunk heading says that it belongs to the hunk.
+    constexpr std::u8string_view source = u8"--- a/x.lua\n"
+                                          u8"+++ b/x.lua\n"
+                                          u8"@@ -1,2 +1 @@\n"
+                                          u8"-- x\n"
+                                          u8"+++ y\n"
+                                          u8"-z\n";
+    const std::vector<Token> tokens = highlight_tokens(source, Flag::diff_langs);
+    EXPECT_EQ(type_at(source, tokens, u8"-- x"), Highlight_Type::diff_deletion);
+    EXPECT_EQ(type_at(source, tokens, u8"+++ y"), Highlight_Type::diff_insertion);
+    EXPECT_EQ(type_at(source, tokens, u8"-z"), Highlight_Type::diff_deletion);
+}
+
+} // namespace
+} // namespace ulight::diff
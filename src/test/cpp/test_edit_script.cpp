@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ulight/impl/edit_script.hpp"
+
+namespace ulight {
+namespace {
+
+using namespace std::literals;
+
+[[nodiscard]]
+std::pmr::vector<Edit_Type>
+myers(std::u8string_view from, std::u8string_view to, std::size_t max_cost = std::size_t(-1))
+{
+    std::pmr::vector<Edit_Type> result;
+    myers_edit_script<char8_t>(result, from, to, std::pmr::get_default_resource(), max_cost);
+    return result;
+}
+
+[[nodiscard]]
+std::size_t cost(std::span<const Edit_Type> edits)
+{
+    return std::size_t(std::ranges::count_if(edits, [](Edit_Type e) {
+        return e != Edit_Type::common;
+    }));
+}
+
+/// @brief Applies `edits` to `from` and returns the result.
+[[nodiscard]]
+std::u8string
+apply(std::span<const Edit_Type> edits, std::u8string_view from, std::u8string_view to)
+{
+    std::u8string result;
+    std::size_t from_index = 0;
+    std::size_t to_index = 0;
+    for (const Edit_Type e : edits) {
+        switch (e) {
+        case Edit_Type::common: {
+            EXPECT_EQ(from[from_index], to[to_index]);
+            result += from[from_index++];
+            ++to_index;
+            break;
+        }
+        case Edit_Type::del: {
+            ++from_index;
+            break;
+        }
+        case Edit_Type::ins: {
+            result += to[to_index++];
+            break;
+        }
+        }
+    }
+    EXPECT_EQ(from_index, from.length());
+    EXPECT_EQ(to_index, to.length());
+    return result;
+}
+
+TEST(Edit_Script, myers_trivial)
+{
+    EXPECT_TRUE(myers(u8"", u8"").empty());
+    EXPECT_EQ(myers(u8"abc", u8"abc"), std::pmr::vector<Edit_Type>(3, Edit_Type::common));
+    EXPECT_EQ(myers(u8"abc", u8""), std::pmr::vector<Edit_Type>(3, Edit_Type::del));
+    EXPECT_EQ(myers(u8"", u8"abc"), std::pmr::vector<Edit_Type>(3, Edit_Type::ins));
+}
+
+TEST(Edit_Script, myers_minimal)
+{
+    // The example from Myers' paper, whose shortest edit script has a cost of 5.
+    const auto edits = myers(u8"ABCABBA", u8"CBABAC");
+    EXPECT_EQ(cost(edits), 5);
+    EXPECT_EQ(std::u8string_view { apply(edits, u8"ABCABBA", u8"CBABAC") }, u8"CBABAC"sv);
+
+    EXPECT_EQ(cost(myers(u8"kitten", u8"sitting")), 5);
+    EXPECT_EQ(cost(myers(u8"abcdef", u8"fedcba")), 10);
+}
+
+TEST(Edit_Script, myers_random)
+{
+    std::default_random_engine rng { 12345 };
+    std::uniform_int_distribution<int> length_distribution { 0, 40 };
+    std::uniform_int_distribution<int> char_distribution { 'a', 'd' };
+    const auto random_string = [&] {
+        std::u8string result(std::size_t(length_distribution(rng)), u8'\0');
+        for (char8_t& c : result) {
+            c = char8_t(char_distribution(rng));
+        }
+        return result;
+    };
+
+    for (int i = 0; i < 200; ++i) {
+        const std::u8string from = random_string();
+        const std::u8string to = random_string();
+        const auto minimal = myers(from, to);
+        EXPECT_EQ(std::u8string_view { apply(minimal, from, to) }, std::u8string_view { to });
+        // With a low cost limit, the script is still valid, just not necessarily minimal.
+        const auto heuristic = myers(from, to, 2);
+        EXPECT_EQ(std::u8string_view { apply(heuristic, from, to) }, std::u8string_view { to });
+        EXPECT_GE(cost(heuristic), cost(minimal));
+    }
+}
+
+TEST(Edit_Script, myers_cost_limit_on_long_sequences)
+{
+    std::u8string from(100'000, u8'a');
+    std::u8string to(100'000, u8'b');
+    for (std::size_t i = 0; i < from.size(); i += 7) {
+        from[i] = u8'x';
+        to[i] = u8'x';
+    }
+    const auto edits = myers(from, to, 16);
+    EXPECT_TRUE(apply(edits, from, to) == to);
+}
+
+[[nodiscard]]
+std::pmr::vector<Edit_Type> histogram(
+    std::span<const std::u8string_view> from,
+    std::span<const std::u8string_view> to,
+    std::size_t max_cost = std::size_t(-1)
+)
+{
+    std::pmr::vector<Edit_Type> result;
+    histogram_edit_script(result, from, to, std::pmr::get_default_resource(), max_cost);
+    return result;
+}
+
+[[nodiscard]]
+std::pmr::u8string unified(
+    std::span<const std::u8string_view> from,
+    std::span<const std::u8string_view> to,
+    std::size_t context = 3
+)
+{
+    std::pmr::vector<Edit_Type> edits = histogram(from, to);
+    group_edits(edits);
+    std::pmr::u8string result;
+    append_unified_diff(result, from, to, edits, context);
+    return result;
+}
+
+TEST(Edit_Script, histogram_anchors_on_unique_lines)
+{
+    // A minimal diff could match up the braces and blank lines of the two functions,
+    // but the histogram diff anchors on the unique lines of g instead.
+    const std::u8string_view from[] {
+        u8"void f()", u8"{", u8"    a();", u8"}", u8"", u8"void g()", u8"{", u8"    b();", u8"}",
+    };
+    const std::u8string_view to[] {
+        u8"void g()", u8"{", u8"    b();", u8"}", u8"", u8"void h()", u8"{", u8"    c();", u8"}",
+    };
+    using enum Edit_Type;
+    std::pmr::vector<Edit_Type> edits = histogram(from, to);
+    group_edits(edits);
+    const std::pmr::vector<Edit_Type> expected {
+        del, del, del, del, del, common, common, common,
+        ins, ins, ins, ins, ins, common,
+    };
+    EXPECT_EQ(edits, expected);
+}
+
+TEST(Edit_Script, histogram_random)
+{
+    std::default_random_engine rng { 54321 };
+    std::uniform_int_distribution<int> length_distribution { 0, 60 };
+    const std::u8string_view alphabet[] { u8"{", u8"}", u8"", u8"x", u8"y", u8"z" };
+    std::uniform_int_distribution<std::size_t> element_distribution { 0, std::size(alphabet) - 1 };
+    const auto random_lines = [&] {
+        std::vector<std::u8string_view> result(std::size_t(length_distribution(rng)));
+        for (std::u8string_view& line : result) {
+            line = alphabet[element_distribution(rng)];
+        }
+        return result;
+    };
+
+    for (int i = 0; i < 200; ++i) {
+        const std::vector<std::u8string_view> from = random_lines();
+        const std::vector<std::u8string_view> to = random_lines();
+        for (const std::size_t max_cost : { std::size_t(-1), std::size_t(2) }) {
+            const auto edits = histogram(from, to, max_cost);
+            std::size_t from_index = 0;
+            std::size_t to_index = 0;
+            for (const Edit_Type e : edits) {
+                if (e == Edit_Type::common) {
+                    ASSERT_EQ(from[from_index], to[to_index]);
+                }
+                from_index += e != Edit_Type::ins;
+                to_index += e != Edit_Type::del;
+            }
+            EXPECT_EQ(from_index, from.size());
+            EXPECT_EQ(to_index, to.size());
+        }
+    }
+}
+
+TEST(Edit_Script, histogram_large)
+{
+    // The Needleman-Wunsch algorithm used to need (N + 1) * (M + 1) words of memory,
+    // which would be 20 GB for inputs of this size.
+    constexpr std::size_t size = 50'000;
+    std::vector<std::u8string> storage;
+    storage.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        storage.push_back(reinterpret_cast<const char8_t*>(std::to_string(i % 1000).c_str()));
+    }
+    std::vector<std::u8string_view> from(storage.begin(), storage.end());
+    std::vector<std::u8string_view> to = from;
+    for (std::size_t i = 0; i < size; i += 97) {
+        to[i] = u8"changed";
+    }
+    to.erase(to.begin() + 1234, to.begin() + 1300);
+
+    const auto edits = histogram(from, to, 1024);
+    std::size_t from_index = 0;
+    std::size_t to_index = 0;
+    std::size_t changes = 0;
+    for (const Edit_Type e : edits) {
+        if (e == Edit_Type::common) {
+            ASSERT_EQ(from[from_index], to[to_index]);
+        }
+        changes += e != Edit_Type::common;
+        from_index += e != Edit_Type::ins;
+        to_index += e != Edit_Type::del;
+    }
+    EXPECT_EQ(from_index, from.size());
+    EXPECT_EQ(to_index, to.size());
+    EXPECT_LT(changes, 2 * (size / 97 + 1) + 66);
+}
+
+TEST(Edit_Script, find_hunks)
+{
+    using enum Edit_Type;
+    const std::pmr::vector<Edit_Type> edits {
+        common, common, common, common, common, del, ins, common, common, // hunk 1
+        common, common, common, common, common, common, common, ins, // hunk 2
+        common, common, common, common, common, common, del, // still hunk 2
+    };
+    std::pmr::vector<Diff_Hunk> hunks;
+    find_hunks(hunks, edits, 3);
+    ASSERT_EQ(hunks.size(), 2);
+
+    EXPECT_EQ(hunks[0].edits_begin, 2);
+    EXPECT_EQ(hunks[0].edits_end, 10);
+    EXPECT_EQ(hunks[0].from_begin, 2);
+    EXPECT_EQ(hunks[0].from_length, 7);
+    EXPECT_EQ(hunks[0].to_begin, 2);
+    EXPECT_EQ(hunks[0].to_length, 7);
+
+    EXPECT_EQ(hunks[1].edits_begin, 13);
+    EXPECT_EQ(hunks[1].edits_end, 24);
+    EXPECT_EQ(hunks[1].from_begin, 12);
+    EXPECT_EQ(hunks[1].from_length, 10);
+    EXPECT_EQ(hunks[1].to_begin, 12);
+    EXPECT_EQ(hunks[1].to_length, 10);
+
+    hunks.clear();
+    find_hunks(hunks, std::pmr::vector<Edit_Type>(10, common), 3);
+    EXPECT_TRUE(hunks.empty());
+}
+
+TEST(Edit_Script, append_unified_diff)
+{
+    const std::u8string_view from[] { u8"a", u8"b", u8"c", u8"d", u8"e", u8"f", u8"g", u8"h" };
+    const std::u8string_view to[] { u8"a", u8"b", u8"C", u8"d", u8"e", u8"f", u8"g", u8"h", u8"i" };
+    EXPECT_EQ(
+        unified(from, to, 1),
+        u8"@@ -2,3 +2,3 @@\n"
+        u8" b\n"
+        u8"-c\n"
+        u8"+C\n"
+        u8" d\n"
+        u8"@@ -8 +8,2 @@\n"
+        u8" h\n"
+        u8"+i\n"sv
+    );
+
+    const std::u8string_view empty[] { u8"" };
+    EXPECT_EQ(unified({}, std::span(empty)), u8"@@ -0,0 +1 @@\n+\n"sv);
+    EXPECT_EQ(unified(from, from), u8""sv);
+}
+
+TEST(Edit_Script, group_edits)
+{
+    using enum Edit_Type;
+    std::vector<Edit_Type> edits { ins, del, ins, common, ins, del, common };
+    group_edits(edits);
+    EXPECT_EQ(edits, (std::vector<Edit_Type> { del, ins, ins, common, del, ins, common }));
+}
+
+} // namespace
+} // namespace ulight
@@ -116,6 +116,8 @@ TEST(HTML, match_raw_text)
     EXPECT_EQ(match(u8"abc</script\f"), 3);
 
     EXPECT_EQ(match(u8"<script>abc</script>"), 11);
+    EXPECT_EQ(match(u8"abc</SCRIPT>"), 3);
+    EXPECT_EQ(match(u8"abc</scripts></script>"), 13);
 }
 
 TEST(HTML, match_escapable_raw_text)
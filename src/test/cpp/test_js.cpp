@@ -1,5 +1,11 @@
+#include <cstddef>
+#include <string>
+#include <string_view>
+
 #include <gtest/gtest.h>
 
+#include "ulight/ulight.hpp"
+
 #include "ulight/impl/lang/js.hpp"
 
 namespace ulight::js {
@@ -147,5 +153,56 @@ TEST(JS, match_escape_sequence)
     EXPECT_EQ(match_escape_sequence(u8"\\a"), Escape_Result(2u));
 }
 
+[[nodiscard]]
+std::u8string repeat(std::u8string_view str, std::size_t n)
+{
+    std::u8string result;
+    result.reserve(str.length() * n);
+    for (std::size_t i = 0; i < n; ++i) {
+        result += str;
+    }
+    return result;
+}
+
+/// @brief Returns the amount of tokens produced by highlighting `source` as JavaScript.
+[[nodiscard]]
+std::size_t count_tokens(std::u8string_view source)
+{
+    Token token_buffer[1024];
+    State state;
+    state.set_source(source);
+    state.set_lang(Lang::javascript);
+    state.set_token_buffer(token_buffer);
+    std::size_t result = 0;
+    const auto flush = [&](Token*, std::size_t amount) { result += amount; };
+    state.on_flush_tokens(flush);
+    EXPECT_EQ(state.source_to_tokens(), Status::ok);
+    return result;
+}
+
+TEST(JS, deep_nesting)
+{
+    // Each of these nests braces within templates or JSX to a great depth,
+    // which would overflow the stack if the highlighter recursed for each level.
+    // Every level produces the same tokens, so the amount of tokens is linear in the depth.
+    // How the highlighting time scales with the depth is measured by ulight-bench.
+    constexpr std::size_t depth = 32'000;
+
+    const std::u8string template_substitutions
+        = repeat(u8"`${", depth) + u8"x" + repeat(u8"}`", depth);
+    EXPECT_EQ(count_tokens(template_substitutions), (4 * depth) + 1);
+
+    const std::u8string jsx_attributes
+        = u8"x = " + repeat(u8"<a b={", depth) + u8"0" + repeat(u8"} />", depth);
+    EXPECT_EQ(count_tokens(jsx_attributes), (8 * depth) + 3);
+
+    const std::u8string jsx_children
+        = u8"x = " + repeat(u8"<a>{", depth) + u8"0" + repeat(u8"}</a>", depth);
+    EXPECT_EQ(count_tokens(jsx_children), (9 * depth) + 3);
+
+    const std::u8string unterminated_jsx_attributes = u8"x" + repeat(u8"<y z={", depth);
+    EXPECT_EQ(count_tokens(unterminated_jsx_attributes), (5 * depth) + 1);
+}
+
 } // namespace
 } // namespace ulight::js
@@ -1,12 +1,27 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "ulight/json.hpp"
+#include "ulight/json_cursor.hpp"
+#include "ulight/json_dom.hpp"
+#include "ulight/json_schema.hpp"
+#include "ulight/json_static.hpp"
 
 #include "ulight/impl/io.hpp"
+#include "ulight/impl/lang/json.hpp"
 #include "ulight/impl/lang/json_chars.hpp"
+#include "ulight/impl/lang/json_index.hpp"
 #include "ulight/impl/platform.h"
 #include "ulight/impl/unicode.hpp"
 
@@ -163,6 +178,13 @@ struct Test_Visitor final : JSON_Visitor {
 
     std::u8string current_string;
 
+    /// @brief For `parse_json_lines`, the value of each record, or `std::nullopt` on error.
+    std::vector<std::optional<Value>> records;
+    std::vector<Source_Position> record_positions;
+    bool record_failed = false;
+
+    using JSON_Visitor::escape;
+
     void line_comment(const Source_Position&, std::u8string_view) final
     {
         ++line_comment_count;
@@ -246,6 +268,25 @@ struct Test_Visitor final : JSON_Visitor {
         insert_value(std::move(array));
     }
 
+    void push_record(const Source_Position& pos) final
+    {
+        root_value.reset();
+        structure_stack.clear();
+        property_stack.clear();
+        record_failed = false;
+        record_positions.push_back(pos);
+    }
+    void pop_record(const Source_Position&) final
+    {
+        records.push_back(record_failed ? std::nullopt : std::move(root_value));
+    }
+
+    Error_Reaction error(const Source_Position&, JSON_Error) final
+    {
+        record_failed = true;
+        return Error_Reaction::abort;
+    }
+
     void insert_value(Value&& value)
     {
         if (structure_stack.empty()) {
@@ -323,6 +364,12 @@ TEST(JSON, parse_integer)
     EXPECT_EQ(value, 123.0);
 }
 
+TEST(JSON, parse_negative)
+{
+    std::optional<Value> value = parse(u8"-123");
+    EXPECT_EQ(value, -123.0);
+}
+
 TEST(JSON, parse_float)
 {
     std::optional<Value> value = parse(u8"123.125");
@@ -385,5 +432,921 @@ TEST(JSON, parse_nested)
     EXPECT_EQ(value, expected);
 }
 
+TEST(JSON, classify_block_matches_scalar)
+{
+    std::u8string block(index_block_size, u8' ');
+    for (std::size_t length = 0; length <= index_block_size; ++length) {
+        for (int c = 0; c < 256; ++c) {
+            const std::size_t i = (std::size_t(c) * 7) % index_block_size;
+            block.assign(index_block_size, u8'a');
+            block[i] = char8_t(c);
+            const std::u8string_view view = std::u8string_view { block }.substr(0, length);
+
+            Block_Masks expected {};
+            for (std::size_t j = 0; j < view.length(); ++j) {
+                const char8_t u = view[j];
+                const std::uint64_t bit = std::uint64_t(1) << j;
+                expected.string_special |= (u == u8'"' || u == u8'\\' || u < 0x20) ? bit : 0;
+                expected.whitespace |= is_json_whitespace(u) ? bit : 0;
+                expected.newline |= u == u8'\n' ? bit : 0;
+                const bool is_nesting
+                    = u == u8'{' || u == u8'}' || u == u8'[' || u == u8']' || u == u8'/';
+                expected.nesting |= is_nesting ? bit : 0;
+            }
+            EXPECT_EQ(classify_block(view), expected) << "c=" << c << ", length=" << length;
+        }
+    }
+}
+
+TEST(JSON, line_tracker_matches_scalar)
+{
+    std::mt19937 rng { 12345 }; // NOLINT(cert-msc51-cpp)
+    std::u8string source;
+    for (int i = 0; i < 1000; ++i) {
+        // Long lines, short lines, and empty lines all have to be covered.
+        const auto length = std::size_t(rng() % 4 == 0 ? rng() % 300 : rng() % 5);
+        source.append(length, u8'x');
+        source.push_back(u8'\n');
+    }
+
+    const Source_Index index { source, std::pmr::get_default_resource() };
+    Line_Tracker tracker { index };
+    Source_Position expected {};
+    for (std::size_t i = 0; i <= source.length(); ++i) {
+        const Source_Position actual = tracker.position(i);
+        EXPECT_EQ(actual.code_unit, expected.code_unit);
+        EXPECT_EQ(actual.line, expected.line);
+        EXPECT_EQ(actual.line_code_unit, expected.line_code_unit);
+        if (i < source.length() && source[i] == u8'\n') {
+            ++expected.line;
+            expected.line_code_unit = 0;
+        }
+        else {
+            ++expected.line_code_unit;
+        }
+        ++expected.code_unit;
+    }
+
+    // Looking up earlier positions is also allowed.
+    EXPECT_EQ(tracker.position(0).line, 0);
+    EXPECT_EQ(tracker.position(source.length()).line, 1000);
+}
+
+TEST(JSON, source_index_skips)
+{
+    std::u8string source(200, u8' ');
+    source[130] = u8'x';
+    source[150] = u8'\\';
+    source[199] = u8'"';
+    const Source_Index index { source, std::pmr::get_default_resource() };
+
+    EXPECT_EQ(index.skip_whitespace(0), 130);
+    EXPECT_EQ(index.skip_whitespace(130), 130);
+    EXPECT_EQ(index.skip_whitespace(131), 150);
+    EXPECT_EQ(index.skip_whitespace(200), 200);
+    EXPECT_EQ(index.find_string_special(0), 150);
+    EXPECT_EQ(index.find_string_special(151), 199);
+    EXPECT_EQ(index.find_string_special(200), 200);
+
+    const std::u8string all_white(100, u8' ');
+    const Source_Index white_index { all_white, std::pmr::get_default_resource() };
+    EXPECT_EQ(white_index.skip_whitespace(0), 100);
+    EXPECT_EQ(white_index.find_string_special(0), 100);
+}
+
+struct Position_Visitor final : JSON_Visitor {
+    std::vector<Source_Position> positions;
+
+    void push_object(const Source_Position& pos) final
+    {
+        positions.push_back(pos);
+    }
+    void pop_object(const Source_Position& pos) final
+    {
+        positions.push_back(pos);
+    }
+    void block_comment(const Source_Position& pos, std::u8string_view comment) final
+    {
+        EXPECT_EQ(comment, u8"/* c */");
+        positions.push_back(pos);
+    }
+};
+
+TEST(JSON, parse_positions)
+{
+    std::u8string source = u8"{\"k\": \"";
+    source.append(100, u8'v');
+    source += u8"\",\n  /* c */ \"o\":\n{ }\n}";
+
+    Position_Visitor visitor;
+    ASSERT_TRUE(parse_json(visitor, source, { .allow_comments = true }));
+    ASSERT_EQ(visitor.positions.size(), 5);
+
+    const auto expect_position = [&](std::size_t i, std::size_t line, std::size_t column) {
+        EXPECT_EQ(visitor.positions[i].line, line) << i;
+        EXPECT_EQ(visitor.positions[i].line_code_unit, column) << i;
+        EXPECT_EQ(source[visitor.positions[i].code_unit - column - 1], u8'\n') << i;
+    };
+    EXPECT_EQ(visitor.positions[0].code_unit, 0);
+    expect_position(1, 1, 2);
+    expect_position(2, 2, 0);
+    expect_position(3, 2, 2);
+    expect_position(4, 3, 0);
+}
+
+TEST(JSON, dom_values)
+{
+    std::vector<char8_t> source;
+    ASSERT_TRUE(load_utf8_file_or_error(source, "test/json/values.json"));
+
+    JSON_Document document;
+    ASSERT_TRUE(document.parse({ source.data(), source.size() }));
+    const JSON_Value& root = document.root();
+    ASSERT_EQ(root.type(), JSON_Type::object);
+    EXPECT_EQ(root.as_object().size(), 8);
+
+    EXPECT_EQ(root.find(u8"string")->as_string(), u8"str\"ing");
+    EXPECT_EQ(root.find(u8"int")->as_number(), 123.0);
+    EXPECT_EQ(root.find(u8"float")->as_number(), 123.125);
+    EXPECT_TRUE(root.find(u8"null")->is_null());
+    EXPECT_TRUE(root.find(u8"true")->as_boolean());
+    EXPECT_FALSE(root.find(u8"false")->as_boolean());
+    EXPECT_TRUE(root.find(u8"object")->as_object().empty());
+    EXPECT_TRUE(root.find(u8"array")->as_array().empty());
+    EXPECT_EQ(root.find(u8"missing"), nullptr);
+    EXPECT_EQ(root.find(std::size_t(0)), nullptr);
+}
+
+TEST(JSON, dom_strings)
+{
+    constexpr std::u8string_view source = u8R"(["plain", "escöaped", "\n", ""])";
+    std::pmr::monotonic_buffer_resource arena;
+    JSON_Value root;
+    ASSERT_TRUE(parse_json_dom(root, source, &arena));
+
+    const std::span<const JSON_Value> elements = root.as_array();
+    ASSERT_EQ(elements.size(), 4);
+    EXPECT_EQ(elements[0].as_string(), u8"plain");
+    // Strings without escape sequences are not copied.
+    EXPECT_EQ(elements[0].as_string().data(), source.data() + 2);
+    EXPECT_EQ(elements[1].as_string(), u8"escöaped");
+    EXPECT_EQ(elements[2].as_string(), u8"\n");
+    EXPECT_EQ(elements[3].as_string(), u8"");
+    EXPECT_EQ(root.find(std::size_t(3)), &elements[3]);
+    EXPECT_EQ(root.find(std::size_t(4)), nullptr);
+}
+
+TEST(JSON, dom_surrogates)
+{
+    constexpr std::u8string_view source
+        = u8R"(["\ud83d\ude00", "a\ud83db", "\ude00", "\ud83d", "\ud83d\ud83d\ude00"])";
+    std::pmr::monotonic_buffer_resource arena;
+    JSON_Value root;
+    ASSERT_TRUE(parse_json_dom(root, source, &arena));
+
+    const std::span<const JSON_Value> elements = root.as_array();
+    ASSERT_EQ(elements.size(), 5);
+    // Surrogate pairs are combined into one code point,
+    // and lone surrogates are replaced with U+FFFD REPLACEMENT CHARACTER.
+    EXPECT_EQ(elements[0].as_string(), u8"😀");
+    EXPECT_EQ(elements[1].as_string(), u8"a\uFFFDb");
+    EXPECT_EQ(elements[2].as_string(), u8"\uFFFD");
+    EXPECT_EQ(elements[3].as_string(), u8"\uFFFD");
+    EXPECT_EQ(elements[4].as_string(), u8"\uFFFD😀");
+}
+
+TEST(JSON, dom_pointer)
+{
+    // https://datatracker.ietf.org/doc/html/rfc6901#section-5
+    constexpr std::u8string_view source = u8R"({
+        "foo": ["bar", "baz"],
+        "": 0,
+        "a/b": 1,
+        "c%d": 2,
+        "e^f": 3,
+        "g|h": 4,
+        "i\\j": 5,
+        "k\"l": 6,
+        " ": 7,
+        "m~n": 8
+    })";
+    JSON_Document document;
+    ASSERT_TRUE(document.parse(source));
+    const JSON_Value& root = document.root();
+
+    EXPECT_EQ(root.find_pointer(u8""), &root);
+    EXPECT_EQ(root.find_pointer(u8"/foo"), root.find(u8"foo"));
+    EXPECT_EQ(root.find_pointer(u8"/foo/0")->as_string(), u8"bar");
+    EXPECT_EQ(root.find_pointer(u8"/foo/1")->as_string(), u8"baz");
+    EXPECT_EQ(root.find_pointer(u8"/")->as_number(), 0);
+    EXPECT_EQ(root.find_pointer(u8"/a~1b")->as_number(), 1);
+    EXPECT_EQ(root.find_pointer(u8"/c%d")->as_number(), 2);
+    EXPECT_EQ(root.find_pointer(u8"/e^f")->as_number(), 3);
+    EXPECT_EQ(root.find_pointer(u8"/g|h")->as_number(), 4);
+    EXPECT_EQ(root.find_pointer(u8"/i\\j")->as_number(), 5);
+    EXPECT_EQ(root.find_pointer(u8"/k\"l")->as_number(), 6);
+    EXPECT_EQ(root.find_pointer(u8"/ ")->as_number(), 7);
+    EXPECT_EQ(root.find_pointer(u8"/m~0n")->as_number(), 8);
+
+    EXPECT_EQ(root.find_pointer(u8"foo"), nullptr);
+    EXPECT_EQ(root.find_pointer(u8"/foo/2"), nullptr);
+    EXPECT_EQ(root.find_pointer(u8"/foo/-"), nullptr);
+    EXPECT_EQ(root.find_pointer(u8"/foo/01"), nullptr);
+    EXPECT_EQ(root.find_pointer(u8"/foo/0/x"), nullptr);
+    EXPECT_EQ(root.find_pointer(u8"/m~2n"), nullptr);
+    EXPECT_EQ(root.find_pointer(u8"/m~"), nullptr);
+}
+
+TEST(JSON, dom_nested)
+{
+    JSON_Document document;
+    ASSERT_TRUE(document.parse(u8R"({"a": [[1, {"b": [true]}], {}], "c": {"d": null}})"));
+    const JSON_Value& root = document.root();
+    EXPECT_TRUE(root.find_pointer(u8"/a/0/1/b/0")->as_boolean());
+    EXPECT_EQ(root.find_pointer(u8"/a/0/0")->as_number(), 1);
+    EXPECT_TRUE(root.find_pointer(u8"/a/1")->as_object().empty());
+    EXPECT_TRUE(root.find_pointer(u8"/c/d")->is_null());
+
+    // Parsing again releases the previous document.
+    ASSERT_TRUE(document.parse(u8"[]"));
+    EXPECT_TRUE(document.root().as_array().empty());
+}
+
+TEST(JSON, dom_ignores_parse_integers)
+{
+    // Integers are stored as numbers, even if the options ask for integers to be parsed.
+    JSON_Document document;
+    ASSERT_TRUE(document.parse(u8R"({"a": 1, "b": [-2, 3.5]})", { .parse_integers = true }));
+    const JSON_Value& root = document.root();
+    ASSERT_EQ(root.as_object().size(), 2);
+    EXPECT_EQ(root.find(u8"a")->as_number(), 1);
+    EXPECT_EQ(root.find_pointer(u8"/b/0")->as_number(), -2);
+    EXPECT_EQ(root.find_pointer(u8"/b/1")->as_number(), 3.5);
+}
+
+TEST(JSON, dom_error)
+{
+    JSON_Document document;
+    JSON_Error_Info error {};
+    EXPECT_FALSE(document.parse(u8"{\n  \"a\": [1, 2", {}, &error));
+    EXPECT_EQ(error.error, JSON_Error::unterminated_array);
+    EXPECT_EQ(error.pos.line, 1);
+
+    EXPECT_FALSE(document.parse(u8"{0: 1}", {}, &error));
+    EXPECT_EQ(error.error, JSON_Error::illegal_character);
+    EXPECT_FALSE(document.parse(u8"  ", {}, &error));
+
+    EXPECT_FALSE(document.parse(u8"// comment\n{}", {}, &error));
+    EXPECT_EQ(error.pos.code_unit, 0);
+    EXPECT_TRUE(document.parse(u8"// comment\n{}", { .allow_comments = true }));
+}
+
+TEST(JSON, cursor_find)
+{
+    // The skipped values contain brackets and escaped quotes within strings.
+    constexpr std::u8string_view source = u8R"( {
+        "skip": {"a": "}]\"[{", "b": [[], {"c": "\\"}]},
+        "x\ty": [1, -2.5e1, "s", true, false, null],
+        "key": "v\nä"
+    } )";
+    const JSON_On_Demand document { source, { .escapes = Escape_Parsing::parse } };
+    const JSON_Cursor root = document.root();
+    ASSERT_TRUE(root);
+    EXPECT_EQ(root.type(), JSON_Type::object);
+    EXPECT_EQ(root.offset(), 1);
+
+    const JSON_Cursor array = root.find(u8"x\ty");
+    ASSERT_TRUE(array);
+    EXPECT_EQ(array.raw(), u8R"([1, -2.5e1, "s", true, false, null])");
+    EXPECT_EQ(array.find(0).get_number(), 1);
+    EXPECT_EQ(array.find(1).get_number(), -25);
+    EXPECT_EQ(array.find(2).get_raw_string(), u8"s");
+    EXPECT_EQ(array.find(3).get_boolean(), true);
+    EXPECT_EQ(array.find(4).get_boolean(), false);
+    EXPECT_TRUE(array.find(5).is_null());
+    EXPECT_FALSE(array.find(6));
+
+    std::u8string string;
+    ASSERT_TRUE(root.find(u8"key").get_string(string));
+    EXPECT_EQ(std::u8string_view { string }, u8"v\nä");
+
+    EXPECT_EQ(root.find(u8"skip").find(u8"a").get_raw_string(), u8R"(}]\"[{)");
+    EXPECT_EQ(root.find(u8"skip").find(u8"b").find(1).find(u8"c").get_raw_string(), u8R"(\\)");
+    EXPECT_FALSE(root.find(u8"missing"));
+    EXPECT_FALSE(root.find(u8"skip").find(0));
+    EXPECT_FALSE(array.find(u8"key"));
+    EXPECT_FALSE(array.find(2).get_number());
+}
+
+TEST(JSON, cursor_surrogates)
+{
+    constexpr std::u8string_view source = u8R"({
+        "\ud83d\ude00": "a\ud83d\ude00b",
+        "lone": ["\ud83d", "\ude00x", "\ud83d\u0041"]
+    })";
+    const JSON_On_Demand document { source, { .escapes = Escape_Parsing::parse } };
+    const JSON_Cursor root = document.root();
+
+    // Escaped surrogate pairs in keys are compared as the code point they represent.
+    const JSON_Cursor value = root.find(u8"😀");
+    ASSERT_TRUE(value);
+    std::u8string string;
+    ASSERT_TRUE(value.get_string(string));
+    EXPECT_EQ(std::u8string_view { string }, u8"a😀b");
+    EXPECT_FALSE(root.find(u8"\uFFFD"));
+
+    // Lone surrogates are replaced with U+FFFD REPLACEMENT CHARACTER.
+    const JSON_Cursor lone = root.find(u8"lone");
+    const std::u8string_view expected[] { u8"\uFFFD", u8"\uFFFDx", u8"\uFFFDA" };
+    for (std::size_t i = 0; i < std::size(expected); ++i) {
+        string.clear();
+        ASSERT_TRUE(lone.find(i).get_string(string));
+        EXPECT_EQ(std::u8string_view { string }, expected[i]);
+    }
+}
+
+TEST(JSON, cursor_iteration)
+{
+    const JSON_On_Demand document { u8R"({"a": [ ], "b": [{}, [1], "]"], "c": {"d": 1, "e": 2}})" };
+    const JSON_Cursor root = document.root();
+
+    std::vector<std::u8string_view> keys;
+    for (const JSON_Member_Cursor member : root.members()) {
+        keys.push_back(*member.key.get_raw_string());
+    }
+    EXPECT_EQ(keys, (std::vector<std::u8string_view> { u8"a", u8"b", u8"c" }));
+
+    EXPECT_EQ(root.find(u8"a").elements().begin(), std::default_sentinel);
+    EXPECT_EQ(root.find(u8"c").find(u8"e").get_number(), 2);
+
+    std::vector<std::u8string_view> elements;
+    for (const JSON_Cursor element : root.find(u8"b").elements()) {
+        elements.push_back(element.raw());
+    }
+    EXPECT_EQ(elements, (std::vector<std::u8string_view> { u8"{}", u8"[1]", u8R"("]")" }));
+}
+
+TEST(JSON, cursor_comments)
+{
+    constexpr std::u8string_view source = u8R"(// leading
+    {
+        "a": /* } */ [1, // ]
+            2],
+        "b": 3 /* trailing */
+    })";
+    const JSON_On_Demand document { source, { .allow_comments = true } };
+    const JSON_Cursor root = document.root();
+    ASSERT_TRUE(root);
+    EXPECT_EQ(root.find(u8"a").find(1).get_number(), 2);
+    EXPECT_EQ(root.find(u8"b").get_number(), 3);
+}
+
+TEST(JSON, cursor_parse)
+{
+    const JSON_On_Demand document { u8R"({"skip": [1, 2], "value": {"x": [true, "A"]}})" };
+    const JSON_Cursor value = document.root().find(u8"value");
+
+    constexpr JSON_Options options { .parse_numbers = true,
+                                     .escapes = Escape_Parsing::parse_encode };
+    Test_Visitor visitor;
+    ASSERT_TRUE(json::parse_json_value(visitor, document.index(), value.offset(), options));
+    EXPECT_EQ(visitor.root_value, (Object { { u8"x", Array { true, u8"A" } } }));
+
+    Position_Visitor position_visitor;
+    ASSERT_TRUE(value.parse(position_visitor));
+    ASSERT_EQ(position_visitor.positions.size(), 2);
+    EXPECT_EQ(position_visitor.positions[0].code_unit, value.offset());
+
+    const JSON_On_Demand malformed { u8R"({"a": [1, }, "b": 2})" };
+    EXPECT_FALSE(malformed.root().find(u8"a").parse(position_visitor));
+    EXPECT_FALSE(JSON_On_Demand { u8"  " }.root());
+}
+
+/// @brief Counts values without deriving from `JSON_Visitor`.
+struct Counting_Visitor : JSON_Static_Visitor {
+    std::size_t values = 0;
+    std::size_t max_depth = 0;
+    std::size_t depth = 0;
+    std::size_t errors = 0;
+
+    using JSON_Static_Visitor::number;
+
+    void number(const Source_Position&, std::u8string_view)
+    {
+        ++values;
+    }
+    void null(const Source_Position&)
+    {
+        ++values;
+    }
+    void boolean(const Source_Position&, bool)
+    {
+        ++values;
+    }
+    void push_string(const Source_Position&)
+    {
+        ++values;
+    }
+    void push_object(const Source_Position&)
+    {
+        push();
+    }
+    void pop_object(const Source_Position&)
+    {
+        --depth;
+    }
+    void push_array(const Source_Position&)
+    {
+        push();
+    }
+    void pop_array(const Source_Position&)
+    {
+        --depth;
+    }
+    Error_Reaction error(const Source_Position&, JSON_Error)
+    {
+        ++errors;
+        return Error_Reaction::abort;
+    }
+
+private:
+    void push()
+    {
+        ++values;
+        max_depth = std::max(max_depth, ++depth);
+    }
+};
+
+TEST(JSON, parse_static)
+{
+    Counting_Visitor visitor;
+    ASSERT_TRUE(parse_json(visitor, u8R"({"a": [1, "b", null, {"c": [true]}], "d": false})"));
+    EXPECT_EQ(visitor.values, 9);
+    EXPECT_EQ(visitor.max_depth, 4);
+    EXPECT_EQ(visitor.depth, 0);
+    EXPECT_EQ(visitor.errors, 0);
+
+    Counting_Visitor failing_visitor;
+    EXPECT_FALSE(parse_json(failing_visitor, u8R"([1, 2)"));
+    EXPECT_EQ(failing_visitor.errors, 1);
+}
+
+TEST(JSON, parse_static_matches_virtual)
+{
+    const std::u8string_view source
+        = u8R"({"k": [1.5, "x\u0041", true, null], /* c */ "o": {"n": -2e3}})";
+    constexpr JSON_Options options { .allow_comments = true,
+                                     .parse_numbers = true,
+                                     .escapes = Escape_Parsing::parse_encode };
+
+    Test_Visitor static_visitor;
+    ASSERT_TRUE(parse_json(static_visitor, source, options));
+    Test_Visitor virtual_visitor;
+    ASSERT_TRUE(parse_json(static_cast<JSON_Visitor&>(virtual_visitor), source, options));
+
+    EXPECT_EQ(static_visitor.root_value, virtual_visitor.root_value);
+    EXPECT_EQ(static_visitor.block_comment_count, 1);
+    EXPECT_EQ(virtual_visitor.block_comment_count, 1);
+}
+
+TEST(JSON, parse_number_value)
+{
+    const auto expect_strtod = [](std::string_view number) {
+        const std::string terminated { number };
+        const double expected = std::strtod(terminated.c_str(), nullptr);
+        const std::u8string_view u8number { reinterpret_cast<const char8_t*>(number.data()),
+                                            number.length() };
+        const std::optional<double> actual = parse_number_value(u8number);
+        ASSERT_TRUE(actual) << number;
+        // Bitwise comparison also distinguishes -0.0 from 0.0.
+        EXPECT_EQ(std::bit_cast<std::uint64_t>(*actual), std::bit_cast<std::uint64_t>(expected))
+            << number;
+    };
+    for (const std::string_view number :
+         { "0", "-0", "-0.0", "1", "-1", "0.1", "0.3", "1e22", "1e23", "9007199254740993",
+           "123456789012345678901234567890", "2.2250738585072011e-308", "4.9e-324", "1e-400",
+           "-1e400", "1.7976931348623157e308", "0.000000000000000000000000000001234",
+           "3.14159265358979323846264338327950288", "1E+2", "5e-1" }) {
+        expect_strtod(number);
+    }
+
+    // Random numbers cover both the exact fast path and the correctly rounded fallback.
+    std::default_random_engine rng { 12345 };
+    std::uniform_int_distribution<int> digit_count { 1, 25 };
+    std::uniform_int_distribution<int> digit { 0, 9 };
+    std::uniform_int_distribution<int> exponent { -330, 330 };
+    for (int i = 0; i < 10000; ++i) {
+        std::string number = i % 2 == 0 ? "-" : "";
+        const int digits = digit_count(rng);
+        const int point = std::uniform_int_distribution<int> { 1, digits }(rng);
+        for (int d = 0; d < digits; ++d) {
+            number += char('0' + digit(rng));
+            if (d + 1 == point && d + 1 != digits) {
+                number += '.';
+            }
+        }
+        if (i % 3 == 0) {
+            number += 'e' + std::to_string(exponent(rng) / (i % 4 == 0 ? 10 : 1));
+        }
+        expect_strtod(number);
+    }
+}
+
+/// @brief Collects integers and the remaining numbers separately.
+struct Integer_Visitor : JSON_Static_Visitor {
+    std::vector<JSON_Integer> integers;
+    std::vector<double> numbers;
+
+    using JSON_Static_Visitor::number;
+
+    void integer(const Source_Position&, std::u8string_view, JSON_Integer value)
+    {
+        integers.push_back(value);
+    }
+    void number(const Source_Position&, std::u8string_view, double value)
+    {
+        numbers.push_back(value);
+    }
+};
+
+TEST(JSON, parse_integers)
+{
+    Integer_Visitor visitor;
+    const std::u8string_view source
+        = u8"[0, -0, 42, -42, 1.0, 1e2, 9223372036854775807, -9223372036854775808, "
+          u8"18446744073709551615, 18446744073709551616, -9223372036854775809]";
+    ASSERT_TRUE(parse_json(visitor, source, { .parse_numbers = true, .parse_integers = true }));
+
+    ASSERT_EQ(visitor.integers.size(), 6);
+    EXPECT_EQ(visitor.integers[0], (JSON_Integer { .magnitude = 0, .negative = false }));
+    EXPECT_EQ(visitor.integers[1].as_int64(), 42);
+    EXPECT_EQ(visitor.integers[2].as_int64(), -42);
+    EXPECT_TRUE(visitor.integers[3].is_int64());
+    EXPECT_EQ(visitor.integers[3].as_int64(), INT64_MAX);
+    EXPECT_TRUE(visitor.integers[4].is_int64());
+    EXPECT_EQ(visitor.integers[4].as_int64(), INT64_MIN);
+    EXPECT_FALSE(visitor.integers[5].is_int64());
+    EXPECT_TRUE(visitor.integers[5].is_uint64());
+    EXPECT_EQ(visitor.integers[5].as_uint64(), UINT64_MAX);
+
+    // -0, fractions, exponents, and integers out of range are still numbers.
+    ASSERT_EQ(visitor.numbers.size(), 5);
+    EXPECT_TRUE(std::signbit(visitor.numbers[0]));
+    EXPECT_EQ(visitor.numbers[1], 1.0);
+    EXPECT_EQ(visitor.numbers[2], 100.0);
+    EXPECT_EQ(visitor.numbers[3], 18446744073709551616.0);
+    EXPECT_EQ(visitor.numbers[4], -9223372036854775809.0);
+
+    const JSON_On_Demand document { source };
+    EXPECT_EQ(document.root().find(3).get_integer()->as_int64(), -42);
+    EXPECT_EQ(document.root().find(4).get_integer(), std::nullopt);
+    EXPECT_EQ(document.root().find(8).get_integer()->as_uint64(), UINT64_MAX);
+}
+
+/// @brief Recovers from all errors, and records them along with all numbers and brackets.
+struct Recovering_Visitor : JSON_Static_Visitor {
+    std::vector<JSON_Error_Info> errors;
+    std::vector<std::int64_t> integers;
+    std::size_t pushes = 0;
+    std::size_t pops = 0;
+
+    void integer(const Source_Position&, std::u8string_view, JSON_Integer value)
+    {
+        integers.push_back(value.as_int64());
+    }
+    void push_object(const Source_Position&)
+    {
+        ++pushes;
+    }
+    void pop_object(const Source_Position&)
+    {
+        ++pops;
+    }
+    void push_array(const Source_Position&)
+    {
+        ++pushes;
+    }
+    void pop_array(const Source_Position&)
+    {
+        ++pops;
+    }
+    Error_Reaction error(const Source_Position& pos, JSON_Error error)
+    {
+        errors.push_back({ pos, error });
+        return Error_Reaction::recover;
+    }
+};
+
+constexpr JSON_Options recovery_options { .allow_comments = true, .parse_integers = true };
+
+TEST(JSON, parse_recover)
+{
+    const std::u8string_view source
+        = u8R"({"a": tru, "b": 1, "c": [2, @, "x)" u8"\n" u8R"(, 3,], "d" 4, "e": 5})";
+    Recovering_Visitor visitor;
+    EXPECT_FALSE(parse_json(visitor, source, recovery_options));
+
+    EXPECT_EQ(visitor.integers, (std::vector<std::int64_t> { 1, 2, 3, 5 }));
+    EXPECT_EQ(visitor.pushes, 2);
+    EXPECT_EQ(visitor.pops, 2);
+    ASSERT_EQ(visitor.errors.size(), 5);
+    const auto expect_error = [&](std::size_t i, JSON_Error error, std::size_t code_unit) {
+        EXPECT_EQ(visitor.errors[i].error, error) << i;
+        EXPECT_EQ(visitor.errors[i].pos.code_unit, code_unit) << i;
+    };
+    expect_error(0, JSON_Error::illegal_character, source.find(u8"tru"));
+    expect_error(1, JSON_Error::illegal_character, source.find(u8'@'));
+    expect_error(2, JSON_Error::illegal_character, source.find(u8'\n'));
+    expect_error(3, JSON_Error::illegal_character, source.find(u8']'));
+    expect_error(4, JSON_Error::valueless_member, source.find(u8'4'));
+}
+
+TEST(JSON, parse_recover_brackets)
+{
+    Recovering_Visitor mismatched;
+    EXPECT_FALSE(parse_json(mismatched, u8"[[1, 2}, 3] ", recovery_options));
+    EXPECT_EQ(mismatched.integers, (std::vector<std::int64_t> { 1, 2, 3 }));
+    EXPECT_EQ(mismatched.pops, 2);
+    ASSERT_EQ(mismatched.errors.size(), 1);
+    EXPECT_EQ(mismatched.errors[0].pos.code_unit, 6);
+
+    Recovering_Visitor unterminated;
+    EXPECT_FALSE(parse_json(unterminated, u8"{\"a\": [1, {\"b\": 2 /* ", recovery_options));
+    EXPECT_EQ(unterminated.integers, (std::vector<std::int64_t> { 1, 2 }));
+    ASSERT_FALSE(unterminated.errors.empty());
+    EXPECT_EQ(unterminated.errors.front().error, JSON_Error::comment);
+    EXPECT_EQ(unterminated.errors.back().error, JSON_Error::unterminated_object);
+    EXPECT_EQ(unterminated.pops, 0);
+
+    // Recovering from errors in nested values doesn't make the parse succeed.
+    Recovering_Visitor nested;
+    EXPECT_FALSE(parse_json(nested, u8"[[[,]]]", recovery_options));
+    // Both the leading and the trailing comma are erroneous.
+    EXPECT_EQ(nested.errors.size(), 2);
+    EXPECT_EQ(nested.pops, 3);
+}
+
+TEST(JSON, parse_abort_reports_one_error)
+{
+    Counting_Visitor visitor;
+    EXPECT_FALSE(parse_json(visitor, u8R"({"a": tru, "b": @})"));
+    EXPECT_EQ(visitor.errors, 1);
+}
+
+TEST(JSON, parse_trailing_content)
+{
+    EXPECT_FALSE(parse(u8"{} {}"));
+    EXPECT_FALSE(parse(u8"1 2"));
+    EXPECT_EQ(parse(u8"[] \n"), Array {});
+}
+
+constexpr JSON_Lines_Options lines_options { .json = { .parse_numbers = true,
+                                                       .escapes = Escape_Parsing::parse_encode } };
+
+TEST(JSON, parse_lines)
+{
+    const std::u8string_view source = u8"{\"a\": 1}\n\n  \t\n[true, \"x\"]\r\nnull";
+    Test_Visitor visitor;
+    ASSERT_TRUE(parse_json_lines(visitor, source, lines_options));
+    ASSERT_EQ(visitor.records.size(), 3);
+    EXPECT_EQ(visitor.records[0], (Object { { u8"a", 1.0 } }));
+    EXPECT_EQ(visitor.records[1], (Array { true, u8"x" }));
+    EXPECT_EQ(visitor.records[2], Null {});
+
+    ASSERT_EQ(visitor.record_positions.size(), 3);
+    EXPECT_EQ(visitor.record_positions[1].line, 3);
+    EXPECT_EQ(visitor.record_positions[1].code_unit, source.find(u8'['));
+    EXPECT_EQ(visitor.record_positions[2].line, 4);
+}
+
+TEST(JSON, parse_lines_errors_are_isolated)
+{
+    Test_Visitor visitor;
+    EXPECT_FALSE(parse_json_lines(visitor, u8"[1]\n{\"a\": \n2 3\n\"s\"\n", lines_options));
+    ASSERT_EQ(visitor.records.size(), 4);
+    EXPECT_EQ(visitor.records[0], Array { 1.0 });
+    EXPECT_EQ(visitor.records[1], std::nullopt);
+    EXPECT_EQ(visitor.records[2], std::nullopt);
+    EXPECT_EQ(visitor.records[3], u8"s");
+}
+
+TEST(JSON, parse_lines_threads)
+{
+    // Large enough for several batches, so that every thread receives work.
+    std::u8string source;
+    std::default_random_engine rng { 12345 };
+    std::uniform_int_distribution<int> distribution { 0, 999 };
+    for (std::size_t i = 0; i < 20000; ++i) {
+        const int n = distribution(rng);
+        if (n % 97 == 0) {
+            source += u8"{\"broken\": [\n";
+            continue;
+        }
+        const std::string id = std::to_string(n);
+        source += u8"{\"id\": ";
+        source.append(id.begin(), id.end());
+        source += u8", \"tags\": [\"a\", null]}\n";
+    }
+
+    Test_Visitor sequential;
+    const bool sequential_success = parse_json_lines(sequential, source, lines_options);
+    Test_Visitor parallel;
+    JSON_Lines_Options parallel_options = lines_options;
+    parallel_options.threads = 4;
+    const bool parallel_success = parse_json_lines(parallel, source, parallel_options);
+
+    EXPECT_FALSE(sequential_success);
+    EXPECT_EQ(sequential_success, parallel_success);
+    ASSERT_EQ(sequential.records.size(), 20000);
+    EXPECT_EQ(sequential.records, parallel.records);
+    ASSERT_EQ(sequential.record_positions.size(), parallel.record_positions.size());
+    for (std::size_t i = 0; i < sequential.record_positions.size(); ++i) {
+        EXPECT_EQ(
+            sequential.record_positions[i].code_unit, parallel.record_positions[i].code_unit
+        );
+        EXPECT_EQ(sequential.record_positions[i].line, i);
+        EXPECT_EQ(parallel.record_positions[i].line, i);
+    }
+}
+
+struct Schema_Test {
+    JSON_Document schema_document;
+    JSON_Schema schema;
+    std::vector<JSON_Schema_Violation> violations;
+    /// @brief The keys of `violations`, copied since they are only valid during the callback.
+    std::vector<std::u8string> properties;
+
+    [[nodiscard]]
+    explicit Schema_Test(std::u8string_view schema_source)
+    {
+        const bool parsed = schema_document.parse(schema_source);
+        const bool compiled = schema.compile(schema_document.root());
+        EXPECT_TRUE(parsed && compiled);
+    }
+
+    bool validate(std::u8string_view source, JSON_Options options = {})
+    {
+        violations.clear();
+        properties.clear();
+        const auto on_violation = [&](const JSON_Schema_Violation& v) {
+            violations.push_back(v);
+            properties.emplace_back(v.property);
+        };
+        return validate_json(source, schema, on_violation, options);
+    }
+};
+
+constexpr std::u8string_view person_schema = u8R"({
+    "type": "object",
+    "properties": {
+        "name": { "type": "string" },
+        "age": { "type": "integer", "minimum": 0, "exclusiveMaximum": 150 },
+        "role": { "enum": ["admin", "user", null] },
+        "tags": { "type": "array", "items": { "type": "string" }, "maxItems": 2 }
+    },
+    "required": ["name", "age"],
+    "additionalProperties": false
+})";
+
+TEST(JSON, schema_compile)
+{
+    JSON_Document document;
+    JSON_Schema schema;
+
+    const auto compiles = [&](std::u8string_view source) {
+        EXPECT_TRUE(document.parse(source));
+        return schema.compile(document.root());
+    };
+    EXPECT_TRUE(compiles(u8"true"));
+    EXPECT_TRUE(compiles(u8"{}"));
+    EXPECT_TRUE(compiles(person_schema));
+    EXPECT_TRUE(compiles(u8R"({"title": "ignored", "pattern": "ignored"})"));
+
+    EXPECT_FALSE(compiles(u8"1"));
+    EXPECT_FALSE(compiles(u8R"({"type": "decimal"})"));
+    EXPECT_FALSE(compiles(u8R"({"minItems": -1})"));
+    EXPECT_FALSE(compiles(u8R"({"items": [{}, {}]})"));
+    EXPECT_FALSE(compiles(u8R"({"additionalProperties": {"type": "string"}})"));
+    EXPECT_FALSE(compiles(u8R"({"enum": [[1]]})"));
+    // A failed compilation leaves a schema which accepts anything.
+    EXPECT_EQ(schema.root().types, JSON_Schema_Node::all_types);
+    EXPECT_TRUE(schema.root().properties.empty());
+
+    // The schema does not refer to the document it was compiled from.
+    ASSERT_TRUE(compiles(person_schema));
+    EXPECT_TRUE(document.parse(u8"null"));
+    ASSERT_EQ(schema.root().properties.size(), 4);
+    EXPECT_EQ(schema.root().properties[0].key, u8"age");
+    EXPECT_TRUE(schema.root().properties[0].required);
+    EXPECT_EQ(schema.root().properties[2].schema->enumeration[0].as_string(), u8"admin");
+}
+
+TEST(JSON, schema_valid)
+{
+    Schema_Test test { person_schema };
+    EXPECT_TRUE(test.validate(u8R"({"name": "Jo", "age": 30})"));
+    EXPECT_TRUE(test.validate(u8R"({"age": 0, "name": "Jo", "role": null, "tags": ["x"]})"));
+    EXPECT_TRUE(test.validate(u8R"({"age": 1.0e2, "name": "", "role": "admin"})"));
+    EXPECT_TRUE(test.violations.empty());
+}
+
+TEST(JSON, schema_violations)
+{
+    Schema_Test test { person_schema };
+    constexpr std::u8string_view source = u8R"({
+    "name": 5,
+    "age": 150,
+    "role": "guest",
+    "tags": ["a", 1, "c"],
+    "extra": {}
+})";
+    EXPECT_FALSE(test.validate(source));
+
+    using enum JSON_Schema_Error;
+    const std::vector<JSON_Schema_Error> expected {
+        type, maximum, enumeration, type, max_items, additional_property,
+    };
+    ASSERT_EQ(test.violations.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(test.violations[i].error, expected[i]);
+    }
+    EXPECT_EQ(test.violations[0].pos.line, 1);
+    EXPECT_EQ(test.violations[0].pos.code_unit, source.find(u8'5'));
+    EXPECT_EQ(test.violations[3].pos.code_unit, source.find(u8", 1,") + 2);
+    EXPECT_EQ(test.violations[4].pos.code_unit, source.find(u8'['));
+    EXPECT_EQ(test.violations[5].pos.code_unit, source.find(u8"\"extra\""));
+    EXPECT_EQ(std::u8string_view { test.properties[5] }, u8"extra");
+}
+
+TEST(JSON, schema_required_and_numbers)
+{
+    Schema_Test test { person_schema };
+    EXPECT_FALSE(test.validate(u8R"({"age": -1.5})"));
+    using enum JSON_Schema_Error;
+    ASSERT_EQ(test.violations.size(), 3);
+    EXPECT_EQ(test.violations[0].error, type);
+    EXPECT_EQ(test.violations[1].error, minimum);
+    EXPECT_EQ(test.violations[2].error, missing_property);
+    EXPECT_EQ(test.violations[2].pos.code_unit, 0);
+    EXPECT_EQ(std::u8string_view { test.properties[2] }, u8"name");
+
+    Schema_Test bounds { u8R"({"type": "array", "minItems": 2,
+        "items": {"minimum": 1, "exclusiveMinimum": true, "maximum": 3}})" };
+    EXPECT_TRUE(bounds.validate(u8"[2, 3]"));
+    EXPECT_FALSE(bounds.validate(u8"[1]"));
+    ASSERT_EQ(bounds.violations.size(), 2);
+    EXPECT_EQ(bounds.violations[0].error, minimum);
+    EXPECT_EQ(bounds.violations[1].error, min_items);
+}
+
+TEST(JSON, schema_surrogates)
+{
+    // Escaped surrogate pairs are equal to the code point they represent,
+    // both in the schema and in the instance.
+    Schema_Test test { u8R"({
+        "properties": { "😀": { "enum": ["\ud83d\ude00", "😀x"] } },
+        "additionalProperties": false
+    })" };
+    EXPECT_TRUE(test.validate(u8R"({"\ud83d\ude00": "😀"})"));
+    EXPECT_TRUE(test.validate(u8R"({"😀": "\ud83d\ude00x"})"));
+
+    EXPECT_FALSE(test.validate(u8R"({"😀": "\ud83d"})"));
+    ASSERT_EQ(test.violations.size(), 1);
+    EXPECT_EQ(test.violations[0].error, JSON_Schema_Error::enumeration);
+
+    EXPECT_FALSE(test.validate(u8R"({"\ude00\ud83d": null})"));
+    ASSERT_EQ(test.violations.size(), 1);
+    EXPECT_EQ(test.violations[0].error, JSON_Schema_Error::additional_property);
+    EXPECT_EQ(std::u8string_view { test.properties[0] }, u8"\uFFFD\uFFFD");
+}
+
+TEST(JSON, schema_fused_with_visitor)
+{
+    Schema_Test test { u8R"({"items": {"type": ["number", "null"], "const": 1}})" };
+    const auto on_violation = [&](const JSON_Schema_Violation& v) { test.violations.push_back(v); };
+
+    // The validator forwards every event, so the document is validated and built in one pass.
+    Test_Visitor next;
+    JSON_Schema_Validator validator { test.schema, on_violation, &next };
+    EXPECT_TRUE(parse_json(validator, u8"[1, null, 2]", lines_options.json));
+    EXPECT_FALSE(validator.valid());
+    EXPECT_EQ(next.root_value, (Array { 1.0, null, 2.0 }));
+    ASSERT_EQ(test.violations.size(), 2);
+    EXPECT_EQ(test.violations[0].error, JSON_Schema_Error::enumeration);
+    EXPECT_EQ(test.violations[0].pos.code_unit, 4);
+    EXPECT_EQ(test.violations[1].pos.code_unit, 10);
+}
+
+TEST(JSON, schema_lines)
+{
+    Schema_Test test { u8R"({"required": ["id"], "properties": {"id": {"type": "integer"}}})" };
+    std::vector<std::size_t> lines;
+    const auto on_violation = [&](const JSON_Schema_Violation& v) { lines.push_back(v.pos.line); };
+
+    JSON_Schema_Validator validator { test.schema, on_violation };
+    EXPECT_FALSE(parse_json_lines(validator, u8"{\"id\": 1}\n{\"x\": [\n{}\n{\"id\": 1.5}\n"));
+    EXPECT_EQ(lines, (std::vector<std::size_t> { 2, 3 }));
+}
+
 } // namespace
 } // namespace ulight::json
@@ -0,0 +1,73 @@
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "ulight/impl/lang/lua.hpp"
+
+namespace ulight::lua {
+namespace {
+
+constexpr auto npos = std::u8string_view::npos;
+
+TEST(Lua, match_opening_long_bracket)
+{
+    EXPECT_EQ(match_opening_long_bracket(u8""), 0);
+    EXPECT_EQ(match_opening_long_bracket(u8"["), 0);
+    EXPECT_EQ(match_opening_long_bracket(u8"[="), 0);
+    EXPECT_EQ(match_opening_long_bracket(u8"[=x"), 0);
+    EXPECT_EQ(match_opening_long_bracket(u8"x[["), 0);
+
+    EXPECT_EQ(match_opening_long_bracket(u8"[["), 2);
+    EXPECT_EQ(match_opening_long_bracket(u8"[=[x"), 3);
+    EXPECT_EQ(match_opening_long_bracket(u8"[===[x"), 5);
+}
+
+TEST(Lua, find_closing_long_bracket)
+{
+    EXPECT_EQ(find_closing_long_bracket(u8"", 0), npos);
+    EXPECT_EQ(find_closing_long_bracket(u8"]", 0), npos);
+    EXPECT_EQ(find_closing_long_bracket(u8"]=]", 0), npos);
+    EXPECT_EQ(find_closing_long_bracket(u8"]]", 1), npos);
+    EXPECT_EQ(find_closing_long_bracket(u8"]==]", 1), npos);
+    EXPECT_EQ(find_closing_long_bracket(u8"]==", 2), npos);
+
+    EXPECT_EQ(find_closing_long_bracket(u8"]]", 0), 0);
+    EXPECT_EQ(find_closing_long_bracket(u8"]=]]", 0), 2);
+    EXPECT_EQ(find_closing_long_bracket(u8"]]=]", 1), 1);
+    EXPECT_EQ(find_closing_long_bracket(u8"]=]==]", 2), 2);
+    EXPECT_EQ(find_closing_long_bracket(u8"]]]]", 0, 1), 1);
+
+    // The closing bracket is found in blocks, so it needs to be found at any position.
+    const std::u8string_view text = u8"abcdefghijklmnopqrstuvwxyz0123456789]=]";
+    for (std::size_t i = 0; i + 3 <= text.length(); ++i) {
+        EXPECT_EQ(find_closing_long_bracket(text.substr(i), 1), text.length() - 3 - i);
+    }
+}
+
+TEST(Lua, match_block_comment)
+{
+    EXPECT_FALSE(match_block_comment(u8"-- [[x]]"));
+    EXPECT_FALSE(match_block_comment(u8"--[=x"));
+
+    const Comment_Result comment = match_block_comment(u8"--[==[ ]] ]=] ]==] x");
+    EXPECT_EQ(comment.length, 18);
+    EXPECT_TRUE(comment.is_terminated);
+
+    const Comment_Result unterminated = match_block_comment(u8"--[[ ]=]");
+    EXPECT_EQ(unterminated.length, 8);
+    EXPECT_FALSE(unterminated.is_terminated);
+}
+
+TEST(Lua, match_string_literal_long)
+{
+    const String_Literal_Result string = match_string_literal(u8"[=[ ]] ]=] x");
+    EXPECT_EQ(string.length, 10);
+    EXPECT_TRUE(string.is_long_string);
+    EXPECT_TRUE(string.terminated);
+
+    EXPECT_FALSE(match_string_literal(u8"[ [[x]]"));
+    EXPECT_FALSE(match_string_literal(u8"[=x"));
+}
+
+} // namespace
+} // namespace ulight::lua
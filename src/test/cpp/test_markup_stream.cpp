@@ -0,0 +1,274 @@
+#include <cstddef>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ulight/ulight.hpp"
+
+#include "ulight/impl/buffer.hpp"
+#include "ulight/impl/highlight.hpp"
+#include "ulight/impl/lang/html.hpp"
+#include "ulight/impl/lang/xml.hpp"
+
+namespace ulight::html {
+namespace {
+
+constexpr std::u8string_view html_block = u8R"(<!DOCTYPE html>
+<html lang="en">
+<head><title>Fish &amp; Chips &lt;3</title>
+<style>p { color: red; }
+a { color: blue; }
+</style>
+<script>let x = 1 < 2;
+console.log("</scrip", x);
+</script>
+</head>
+<!-- A comment with -- dashes inside, which goes on and on for quite a while, naïve café. -->
+<body class='a &lt; b' data-x=y&amp;z hidden>
+<p title="A long attribute value with &quot;references&quot; in it, long enough to be split.">
+Text &copy; more text &#x27; & plain text with an ampersand, and some more text, naïve café.</p>
+<textarea>raw &lt; <b> text, which is not markup, and which goes on for a while</textarea>
+<![CDATA[ cdata <b> which also goes on for a while, so that it can be split ]]>
+<img src=a.png alt=""/>
+</body>
+</html>
+)";
+
+constexpr std::u8string_view xml_block = u8R"(<?xml version="1.0" encoding="UTF-8"?>
+<!DOCTYPE catalog [ <!ENTITY publisher "Fish &amp; Chips"> <!-- ]> --> ]>
+<catalog xmlns:a="urn:example">
+<!-- A comment which goes on and on for quite a while, long enough to be split. -->
+<a:book id="b1" title='Fish &amp; Chips, a very long title which is long enough to be split'>
+Text &lt; more text &#x27; with some more text to fill the line, naïve café, a & b.
+<![CDATA[ raw <stuff> & more raw stuff, which goes on for a while as well ]]>
+<empty/>
+</a:book>
+<?target some processing instruction ?>
+</catalog>
+)";
+
+struct Span {
+    std::size_t begin;
+    std::size_t length;
+    Underlying type;
+
+    [[nodiscard]]
+    friend bool operator==(const Span&, const Span&)
+        = default;
+
+    friend std::ostream& operator<<(std::ostream& out, const Span& span)
+    {
+        return out << "{ .begin = " << span.begin << ", .length = " << span.length
+                   << ", .type = " << int(span.type) << " }";
+    }
+};
+
+/// @brief Converts tokens into spans,
+/// where adjacent tokens of the same type are merged into one span.
+/// This is necessary because streaming splits some tokens at window boundaries.
+[[nodiscard]]
+std::vector<Span> merge_tokens(const std::vector<Token>& tokens)
+{
+    std::vector<Span> result;
+    for (const Token& token : tokens) {
+        if (!result.empty() && result.back().type == token.type
+            && result.back().begin + result.back().length == token.begin) {
+            result.back().length += token.length;
+        }
+        else {
+            result.push_back({ token.begin, token.length, token.type });
+        }
+    }
+    return result;
+}
+
+template <typename Highlight>
+[[nodiscard]]
+std::vector<Span> highlight_whole(std::u8string_view source, Highlight highlight)
+{
+    std::vector<Token> result;
+    Token buffer[16];
+    const auto flush = [&](Token* tokens, std::size_t amount) {
+        result.insert(result.end(), tokens, tokens + amount);
+    };
+    Non_Owning_Buffer<Token> out { buffer, flush };
+    EXPECT_TRUE(highlight(out, source, std::pmr::get_default_resource(), Highlight_Options {}));
+    out.flush();
+    return merge_tokens(result);
+}
+
+/// @brief Highlights `source` in windows of at most `window_size` code units,
+/// where each window starts with what the previous window left unconsumed.
+template <typename Highlight_Window>
+[[nodiscard]]
+std::vector<Span> highlight_streamed(
+    std::u8string_view source,
+    std::size_t window_size,
+    Highlight_Window highlight_window
+)
+{
+    std::vector<Token> result;
+    Token buffer[16];
+    const auto flush = [&](Token* tokens, std::size_t amount) {
+        result.insert(result.end(), tokens, tokens + amount);
+    };
+    Non_Owning_Buffer<Token> out { buffer, flush };
+    Stream_State state;
+    std::size_t offset = 0;
+    while (true) {
+        const std::u8string_view window = source.substr(offset, window_size);
+        const bool final = offset + window.length() == source.length();
+        const std::size_t consumed = highlight_window(out, window, offset, state, final);
+        if (final) {
+            EXPECT_EQ(consumed, window.length());
+            break;
+        }
+        if (consumed == 0) {
+            ADD_FAILURE() << "No progress at offset " << offset;
+            break;
+        }
+        offset += consumed;
+    }
+    out.flush();
+    return merge_tokens(result);
+}
+
+[[nodiscard]]
+std::u8string repeat(std::u8string_view block, std::size_t times)
+{
+    std::u8string result;
+    for (std::size_t i = 0; i < times; ++i) {
+        result += block;
+    }
+    return result;
+}
+
+constexpr std::size_t window_sizes[] { 128, 129, 150, 200, 256, 333, 500, 1000, 4096 };
+
+TEST(HTML_Stream, windows_match_whole_document)
+{
+    const std::u8string source = repeat(html_block, 4);
+    const std::vector<Span> expected = highlight_whole(source, highlight_html);
+
+    const auto highlight_html_window = [](Non_Owning_Buffer<Token>& out,
+                                          std::u8string_view window, std::size_t offset,
+                                          Stream_State& state, bool final) {
+        return highlight_window(
+            out, window, offset, state, final, std::pmr::get_default_resource(),
+            Highlight_Options {}
+        );
+    };
+    for (const std::size_t window_size : window_sizes) {
+        EXPECT_EQ(highlight_streamed(source, window_size, highlight_html_window), expected)
+            << "window size " << window_size;
+    }
+}
+
+TEST(HTML_Stream, state_at_window_end)
+{
+    std::vector<Token> tokens;
+    Token buffer[16];
+    const auto flush = [&](Token* data, std::size_t amount) {
+        tokens.insert(tokens.end(), data, data + amount);
+    };
+    Non_Owning_Buffer<Token> out { buffer, flush };
+
+    const auto highlight = [&](std::u8string_view window, Stream_State& state) {
+        return highlight_window(
+            out, window, 0, state, false, std::pmr::get_default_resource(), Highlight_Options {}
+        );
+    };
+
+    // Markup which starts within the lookahead is left for the next window.
+    Stream_State state;
+    EXPECT_EQ(highlight(std::u8string(70, u8'x') + u8"<p>text</p>", state), 70);
+    EXPECT_EQ(state, Stream_State {});
+
+    // Tag names are never split.
+    EXPECT_EQ(highlight(u8"<" + std::u8string(100, u8'x'), state), 0);
+    EXPECT_EQ(state, Stream_State {});
+
+    const std::u8string long_value = u8"<a href=\"" + std::u8string(100, u8'x');
+    EXPECT_EQ(highlight(long_value, state), long_value.length() - stream_lookahead);
+    EXPECT_EQ(state.context, Stream_Context::attribute_value);
+    EXPECT_EQ(state.quote, u8'"');
+
+    const std::u8string script = u8"<script type=module>" + std::u8string(100, u8'x');
+    state = {};
+    EXPECT_EQ(highlight(script, state), script.length() - stream_lookahead);
+    EXPECT_EQ(state.context, Stream_Context::raw_text);
+    EXPECT_EQ(state.element, Raw_Text_Element::script);
+
+    // Attributes are not split before the opening quote of their value.
+    state = {};
+    EXPECT_EQ(highlight(u8"<textarea rows=" + std::u8string(100, u8' '), state), 10);
+    EXPECT_EQ(state.context, Stream_Context::tag);
+    EXPECT_EQ(state.element, Raw_Text_Element::textarea);
+}
+
+TEST(HTML_Stream, window_split_position)
+{
+    EXPECT_EQ(window_split_position(u8""), 0);
+    EXPECT_EQ(window_split_position(std::u8string(stream_lookahead, u8'x')), 0);
+    EXPECT_EQ(window_split_position(std::u8string(stream_lookahead + 10, u8'x')), 10);
+
+    // "é" is encoded as two code units, and the split must not be between them.
+    const std::u8string text = std::u8string(9, u8'x') + u8"é" + std::u8string(63, u8'x');
+    EXPECT_EQ(window_split_position(text), 9);
+}
+
+TEST(XML_Stream, windows_match_whole_document)
+{
+    const std::u8string source = repeat(xml_block, 4);
+    const std::vector<Span> expected = highlight_whole(source, highlight_xml);
+
+    const auto highlight_xml_window = [](Non_Owning_Buffer<Token>& out,
+                                         std::u8string_view window, std::size_t offset,
+                                         Stream_State& state, bool final) {
+        return xml::highlight_window(
+            out, window, offset, state, final, std::pmr::get_default_resource(),
+            Highlight_Options {}
+        );
+    };
+    for (const std::size_t window_size : window_sizes) {
+        EXPECT_EQ(highlight_streamed(source, window_size, highlight_xml_window), expected)
+            << "window size " << window_size;
+    }
+}
+
+TEST(Markup_Stream, public_window_api)
+{
+    const std::u8string source = repeat(xml_block, 4);
+    const std::vector<Span> expected = highlight_whole(source, highlight_xml);
+
+    std::vector<Token> tokens;
+    Token buffer[16];
+    State state;
+    state.set_lang(Lang::xml);
+    state.set_token_buffer(buffer);
+    const auto flush = [&](Token* data, std::size_t amount) {
+        tokens.insert(tokens.end(), data, data + amount);
+    };
+    state.on_flush_tokens(flush);
+
+    constexpr std::size_t window_size = 200;
+    Window_State window {};
+    do {
+        const std::u8string_view rest = std::u8string_view { source }.substr(window.offset);
+        state.set_source(rest.substr(0, window_size));
+        window.last = rest.length() <= window_size;
+        ASSERT_EQ(state.window_to_tokens(window), Status::ok);
+        ASSERT_NE(window.consumed, 0);
+    } while (window.offset != source.length());
+    EXPECT_EQ(merge_tokens(tokens), expected);
+
+    state.set_lang(Lang::cpp);
+    EXPECT_EQ(state.window_to_tokens(window), Status::bad_lang);
+}
+
+} // namespace
+} // namespace ulight::html
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "ulight/impl/lang/nasm.hpp"
+
+namespace ulight::nasm {
+namespace {
+
+TEST(NASM, classify_keyword)
+{
+    EXPECT_EQ(classify_keyword(u8"db"), Keyword_Type::pseudo_instruction);
+    EXPECT_EQ(classify_keyword(u8"times"), Keyword_Type::pseudo_instruction);
+    EXPECT_EQ(classify_keyword(u8"dword"), Keyword_Type::type);
+    EXPECT_EQ(classify_keyword(u8"seg"), Keyword_Type::operator_keyword);
+    EXPECT_EQ(classify_keyword(u8"eax"), Keyword_Type::register_);
+    EXPECT_EQ(classify_keyword(u8"zmm31"), Keyword_Type::register_);
+    EXPECT_EQ(classify_keyword(u8"eflags"), Keyword_Type::register_);
+    EXPECT_EQ(classify_keyword(u8"jmp"), Keyword_Type::label_instruction);
+    EXPECT_EQ(classify_keyword(u8"loopnz"), Keyword_Type::label_instruction);
+
+    EXPECT_EQ(classify_keyword(u8""), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"mov"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"ea"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"eaxx"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"eflagss"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"verylongidentifier"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(std::u8string_view { u8"eax\0", 4 }), Keyword_Type::none);
+}
+
+TEST(NASM, classify_keyword_ignores_case)
+{
+    EXPECT_EQ(classify_keyword(u8"EAX"), Keyword_Type::register_);
+    EXPECT_EQ(classify_keyword(u8"eAx"), Keyword_Type::register_);
+    EXPECT_EQ(classify_keyword(u8"DWORD"), Keyword_Type::type);
+    EXPECT_EQ(classify_keyword(u8"Wrt"), Keyword_Type::operator_keyword);
+    EXPECT_EQ(classify_keyword(u8"LOOPNZ"), Keyword_Type::label_instruction);
+
+    // Only ASCII letters are folded, so neighboring characters must not be mistaken for them.
+    EXPECT_EQ(classify_keyword(u8"@AX"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"[AX"), Keyword_Type::none);
+    EXPECT_EQ(classify_keyword(u8"ÁX"), Keyword_Type::none);
+    // 0xc1 is 'A' with the high bit set.
+    EXPECT_EQ(classify_keyword(std::u8string_view { u8"\xc1X", 2 }), Keyword_Type::none);
+}
+
+TEST(NASM, is_keyword)
+{
+    EXPECT_TRUE(is_pseudo_instruction(u8"RESB"));
+    EXPECT_FALSE(is_pseudo_instruction(u8"eax"));
+    EXPECT_TRUE(is_type(u8"Qword"));
+    EXPECT_TRUE(is_operator_keyword(u8"wrt"));
+    EXPECT_TRUE(is_register(u8"Xmm0"));
+    EXPECT_FALSE(is_register(u8"jmp"));
+    EXPECT_TRUE(is_label_instruction(u8"CALL"));
+}
+
+} // namespace
+} // namespace ulight::nasm
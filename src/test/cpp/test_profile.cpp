@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ulight/ulight.hpp"
+
+namespace ulight {
+namespace {
+
+using namespace std::literals;
+
+void highlight_cpp(std::u8string_view source)
+{
+    Token token_buffer[64];
+    State state;
+    state.set_source(source);
+    state.set_lang(Lang::cpp);
+    state.set_token_buffer(token_buffer);
+    const auto flush = [](Token*, std::size_t) { };
+    state.on_flush_tokens(flush);
+    ASSERT_EQ(state.source_to_tokens(), Status::ok);
+}
+
+TEST(Profile, entries_after_highlighting)
+{
+    profile_reset();
+    highlight_cpp(u8"int x = 0; // comment"sv);
+
+    std::vector<Profile_Entry> entries(profile_entries({}));
+    entries.resize(profile_entries(entries));
+
+#ifdef ULIGHT_PROFILE
+    ASSERT_FALSE(entries.empty());
+    const auto whitespace = std::ranges::find_if(entries, [](const Profile_Entry& e) {
+        return e.lang == ULIGHT_LANG_CPP
+            && std::string_view { e.rule, e.rule_length } == "expect_whitespace()";
+    });
+    ASSERT_NE(whitespace, entries.end());
+    EXPECT_GE(whitespace->attempts, whitespace->hits);
+    EXPECT_EQ(whitespace->hits, 4);
+
+    profile_reset();
+    EXPECT_EQ(profile_entries({}), 0);
+#else
+    EXPECT_TRUE(entries.empty());
+#endif
+}
+
+} // namespace
+} // namespace ulight
@@ -0,0 +1,114 @@
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "ulight/impl/string_search.hpp"
+#include "ulight/impl/strings.hpp"
+
+namespace ulight {
+namespace {
+
+constexpr std::size_t npos = std::u8string_view::npos;
+
+TEST(String_Search, find_either)
+{
+    EXPECT_EQ(find_either(u8"", u8'a', u8'b'), npos);
+    EXPECT_EQ(find_either(u8"xyz", u8'a', u8'b'), npos);
+    EXPECT_EQ(find_either(u8"xbza", u8'a', u8'b'), 1);
+    EXPECT_EQ(find_either(u8"xbza", u8'a', u8'b', 2), 3);
+    EXPECT_EQ(find_either(u8"xbza", u8'a', u8'b', 4), npos);
+
+    // Matches at every position, including past the first vector block, are found.
+    for (std::size_t length = 1; length < 70; ++length) {
+        for (std::size_t pos = 0; pos < length; ++pos) {
+            std::u8string str(length, u8'x');
+            str[pos] = u8'\n';
+            EXPECT_EQ(find_either(str, u8'\r', u8'\n'), pos);
+            EXPECT_EQ(find_either(str, u8'\r', u8'\n', pos + 1), npos);
+        }
+    }
+}
+
+TEST(String_Search, find_first_not_in_ranges)
+{
+    constexpr Code_Unit_Range digits[] { { u8'0', u8'9' } };
+    constexpr Code_Unit_Range word[] { { u8'a', u8'z' }, { u8'_', u8'_' }, { 0x80, 0xff } };
+    EXPECT_EQ(find_first_not_in_ranges(u8"", digits), npos);
+    EXPECT_EQ(find_first_not_in_ranges(u8"123", digits), npos);
+    EXPECT_EQ(find_first_not_in_ranges(u8"12a3", digits), 2);
+    EXPECT_EQ(find_first_not_in_ranges(u8"a12b", digits, 1), 3);
+    EXPECT_EQ(find_first_not_in_ranges(u8"a_\u00E4b c", word), 5);
+    EXPECT_EQ(find_first_not_in_ranges(u8"a/", word), 1);
+    EXPECT_EQ(find_first_not_in_ranges(u8"a`{", word), 1);
+
+    // Mismatches at every position, including past the first vector block, are found.
+    for (std::size_t length = 1; length < 70; ++length) {
+        for (std::size_t pos = 0; pos < length; ++pos) {
+            std::u8string str(length, u8'7');
+            str[pos] = u8'/';
+            EXPECT_EQ(find_first_not_in_ranges(str, digits), pos);
+            EXPECT_EQ(find_first_not_in_ranges(str, digits, pos + 1), npos);
+        }
+    }
+}
+
+TEST(String_Search, find_substring)
+{
+    EXPECT_EQ(find_substring(u8"", u8""), 0);
+    EXPECT_EQ(find_substring(u8"abc", u8""), 0);
+    EXPECT_EQ(find_substring(u8"abc", u8"", 3), 3);
+    EXPECT_EQ(find_substring(u8"abc", u8"", 4), npos);
+    EXPECT_EQ(find_substring(u8"", u8"-->"), npos);
+    EXPECT_EQ(find_substring(u8"--", u8"-->"), npos);
+    EXPECT_EQ(find_substring(u8"-->", u8"-->"), 0);
+    EXPECT_EQ(find_substring(u8"a -- b --> c", u8"-->"), 7);
+    EXPECT_EQ(find_substring(u8"a]]>b]]>", u8"]]>", 2), 5);
+    EXPECT_EQ(find_substring(u8"abc", u8"c"), 2);
+    EXPECT_EQ(find_substring(u8"abc", u8"C"), npos);
+}
+
+TEST(String_Search, find_substring_matches_std)
+{
+    // Candidates which match the first and last code unit, but not the middle,
+    // are placed densely, to exercise the verification of candidates.
+    const std::u8string_view needles[] { u8"]]>", u8"-->", u8"</script", u8"??" };
+    for (const std::u8string_view needle : needles) {
+        for (std::size_t length = 0; length < 80; ++length) {
+            std::u8string haystack;
+            for (std::size_t i = 0; i < length; ++i) {
+                haystack += i % 3 == 0 ? needle.front() : needle.back();
+            }
+            for (std::size_t pos = 0; pos + needle.length() <= length; pos += 7) {
+                std::u8string str = haystack;
+                str.replace(pos, needle.length(), needle);
+                for (const std::size_t start : { std::size_t(0), pos / 2, pos }) {
+                    EXPECT_EQ(find_substring(str, needle, start), str.find(needle, start));
+                }
+            }
+            EXPECT_EQ(find_substring(haystack, needle), haystack.find(needle));
+        }
+    }
+}
+
+TEST(String_Search, find_substring_ascii_ignore_case)
+{
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"</SCRIPT>", u8"</script"), 0);
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"x</ScRiPt>", u8"</script"), 1);
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"x</scripT", u8"</script"), 1);
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"x</scrip", u8"</script"), npos);
+    // Setting the case bit of '@' or '[' produces '`' or '{',
+    // which must not be mistaken for letters.
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"`", u8"@"), npos);
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"@", u8"`"), npos);
+    EXPECT_EQ(find_substring_ascii_ignore_case(u8"A", u8"a"), 0);
+
+    std::u8string long_script(1000, u8'x');
+    long_script += u8"</Style </STYLE>";
+    EXPECT_EQ(find_substring_ascii_ignore_case(long_script, u8"</style"), 1000);
+    EXPECT_EQ(find_substring_ascii_ignore_case(long_script, u8"</style", 1001), 1008);
+}
+
+} // namespace
+} // namespace ulight
@@ -4,6 +4,7 @@
 #include <iterator>
 #include <memory_resource>
 #include <random>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -12,10 +13,18 @@
 #include "ulight/impl/io.hpp"
 #include "ulight/impl/unicode.hpp"
 #include "ulight/impl/unicode_chars.hpp"
+#include "ulight/impl/unicode_xid_ranges.hpp"
 
 namespace ulight::utf8 {
 namespace {
 
+[[nodiscard]]
+bool ranges_contain(std::span<const Code_Point_Range> ranges, char32_t c)
+{
+    const auto it = std::ranges::lower_bound(ranges, c, {}, &Code_Point_Range::max);
+    return it != ranges.end() && it->min <= c;
+}
+
 [[nodiscard]]
 std::pmr::vector<char32_t> to_utf32(std::u8string_view utf8, std::pmr::memory_resource* memory)
 {
@@ -83,5 +92,19 @@ TEST(Unicode, encode_decode_reversible_fuzzing)
     }
 }
 
+TEST(Unicode, xid_tables_exhaustive)
+{
+    // The lookup tables used by is_xid_start and is_xid_continue are generated from the ranges
+    // by scripts/generate-xid-tables.js, and have to be regenerated whenever these change.
+    for (char32_t c = 0; c <= code_point_max + 1; ++c) {
+        const bool start = ranges_contain(XID_Start_Ranges, c);
+        const bool continue_ = start || ranges_contain(XID_Continue_Minus_XID_Start, c);
+        ASSERT_EQ(is_xid_start(c), start) << "U+" << std::hex << std::uint32_t(c);
+        ASSERT_EQ(is_xid_continue(c), continue_) << "U+" << std::hex << std::uint32_t(c);
+    }
+    EXPECT_FALSE(is_xid_start(char32_t(-1)));
+    EXPECT_FALSE(is_xid_continue(char32_t(-1)));
+}
+
 } // namespace
 } // namespace ulight::utf8
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "ulight/impl/ascii_chars.hpp"
 #include "ulight/impl/unicode_algorithm.hpp"
 
 namespace ulight::utf8 {
@@ -39,5 +40,20 @@ TEST(Unicode_Algorithm, length_if_not_ascii)
     EXPECT_EQ(length_if_not(u8"abc", [](char32_t c) { return c == U'd'; }), 3);
 }
 
+TEST(Unicode_Algorithm, length_if_likely_ascii)
+{
+    // The predicate is deliberately inconsistent with the ASCII set for ASCII characters,
+    // which shows that it is only used for non-ASCII characters.
+    constexpr auto is_greek = [](char32_t c) { return c >= U'\u0370' && c <= U'\u03FF'; };
+
+    EXPECT_EQ(length_if_likely_ascii(u8"", is_ascii_alpha_set, is_greek), 0);
+    EXPECT_EQ(length_if_likely_ascii(u8"abc", is_ascii_alpha_set, is_greek), 3);
+    EXPECT_EQ(length_if_likely_ascii(u8"ab1", is_ascii_alpha_set, is_greek), 2);
+    EXPECT_EQ(length_if_likely_ascii(u8"a\u03B1b", is_ascii_alpha_set, is_greek), 4);
+    EXPECT_EQ(length_if_likely_ascii(u8"a\u4E00b", is_ascii_alpha_set, is_greek), 1);
+    EXPECT_EQ(length_if_likely_ascii(u8"1ab", is_ascii_alpha_set, is_greek, 1), 3);
+    EXPECT_EQ(length_if_likely_ascii(u8"1ab", is_ascii_alpha_set, is_greek, 3), 3);
+}
+
 } // namespace
 } // namespace ulight::utf8
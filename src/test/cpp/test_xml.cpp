@@ -17,19 +17,45 @@ TEST(XML, match_whitespace)
     EXPECT_EQ(match_whitespace(u8"\t\r\n"), 3);
 }
 
-TEST(XML, match_name_permissive)
+TEST(XML, match_name)
 {
+    EXPECT_EQ(match_name(u8""), 0);
+    EXPECT_EQ(match_name(u8"simple_name"), 11);
+    EXPECT_EQ(match_name(u8"stroke-width=\"2\""), 12);
+    EXPECT_EQ(match_name(u8"xlink:href"), 10);
+    EXPECT_EQ(match_name(u8"n&a&m&e"), 1);
+    EXPECT_EQ(match_name(u8"café>"), 5);
+    EXPECT_EQ(match_name(u8"-name"), 0);
+    EXPECT_EQ(match_name(u8"1name"), 0);
+
+    EXPECT_EQ(match_nmtoken(u8"1name"), 5);
+    EXPECT_EQ(match_nmtoken(u8"-name "), 5);
+    EXPECT_EQ(match_nmtoken(u8" name"), 0);
+}
 
-    Name_Match_Result result;
-    result = match_name_permissive(u8"simple_name", [](std::u8string_view) { return false; });
-    EXPECT_EQ(result.length, 11);
-    EXPECT_EQ(result.error_indicies.size(), 0);
+TEST(XML, split_qualified_name)
+{
+    EXPECT_EQ(split_qualified_name(u8"rect"), (Qualified_Name { u8"", u8"rect" }));
+    EXPECT_EQ(split_qualified_name(u8"svg:rect"), (Qualified_Name { u8"svg", u8"rect" }));
+    EXPECT_EQ(split_qualified_name(u8"a:b:c"), (Qualified_Name { u8"a", u8"b:c" }));
+    EXPECT_EQ(split_qualified_name(u8":rect"), (Qualified_Name { u8"", u8":rect" }));
+    EXPECT_EQ(split_qualified_name(u8"svg:"), (Qualified_Name { u8"", u8"svg:" }));
+}
 
-    result = match_name_permissive(u8"n&a&m&e", [](std::u8string_view) { return false; });
-    EXPECT_EQ(result.length, 7);
-    EXPECT_TRUE(result.error_indicies.contains(1));
-    EXPECT_TRUE(result.error_indicies.contains(3));
-    EXPECT_TRUE(result.error_indicies.contains(5));
+TEST(XML, match_doctype)
+{
+    EXPECT_EQ(match_doctype(u8"<!DOCTYP"), html::Match_Result {});
+    EXPECT_EQ(match_doctype(u8"<!DOCTYPE a>"), (html::Match_Result { 12, true }));
+    EXPECT_EQ(match_doctype(u8"<!DOCTYPE a SYSTEM \">\">"), (html::Match_Result { 23, true }));
+    EXPECT_EQ(
+        match_doctype(u8"<!DOCTYPE a [<!ENTITY b \"]>\">]>c"), (html::Match_Result { 31, true })
+    );
+    EXPECT_EQ(match_doctype(u8"<!DOCTYPE a [<!-- ]> -->]>"), (html::Match_Result { 26, true }));
+    EXPECT_EQ(match_doctype(u8"<!DOCTYPE a [<? ]> ?>]>"), (html::Match_Result { 23, true }));
+    EXPECT_EQ(
+        match_doctype(u8"<!DOCTYPE a [<!ELEMENT a EMPTY>"), (html::Match_Result { 31, false })
+    );
+    EXPECT_EQ(match_doctype(u8"<!DOCTYPE a SYSTEM \"b>"), (html::Match_Result { 22, false }));
 }
 
 } // namespace ulight::xml
@@ -0,0 +1,16 @@
+cat <<EOF > "$out"
+Hello, $USER! Today is $(date), \$5 and a "quote".
+EOF
+cat <<-'END'
+	No $expansion here.
+	END
+jq . <<"JSON"
+{"name": "ulight", "tags": ["a", "b"]}
+JSON
+cat <<A; cat <<B
+first
+A
+second
+B
+echo $((1 << 2))
+echo done
@@ -0,0 +1,2 @@
+"\あ"
+u8'\é'
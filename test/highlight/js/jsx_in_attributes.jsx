@@ -0,0 +1,7 @@
+const list = <List
+    header={<Title text="Items" /* inline */ />}
+    render={(item) => <Item key={item.id} icon={<Icon name='dot' />}>{item.name}</Item>}
+    {...props}
+/>;
+
+const fallback = 1 < 2 ? <></> : a <b;
@@ -0,0 +1,6 @@
+const greeting = `Hello, ${user ? `${user.first} ${`${user.last}`}` : "stranger"}!`;
+
+const list = <ul>
+    {items.map((item) => <li key={item.id}>{`${item.name}: ${{ a: 1 }.a}`}</li>)}
+    {/[{}]/.test(text) ? <b>{"}"}</b> : null}
+</ul>;
@@ -0,0 +1 @@
+const _private = __proto__ + _1 + x_y;
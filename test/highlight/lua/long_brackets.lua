@@ -0,0 +1,9 @@
+local a = [[plain ]=] and ]==] inside]]
+local b = [==[
+level two with ]] and ]=] inside
+]==]
+--[[ comment with ] and ]=] ]]
+--[=[ comment
+with ]] inside ]=]
+print(a, b) -- [[ not a block comment
+local c = t[ [=[key]=] ]